@@ -0,0 +1,94 @@
+#include <random>
+#include <vector>
+#include "benchmark/benchmark.h"
+#include "engine/pair.hpp"
+
+// the scalar math of the simulation on double and on Fixed, whatever real
+// this build uses. Run cbench of a SIM_FIXED build for the whole simulation
+
+template <typename T>
+static std::vector<T> makeRandomValues(unsigned int seed,
+                                       double min,
+                                       double max) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> value(min, max);
+    std::vector<T> values;
+    for (size_t i = 0; i < 256; i++) {
+        values.push_back(T(value(rng)));
+    }
+    return values;
+}
+
+// the cross products line intersections are made of
+template <typename T>
+static void BM_ScalarPerpDot(benchmark::State& state) {
+    std::vector<T> values = makeRandomValues<T>(6, -2, 2);
+
+    size_t i = 0;
+    for (auto _ : state) {
+        Vec2<T> a = Vec2<T>(values[i % 256], values[(i + 1) % 256]);
+        Vec2<T> b = Vec2<T>(values[(i + 2) % 256], values[(i + 3) % 256]);
+        benchmark::DoNotOptimize((a.y * b.x) - (a.x * b.y));
+        i++;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK_TEMPLATE(BM_ScalarPerpDot, double);
+BENCHMARK_TEMPLATE(BM_ScalarPerpDot, Fixed);
+
+template <typename T>
+static void BM_ScalarDivide(benchmark::State& state) {
+    std::vector<T> values = makeRandomValues<T>(7, 0.5, 2);
+
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(values[i % 256] / values[(i + 1) % 256]);
+        i++;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK_TEMPLATE(BM_ScalarDivide, double);
+BENCHMARK_TEMPLATE(BM_ScalarDivide, Fixed);
+
+template <typename T>
+static void BM_ScalarSqrt(benchmark::State& state) {
+    std::vector<T> values = makeRandomValues<T>(8, 0, 100);
+
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(sqrt(values[i++ % 256]));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK_TEMPLATE(BM_ScalarSqrt, double);
+BENCHMARK_TEMPLATE(BM_ScalarSqrt, Fixed);
+
+template <typename T>
+static void BM_ScalarAtan2(benchmark::State& state) {
+    std::vector<T> values = makeRandomValues<T>(9, -2, 2);
+
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(
+            atan2(values[i % 256], values[(i + 1) % 256]));
+        i++;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK_TEMPLATE(BM_ScalarAtan2, double);
+BENCHMARK_TEMPLATE(BM_ScalarAtan2, Fixed);
+
+template <typename T>
+static void BM_ScalarSinCos(benchmark::State& state) {
+    std::vector<T> values = makeRandomValues<T>(10, -4, 4);
+
+    size_t i = 0;
+    for (auto _ : state) {
+        T angle = values[i++ % 256];
+        benchmark::DoNotOptimize(sin(angle));
+        benchmark::DoNotOptimize(cos(angle));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK_TEMPLATE(BM_ScalarSinCos, double);
+BENCHMARK_TEMPLATE(BM_ScalarSinCos, Fixed);
@@ -0,0 +1,330 @@
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <unistd.h>
+#include "benchmark/benchmark.h"
+#include "terrain/map.hpp"
+#include "player/playerconfig.hpp"
+#include "player/inputhandler.hpp"
+#include "stage/stagefile.hpp"
+
+using namespace Terrain;
+
+static std::vector<Platform> makeRandomPlatforms(unsigned int seed,
+                                                 size_t count) {
+    std::mt19937 rng(seed);
+    double extent = 20 * std::sqrt(count / 200.0);
+    std::uniform_real_distribution<double> position(-extent, extent);
+    std::uniform_real_distribution<double> step(-1.5, 1.5);
+
+    std::vector<Platform> platforms;
+    for (size_t i = 0; i < count; i++) {
+        Pair p = Pair(position(rng), position(rng));
+        std::vector<Pair> points = {p};
+        for (size_t j = 0; j < 1 + rng() % 6; j++) {
+            p = p + Pair(step(rng), step(rng));
+            points.push_back(p);
+        }
+        platforms.push_back(Platform(points, rng() % 4 == 0));
+    }
+    return platforms;
+}
+
+class EcbMove {
+   public:
+    Ecb current;
+    Ecb projected;
+};
+
+static std::vector<EcbMove> makeRandomMoves(unsigned int seed,
+                                            size_t count,
+                                            size_t platforms) {
+    std::mt19937 rng(seed);
+    double extent = 20 * std::sqrt(platforms / 200.0);
+    std::uniform_real_distribution<double> position(-extent, extent);
+    std::uniform_real_distribution<double> step(-0.5, 0.5);
+
+    std::vector<EcbMove> moves;
+    for (size_t i = 0; i < count; i++) {
+        EcbMove move;
+        move.current = Ecb(Pair(position(rng), position(rng)), 1, 2);
+        move.projected = move.current;
+        move.projected.setOrigin(move.current.origin +
+                                 Pair(step(rng), step(rng)));
+        moves.push_back(move);
+    }
+    return moves;
+}
+
+/** Run the queries the nine probes of one moveRecursive iteration make */
+template <typename... Scratch>
+static size_t probeQueries(Map const& m,
+                           EcbMove const& move,
+                           Scratch&... scratch) {
+    Ecb const& c = move.current;
+    Ecb const& p = move.projected;
+    PlatformSegment ignored;
+    CollisionDatum collision;
+    EdgeCollision edge;
+    size_t hits = 0;
+
+    hits += m.getClosestCollision(c.right, p.right, collision, ignored,
+                                  WALL_COLLISION, scratch...);
+    hits += m.getClosestCollision(c.left, p.left, collision, ignored,
+                                  WALL_COLLISION, scratch...);
+    hits += m.getClosestCollision(c.top, p.top, collision, ignored,
+                                  CEIL_COLLISION, scratch...);
+
+    // topRight is probed twice, as in moveRecursive
+    hits += m.getClosestEdgeCollision(c.top, c.right, p.top, p.right, edge,
+                                      NULL, scratch...);
+    hits += m.getClosestEdgeCollision(c.right, c.bottom, p.right, p.bottom,
+                                      edge, NULL, scratch...);
+    hits += m.getClosestEdgeCollision(c.bottom, c.left, p.bottom, p.left,
+                                      edge, NULL, scratch...);
+    hits += m.getClosestEdgeCollision(c.top, c.right, p.top, p.right, edge,
+                                      NULL, scratch...);
+    hits += m.getClosestEdgeCollision(c.left, c.top, p.left, p.top, edge,
+                                      NULL, scratch...);
+
+    hits += m.getClosestCollision(c.bottom, p.bottom, collision, ignored,
+                                  FLOOR_COLLISION, scratch...);
+    return hits;
+}
+
+// every probe queries the map on its own
+static void BM_MoveIteration_SeparateQueries(benchmark::State& state) {
+    Map m = Map(makeRandomPlatforms(42, state.range(0)), {});
+    std::vector<EcbMove> moves = makeRandomMoves(7, 256, state.range(0));
+
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(probeQueries(m, moves[i++ % moves.size()]));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_MoveIteration_SeparateQueries)->Arg(50)->Arg(200)->Arg(2000);
+
+// one broadphase pass per iteration, shared by all probes
+static void BM_MoveIteration_SharedCandidates(benchmark::State& state) {
+    Map m = Map(makeRandomPlatforms(42, state.range(0)), {});
+    std::vector<EcbMove> moves = makeRandomMoves(7, 256, state.range(0));
+    MovementScratch scratch;
+
+    size_t i = 0;
+    for (auto _ : state) {
+        EcbMove const& move = moves[i++ % moves.size()];
+        m.gatherCandidates(move.current, move.projected, scratch);
+        benchmark::DoNotOptimize(probeQueries(m, move, scratch));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_MoveIteration_SharedCandidates)->Arg(50)->Arg(200)->Arg(2000);
+
+// one frame of movement for 256 airborne players, on a pool of Arg workers
+static void BM_MovePlayers(benchmark::State& state) {
+    Map m = Map(makeRandomPlatforms(42, 2000), {});
+    std::vector<EcbMove> moves = makeRandomMoves(7, 256, 2000);
+    WorkerPool pool(state.range(0));
+
+    PlayerConfig config("assets/attributes.yaml");
+    InputMapping::JoystickInputHandler input(InputMapping::gamecubeButtons,
+                                             InputMapping::gamecubeAxies,
+                                             NULL);
+    std::vector<Player> players;
+    for (EcbMove const& move : moves) {
+        players.push_back(Player(&config, &input, NULL, move.current.origin));
+    }
+    std::vector<Player*> playerPtrs;
+    for (Player& p : players) {
+        playerPtrs.push_back(&p);
+    }
+    std::vector<Pair> distances(players.size());
+
+    for (auto _ : state) {
+        // put everyone back in the air where they started
+        state.PauseTiming();
+        for (size_t i = 0; i < players.size(); i++) {
+            players[i].moveTo(moves[i].current.origin);
+            if (players[i].isGrounded())
+                players[i].fallOffPlatform();
+            distances[i] = moves[i].projected.origin - moves[i].current.origin;
+        }
+        state.ResumeTiming();
+
+        m.movePlayers(playerPtrs.data(), distances.data(), players.size(),
+                      pool);
+    }
+    state.SetItemsProcessed(state.iterations() * players.size());
+}
+BENCHMARK(BM_MovePlayers)->Arg(1)->Arg(2)->Arg(4)->UseRealTime();
+
+// the walls, floors and ceilings the movePlayer scenarios run into
+static std::vector<Platform> makeArena() {
+    return {
+        Platform({Pair(-10, 0), Pair(10, 0)}),
+        Platform({Pair(6, 0), Pair(6, -10)}),
+        Platform({Pair(-2, -6), Pair(-8, -6)}),
+        // a ledge whose left corner is hit from the side
+        Platform({Pair(2, -8), Pair(5, -8)}),
+    };
+}
+
+/** The arena surrounded by random platforms, segments in total
+ *
+ * The random platforms keep out of the arena and are spread as densely as
+ * in makeRandomPlatforms, so the map grows outwards with its size.
+ */
+static std::vector<Platform> makeArenaMap(unsigned int seed,
+                                          size_t segments) {
+    std::vector<Platform> platforms = makeArena();
+    // the arena's platforms are a segment each
+    size_t count = platforms.size();
+
+    Bounds arena = Bounds(Pair(-12, -12), Pair(12, 12));
+    double extent = 14 + std::sqrt(2.0 * segments) / 2;
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> position(-extent, extent);
+    std::uniform_real_distribution<double> step(-1.5, 1.5);
+    while (count < segments) {
+        Pair p = Pair(position(rng), position(rng));
+        std::vector<Pair> points = {p};
+        size_t length = std::min<size_t>(1 + rng() % 6, segments - count);
+        bool inArena = arena.contains(p);
+        for (size_t j = 0; j < length; j++) {
+            p = p + Pair(step(rng), step(rng));
+            inArena |= arena.contains(p);
+            points.push_back(p);
+        }
+        bool passable = rng() % 4 == 0;
+        if (!inArena) {
+            platforms.push_back(Platform(points, passable));
+            count += length;
+        }
+    }
+    return platforms;
+}
+
+typedef enum MoveScenario {
+    // walking back and forth along the floor
+    GROUNDED_WALK,
+    // falling diagonally into the wall
+    WALL_SLIDE,
+    // jumping into the ceiling
+    CEILING_BONK,
+    // the top right edge of the ECB catching the ledge's corner
+    CORNER,
+} MoveScenario;
+
+// one movePlayer call of the scenario, on a map of Arg segments
+static void BM_MovePlayer(benchmark::State& state, MoveScenario scenario) {
+    Map m = Map(makeArenaMap(42, state.range(0)), {});
+    PlayerConfig config("assets/attributes.yaml");
+    InputMapping::JoystickInputHandler input(InputMapping::gamecubeButtons,
+                                             InputMapping::gamecubeAxies,
+                                             NULL);
+
+    Pair start, distance;
+    switch (scenario) {
+        case GROUNDED_WALK:
+            start = Pair(0, 0);
+            distance = Pair(0.5, 0);
+            break;
+        case WALL_SLIDE:
+            start = Pair(5.9, -5);
+            distance = Pair(0.3, 0.2);
+            break;
+        case CEILING_BONK:
+            start = Pair(-5, -5.5);
+            distance = Pair(0.1, -0.5);
+            break;
+        case CORNER:
+            start = Pair(1.9, -7.75);
+            distance = Pair(0.5, 0);
+            break;
+    }
+    Player player = Player(&config, &input, NULL, start);
+    if (scenario == GROUNDED_WALK) {
+        player.land(&m.getPlatforms()[0]);
+    }
+
+    size_t i = 0, iterations = 0;
+    for (auto _ : state) {
+        // walkers turn around every step, everyone else starts over
+        Pair requested = distance;
+        if (scenario == GROUNDED_WALK) {
+            requested.x *= i++ % 2 ? -1 : 1;
+        } else {
+            player.moveTo(start);
+        }
+        m.movePlayer(player, requested);
+        iterations += m.getLastMovementStats().iterations;
+    }
+    state.SetItemsProcessed(state.iterations());
+    // movement iterations per call
+    state.counters["moveIterations"] =
+        benchmark::Counter(iterations, benchmark::Counter::kAvgIterations);
+}
+BENCHMARK_CAPTURE(BM_MovePlayer, GroundedWalk, GROUNDED_WALK)
+    ->RangeMultiplier(10)
+    ->Range(10, 100000);
+BENCHMARK_CAPTURE(BM_MovePlayer, WallSlide, WALL_SLIDE)
+    ->RangeMultiplier(10)
+    ->Range(10, 100000);
+BENCHMARK_CAPTURE(BM_MovePlayer, CeilingBonk, CEILING_BONK)
+    ->RangeMultiplier(10)
+    ->Range(10, 100000);
+BENCHMARK_CAPTURE(BM_MovePlayer, Corner, CORNER)
+    ->RangeMultiplier(10)
+    ->Range(10, 100000);
+
+// a frame of line of sight checks for AI players, on a pool of Arg workers
+static void BM_RayCasts(benchmark::State& state) {
+    Map m = Map(makeRandomPlatforms(42, 2000), {});
+    std::vector<EcbMove> moves = makeRandomMoves(8, 4096, 2000);
+    std::vector<Ray> rays;
+    for (EcbMove const& move : moves) {
+        rays.push_back(Ray(move.current.origin,
+                           move.current.origin +
+                               (move.projected.origin - move.current.origin) *
+                                   10));
+    }
+    std::vector<QueryHit> hits(rays.size());
+    WorkerPool pool(state.range(0));
+
+    for (auto _ : state) {
+        m.rayCasts(rays.data(), rays.size(), QUERY_SOLID, hits.data(), pool);
+        benchmark::DoNotOptimize(hits.data());
+    }
+    state.SetItemsProcessed(state.iterations() * rays.size());
+}
+BENCHMARK(BM_RayCasts)->Arg(1)->Arg(4)->UseRealTime();
+
+// building a map from its platforms, index structures included
+static void BM_MapBuild(benchmark::State& state) {
+    std::vector<Platform> platforms = makeRandomPlatforms(42, state.range(0));
+    for (auto _ : state) {
+        Map m = Map(platforms, {});
+        benchmark::DoNotOptimize(m.getSegments().size());
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_MapBuild)->Arg(200)->Arg(2000)->Arg(20000);
+
+// loading the same map from a compiled stage
+static void BM_MapLoad(benchmark::State& state) {
+    char path[] = "/tmp/cbench-stage-XXXXXX";
+    close(mkstemp(path));
+    StageWriter out;
+    Map(makeRandomPlatforms(42, state.range(0)), {}).save(out);
+    out.save(path);
+
+    for (auto _ : state) {
+        Map* m = Map::load(path);
+        benchmark::DoNotOptimize(m->getSegments().size());
+        delete m;
+    }
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+    remove(path);
+}
+BENCHMARK(BM_MapLoad)->Arg(200)->Arg(2000)->Arg(20000);
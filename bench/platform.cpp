@@ -0,0 +1,110 @@
+#include <random>
+#include "benchmark/benchmark.h"
+#include "terrain/platform.hpp"
+
+// a long, bumpy floor of count points
+static std::vector<Pair> makeBumpyFloor(std::mt19937& rng, size_t count) {
+    std::uniform_real_distribution<double> bump(-0.2, 0.2);
+    std::vector<Pair> points;
+    for (size_t i = 0; i < count; i++) {
+        points.push_back(Pair(i * 0.5, bump(rng)));
+    }
+    return points;
+}
+
+// random positions along the segments of a floor
+static std::vector<Pair> makeFloorPositions(std::mt19937& rng,
+                                            std::vector<Pair> const& points) {
+    std::vector<Pair> positions;
+    std::uniform_real_distribution<double> unit(0, 1);
+    for (size_t i = 0; i < 256; i++) {
+        size_t s = rng() % (points.size() - 1);
+        positions.push_back(points[s] +
+                            (points[s + 1] - points[s]) * unit(rng));
+    }
+    return positions;
+}
+
+// a floor of Arg points, walked onto at random positions
+static void BM_SegmentIndexByLocation(benchmark::State& state) {
+    std::mt19937 rng(5);
+    std::vector<Pair> points = makeBumpyFloor(rng, state.range(0));
+    Platform platform = Platform(points);
+    std::vector<Pair> positions = makeFloorPositions(rng, points);
+
+    size_t i = 0;
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(platform.getSegmentIndexByLocation(
+            positions[i++ % positions.size()], 1));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SegmentIndexByLocation)->RangeMultiplier(10)->Range(10, 100000);
+
+// walking 4 units along a floor of Arg points, one segment per step
+static void BM_StepGroundedMovement(benchmark::State& state) {
+    std::mt19937 rng(6);
+    std::vector<Pair> points = makeBumpyFloor(rng, state.range(0));
+    Platform platform = Platform(points);
+    std::vector<Pair> positions = makeFloorPositions(rng, points);
+
+    size_t i = 0, steps = 0;
+    for (auto _ : state) {
+        Pair position = positions[i % positions.size()];
+        Pair velocity = Pair(i % 2 ? 4 : -4, 0);
+        i++;
+
+        PlatformMovementState m;
+        bool stayOn = platform.initGroundedMovement(position, velocity, m);
+        while (stayOn && velocity.x != 0) {
+            stayOn = platform.stepGroundedMovement(position, velocity, m);
+            steps++;
+        }
+        benchmark::DoNotOptimize(position);
+    }
+    state.SetItemsProcessed(steps);
+}
+BENCHMARK(BM_StepGroundedMovement)->RangeMultiplier(10)->Range(10, 100000);
+
+static std::vector<Pair> makeRandomPoints(unsigned int seed, size_t count) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> position(-10, 10);
+    std::vector<Pair> points;
+    for (size_t i = 0; i < count; i++) {
+        points.push_back(Pair(position(rng), position(rng)));
+    }
+    return points;
+}
+
+// segment space transforms through the segment angle
+static void BM_SegmentSpace_Angle(benchmark::State& state) {
+    std::vector<Pair> points = makeRandomPoints(8, 256);
+    Platform platform = Platform(points);
+
+    size_t i = 0;
+    for (auto _ : state) {
+        size_t s = i % (points.size() - 1);
+        Pair& other = points[(i * 7 + 3) % points.size()];
+        benchmark::DoNotOptimize(Platform::movePointToSegmentSpace(
+            points[s], platform.getSegment(s).angle(), other));
+        i++;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SegmentSpace_Angle);
+
+// the same transforms through the precomputed direction and normal
+static void BM_SegmentSpace_Dot(benchmark::State& state) {
+    std::vector<Pair> points = makeRandomPoints(8, 256);
+    Platform platform = Platform(points);
+
+    size_t i = 0;
+    for (auto _ : state) {
+        size_t s = i % (points.size() - 1);
+        Pair const& other = points[(i * 7 + 3) % points.size()];
+        benchmark::DoNotOptimize(platform.toSegmentSpace(s, other));
+        i++;
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_SegmentSpace_Dot);
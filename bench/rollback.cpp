@@ -0,0 +1,89 @@
+#include <random>
+#include "benchmark/benchmark.h"
+#include "player/inputhandler.hpp"
+#include "player/playerconfig.hpp"
+#include "sim/simulation.hpp"
+#include "sim/snapshot.hpp"
+#include "terrain/map.hpp"
+
+using namespace Terrain;
+using namespace InputMapping;
+
+// a walled floor under a turning passable platform, with players along it
+static Map makeRollbackArena() {
+    Platform spinner({Pair(-4, 2), Pair(4, 2)}, true);
+    PlatformMotion motion;
+    motion.angularVelocity = 0.02;
+    motion.pivot = Pair(0, 2);
+    spinner.setMotion(motion);
+    return Map({Platform({Pair(-20, -10),
+                          Pair(-20, 5),
+                          Pair(20, 5),
+                          Pair(20, -10)}),
+                spinner},
+               {});
+}
+
+static std::vector<Pair> makeSpawns(size_t players) {
+    std::vector<Pair> spawns;
+    for (size_t i = 0; i < players; i++) {
+        spawns.push_back(Pair(-16 + 32.0 * i / players, 4));
+    }
+    return spawns;
+}
+
+// frames of random walking and jumping for each player
+static std::vector<InputFrame> makeInputs(size_t players, size_t frames) {
+    std::mt19937 rng(17);
+    std::uniform_real_distribution<double> walk(-1, 1);
+    std::vector<InputFrame> inputs(players * frames);
+    for (InputFrame& input : inputs) {
+        input.axies[MOVEMENT_AXIS_X] = walk(rng);
+        if (rng() % 20 == 0) {
+            input.buttons |= 1 << JUMP;
+        }
+    }
+    return inputs;
+}
+
+/** The worst case of a rollback: a late input for the oldest frame still
+ * snapshotted, restoring it and resimulating range(0) frames of 8 players
+ */
+static void BM_Rollback(benchmark::State& state) {
+    size_t const players = 8;
+    size_t frames = state.range(0);
+    Map m = makeRollbackArena();
+    PlayerConfig config("assets/attributes.yaml");
+    Simulation sim(m, config, makeSpawns(players));
+    std::vector<InputFrame> inputs = makeInputs(players, 60 + frames);
+
+    for (size_t f = 0; f < 60; f++) {
+        sim.step(&inputs[f * players], 1.0 / 60.0);
+    }
+    SnapshotArena snapshot(sim.getSnapshotSize(), 1);
+    sim.save(snapshot.getSlot(0));
+
+    for (auto _ : state) {
+        sim.restore(snapshot.getSlot(0));
+        for (size_t f = 60; f < 60 + frames; f++) {
+            sim.step(&inputs[f * players], 1.0 / 60.0);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * frames);
+}
+BENCHMARK(BM_Rollback)->Arg(1)->Arg(4)->Arg(8)->Arg(16);
+
+// the snapshot every frame takes
+static void BM_SimulationSave(benchmark::State& state) {
+    Map m = makeRollbackArena();
+    PlayerConfig config("assets/attributes.yaml");
+    Simulation sim(m, config, makeSpawns(state.range(0)));
+    SnapshotArena snapshot(sim.getSnapshotSize(), 1);
+    for (auto _ : state) {
+        sim.save(snapshot.getSlot(0));
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(state.iterations());
+    state.SetBytesProcessed(state.iterations() * sim.getSnapshotSize());
+}
+BENCHMARK(BM_SimulationSave)->Arg(2)->Arg(8)->Arg(64);
@@ -0,0 +1,62 @@
+#include <random>
+#include "benchmark/benchmark.h"
+#include "util.hpp"
+
+class LinePair {
+   public:
+    Pair p0, p1;
+    Pair q0, q1;
+};
+
+// short lines around the origin, about half of the pairs crossing
+static std::vector<LinePair> makeRandomLinePairs(unsigned int seed,
+                                                 size_t count) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> position(-2, 2);
+    std::vector<LinePair> lines;
+    for (size_t i = 0; i < count; i++) {
+        LinePair l;
+        l.p0 = Pair(position(rng), position(rng));
+        l.p1 = Pair(position(rng), position(rng));
+        l.q0 = Pair(position(rng), position(rng));
+        l.q1 = Pair(position(rng), position(rng));
+        lines.push_back(l);
+    }
+    return lines;
+}
+
+static void BM_CheckLineIntersection(benchmark::State& state) {
+    std::vector<LinePair> lines = makeRandomLinePairs(3, 256);
+    Pair out;
+
+    size_t i = 0;
+    for (auto _ : state) {
+        LinePair const& l = lines[i++ % lines.size()];
+        benchmark::DoNotOptimize(
+            checkLineIntersection(l.p0, l.p1, l.q0, l.q1, out));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_CheckLineIntersection);
+
+// sweeping the first line of each pair to the second, against a point
+static void BM_CheckLineSweep(benchmark::State& state) {
+    std::vector<LinePair> lines = makeRandomLinePairs(4, 256);
+    std::mt19937 rng(5);
+    std::uniform_real_distribution<double> position(-2, 2);
+    std::vector<Pair> points;
+    for (size_t i = 0; i < lines.size(); i++) {
+        points.push_back(Pair(position(rng), position(rng)));
+    }
+    Pair out1, out2;
+
+    size_t i = 0;
+    for (auto _ : state) {
+        size_t n = i++ % lines.size();
+        LinePair const& l = lines[n];
+        benchmark::DoNotOptimize(
+            checkLineSweep(l.p0, l.p1, l.q0, l.q1, points[n], out1, out2));
+    }
+    state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_CheckLineSweep);
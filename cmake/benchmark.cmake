@@ -0,0 +1,27 @@
+# Enable ExternalProject CMake module
+include(ExternalProject)
+
+# Download and build Google Benchmark
+ExternalProject_Add(
+    benchmark
+    URL https://github.com/google/benchmark/archive/v1.4.1.zip
+    PREFIX ${CMAKE_CURRENT_BINARY_DIR}/benchmark
+    CMAKE_ARGS -DCMAKE_BUILD_TYPE=Release
+               -DBENCHMARK_ENABLE_TESTING=OFF
+               -DBENCHMARK_ENABLE_GTEST_TESTS=OFF
+    # Disable install step
+    INSTALL_COMMAND ""
+)
+
+# Create a libbenchmark target to be used as a dependency by benchmarks
+add_library(libbenchmark IMPORTED STATIC GLOBAL)
+add_dependencies(libbenchmark benchmark)
+
+ExternalProject_Get_Property(benchmark source_dir binary_dir)
+set_target_properties(libbenchmark PROPERTIES
+    "IMPORTED_LOCATION" "${binary_dir}/src/${CMAKE_FIND_LIBRARY_PREFIXES}benchmark.a"
+    "IMPORTED_LINK_INTERFACE_LIBRARIES" "${CMAKE_THREAD_LIBS_INIT}"
+)
+
+set(BENCHMARK_INCLUDE_DIR ${source_dir}/include)
+set(BENCHMARK_LIBRARY libbenchmark)
@@ -4,6 +4,8 @@
 // destructors cannot be pure virtual
 Entity::~Entity() {}
 
+void Entity::interpolate(double alpha) {}
+
 AbstractRenderer* Entity::getRenderer() {
     return NULL;
 }
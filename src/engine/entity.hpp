@@ -13,6 +13,10 @@ class Entity {
     virtual void update() = 0;
     virtual void postUpdate() = 0;
 
+    // place the entity for drawing alpha of the way from where it was
+    // before the last update to where it is now
+    virtual void interpolate(double alpha);
+
     virtual AbstractRenderer* getRenderer();
 };
 
@@ -0,0 +1,141 @@
+#include <cmath>
+#include "./fixed.hpp"
+
+#define FIXED_FRACTION_MASK ((int64_t(1) << 32) - 1)
+
+// atan(2^-i) for each CORDIC step, in raw Q32.32
+static const int64_t CORDIC_ANGLES[] = {
+    3373259426, 1991351318, 1052175346, 534100635, 268086748, 134174063,
+    67103403,   33553749,   16777131,   8388597,   4194303,   2097152,
+    1048576,    524288,     262144,     131072,    65536,     32768,
+    16384,      8192,       4096,       2048,      1024,      512,
+    256,        128,        64,         32,        16,        8,
+    4,          2,          1};
+#define CORDIC_STEPS (sizeof(CORDIC_ANGLES) / sizeof(CORDIC_ANGLES[0]))
+
+// 1 / the gain of all the CORDIC steps, pi and pi / 2, in raw Q32.32
+#define CORDIC_INVERSE_GAIN int64_t(2608131496)
+#define FIXED_PI int64_t(13493037705)
+#define FIXED_HALF_PI int64_t(6746518852)
+
+Fixed abs(Fixed v) {
+    return v < 0 ? -v : v;
+}
+
+Fixed floor(Fixed v) {
+    return Fixed::fromRaw(v.getRaw() & ~FIXED_FRACTION_MASK);
+}
+
+Fixed ceil(Fixed v) {
+    return -floor(-v);
+}
+
+Fixed sqrt(Fixed v) {
+    if (v <= 0)
+        return 0;
+
+    // the root of raw * 2^32 is the raw root. Double's sqrt is within one
+    // of it, and is then corrected to exactly the integer root, so the
+    // result doesn't depend on how the estimate was rounded
+    unsigned __int128 square = (unsigned __int128)v.getRaw() << 32;
+    uint64_t root = (uint64_t)std::sqrt((double)square);
+    while ((unsigned __int128)root * root > square)
+        root--;
+    while ((unsigned __int128)(root + 1) * (root + 1) <= square)
+        root++;
+    return Fixed::fromRaw((int64_t)root);
+}
+
+Fixed atan2(Fixed y, Fixed x) {
+    int64_t vx = x.getRaw(), vy = y.getRaw();
+    if (vx == 0 && vy == 0)
+        return 0;
+
+    // scale the vector to the top of the range, which doesn't change its
+    // angle, so small vectors keep their precision and large ones can't
+    // overflow through the gain of the rotations
+    uint64_t magnitude = (vx < 0 ? 0 - (uint64_t)vx : (uint64_t)vx) |
+                         (vy < 0 ? 0 - (uint64_t)vy : (uint64_t)vy);
+    int shift = __builtin_clzll(magnitude) - 3;
+    if (shift > 0) {
+        vx *= int64_t(1) << shift;
+        vy *= int64_t(1) << shift;
+    } else {
+        vx >>= -shift;
+        vy >>= -shift;
+    }
+
+    // CORDIC converges within a quarter turn either side of the x axis
+    int64_t angle = 0;
+    if (vx < 0) {
+        angle = vy >= 0 ? FIXED_PI : -FIXED_PI;
+        vx = -vx;
+        vy = -vy;
+    }
+
+    // rotate onto the x axis, adding up the rotations
+    for (size_t i = 0; i < CORDIC_STEPS; i++) {
+        int64_t dx = vy >> i, dy = vx >> i;
+        if (vy > 0) {
+            vx += dx;
+            vy -= dy;
+            angle += CORDIC_ANGLES[i];
+        } else {
+            vx -= dx;
+            vy += dy;
+            angle -= CORDIC_ANGLES[i];
+        }
+    }
+    return Fixed::fromRaw(angle);
+}
+
+// rotate (1, 0) by angle, leaving its cosine and sine
+static void rotateUnit(Fixed angle, int64_t& cosine, int64_t& sine) {
+    int64_t z = angle.getRaw() % (2 * FIXED_PI);
+    if (z > FIXED_PI)
+        z -= 2 * FIXED_PI;
+    else if (z < -FIXED_PI)
+        z += 2 * FIXED_PI;
+
+    // CORDIC converges within a quarter turn either side of the x axis
+    bool flip = false;
+    if (z > FIXED_HALF_PI) {
+        z -= FIXED_PI;
+        flip = true;
+    } else if (z < -FIXED_HALF_PI) {
+        z += FIXED_PI;
+        flip = true;
+    }
+
+    int64_t vx = CORDIC_INVERSE_GAIN, vy = 0;
+    for (size_t i = 0; i < CORDIC_STEPS; i++) {
+        int64_t dx = vy >> i, dy = vx >> i;
+        if (z >= 0) {
+            vx -= dx;
+            vy += dy;
+            z -= CORDIC_ANGLES[i];
+        } else {
+            vx += dx;
+            vy -= dy;
+            z += CORDIC_ANGLES[i];
+        }
+    }
+    cosine = flip ? -vx : vx;
+    sine = flip ? -vy : vy;
+}
+
+Fixed sin(Fixed angle) {
+    int64_t cosine, sine;
+    rotateUnit(angle, cosine, sine);
+    return Fixed::fromRaw(sine);
+}
+
+Fixed cos(Fixed angle) {
+    int64_t cosine, sine;
+    rotateUnit(angle, cosine, sine);
+    return Fixed::fromRaw(cosine);
+}
+
+std::ostream& operator<<(std::ostream& strm, Fixed v) {
+    return strm << (double)v;
+}
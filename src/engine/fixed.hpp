@@ -0,0 +1,117 @@
+#ifndef __ENGINE_FIXED
+#define __ENGINE_FIXED
+
+#include <stdint.h>
+#include <iostream>
+#include <type_traits>
+
+/**
+ * Signed Q32.32 fixed point number
+ *
+ * Every operation, sqrt, atan2, sin and cos below included, gives a result
+ * defined by integer arithmetic alone, so a simulation on Fixed gives bit
+ * identical results on any compiler, optimization level and cpu. Results
+ * that don't fit saturate instead of wrapping, dividing by zero included.
+ * Converting from double
+ * rounds to nearest and is implicit, so literals and config values mix in
+ * freely; converting back is explicit, so doubles don't silently leak into
+ * the arithmetic.
+ */
+class Fixed {
+    int64_t raw;
+
+    static constexpr int64_t ONE = int64_t(1) << 32;
+
+    static constexpr int64_t saturate(__int128 v) {
+        return v > INT64_MAX ? INT64_MAX
+                             : v < INT64_MIN ? INT64_MIN : (int64_t)v;
+    }
+
+    static constexpr int64_t fromDouble(double v) {
+        return v != v ? 0
+               : v >= 2147483648.0
+                   ? INT64_MAX
+                   : v <= -2147483648.0
+                         ? INT64_MIN
+                         : (int64_t)(v * 4294967296.0 + (v < 0 ? -0.5 : 0.5));
+    }
+
+   public:
+    Fixed() = default;
+    constexpr Fixed(double v) : raw(fromDouble(v)) {}
+    template <typename I,
+              typename = typename std::enable_if<
+                  std::is_integral<I>::value>::type>
+    constexpr Fixed(I v) : raw(saturate((__int128)v * ONE)) {}
+
+    static constexpr Fixed fromRaw(int64_t raw) {
+        return Fixed(raw, true);
+    }
+    constexpr int64_t getRaw() const { return raw; }
+
+    // through double, so converting to an integer truncates
+    template <typename T,
+              typename = typename std::enable_if<
+                  std::is_arithmetic<T>::value>::type>
+    explicit constexpr operator T() const {
+        return (T)(raw / 4294967296.0);
+    }
+
+    friend constexpr Fixed operator+(Fixed a, Fixed b) {
+        return fromRaw(saturate((__int128)a.raw + b.raw));
+    }
+    friend constexpr Fixed operator-(Fixed a, Fixed b) {
+        return fromRaw(saturate((__int128)a.raw - b.raw));
+    }
+    friend constexpr Fixed operator*(Fixed a, Fixed b) {
+        return fromRaw(saturate(((__int128)a.raw * b.raw) >> 32));
+    }
+    friend constexpr Fixed operator/(Fixed a, Fixed b) {
+        return fromRaw(b.raw != 0 ? saturate((__int128)a.raw * ONE / b.raw)
+                       : a.raw > 0 ? INT64_MAX
+                       : a.raw < 0 ? INT64_MIN
+                                   : 0);
+    }
+    constexpr Fixed operator+() const { return *this; }
+    constexpr Fixed operator-() const {
+        return fromRaw(raw == INT64_MIN ? INT64_MAX : -raw);
+    }
+    constexpr bool operator!() const { return raw == 0; }
+
+    Fixed& operator+=(Fixed v) { return *this = *this + v; }
+    Fixed& operator-=(Fixed v) { return *this = *this - v; }
+    Fixed& operator*=(Fixed v) { return *this = *this * v; }
+    Fixed& operator/=(Fixed v) { return *this = *this / v; }
+
+    friend constexpr bool operator==(Fixed a, Fixed b) {
+        return a.raw == b.raw;
+    }
+    friend constexpr bool operator!=(Fixed a, Fixed b) {
+        return a.raw != b.raw;
+    }
+    friend constexpr bool operator<(Fixed a, Fixed b) { return a.raw < b.raw; }
+    friend constexpr bool operator>(Fixed a, Fixed b) { return a.raw > b.raw; }
+    friend constexpr bool operator<=(Fixed a, Fixed b) {
+        return a.raw <= b.raw;
+    }
+    friend constexpr bool operator>=(Fixed a, Fixed b) {
+        return a.raw >= b.raw;
+    }
+
+   private:
+    constexpr Fixed(int64_t raw, bool) : raw(raw) {}
+};
+
+// the math the simulation uses, found by argument dependent lookup when
+// called unqualified. Each is exact to within a few units of the last place
+Fixed abs(Fixed v);
+Fixed floor(Fixed v);
+Fixed ceil(Fixed v);
+Fixed sqrt(Fixed v);
+Fixed atan2(Fixed y, Fixed x);
+Fixed sin(Fixed angle);
+Fixed cos(Fixed angle);
+
+std::ostream& operator<<(std::ostream& strm, Fixed v);
+
+#endif
@@ -0,0 +1,32 @@
+#include <algorithm>
+#include <cmath>
+#include "./fixedtimestep.hpp"
+
+FixedTimestep::FixedTimestep(double step, size_t maxSteps)
+    : step(step), maxSteps(maxSteps) {}
+
+size_t FixedTimestep::advance(double seconds) {
+    accumulator += std::max(0.0, seconds);
+    size_t steps = (size_t)std::floor(accumulator / step);
+    accumulator -= steps * step;
+    // rounding can leave the remainder a hair outside [0, step)
+    accumulator = std::min(std::max(0.0, accumulator), step);
+
+    if (steps > maxSteps) {
+        droppedSteps += steps - maxSteps;
+        steps = maxSteps;
+    }
+    return steps;
+}
+
+double FixedTimestep::interpolation() const {
+    return std::min(1.0, accumulator / step);
+}
+
+double FixedTimestep::getStep() const {
+    return step;
+}
+
+size_t FixedTimestep::getDroppedSteps() const {
+    return droppedSteps;
+}
@@ -0,0 +1,37 @@
+#ifndef __ENGINE_FIXED_TIMESTEP
+#define __ENGINE_FIXED_TIMESTEP
+
+#include <stddef.h>
+
+/**
+ * Splits real time into simulation steps of a fixed length
+ *
+ * Time left over from one frame carries into the next, so the simulation
+ * runs at exactly one step per step length on average, whatever the frame
+ * rate. A frame never runs more than maxSteps steps: time past that is
+ * dropped, so one slow frame can't make the next frames slower still.
+ */
+class FixedTimestep {
+    double step;
+    size_t maxSteps;
+    double accumulator = 0;
+    size_t droppedSteps = 0;
+
+   public:
+    FixedTimestep(double step, size_t maxSteps = 5);
+
+    // add the seconds since the last frame, returning how many steps to
+    // simulate this frame
+    size_t advance(double seconds);
+
+    /** How far the present is from the last step to the next one, between
+     * 0 and 1, for drawing between the last two simulated states
+     */
+    double interpolation() const;
+
+    double getStep() const;
+    // steps skipped so far by frames that hit maxSteps
+    size_t getDroppedSteps() const;
+};
+
+#endif
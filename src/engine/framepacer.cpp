@@ -0,0 +1,131 @@
+#include <algorithm>
+#include <thread>
+#include "./framepacer.hpp"
+
+#define FRAME_TIME_BUCKET_NANOS 10000
+#define FRAME_TIME_BUCKETS 5000
+
+FrameTimeHistogram::FrameTimeHistogram()
+    : buckets(FRAME_TIME_BUCKETS + 1) {}
+
+void FrameTimeHistogram::record(int64_t nanos) {
+    nanos = std::max<int64_t>(0, nanos);
+    size_t bucket = std::min<int64_t>(nanos / FRAME_TIME_BUCKET_NANOS,
+                                      FRAME_TIME_BUCKETS);
+    buckets[bucket]++;
+    count++;
+    totalNanos += nanos;
+    maxNanos = std::max(maxNanos, nanos);
+}
+
+void FrameTimeHistogram::reset() {
+    std::fill(buckets.begin(), buckets.end(), 0);
+    count = 0;
+    totalNanos = 0;
+    maxNanos = 0;
+}
+
+uint64_t FrameTimeHistogram::getCount() const {
+    return count;
+}
+
+int64_t FrameTimeHistogram::getMean() const {
+    return count > 0 ? totalNanos / (int64_t)count : 0;
+}
+
+int64_t FrameTimeHistogram::getMax() const {
+    return maxNanos;
+}
+
+int64_t FrameTimeHistogram::getPercentile(double fraction) const {
+    uint64_t seen = 0;
+    for (size_t i = 0; i < FRAME_TIME_BUCKETS; i++) {
+        seen += buckets[i];
+        if (seen > 0 && seen >= count * fraction) {
+            // the top of the bucket, which the longest duration may be under
+            return std::min<int64_t>((i + 1) * FRAME_TIME_BUCKET_NANOS,
+                                     maxNanos);
+        }
+    }
+    return maxNanos;
+}
+
+std::ostream& operator<<(std::ostream& strm, const FrameTimeHistogram& h) {
+    return strm << "p50 = " << h.getPercentile(0.5) / 1e6
+                << "ms, p99 = " << h.getPercentile(0.99) / 1e6
+                << "ms, max = " << h.getMax() / 1e6 << "ms";
+}
+
+FramePacer::FramePacer(double targetRate, Clock::duration spinThreshold)
+    : spinThreshold(spinThreshold) {
+    setTargetRate(targetRate);
+}
+
+void FramePacer::setTargetRate(double targetRate) {
+    frameLength = targetRate > 0
+                      ? std::chrono::duration_cast<Clock::duration>(
+                            std::chrono::duration<double>(1 / targetRate))
+                      : Clock::duration::zero();
+    started = false;
+}
+
+void FramePacer::setSpinThreshold(Clock::duration spinThreshold) {
+    this->spinThreshold = spinThreshold;
+}
+
+void FramePacer::waitForNextFrame() {
+    Clock::time_point now = Clock::now();
+    // the first frame has no start to time it from
+    bool first = !started;
+    if (first) {
+        nextFrame = now;
+        started = true;
+    } else {
+        workTimes.record(std::chrono::nanoseconds(now - frameStart).count());
+    }
+
+    nextFrame += frameLength;
+    if (now - nextFrame > frameLength) {
+        nextFrame = now;
+    }
+
+    if (nextFrame - now > spinThreshold) {
+        std::this_thread::sleep_for(nextFrame - now - spinThreshold);
+    }
+    // yielding lets other threads have the core without giving it up for
+    // a whole scheduler tick
+    while ((now = Clock::now()) < nextFrame) {
+        std::this_thread::yield();
+    }
+
+    lateness.record(std::chrono::nanoseconds(now - nextFrame).count());
+    if (!first) {
+        frameTimes.record(std::chrono::nanoseconds(now - frameStart).count());
+    }
+    frameStart = now;
+}
+
+FrameTimeHistogram const& FramePacer::getFrameTimes() const {
+    return frameTimes;
+}
+
+FrameTimeHistogram const& FramePacer::getWorkTimes() const {
+    return workTimes;
+}
+
+FrameTimeHistogram const& FramePacer::getLateness() const {
+    return lateness;
+}
+
+void FramePacer::resetTimings() {
+    frameTimes.reset();
+    workTimes.reset();
+    lateness.reset();
+}
+
+void FramePacer::report(std::ostream& out) const {
+    out << "frames: " << frameTimes.getCount() << std::endl;
+    out << "    frame time: " << frameTimes << std::endl;
+    out << "    work time: " << workTimes << std::endl;
+    out << "    lateness: " << lateness << std::endl;
+}
@@ -0,0 +1,87 @@
+#ifndef __ENGINE_FRAME_PACER
+#define __ENGINE_FRAME_PACER
+
+#include <stdint.h>
+#include <chrono>
+#include <iostream>
+#include <vector>
+
+/**
+ * Counts of durations in 10us buckets up to 50ms, with anything longer
+ * counted in a last bucket. The longest duration is kept exactly.
+ */
+class FrameTimeHistogram {
+    std::vector<uint64_t> buckets;
+    uint64_t count = 0;
+    int64_t totalNanos = 0;
+    int64_t maxNanos = 0;
+
+   public:
+    FrameTimeHistogram();
+
+    void record(int64_t nanos);
+    void reset();
+
+    uint64_t getCount() const;
+    int64_t getMean() const;
+    int64_t getMax() const;
+    /** The shortest duration at least fraction of the recorded durations
+     * fit in, to within a bucket. 0 if nothing was recorded
+     */
+    int64_t getPercentile(double fraction) const;
+};
+
+std::ostream& operator<<(std::ostream& strm, const FrameTimeHistogram& h);
+
+/**
+ * Holds frames to a target rate on a monotonic nanosecond clock
+ *
+ * Waiting sleeps until spinThreshold before the next frame is due, as the
+ * OS may oversleep by a scheduler tick, then spins, yielding, for the
+ * rest. Frames are due at a steady cadence from the first one, so a frame
+ * that's a bit late doesn't push back every frame after it; one that's more
+ * than a whole frame late restarts the cadence rather than rushing frames
+ * out to catch up.
+ */
+class FramePacer {
+   public:
+    typedef std::chrono::steady_clock Clock;
+
+   private:
+    Clock::duration frameLength;
+    Clock::duration spinThreshold;
+    Clock::time_point frameStart;
+    Clock::time_point nextFrame;
+    bool started = false;
+
+    // from the start of one frame to the start of the next
+    FrameTimeHistogram frameTimes;
+    // from the start of a frame to when it asked to wait
+    FrameTimeHistogram workTimes;
+    // how long after it was due each frame started
+    FrameTimeHistogram lateness;
+
+   public:
+    // a target rate of 0 doesn't wait at all
+    explicit FramePacer(double targetRate = 60,
+                        Clock::duration spinThreshold =
+                            std::chrono::milliseconds(2));
+
+    void setTargetRate(double targetRate);
+    void setSpinThreshold(Clock::duration spinThreshold);
+
+    /** Record the time taken by the frame that's finishing, then return
+     * once the next frame is due
+     */
+    void waitForNextFrame();
+
+    FrameTimeHistogram const& getFrameTimes() const;
+    FrameTimeHistogram const& getWorkTimes() const;
+    FrameTimeHistogram const& getLateness() const;
+    void resetTimings();
+
+    // write the timings' p50, p99 and max
+    void report(std::ostream& out) const;
+};
+
+#endif
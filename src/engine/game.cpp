@@ -1,5 +1,7 @@
+#include <chrono>
 #include <iostream>
 
+#include "fixedtimestep.hpp"
 #include "game.hpp"
 #include "input/input.hpp"
 #include "util.hpp"
@@ -18,24 +20,17 @@ Game::Game(unsigned int width,
            Scene& initialScene,
            unsigned int zoomLevel)
     : currentScene(&initialScene) {
-    // check if there is an existing global reference to Game. If there is
-    // not, register this as the Game singleton
-    if (EnG != nullptr) {
-        std::cerr << "Tried to create another instance of singleton Game"
-                  << std::endl;
+    makeSingleton();
+
+    // init SDL
+    SDL_SetHint(SDL_HINT_JOYSTICK_ALLOW_BACKGROUND_EVENTS, "1");
+    if (SDL_Init(SDL_INIT_EVERYTHING) != 0) {
+        std::cout << "SDL_Init Error: " << SDL_GetError() << std::endl;
         exit(1);
-    } else {
-        // init SDL
-        SDL_SetHint(SDL_HINT_JOYSTICK_ALLOW_BACKGROUND_EVENTS, "1");
-        if (SDL_Init(SDL_INIT_EVERYTHING) != 0) {
-            std::cout << "SDL_Init Error: " << SDL_GetError() << std::endl;
-            exit(1);
-        }
-        if (TTF_Init() == -1) {
-            printf("TTF_Init: %s\n", TTF_GetError());
-            exit(2);
-        }
-        EnG = this;
+    }
+    if (TTF_Init() == -1) {
+        printf("TTF_Init: %s\n", TTF_GetError());
+        exit(2);
     }
 
     // init input system
@@ -53,8 +48,35 @@ Game::Game(unsigned int width,
     FALLBACK_TEXTURE = loadPNG("assets/fallback.png");
 }
 
+Game::Game(Scene& initialScene)
+    : win(nullptr),
+      ren(nullptr),
+      ctx(nullptr),
+      headless(true),
+      currentScene(&initialScene) {
+    makeSingleton();
+}
+
 Game::~Game() {
-    SDL_Quit();
+    if (!headless) {
+        SDL_Quit();
+    }
+    if (EnG == this) {
+        EnG = nullptr;
+    }
+}
+
+/**
+ * Registers this as the Game singleton, exits program if there already is
+ * one
+ */
+void Game::makeSingleton() {
+    if (EnG != nullptr) {
+        std::cerr << "Tried to create another instance of singleton Game"
+                  << std::endl;
+        exit(1);
+    }
+    EnG = this;
 }
 
 /**
@@ -124,21 +146,18 @@ SDL_Texture* Game::loadPNG(const std::string& file) {
 }
 
 void Game::start() {
-    uint32_t lastTick, thisTick = SDL_GetTicks();
     this->currentScene->init();
-    while (!readyToExit) {
-        lastTick = thisTick;
-        uint32_t thisTick = SDL_GetTicks(), tickDiff = thisTick - lastTick;
 
-        if (this->fixedTickrate == 0) {
-            // figure out the elased milliseconds
-            this->elapsed = (tickDiff / 16.66666);
-        } else {
-            this->elapsed = fixedTickrate;
-        }
+    FixedTimestep timestep(fixedTickrate, maxStepsPerFrame);
+    auto lastFrame = std::chrono::steady_clock::now();
+    while (!readyToExit) {
+        auto thisFrame = std::chrono::steady_clock::now();
+        double seconds =
+            std::chrono::duration<double>(thisFrame - lastFrame).count();
+        lastFrame = thisFrame;
+        this->frameSeconds = seconds;
 
         // Process SDL events
-        input.clear();
         SDL_Event e;
         while (SDL_PollEvent(&e)) {
             // If user closes the window, ready to exit
@@ -149,8 +168,22 @@ void Game::start() {
             input.processEvent(&e);
         }
 
-        // update the game's state
-        currentScene->update();
+        // update the game's state, at fixed steps whatever the frame rate
+        // if there's a fixed tickrate
+        size_t steps = 1;
+        if (this->fixedTickrate == 0) {
+            this->elapsed = seconds * 60;
+            this->interpolation = 1;
+        } else {
+            steps = timestep.advance(seconds);
+            this->elapsed = fixedTickrate;
+            this->interpolation = timestep.interpolation();
+        }
+        for (size_t i = 0; i < steps; i++) {
+            currentScene->update();
+            // the events are only new to the first update that sees them
+            input.clear();
+        }
 
         // update the frame buffer
         glClearColor(0, 0, 0, 1);
@@ -160,11 +193,24 @@ void Game::start() {
 
         SDL_GL_SwapWindow(win);
 
-        // Cap framerate at 60fps
-        long int ticks = (SDL_GetTicks() - thisTick);
-        long long int millis_to_delay = 16 - ticks;
-        SDL_Delay(std::max(0LL, std::min(16LL, millis_to_delay)));
+        pacer.waitForNextFrame();
+    }
+}
+
+double Game::runHeadless(size_t frames) {
+    // with nothing on screen there's no real time to keep up with. A game
+    // without a fixed tickrate steps each frame as if it ran at 60fps
+    this->elapsed = fixedTickrate != 0 ? fixedTickrate : 1;
+
+    this->currentScene->init();
+    auto start = std::chrono::steady_clock::now();
+    for (size_t frame = 0; frame < frames; frame++) {
+        currentScene->update();
     }
+    double seconds = std::chrono::duration<double>(
+                         std::chrono::steady_clock::now() - start)
+                         .count();
+    return frames / seconds;
 }
 
 SDL_Renderer* Game::getRenderer() {
@@ -174,3 +220,7 @@ SDL_Renderer* Game::getRenderer() {
 SDL_Window* Game::getWindow() {
     return win;
 }
+
+FramePacer& Game::getFramePacer() {
+    return pacer;
+}
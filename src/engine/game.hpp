@@ -2,6 +2,7 @@
 #define __ENGINE_GAME
 
 #include "entity.hpp"
+#include "framepacer.hpp"
 #include "input/input.hpp"
 #include "scene.hpp"
 #include <SDL_image.h>
@@ -18,6 +19,11 @@ class Game {
     SDL_Renderer* ren;
     SDL_GLContext ctx;
     bool readyToExit = false;
+    bool headless = false;
+    // caps the frame rate at 60fps unless told otherwise
+    FramePacer pacer;
+
+    void makeSingleton();
 
     SDL_Window* makeWindow(const std::string& name,
                            unsigned int width,
@@ -28,7 +34,15 @@ class Game {
    public:
     // FlxG convenience values
     double elapsed;
+    // seconds each update steps the scene by. 0 updates once per rendered
+    // frame instead, by the 60fps frames since the last one
     double fixedTickrate = 0;
+    // most updates a rendered frame catches up on with a fixed tickrate
+    size_t maxStepsPerFrame = 5;
+    // how far between the last two updates the frame being rendered is
+    double interpolation = 1;
+    // seconds since the last rendered frame, whatever the tickrate
+    double frameSeconds = 0;
     Scene* currentScene;
     Input input;
 
@@ -39,12 +53,23 @@ class Game {
          unsigned int height,
          Scene& initialScene,
          unsigned int zoomLevel = 1);
+    // a game with no window, renderer or GL context, that can only run its
+    // scene with runHeadless
+    explicit Game(Scene& initialScene);
 
     ~Game();
     void start();
 
+    /** Initialize the scene and update it frames times, stepping each frame
+     * by fixedTickrate, as fast as they run and without rendering
+     *
+     * @return how many frames a second were simulated
+     */
+    double runHeadless(size_t frames);
+
     SDL_Renderer* getRenderer();
     SDL_Window* getWindow();
+    FramePacer& getFramePacer();
 };
 
 #endif
@@ -19,7 +19,12 @@ Joystick::Joystick(int numButtons, int numAxies, size_t historySize) {
                   << std::endl;
     }
 
-    // initialize and zero axies values
+    allocate();
+}
+
+// make zeroed history buffers and disabled calibrations for historySize and
+// num_axies
+void Joystick::allocate() {
     axies = new double*[historySize];
     for (size_t i = 0; i < historySize; i++) {
         axies[i] = new double[num_axies];
@@ -44,14 +49,90 @@ Joystick::Joystick(int numButtons, int numAxies, size_t historySize) {
     }
 }
 
-Joystick::~Joystick() {
+void Joystick::release() {
     delete[] heldMask;
     delete[] downMask;
     delete[] upMask;
-    for (size_t i = 0; i < num_axies; i++) {
+    for (size_t i = 0; i < historySize; i++) {
         delete[] axies[i];
     }
     delete[] axies;
+    delete[] axisCalibrations;
+}
+
+Joystick::Joystick(Joystick const& j)
+    : controller(j.controller),
+      historySize(j.historySize),
+      num_axies(j.num_axies) {
+    allocate();
+    *this = j;
+}
+
+Joystick& Joystick::operator=(Joystick const& j) {
+    if (this == &j) {
+        return *this;
+    }
+    if (historySize != j.historySize || num_axies != j.num_axies) {
+        release();
+        historySize = j.historySize;
+        num_axies = j.num_axies;
+        allocate();
+    }
+
+    controller = j.controller;
+    currentHistory = j.currentHistory;
+    for (size_t i = 0; i < historySize; i++) {
+        heldMask[i] = j.heldMask[i];
+        downMask[i] = j.downMask[i];
+        upMask[i] = j.upMask[i];
+        for (size_t y = 0; y < num_axies; y++) {
+            axies[i][y] = j.axies[i][y];
+        }
+    }
+    for (size_t i = 0; i < num_axies; i++) {
+        axisCalibrations[i] = j.axisCalibrations[i];
+    }
+    return *this;
+}
+
+Joystick::~Joystick() {
+    release();
+}
+
+void Joystick::saveHistory(size_t& current,
+                           uint64_t* held,
+                           uint64_t* down,
+                           uint64_t* up,
+                           double* axies) const {
+    current = currentHistory;
+    for (size_t i = 0; i < historySize; i++) {
+        held[i] = heldMask[i];
+        down[i] = downMask[i];
+        up[i] = upMask[i];
+        for (size_t y = 0; y < num_axies; y++) {
+            axies[i * num_axies + y] = this->axies[i][y];
+        }
+    }
+}
+
+void Joystick::restoreHistory(size_t current,
+                              uint64_t const* held,
+                              uint64_t const* down,
+                              uint64_t const* up,
+                              double const* axies) {
+    currentHistory = current;
+    for (size_t i = 0; i < historySize; i++) {
+        heldMask[i] = held[i];
+        downMask[i] = down[i];
+        upMask[i] = up[i];
+        for (size_t y = 0; y < num_axies; y++) {
+            this->axies[i][y] = axies[i * num_axies + y];
+        }
+    }
+}
+
+size_t Joystick::getHistorySize() const {
+    return historySize;
 }
 
 void Joystick::calibrateAxis(unsigned int axisId,
@@ -14,7 +14,7 @@ typedef struct AxisCalibration {
 
 class Joystick {
     friend Input;
-    SDL_Joystick* controller;
+    SDL_Joystick* controller = nullptr;
 
     size_t historySize;
     size_t currentHistory = 0;
@@ -26,6 +26,9 @@ class Joystick {
     double** axies;
     AxisCalibration* axisCalibrations;
 
+    void allocate();
+    void release();
+
    public:
     void setDown(unsigned int buttonId);
     void setUp(unsigned int buttonId);
@@ -34,11 +37,32 @@ class Joystick {
     size_t numAxies();
 
     Joystick(int numButtons, int numAxies, size_t historySize = 10);
+    // copies the history and calibration. Assigning between joysticks of
+    // the same size reuses the history buffers
+    Joystick(Joystick const& j);
+    Joystick& operator=(Joystick const& j);
     ~Joystick();
     void calibrateAxis(unsigned int axisId,
                        double lower,
                        double upper,
                        double neutral);
+
+    /** Copy the history out as flat arrays: historySize masks of each
+     * kind, and historySize rows of numAxies() axis values. Calibrations
+     * aren't part of it
+     */
+    void saveHistory(size_t& current,
+                     uint64_t* held,
+                     uint64_t* down,
+                     uint64_t* up,
+                     double* axies) const;
+    void restoreHistory(size_t current,
+                        uint64_t const* held,
+                        uint64_t const* down,
+                        uint64_t const* up,
+                        double const* axies);
+    size_t getHistorySize() const;
+
     bool up(unsigned int buttonId, int framesBack = 0);
     bool down(unsigned int buttonId, int framesBack = 0);
     bool held(unsigned int buttonId, int framesBack = 0);
@@ -1,54 +1,41 @@
 #ifndef __ENGINE_PAIR
 #define __ENGINE_PAIR
 
-#include <iostream>
-
-class Pair {
-   public:
-    double x;
-    double y;
-
-    double euclid() const;
-
-    Pair();
-    Pair(double x, double y);
-
-    // TODO implement the quake fast inverse sqrt
-    // double euclidApprox();
-    double euclidSquared() const;
-
-    // pairwise new product ops
-    Pair operator+(const Pair& p) const;
-    Pair operator-(const Pair& p) const;
-    Pair operator*(const Pair& p) const;
-    Pair operator/(const Pair& p) const;
-    Pair operator^(const Pair& exp) const;
-
-    // scalar new product ops
-    Pair operator+(const double x) const;
-    Pair operator-(const double x) const;
-    Pair operator*(const double x) const;
-    Pair operator/(const double x) const;
-    Pair operator^(const double exp) const;
-
-    // pairwise mutation ops
-    void operator+=(const Pair& p);
-    void operator-=(const Pair& p);
-    void operator*=(const Pair& p);
-    void operator/=(const Pair& p);
-    void operator^=(const Pair& exp);
-    void operator^=(const double exp);
-    void operator*=(const double factor);
-    void operator/=(const double factor);
+#include <cmath>
+#include "./vec2.hpp"
+#include "./fixed.hpp"
+
+// scalar of the simulation's vectors. Building with SIM_FLOAT halves them,
+// to trade precision for cache and SIMD width. Building with SIM_FIXED makes
+// them fixed point, so that simulations replay identically everywhere
+#if defined(SIM_FIXED)
+typedef Fixed real;
+#elif defined(SIM_FLOAT)
+typedef float real;
+#else
+typedef double real;
+#endif
 
-    // comparators
-    bool operator==(const Pair& p) const;
-    bool operator!=(const Pair& p) const;
+typedef Vec2<real> Pair;
 
-    // defined solely for ordering in sets
-    bool operator<(const Pair& p) const;
-};
+// scalar the collision routines intersect lines in. A float build still
+// intersects in double, a fixed build stays in fixed point
+#ifdef SIM_FIXED
+typedef Fixed wideReal;
+#else
+typedef double wideReal;
+#endif
 
-std::ostream& operator<<(std::ostream& strm, const Pair& p);
+typedef Vec2<wideReal> WidePair;
+
+// the simulation calls these unqualified, so that a fixed build finds
+// Fixed's deterministic versions instead
+using std::abs;
+using std::atan2;
+using std::ceil;
+using std::cos;
+using std::floor;
+using std::sin;
+using std::sqrt;
 
 #endif
@@ -50,6 +50,7 @@ void Scene::render() {
     glm::mat4 matrix = projectionMatrix * cameraMatrix;
 
     for (Entity* e : this->entities) {
+        e->interpolate(EnG->interpolation);
         AbstractRenderer* r = e->getRenderer();
         if (r) {
             r->render(matrix);
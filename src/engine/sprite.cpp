@@ -35,19 +35,19 @@ void Sprite::updateMotion() {
     }
 
     // update x position
-    vdelta =
-        (computeVelocity(velocity.x, acceleration.x, drag.x, maxVelocity.x) -
-         velocity.x) /
-        2;
+    vdelta = (computeVelocity((double)velocity.x, (double)acceleration.x,
+                              (double)drag.x, (double)maxVelocity.x) -
+              (double)velocity.x) /
+             2;
     velocity.x += vdelta;
     position.x += velocity.x * EnG->elapsed;
     velocity.x += vdelta;
 
     // update y position
-    vdelta =
-        (computeVelocity(velocity.y, acceleration.y, drag.y, maxVelocity.y) -
-         velocity.y) /
-        2;
+    vdelta = (computeVelocity((double)velocity.y, (double)acceleration.y,
+                              (double)drag.y, (double)maxVelocity.y) -
+              (double)velocity.y) /
+             2;
     velocity.y += vdelta;
     position.y += velocity.y * EnG->elapsed;
     velocity.y += vdelta;
@@ -0,0 +1,98 @@
+#ifndef __ENGINE_TABLE
+#define __ENGINE_TABLE
+
+#include <vector>
+#include <utility>
+#include <stddef.h>
+
+/**
+ * Read-only array that either owns its elements or borrows them from memory
+ * owned by someone else, such as a memory mapped file
+ *
+ * Tables built at runtime own a vector. Tables loaded from a compiled stage
+ * point straight into the file, so loading does not copy or allocate.
+ * Mutating a borrowed table first copies the elements it borrows.
+ */
+template <typename T>
+class Table {
+    std::vector<T> owned;
+    T const* borrowed = NULL;
+    size_t borrowedSize = 0;
+    bool isBorrowing = false;
+
+    void own() {
+        if (isBorrowing) {
+            owned.assign(borrowed, borrowed + borrowedSize);
+            isBorrowing = false;
+        }
+    }
+
+   public:
+    typedef T value_type;
+    typedef T const* iterator;
+    typedef T const* const_iterator;
+
+    Table() {}
+    Table(std::vector<T> elements) : owned(std::move(elements)) {}
+
+    T const* data() const {
+        return isBorrowing ? borrowed : owned.data();
+    }
+    size_t size() const {
+        return isBorrowing ? borrowedSize : owned.size();
+    }
+    bool empty() const { return size() == 0; }
+    bool isBorrowed() const { return isBorrowing; }
+
+    T const& operator[](size_t i) const { return data()[i]; }
+    T const& back() const { return data()[size() - 1]; }
+    T const* begin() const { return data(); }
+    T const* end() const { return data() + size(); }
+
+    // copies the elements of a borrowed table, so they can be written to
+    T* mutableData() {
+        own();
+        return owned.data();
+    }
+
+    void assign(std::vector<T> elements) {
+        owned = std::move(elements);
+        isBorrowing = false;
+    }
+
+    // elements must outlive the table and every copy of it
+    void borrow(T const* elements, size_t count) {
+        owned.clear();
+        borrowed = elements;
+        borrowedSize = count;
+        isBorrowing = true;
+    }
+
+    void clear() {
+        owned.clear();
+        isBorrowing = false;
+    }
+
+    void push_back(T const& element) {
+        own();
+        owned.push_back(element);
+    }
+};
+
+template <typename T>
+bool operator==(std::vector<T> const& a, Table<T> const& b) {
+    if (a.size() != b.size())
+        return false;
+    for (size_t i = 0; i < a.size(); i++) {
+        if (!(a[i] == b[i]))
+            return false;
+    }
+    return true;
+}
+
+template <typename T>
+bool operator==(Table<T> const& a, std::vector<T> const& b) {
+    return b == a;
+}
+
+#endif
@@ -0,0 +1,115 @@
+#ifndef __ENGINE_VEC2
+#define __ENGINE_VEC2
+
+#include <cmath>
+#include <iostream>
+
+// how close two components must be to compare equal
+#define VEC2_EPSILON 0.00001
+
+/**
+ * Two component vector of T
+ *
+ * Everything is defined here so that the arithmetic inlines wherever it's
+ * used, and is constexpr where C++11 allows it. The default constructor
+ * leaves the components uninitialized, which keeps Vec2 trivial so tables
+ * of them can be copied and mapped from files as plain memory.
+ */
+template <typename T>
+class Vec2 {
+    static constexpr T absolute(T v) { return v < 0 ? -v : v; }
+
+   public:
+    typedef T Scalar;
+
+    T x;
+    T y;
+
+    Vec2() = default;
+    constexpr Vec2(T x, T y) : x(x), y(y) {}
+
+    T euclid() const {
+        using std::sqrt;
+        return sqrt(x * x + y * y);
+    }
+    constexpr T euclidSquared() const { return x * x + y * y; }
+
+    // pairwise new product ops
+    constexpr Vec2 operator+(Vec2 const& p) const {
+        return Vec2(x + p.x, y + p.y);
+    }
+    constexpr Vec2 operator-(Vec2 const& p) const {
+        return Vec2(x - p.x, y - p.y);
+    }
+    constexpr Vec2 operator*(Vec2 const& p) const {
+        return Vec2(x * p.x, y * p.y);
+    }
+    constexpr Vec2 operator/(Vec2 const& p) const {
+        return Vec2(x / p.x, y / p.y);
+    }
+    Vec2 operator^(Vec2 const& exp) const {
+        return Vec2(std::pow(x, exp.x), std::pow(y, exp.y));
+    }
+
+    // scalar new product ops
+    constexpr Vec2 operator+(T z) const { return Vec2(x + z, y + z); }
+    constexpr Vec2 operator-(T z) const { return Vec2(x - z, y - z); }
+    constexpr Vec2 operator*(T z) const { return Vec2(x * z, y * z); }
+    constexpr Vec2 operator/(T z) const { return Vec2(x / z, y / z); }
+    Vec2 operator^(T exp) const {
+        return Vec2(std::pow(x, exp), std::pow(y, exp));
+    }
+
+    // pairwise mutation ops
+    void operator+=(Vec2 const& p) {
+        x += p.x;
+        y += p.y;
+    }
+    void operator-=(Vec2 const& p) {
+        x -= p.x;
+        y -= p.y;
+    }
+    void operator*=(Vec2 const& p) {
+        x *= p.x;
+        y *= p.y;
+    }
+    void operator/=(Vec2 const& p) {
+        x /= p.x;
+        y /= p.y;
+    }
+    void operator^=(Vec2 const& exp) {
+        x = std::pow(x, exp.x);
+        y = std::pow(y, exp.y);
+    }
+    void operator^=(T exp) {
+        x = std::pow(x, exp);
+        y = std::pow(y, exp);
+    }
+    void operator*=(T factor) {
+        x = x * factor;
+        y = y * factor;
+    }
+    void operator/=(T factor) {
+        x = x / factor;
+        y = y / factor;
+    }
+
+    // comparators
+    constexpr bool operator==(Vec2 const& p) const {
+        return absolute(p.x - x) < VEC2_EPSILON &&
+               absolute(p.y - y) < VEC2_EPSILON;
+    }
+    constexpr bool operator!=(Vec2 const& p) const { return !(*this == p); }
+
+    // defined solely for ordering in sets
+    constexpr bool operator<(Vec2 const& p) const {
+        return (x < p.x) || (x == p.x && y < p.y);
+    }
+};
+
+template <typename T>
+std::ostream& operator<<(std::ostream& strm, Vec2<T> const& p) {
+    return strm << "Pair(" << p.x << ", " << p.y << ")";
+}
+
+#endif
@@ -0,0 +1,85 @@
+#include "./workerpool.hpp"
+#include <algorithm>
+
+WorkerPool::WorkerPool(size_t workers) : nextItem(0) {
+    if (workers == 0) {
+        workers = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    for (size_t i = 1; i < workers; i++) {
+        threads.push_back(std::thread(&WorkerPool::work, this, i));
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    wake.notify_all();
+    for (std::thread& t : threads) {
+        t.join();
+    }
+}
+
+size_t WorkerPool::size() const {
+    return threads.size() + 1;
+}
+
+void WorkerPool::runItems(size_t worker) {
+    size_t item;
+    while ((item = nextItem.fetch_add(1)) < jobSize) {
+        (*job)(item, worker);
+    }
+}
+
+void WorkerPool::work(size_t worker) {
+    size_t seenGeneration = 0;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&] {
+                return stopping || generation != seenGeneration;
+            });
+            if (stopping)
+                return;
+            seenGeneration = generation;
+        }
+
+        runItems(worker);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            busyWorkers--;
+        }
+        finished.notify_one();
+    }
+}
+
+void WorkerPool::run(size_t count, Job const& newJob) {
+    if (count == 0)
+        return;
+
+    if (threads.empty() || count == 1) {
+        for (size_t i = 0; i < count; i++) {
+            newJob(i, 0);
+        }
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        job = &newJob;
+        jobSize = count;
+        nextItem = 0;
+        busyWorkers = threads.size();
+        generation++;
+    }
+    wake.notify_all();
+
+    runItems(0);
+
+    std::unique_lock<std::mutex> lock(mutex);
+    finished.wait(lock, [&] { return busyWorkers == 0; });
+    job = NULL;
+}
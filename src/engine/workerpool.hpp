@@ -0,0 +1,59 @@
+#ifndef __ENGINE_WORKER_POOL
+#define __ENGINE_WORKER_POOL
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <stddef.h>
+
+/**
+ * Fixed set of threads for running parallel loops
+ *
+ * The thread calling run() takes part in the loop as worker 0, so a pool
+ * of size 1 starts no threads and runs everything inline.
+ */
+class WorkerPool {
+   public:
+    // called with the index of the item to process, and the index of the
+    // worker processing it
+    typedef std::function<void(size_t item, size_t worker)> Job;
+
+   private:
+    std::vector<std::thread> threads;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable finished;
+
+    Job const* job = NULL;
+    size_t jobSize = 0;
+    std::atomic<size_t> nextItem;
+    size_t generation = 0;
+    size_t busyWorkers = 0;
+    bool stopping = false;
+
+    void work(size_t worker);
+    void runItems(size_t worker);
+
+   public:
+    // 0 uses one worker per hardware thread
+    explicit WorkerPool(size_t workers = 0);
+    ~WorkerPool();
+
+    WorkerPool(WorkerPool const&) = delete;
+    WorkerPool& operator=(WorkerPool const&) = delete;
+
+    size_t size() const;
+
+    /** Call job for every item in [0, count), returning once all are done
+     *
+     * Items are handed out dynamically, so which worker runs an item is not
+     * deterministic. Jobs must only rely on the worker index to pick
+     * per-worker scratch memory.
+     */
+    void run(size_t count, Job const& job);
+};
+
+#endif
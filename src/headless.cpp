@@ -0,0 +1,79 @@
+#include <cstdlib>
+#include <iostream>
+#include <unistd.h>
+
+#include "engine/game.hpp"
+#include "player/playerconfig.hpp"
+#include "scenes/simscene.hpp"
+#include "terrain/map.hpp"
+
+using namespace Terrain;
+
+static void usage(char const* name) {
+    std::cerr << "usage: " << name
+              << " [-m stage] [-p players] [-f frames] [-s seed]"
+                 " [-t tickrate] [-j workers]"
+              << std::endl;
+}
+
+/** Run players on random inputs around a stage with no window, GL context
+ * or frame cap, and report how many frames a second the simulation ran
+ *
+ * Players log to stdout, so the report goes to stderr.
+ */
+int main(int argc, char** argv) {
+    std::string stagePath = "assets/main.stage";
+    size_t numPlayers = 4, frames = 3600, workers = 1;
+    unsigned int seed = 1;
+    double tickrate = 1.0 / 60.0;
+    int opt;
+    while ((opt = getopt(argc, argv, "m:p:f:s:t:j:")) != -1) {
+        switch (opt) {
+            case 'm':
+                stagePath = optarg;
+                break;
+            case 'p':
+                numPlayers = std::strtoul(optarg, NULL, 10);
+                break;
+            case 'f':
+                frames = std::strtoul(optarg, NULL, 10);
+                break;
+            case 's':
+                seed = std::strtoul(optarg, NULL, 10);
+                break;
+            case 't':
+                tickrate = std::atof(optarg);
+                break;
+            case 'j':
+                workers = std::max(1ul, std::strtoul(optarg, NULL, 10));
+                break;
+            default:
+                usage(argv[0]);
+                return 2;
+        }
+    }
+    if (optind != argc) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    Map* map = Map::load(stagePath);
+    if (!map) {
+        return 1;
+    }
+    PlayerConfig config("assets/attributes.yaml");
+    SimScene scene(*map, config, numPlayers, seed, workers);
+
+    Game game(scene);
+    game.fixedTickrate = tickrate;
+    double framesPerSecond = game.runHeadless(frames);
+
+    std::cerr << "frames: " << frames << " of " << numPlayers
+              << " players at " << framesPerSecond << " frames/s ("
+              << framesPerSecond * numPlayers << " player frames/s on "
+              << workers << " workers)" << std::endl;
+    std::cerr << "respawned: " << scene.getRespawns() << std::endl;
+
+    delete map;
+    return 0;
+}
@@ -0,0 +1,415 @@
+#include <cmath>
+#include <limits>
+#include "./linebatch.hpp"
+#include "./util.hpp"
+
+#if defined(__SSE2__) && !defined(SIM_FIXED)
+#include <emmintrin.h>
+#define LINE_BATCH_HAS_SSE2
+#endif
+
+#if defined(__GNUC__) && defined(__x86_64__) && !defined(SIM_FIXED)
+#include <immintrin.h>
+#define LINE_BATCH_HAS_AVX2
+#endif
+
+// The vector kernels mirror checkLineIntersectionPrecise operation for
+// operation (no fused multiply-add) so that every lane computes the same
+// distance the scalar code would. Lanes are always double, whatever real
+// the segments are stored as. The winning segment is then rerun through
+// checkLineIntersection to fill in the hit point and direction. A fixed
+// point build only has the scalar loop.
+
+void SegmentArrays::clear() {
+    x1.clear();
+    y1.clear();
+    x2.clear();
+    y2.clear();
+}
+
+void SegmentArrays::push(Pair const& first, Pair const& second) {
+    x1.push_back(first.x);
+    y1.push_back(first.y);
+    x2.push_back(second.x);
+    y2.push_back(second.y);
+}
+
+void SegmentArrays::set(size_t i, Pair const& first, Pair const& second) {
+    x1.mutableData()[i] = first.x;
+    y1.mutableData()[i] = first.y;
+    x2.mutableData()[i] = second.x;
+    y2.mutableData()[i] = second.y;
+}
+
+size_t SegmentArrays::size() const {
+    return x1.size();
+}
+
+static inline size_t batchId(size_t const* ids, size_t k) {
+    return ids ? ids[k] : k;
+}
+
+static inline bool directionMatches(int direction, int requiredDirection) {
+    if (!direction)
+        return false;
+    return !requiredDirection || direction == requiredDirection;
+}
+
+// test items [begin, end) one at a time, keeping the closest hit
+static void batchScalar(Pair const& p0,
+                        Pair const& p1,
+                        SegmentArrays const& s,
+                        size_t const* ids,
+                        size_t begin,
+                        size_t end,
+                        int requiredDirection,
+                        wideReal epsilon,
+                        size_t& bestK,
+                        wideReal& bestDist) {
+    WidePair point;
+    WidePair start = WidePair(p0.x, p0.y);
+    for (size_t k = begin; k < end; k++) {
+        size_t i = batchId(ids, k);
+        int direction = checkLineIntersectionPrecise(
+            p0, p1, Pair(s.x1[i], s.y1[i]), Pair(s.x2[i], s.y2[i]), point,
+            epsilon);
+        if (!directionMatches(direction, requiredDirection))
+            continue;
+
+        wideReal distance = (point - start).euclid();
+        if (distance < bestDist) {
+            bestDist = distance;
+            bestK = k;
+        }
+    }
+}
+
+#ifdef LINE_BATCH_HAS_SSE2
+// two consecutive coordinates, widened to double
+static inline __m128d sse2Load(double const* p) {
+    return _mm_loadu_pd(p);
+}
+
+static inline __m128d sse2Load(float const* p) {
+    return _mm_cvtps_pd(_mm_castsi128_ps(_mm_loadl_epi64((__m128i const*)p)));
+}
+
+static inline __m128d sse2Select(__m128d mask, __m128d a, __m128d b) {
+    return _mm_or_pd(_mm_and_pd(mask, a), _mm_andnot_pd(mask, b));
+}
+
+static void batchSse2(Pair const& p0,
+                      Pair const& p1,
+                      SegmentArrays const& s,
+                      size_t const* ids,
+                      size_t count,
+                      int requiredDirection,
+                      double epsilon,
+                      size_t& bestK,
+                      double& bestDist) {
+    const __m128d zero = _mm_setzero_pd();
+    const __m128d one = _mm_set1_pd(1.0);
+    const __m128d eps = _mm_set1_pd(epsilon);
+    const __m128d negEps = _mm_set1_pd(-epsilon);
+    const __m128d p0x = _mm_set1_pd(p0.x), p0y = _mm_set1_pd(p0.y);
+    const __m128d p1x = _mm_set1_pd(p1.x), p1y = _mm_set1_pd(p1.y);
+    const __m128d ax = _mm_set1_pd((double)p1.x - p0.x);
+    const __m128d ay = _mm_set1_pd((double)p1.y - p0.y);
+
+    __m128d laneDist = _mm_set1_pd(std::numeric_limits<double>::infinity());
+    __m128d laneK = _mm_set1_pd(-1.0);
+
+    size_t k = 0;
+    for (; k + 2 <= count; k += 2) {
+        __m128d x2, y2, x3, y3;
+        if (ids) {
+            size_t i0 = ids[k], i1 = ids[k + 1];
+            x2 = _mm_set_pd(s.x1[i1], s.x1[i0]);
+            y2 = _mm_set_pd(s.y1[i1], s.y1[i0]);
+            x3 = _mm_set_pd(s.x2[i1], s.x2[i0]);
+            y3 = _mm_set_pd(s.y2[i1], s.y2[i0]);
+        } else {
+            x2 = sse2Load(&s.x1[k]);
+            y2 = sse2Load(&s.y1[k]);
+            x3 = sse2Load(&s.x2[k]);
+            y3 = sse2Load(&s.y2[k]);
+        }
+
+        __m128d bx = _mm_sub_pd(x3, x2);
+        __m128d by = _mm_sub_pd(y3, y2);
+        __m128d f = _mm_sub_pd(_mm_mul_pd(ay, bx), _mm_mul_pd(ax, by));
+        __m128d cx = _mm_sub_pd(x3, p1x);
+        __m128d cy = _mm_sub_pd(y3, p1y);
+        __m128d aa = _mm_sub_pd(_mm_mul_pd(ay, cx), _mm_mul_pd(ax, cy));
+        __m128d bb = _mm_sub_pd(_mm_mul_pd(by, cx), _mm_mul_pd(bx, cy));
+
+        __m128d fLow = _mm_sub_pd(f, eps);
+        __m128d fHigh = _mm_add_pd(f, eps);
+
+        __m128d rejectNeg = _mm_or_pd(
+            _mm_or_pd(_mm_cmpgt_pd(aa, eps), _mm_cmpgt_pd(bb, eps)),
+            _mm_or_pd(_mm_cmplt_pd(aa, fLow), _mm_cmplt_pd(bb, fLow)));
+        __m128d rejectPos = _mm_or_pd(
+            _mm_or_pd(_mm_cmplt_pd(aa, negEps), _mm_cmplt_pd(bb, negEps)),
+            _mm_or_pd(_mm_cmpgt_pd(aa, fHigh), _mm_cmpgt_pd(bb, fHigh)));
+
+        // f < 0 hits in direction 1, f > 0 in direction -1
+        __m128d hitNeg = _mm_andnot_pd(rejectNeg, _mm_cmplt_pd(f, zero));
+        __m128d hitPos = _mm_andnot_pd(rejectPos, _mm_cmpgt_pd(f, zero));
+        __m128d hit = requiredDirection > 0
+                          ? hitNeg
+                          : requiredDirection < 0 ? hitPos
+                                                  : _mm_or_pd(hitNeg, hitPos);
+        if (!_mm_movemask_pd(hit))
+            continue;
+
+        __m128d r = _mm_max_pd(
+            _mm_sub_pd(one, _mm_min_pd(_mm_div_pd(aa, f), one)), zero);
+        __m128d dx = _mm_sub_pd(_mm_add_pd(_mm_mul_pd(bx, r), x2), p0x);
+        __m128d dy = _mm_sub_pd(_mm_add_pd(_mm_mul_pd(by, r), y2), p0y);
+        __m128d dist = _mm_sqrt_pd(
+            _mm_add_pd(_mm_mul_pd(dx, dx), _mm_mul_pd(dy, dy)));
+
+        __m128d better = _mm_and_pd(hit, _mm_cmplt_pd(dist, laneDist));
+        laneDist = sse2Select(better, dist, laneDist);
+        laneK = sse2Select(better, _mm_set_pd(k + 1, k), laneK);
+    }
+
+    double dists[2], ks[2];
+    _mm_storeu_pd(dists, laneDist);
+    _mm_storeu_pd(ks, laneK);
+    for (int lane = 0; lane < 2; lane++) {
+        if (ks[lane] < 0)
+            continue;
+        size_t laneBest = (size_t)ks[lane];
+        if (dists[lane] < bestDist ||
+            (dists[lane] == bestDist && laneBest < bestK)) {
+            bestDist = dists[lane];
+            bestK = laneBest;
+        }
+    }
+
+    batchScalar(p0, p1, s, ids, k, count, requiredDirection, epsilon, bestK,
+                bestDist);
+}
+#endif
+
+#ifdef LINE_BATCH_HAS_AVX2
+// four consecutive or gathered coordinates, widened to double
+__attribute__((target("avx2"))) static inline __m256d avx2Load(
+    double const* p) {
+    return _mm256_loadu_pd(p);
+}
+
+__attribute__((target("avx2"))) static inline __m256d avx2Load(
+    float const* p) {
+    return _mm256_cvtps_pd(_mm_loadu_ps(p));
+}
+
+__attribute__((target("avx2"))) static inline __m256d avx2Gather(
+    double const* p,
+    __m256i idx) {
+    return _mm256_i64gather_pd(p, idx, 8);
+}
+
+__attribute__((target("avx2"))) static inline __m256d avx2Gather(
+    float const* p,
+    __m256i idx) {
+    return _mm256_cvtps_pd(_mm256_i64gather_ps(p, idx, 4));
+}
+
+__attribute__((target("avx2"))) static void batchAvx2(
+    Pair const& p0,
+    Pair const& p1,
+    SegmentArrays const& s,
+    size_t const* ids,
+    size_t count,
+    int requiredDirection,
+    double epsilon,
+    size_t& bestK,
+    double& bestDist) {
+    const __m256d zero = _mm256_setzero_pd();
+    const __m256d one = _mm256_set1_pd(1.0);
+    const __m256d eps = _mm256_set1_pd(epsilon);
+    const __m256d negEps = _mm256_set1_pd(-epsilon);
+    const __m256d p0x = _mm256_set1_pd(p0.x), p0y = _mm256_set1_pd(p0.y);
+    const __m256d p1x = _mm256_set1_pd(p1.x), p1y = _mm256_set1_pd(p1.y);
+    const __m256d ax = _mm256_set1_pd((double)p1.x - p0.x);
+    const __m256d ay = _mm256_set1_pd((double)p1.y - p0.y);
+    const __m256d laneOffsets = _mm256_set_pd(3, 2, 1, 0);
+
+    __m256d laneDist =
+        _mm256_set1_pd(std::numeric_limits<double>::infinity());
+    __m256d laneK = _mm256_set1_pd(-1.0);
+
+    size_t k = 0;
+    for (; k + 4 <= count; k += 4) {
+        __m256d x2, y2, x3, y3;
+        if (ids) {
+            __m256i idx = _mm256_loadu_si256((__m256i const*)(ids + k));
+            x2 = avx2Gather(s.x1.data(), idx);
+            y2 = avx2Gather(s.y1.data(), idx);
+            x3 = avx2Gather(s.x2.data(), idx);
+            y3 = avx2Gather(s.y2.data(), idx);
+        } else {
+            x2 = avx2Load(&s.x1[k]);
+            y2 = avx2Load(&s.y1[k]);
+            x3 = avx2Load(&s.x2[k]);
+            y3 = avx2Load(&s.y2[k]);
+        }
+
+        __m256d bx = _mm256_sub_pd(x3, x2);
+        __m256d by = _mm256_sub_pd(y3, y2);
+        __m256d f =
+            _mm256_sub_pd(_mm256_mul_pd(ay, bx), _mm256_mul_pd(ax, by));
+        __m256d cx = _mm256_sub_pd(x3, p1x);
+        __m256d cy = _mm256_sub_pd(y3, p1y);
+        __m256d aa =
+            _mm256_sub_pd(_mm256_mul_pd(ay, cx), _mm256_mul_pd(ax, cy));
+        __m256d bb =
+            _mm256_sub_pd(_mm256_mul_pd(by, cx), _mm256_mul_pd(bx, cy));
+
+        __m256d fLow = _mm256_sub_pd(f, eps);
+        __m256d fHigh = _mm256_add_pd(f, eps);
+
+        __m256d rejectNeg =
+            _mm256_or_pd(_mm256_or_pd(_mm256_cmp_pd(aa, eps, _CMP_GT_OQ),
+                                      _mm256_cmp_pd(bb, eps, _CMP_GT_OQ)),
+                         _mm256_or_pd(_mm256_cmp_pd(aa, fLow, _CMP_LT_OQ),
+                                      _mm256_cmp_pd(bb, fLow, _CMP_LT_OQ)));
+        __m256d rejectPos =
+            _mm256_or_pd(_mm256_or_pd(_mm256_cmp_pd(aa, negEps, _CMP_LT_OQ),
+                                      _mm256_cmp_pd(bb, negEps, _CMP_LT_OQ)),
+                         _mm256_or_pd(_mm256_cmp_pd(aa, fHigh, _CMP_GT_OQ),
+                                      _mm256_cmp_pd(bb, fHigh, _CMP_GT_OQ)));
+
+        __m256d hitNeg =
+            _mm256_andnot_pd(rejectNeg, _mm256_cmp_pd(f, zero, _CMP_LT_OQ));
+        __m256d hitPos =
+            _mm256_andnot_pd(rejectPos, _mm256_cmp_pd(f, zero, _CMP_GT_OQ));
+        __m256d hit = requiredDirection > 0
+                          ? hitNeg
+                          : requiredDirection < 0
+                                ? hitPos
+                                : _mm256_or_pd(hitNeg, hitPos);
+        if (!_mm256_movemask_pd(hit))
+            continue;
+
+        __m256d r = _mm256_max_pd(
+            _mm256_sub_pd(one, _mm256_min_pd(_mm256_div_pd(aa, f), one)),
+            zero);
+        __m256d dx =
+            _mm256_sub_pd(_mm256_add_pd(_mm256_mul_pd(bx, r), x2), p0x);
+        __m256d dy =
+            _mm256_sub_pd(_mm256_add_pd(_mm256_mul_pd(by, r), y2), p0y);
+        __m256d dist = _mm256_sqrt_pd(
+            _mm256_add_pd(_mm256_mul_pd(dx, dx), _mm256_mul_pd(dy, dy)));
+
+        __m256d better =
+            _mm256_and_pd(hit, _mm256_cmp_pd(dist, laneDist, _CMP_LT_OQ));
+        laneDist = _mm256_blendv_pd(laneDist, dist, better);
+        laneK = _mm256_blendv_pd(
+            laneK, _mm256_add_pd(_mm256_set1_pd(k), laneOffsets), better);
+    }
+
+    double dists[4], ks[4];
+    _mm256_storeu_pd(dists, laneDist);
+    _mm256_storeu_pd(ks, laneK);
+    // the rest of the program is compiled without avx, clear the upper
+    // register halves to avoid a state transition penalty in sse code
+    _mm256_zeroupper();
+    for (int lane = 0; lane < 4; lane++) {
+        if (ks[lane] < 0)
+            continue;
+        size_t laneBest = (size_t)ks[lane];
+        if (dists[lane] < bestDist ||
+            (dists[lane] == bestDist && laneBest < bestK)) {
+            bestDist = dists[lane];
+            bestK = laneBest;
+        }
+    }
+
+    batchScalar(p0, p1, s, ids, k, count, requiredDirection, epsilon, bestK,
+                bestDist);
+}
+#endif
+
+bool isLineBatchImplSupported(LineBatchImpl impl) {
+    switch (impl) {
+        case LINE_BATCH_AUTO:
+        case LINE_BATCH_SCALAR:
+            return true;
+#ifdef LINE_BATCH_HAS_SSE2
+        case LINE_BATCH_SSE2:
+            return true;
+#endif
+#ifdef LINE_BATCH_HAS_AVX2
+        case LINE_BATCH_AVX2:
+            return __builtin_cpu_supports("avx2");
+#endif
+        default:
+            return false;
+    }
+}
+
+static LineBatchImpl bestLineBatchImpl() {
+    if (isLineBatchImplSupported(LINE_BATCH_AVX2))
+        return LINE_BATCH_AVX2;
+    if (isLineBatchImplSupported(LINE_BATCH_SSE2))
+        return LINE_BATCH_SSE2;
+    return LINE_BATCH_SCALAR;
+}
+
+static LineBatchImpl lineBatchImpl = bestLineBatchImpl();
+
+void setLineBatchImpl(LineBatchImpl impl) {
+    if (impl == LINE_BATCH_AUTO || !isLineBatchImplSupported(impl))
+        impl = bestLineBatchImpl();
+    lineBatchImpl = impl;
+}
+
+LineBatchImpl getLineBatchImpl() {
+    return lineBatchImpl;
+}
+
+bool checkLineIntersectionBatch(Pair const& p0,
+                                Pair const& p1,
+                                SegmentArrays const& segments,
+                                size_t const* ids,
+                                size_t count,
+                                int requiredDirection,
+                                LineHit& out,
+                                wideReal epsilon) {
+    size_t bestK = count;
+    wideReal bestDist = std::numeric_limits<double>::infinity();
+
+    switch (lineBatchImpl) {
+#ifdef LINE_BATCH_HAS_AVX2
+        case LINE_BATCH_AVX2:
+            batchAvx2(p0, p1, segments, ids, count, requiredDirection,
+                      epsilon, bestK, bestDist);
+            break;
+#endif
+#ifdef LINE_BATCH_HAS_SSE2
+        case LINE_BATCH_SSE2:
+            batchSse2(p0, p1, segments, ids, count, requiredDirection,
+                      epsilon, bestK, bestDist);
+            break;
+#endif
+        default:
+            batchScalar(p0, p1, segments, ids, 0, count, requiredDirection,
+                        epsilon, bestK, bestDist);
+            break;
+    }
+
+    if (bestK == count)
+        return false;
+
+    size_t i = batchId(ids, bestK);
+    out.index = i;
+    out.distance = bestDist;
+    out.direction = checkLineIntersection(
+        p0, p1, Pair(segments.x1[i], segments.y1[i]),
+        Pair(segments.x2[i], segments.y2[i]), out.point, epsilon);
+    return true;
+}
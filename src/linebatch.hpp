@@ -0,0 +1,67 @@
+#ifndef __GAME_LINE_BATCH
+#define __GAME_LINE_BATCH
+
+#include <vector>
+#include <stddef.h>
+#include "engine/pair.hpp"
+#include "engine/table.hpp"
+
+/**
+ * Line segments stored as a structure of arrays, so that a single sweep can
+ * be tested against several segments at once
+ */
+class SegmentArrays {
+   public:
+    Table<real> x1, y1, x2, y2;
+
+    void clear();
+    void push(Pair const& first, Pair const& second);
+    void set(size_t i, Pair const& first, Pair const& second);
+    size_t size() const;
+};
+
+/** Nearest hit of a batched intersection test */
+class LineHit {
+   public:
+    // index of the hit segment in the SegmentArrays
+    size_t index;
+    Pair point;
+    int direction;
+    wideReal distance;
+};
+
+typedef enum LineBatchImpl {
+    LINE_BATCH_AUTO,
+    LINE_BATCH_SCALAR,
+    LINE_BATCH_SSE2,
+    LINE_BATCH_AVX2,
+} LineBatchImpl;
+
+/**
+ * Test the line p0..p1 against many segments, and find the hit closest to p0
+ *
+ * Each segment is tested exactly as checkLineIntersectionPrecise(p0, p1,
+ * first, second) would, and only hits in requiredDirection are considered (any
+ * direction if requiredDirection is 0). When several hits are equally
+ * close, the one appearing first in the batch wins.
+ *
+ * @param ids the segments to test, or NULL to test the first count segments
+ * @return if any segment was hit
+ */
+bool checkLineIntersectionBatch(Pair const& p0,
+                                Pair const& p1,
+                                SegmentArrays const& segments,
+                                size_t const* ids,
+                                size_t count,
+                                int requiredDirection,
+                                LineHit& out,
+                                wideReal epsilon = 0.0000001);
+
+// select the implementation used by checkLineIntersectionBatch. Requests
+// for an implementation the cpu does not support fall back to the best
+// supported one.
+void setLineBatchImpl(LineBatchImpl impl);
+LineBatchImpl getLineBatchImpl();
+bool isLineBatchImplSupported(LineBatchImpl impl);
+
+#endif
@@ -16,6 +16,7 @@ int main(int argc, char** argv) {
     std::cout << "entering main loop" << std::endl;
     g.start();
     std::cout << "exiting main loop" << std::endl;
+    g.getFramePacer().report(std::cout);
 
     // quit everything
     std::cout << "shutting down" << std::endl;
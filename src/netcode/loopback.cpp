@@ -0,0 +1,64 @@
+#include "./loopback.hpp"
+
+LoopbackNetwork::Endpoint::Endpoint(LoopbackNetwork* network, size_t index)
+    : network(network), index(index) {}
+
+void LoopbackNetwork::Endpoint::send(InputPacket const& packet) {
+    std::uniform_real_distribution<double> chance(0, 1);
+    for (size_t to = 0; to < network->endpoints.size(); to++) {
+        if (to == index) {
+            continue;
+        }
+        network->sent++;
+        if (chance(network->rng) < network->config.loss) {
+            network->dropped++;
+            continue;
+        }
+        InFlight f;
+        f.arrival = network->now + network->config.delay +
+                    network->rng() % (network->config.jitter + 1);
+        f.packet = packet;
+        network->inFlight[to].push_back(f);
+    }
+}
+
+// the earliest arrived packet, and of those the first sent
+bool LoopbackNetwork::Endpoint::receive(InputPacket& packet) {
+    std::vector<InFlight>& queue = network->inFlight[index];
+    size_t next = queue.size();
+    for (size_t i = 0; i < queue.size(); i++) {
+        if (queue[i].arrival <= network->now &&
+            (next == queue.size() || queue[i].arrival < queue[next].arrival)) {
+            next = i;
+        }
+    }
+    if (next == queue.size()) {
+        return false;
+    }
+    packet = queue[next].packet;
+    queue.erase(queue.begin() + next);
+    return true;
+}
+
+LoopbackNetwork::LoopbackNetwork(LoopbackConfig const& config, size_t peers)
+    : config(config), rng(config.seed), inFlight(peers) {
+    for (size_t i = 0; i < peers; i++) {
+        endpoints.push_back(Endpoint(this, i));
+    }
+}
+
+Transport& LoopbackNetwork::getEndpoint(size_t index) {
+    return endpoints[index];
+}
+
+void LoopbackNetwork::tick() {
+    now++;
+}
+
+size_t LoopbackNetwork::getSent() const {
+    return sent;
+}
+
+size_t LoopbackNetwork::getDropped() const {
+    return dropped;
+}
@@ -0,0 +1,69 @@
+#ifndef __NETCODE_LOOPBACK
+#define __NETCODE_LOOPBACK
+
+#include <random>
+#include <vector>
+#include "./transport.hpp"
+
+class LoopbackConfig {
+   public:
+    // frames every packet takes to arrive
+    size_t delay = 0;
+    // up to this many more frames, picked at random for each packet, so
+    // packets can arrive out of order
+    size_t jitter = 0;
+    // the fraction of packets that never arrive
+    double loss = 0;
+    unsigned int seed = 1;
+};
+
+/**
+ * Peers in one process, passing packets through a simulated network
+ *
+ * Time moves a frame on each tick(), and a packet sent on one frame can be
+ * received from the frame it arrives on. The same seed always delays and
+ * drops the same packets, for sessions that play out the same every run.
+ */
+class LoopbackNetwork {
+   public:
+    class Endpoint : public Transport {
+        LoopbackNetwork* network;
+        size_t index;
+
+       public:
+        Endpoint(LoopbackNetwork* network, size_t index);
+        void send(InputPacket const& packet) override;
+        bool receive(InputPacket& packet) override;
+    };
+
+   private:
+    class InFlight {
+       public:
+        size_t arrival;
+        InputPacket packet;
+    };
+
+    LoopbackConfig config;
+    std::mt19937 rng;
+    size_t now = 0;
+    std::vector<Endpoint> endpoints;
+    // packets on their way to each endpoint
+    std::vector<std::vector<InFlight>> inFlight;
+    size_t sent = 0;
+    size_t dropped = 0;
+
+   public:
+    LoopbackNetwork(LoopbackConfig const& config, size_t peers);
+
+    LoopbackNetwork(LoopbackNetwork const&) = delete;
+    LoopbackNetwork& operator=(LoopbackNetwork const&) = delete;
+
+    // the transport peer index sends and receives through
+    Transport& getEndpoint(size_t index);
+    void tick();
+
+    size_t getSent() const;
+    size_t getDropped() const;
+};
+
+#endif
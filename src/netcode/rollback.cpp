@@ -0,0 +1,169 @@
+#include <algorithm>
+#include <chrono>
+#include "./rollback.hpp"
+
+using namespace InputMapping;
+
+static bool sameInput(InputFrame const& a, InputFrame const& b) {
+    if (a.buttons != b.buttons) {
+        return false;
+    }
+    for (size_t i = 0; i < __NUM_AXIES; i++) {
+        if (a.axies[i] != b.axies[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// the ring of inputs has room for the oldest frame a rollback can go back
+// to, up to the furthest ahead a peer's inputs can be
+RollbackSession::RollbackSession(RollbackConfig const& config,
+                                 Simulation& simulation,
+                                 size_t localPlayer,
+                                 Transport& transport)
+    : config(config),
+      simulation(&simulation),
+      localPlayer(localPlayer),
+      transport(&transport),
+      inputs(simulation.getPlayers().size(),
+             std::vector<InputFrame>(
+                 2 * (config.maxRollbackFrames + config.inputDelay + 1))),
+      received(simulation.getPlayers().size(), config.inputDelay),
+      acknowledged(simulation.getPlayers().size(), config.inputDelay),
+      snapshots(simulation.getSnapshotSize(), config.maxRollbackFrames + 1),
+      frameInputs(simulation.getPlayers().size()) {}
+
+InputFrame& RollbackSession::inputAt(size_t player, size_t frame) {
+    std::vector<InputFrame>& ring = inputs[player];
+    return ring[frame % ring.size()];
+}
+
+// inputs only count once every frame before them has arrived, as packets
+// resend everything that hasn't been acknowledged
+void RollbackSession::receiveInputs() {
+    while (transport->receive(packet)) {
+        size_t p = packet.player;
+        if (p >= received.size() || p == localPlayer) {
+            continue;
+        }
+        if (localPlayer < packet.received.size()) {
+            acknowledged[p] =
+                std::max(acknowledged[p], packet.received[localPlayer]);
+        }
+        for (size_t i = 0; i < packet.inputs.size(); i++) {
+            size_t frame = packet.firstFrame + i;
+            if (frame != received[p]) {
+                continue;
+            }
+            InputFrame& input = inputAt(p, frame);
+            if (frame < simulation->getFrame() &&
+                !sameInput(input, packet.inputs[i])) {
+                if (!mispredicted || frame < firstWrongFrame) {
+                    firstWrongFrame = frame;
+                }
+                mispredicted = true;
+            }
+            input = packet.inputs[i];
+            received[p]++;
+        }
+    }
+}
+
+void RollbackSession::rollback() {
+    if (!mispredicted) {
+        return;
+    }
+    mispredicted = false;
+
+    std::chrono::steady_clock::time_point start =
+        std::chrono::steady_clock::now();
+    size_t present = simulation->getFrame();
+    simulation->restore(
+        snapshots.getSlot(firstWrongFrame % snapshots.getSlots()));
+    while (simulation->getFrame() < present) {
+        simulateFrame();
+    }
+    int64_t nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                        std::chrono::steady_clock::now() - start)
+                        .count();
+
+    size_t depth = present - firstWrongFrame;
+    stats.rollbacks++;
+    stats.resimulatedFrames += depth;
+    stats.deepestRollback = std::max(stats.deepestRollback, depth);
+    stats.resimulationTimes.record(nanos);
+    if (nanos > config.frameBudget * 1e9) {
+        stats.overBudget++;
+    }
+}
+
+void RollbackSession::simulateFrame() {
+    size_t frame = simulation->getFrame();
+    simulation->save(snapshots.getSlot(frame % snapshots.getSlots()));
+    for (size_t p = 0; p < frameInputs.size(); p++) {
+        // predict the last input that arrived
+        if (frame >= received[p]) {
+            inputAt(p, frame) =
+                received[p] > 0 ? inputAt(p, received[p] - 1) : InputFrame();
+        }
+        frameInputs[p] = inputAt(p, frame);
+    }
+    simulation->step(frameInputs.data(), config.elapsed);
+}
+
+// everything since the peer that's furthest behind last acknowledged,
+// which is never more than the ring holds
+void RollbackSession::sendInputs() {
+    size_t end = received[localPlayer];
+    size_t first = end;
+    for (size_t p = 0; p < acknowledged.size(); p++) {
+        if (p != localPlayer) {
+            first = std::min(first, (size_t)acknowledged[p]);
+        }
+    }
+    first = std::max(first, end - std::min(end, inputs[localPlayer].size()));
+
+    packet.player = localPlayer;
+    packet.firstFrame = first;
+    packet.inputs.clear();
+    for (size_t frame = first; frame < end; frame++) {
+        packet.inputs.push_back(inputAt(localPlayer, frame));
+    }
+    packet.received = received;
+    transport->send(packet);
+}
+
+bool RollbackSession::advanceFrame(InputFrame const& local) {
+    receiveInputs();
+    rollback();
+
+    size_t frame = simulation->getFrame();
+    for (uint32_t r : received) {
+        if (frame + 1 > r + config.maxRollbackFrames) {
+            stats.stalls++;
+            sendInputs();
+            return false;
+        }
+    }
+
+    inputAt(localPlayer, received[localPlayer]) = local;
+    received[localPlayer]++;
+    simulateFrame();
+    sendInputs();
+    return true;
+}
+
+void RollbackSession::poll() {
+    receiveInputs();
+    rollback();
+    sendInputs();
+}
+
+size_t RollbackSession::getConfirmedFrame() const {
+    return *std::min_element(received.begin(), received.end());
+}
+
+RollbackStats const& RollbackSession::getStats() const {
+    return stats;
+}
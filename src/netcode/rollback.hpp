@@ -0,0 +1,111 @@
+#ifndef __NETCODE_ROLLBACK
+#define __NETCODE_ROLLBACK
+
+#include <stdint.h>
+#include <vector>
+#include "engine/framepacer.hpp"
+#include "player/inputhandler.hpp"
+#include "sim/simulation.hpp"
+#include "sim/snapshot.hpp"
+#include "./transport.hpp"
+
+class RollbackConfig {
+   public:
+    // the furthest back a late input can roll the simulation; a session
+    // further than this ahead of a peer's inputs waits for them
+    size_t maxRollbackFrames = 8;
+    // frames between a local input being given and the frame it's for, to
+    // give it time to reach the peers before they simulate that frame
+    size_t inputDelay = 2;
+    // seconds each frame simulates
+    double elapsed = 1.0 / 60.0;
+    // seconds a rollback may spend resimulating before it's counted over
+    // budget
+    double frameBudget = 1.0 / 120.0;
+};
+
+class RollbackStats {
+   public:
+    size_t rollbacks = 0;
+    size_t resimulatedFrames = 0;
+    size_t deepestRollback = 0;
+    // frames the session waited on a peer's inputs
+    size_t stalls = 0;
+    // rollbacks that took longer than the frame budget
+    size_t overBudget = 0;
+    // how long each rollback took to restore and resimulate
+    FrameTimeHistogram resimulationTimes;
+};
+
+/**
+ * Runs a Simulation in step with peers, GGPO style
+ *
+ * Each frame the session simulates straight away, predicting that any
+ * player whose input hasn't arrived is still holding what they last
+ * pressed. Before each frame it snapshots the simulation into a ring of the
+ * last maxRollbackFrames frames. When an input arrives that differs from
+ * what was predicted for it, the session restores the snapshot from that
+ * frame and resimulates up to the present with the inputs it now has.
+ *
+ * Every peer's inputs for the first inputDelay frames are empty.
+ */
+class RollbackSession {
+    RollbackConfig config;
+    Simulation* simulation;
+    size_t localPlayer;
+    Transport* transport;
+
+    // each player's inputs, by frame modulo the ring's size: what they
+    // pressed up to received, and predictions after
+    std::vector<std::vector<InputMapping::InputFrame>> inputs;
+    // how many frames of each player's input have arrived
+    std::vector<uint32_t> received;
+    // how many frames of the local input each peer has acknowledged
+    std::vector<uint32_t> acknowledged;
+    // the simulation at the start of each frame, by frame modulo the
+    // number of slots
+    SnapshotArena snapshots;
+
+    // the first frame simulated with a wrong prediction, if mispredicted
+    size_t firstWrongFrame = 0;
+    bool mispredicted = false;
+
+    RollbackStats stats;
+    // reused for each frame's inputs and each packet
+    std::vector<InputMapping::InputFrame> frameInputs;
+    InputPacket packet;
+
+    InputMapping::InputFrame& inputAt(size_t player, size_t frame);
+    void receiveInputs();
+    void rollback();
+    // save a snapshot, then simulate the next frame
+    void simulateFrame();
+    void sendInputs();
+
+   public:
+    // simulation must be at its first frame
+    RollbackSession(RollbackConfig const& config,
+                    Simulation& simulation,
+                    size_t localPlayer,
+                    Transport& transport);
+
+    RollbackSession(RollbackSession const&) = delete;
+    RollbackSession& operator=(RollbackSession const&) = delete;
+
+    /** Take in what's arrived, then simulate a frame with the local
+     * player's input, for inputDelay frames on
+     * @return false, having not used local, if the session was waiting on
+     * a peer's inputs
+     */
+    bool advanceFrame(InputMapping::InputFrame const& local);
+
+    // take in what's arrived and resend the local inputs, without
+    // simulating a frame
+    void poll();
+
+    // frames of input every player has confirmed
+    size_t getConfirmedFrame() const;
+    RollbackStats const& getStats() const;
+};
+
+#endif
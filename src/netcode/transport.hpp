@@ -0,0 +1,38 @@
+#ifndef __NETCODE_TRANSPORT
+#define __NETCODE_TRANSPORT
+
+#include <stdint.h>
+#include <vector>
+#include "player/inputhandler.hpp"
+
+/** One player's inputs for a run of frames, as sent to its peers */
+class InputPacket {
+   public:
+    // whose inputs these are
+    uint32_t player = 0;
+    // the frame inputs[0] is for
+    uint32_t firstFrame = 0;
+    std::vector<InputMapping::InputFrame> inputs;
+    // how many frames of each player's input the sender has, acknowledging
+    // what it was sent
+    std::vector<uint32_t> received;
+};
+
+/**
+ * Carries input packets between the peers of a session
+ *
+ * Packets may arrive late, out of order or not at all, so peers resend
+ * whatever hasn't been acknowledged.
+ */
+class Transport {
+   public:
+    virtual ~Transport() {}
+
+    // send packet to every other peer
+    virtual void send(InputPacket const& packet) = 0;
+    // take the next packet that's arrived, returning false if there isn't
+    // one
+    virtual bool receive(InputPacket& packet) = 0;
+};
+
+#endif
@@ -75,7 +75,7 @@ bool interruptWithTiltTurn(Player& p) {
 }
 
 bool interruptWithRunBrake(Player& p) {
-    if (std::abs(p.input->axis(MOVEMENT_AXIS_X)) < 0.62) {
+    if (abs(p.input->axis(MOVEMENT_AXIS_X)) < 0.62) {
         p.changeAction(RUNBRAKE);
         return true;
     }
@@ -99,7 +99,7 @@ bool interruptWithWalk(Player& p) {
 }
 
 bool interruptWithWait(Player& p) {
-    if (std::abs(p.input->axis(MOVEMENT_AXIS_X)) < 0.1) {
+    if (abs(p.input->axis(MOVEMENT_AXIS_X)) < 0.1) {
         p.changeAction(WAIT);
         return true;
     }
@@ -134,12 +134,12 @@ bool interruptWithSquatRv(Player& p) {
     return false;
 }
 
-void applyTraction(Player& p, double multiplier = 1.0) {
-    double friction = p.getAttribute("friction");
+void applyTraction(Player& p, wideReal multiplier = 1.0) {
+    wideReal friction = p.getAttribute("friction");
     if (p.cVel.x > 0) {
-        p.cVel.x = std::max(0.0, p.cVel.x - friction * multiplier);
+        p.cVel.x = std::max<wideReal>(0, p.cVel.x - friction * multiplier);
     } else {
-        p.cVel.x = std::min(0.0, p.cVel.x + friction * multiplier);
+        p.cVel.x = std::min<wideReal>(0, p.cVel.x + friction * multiplier);
     }
 }
 
@@ -171,7 +171,7 @@ class Walk : public Action {
     void step(Player& p) override {
         if (p.timer == 0) {
             float walkInitialVelocity = p.getAttribute("walk_initial_velocity");
-            float initialWalk = walkInitialVelocity * p.face;
+            float initialWalk = (float)(walkInitialVelocity * p.face);
             if ((initialWalk > 0 && p.cVel.x < initialWalk) ||
                 (initialWalk < 0 && p.cVel.x > initialWalk)) {
                 p.cVel.x += initialWalk;
@@ -189,12 +189,12 @@ class Walk : public Action {
 
         float requestedWalkSpeed =
             walkSpeedMax * p.input->axis(MOVEMENT_AXIS_X);
-        if (std::abs(p.cVel.x) > std::abs(requestedWalkSpeed)) {
+        if (abs(p.cVel.x) > abs(requestedWalkSpeed)) {
             applyTraction(p, 2);
         } else {
             float requestedWalkAcc =
-                (requestedWalkSpeed - p.cVel.x) * (0.5 / walkSpeedMax) +
-                walkAcc;
+                (float)((requestedWalkSpeed - p.cVel.x) * (0.5 / walkSpeedMax) +
+                        walkAcc);
 
             p.cVel.x += requestedWalkAcc;
 
@@ -309,10 +309,10 @@ void startGroundedJump(Player& p, bool isShort) {
 
     p.fixEcbBottom(10, 0);
 
-    double maxJumpVel = p.getAttribute("jump_h_max_velocity");
+    wideReal maxJumpVel = p.getAttribute("jump_h_max_velocity");
 
     p.cVel.x = p.cVel.x * p.getAttribute("ground_air_jump_momentum_mult");
-    if (std::abs(p.cVel.x) > maxJumpVel) {
+    if (abs(p.cVel.x) > maxJumpVel) {
         p.cVel.x = sign(p.cVel.x) * maxJumpVel;
     }
 
@@ -376,10 +376,10 @@ void startDoubleJump(Player& p) {
     p.cVel.x =
         p.input->axis(MOVEMENT_AXIS_X) * p.getAttribute("air_jump_h_momentum");
 
-    double maxJumpVel = p.getAttribute("jump_h_max_velocity");
+    wideReal maxJumpVel = p.getAttribute("jump_h_max_velocity");
 
     p.cVel.x = p.cVel.x * p.getAttribute("ground_air_jump_momentum_mult");
-    if (std::abs(p.cVel.x) > maxJumpVel) {
+    if (abs(p.cVel.x) > maxJumpVel) {
         p.cVel.x = sign(p.cVel.x) * maxJumpVel;
     }
 
@@ -454,13 +454,13 @@ class EscapeAir : public Action {
     }
 
     void dodgeVelocity(Player& p) {
-        double x = p.input->axis(MOVEMENT_AXIS_X);
-        double y = p.input->axis(MOVEMENT_AXIS_Y);
+        wideReal x = p.input->axis(MOVEMENT_AXIS_X);
+        wideReal y = p.input->axis(MOVEMENT_AXIS_Y);
 
-        if (std::abs(x) > 0.3 || std::abs(y) > 0.3) {
-            double ang = atan2(y, x);
-            p.cVel.x = 3.1 * std::cos(ang);
-            p.cVel.y = 3.1 * std::sin(ang);
+        if (abs(x) > 0.3 || abs(y) > 0.3) {
+            wideReal ang = atan2(y, x);
+            p.cVel.x = 3.1 * cos(ang);
+            p.cVel.y = 3.1 * sin(ang);
         } else {
             p.cVel.x = 0;
             p.cVel.y = 0;
@@ -478,32 +478,33 @@ class Dash : public Action {
     void step(Player& p) override {
         if (interrupt(p))
             return;
-        double dMaxV = p.getAttribute("run_max_velocity");
-        double dAccA = p.getAttribute("stopturn_initial_velocity");
+        wideReal dMaxV = p.getAttribute("run_max_velocity");
+        wideReal dAccA = p.getAttribute("stopturn_initial_velocity");
 
         if (p.timer == 1) {
             p.cVel.x += p.face * p.getAttribute("dash_initial_velocity");
-            if (std::abs(p.cVel.x) > std::abs(dMaxV)) {
+            if (abs(p.cVel.x) > abs(dMaxV)) {
                 p.cVel.x = dMaxV * p.face;
             }
         }
 
         if (p.timer > 0) {
-            if (std::abs(p.input->axis(MOVEMENT_AXIS_X)) < 0.3) {
+            if (abs(p.input->axis(MOVEMENT_AXIS_X)) < 0.3) {
                 applyTraction(p);
             } else {
-                double tempMax = p.input->axis(MOVEMENT_AXIS_X) * dMaxV;
-                double tempAcc = p.input->axis(MOVEMENT_AXIS_X) * dAccA;
+                wideReal tempMax = p.input->axis(MOVEMENT_AXIS_X) * dMaxV;
+                wideReal tempAcc = p.input->axis(MOVEMENT_AXIS_X) * dAccA;
 
                 p.cVel.x += tempAcc;
                 // if the player is moving too fast, slow them down
                 if (sign(tempMax) == sign(p.cVel.x) &&
-                    std::abs(tempMax) < std::abs(p.cVel.x)) {
+                    abs(tempMax) < abs(p.cVel.x)) {
                     applyTraction(p);
 
                     // cap at tempMax
                     p.cVel.x = sign(p.cVel.x) *
-                               std::max(std::abs(p.cVel.x), std::abs(tempMax));
+                               std::max<real>(abs(p.cVel.x),
+                                              abs(tempMax));
                 }
                 // if the player is moving within bounds, speed them up more
                 else {
@@ -511,7 +512,8 @@ class Dash : public Action {
 
                     // cap at tempMax
                     p.cVel.x = sign(p.cVel.x) *
-                               std::min(std::abs(p.cVel.x), std::abs(tempMax));
+                               std::min<real>(abs(p.cVel.x),
+                                              abs(tempMax));
                 }
             }
         }
@@ -544,12 +546,12 @@ class Run : public Action {
         if (interrupt(p))
             return;
         // TODO RUNBRAKE and RUNTURN
-        double rMaxV = p.getAttribute("run_max_velocity");
-        double rAccA = p.getAttribute("stopturn_initial_velocity");
-        double rAccB = p.getAttribute("walk_acceleration");
-        double xInput = p.input->axis(MOVEMENT_AXIS_X);
+        wideReal rMaxV = p.getAttribute("run_max_velocity");
+        wideReal rAccA = p.getAttribute("stopturn_initial_velocity");
+        wideReal rAccB = p.getAttribute("walk_acceleration");
+        wideReal xInput = p.input->axis(MOVEMENT_AXIS_X);
 
-        double tempMax = xInput * rMaxV;
+        wideReal tempMax = xInput * rMaxV;
 
         p.cVel.x += (rMaxV * xInput - p.cVel.x) * (0.25 / rMaxV) *
                     (rAccA + rAccB / sign(xInput));
@@ -559,7 +561,7 @@ class Run : public Action {
         }
 
         // // animation scaling
-        // double time = p.cVel.x * p.face / dMaxV;
+        // wideReal time = p.cVel.x * p.face / dMaxV;
         // if (time > 0) {
         //     p.timer += time;
         // }
@@ -602,14 +604,14 @@ class RunTurn : public Action {
         }
 
         if (p.timer < breakPoint && p.getXInput() < -0.3) {
-            double dAccA = p.getAttribute("stopturn_initial_velocity");
-            double tempAcc =
-                p.face * dAccA * std::abs(p.input->axis(MOVEMENT_AXIS_X));
+            wideReal dAccA = p.getAttribute("stopturn_initial_velocity");
+            wideReal tempAcc =
+                p.face * dAccA * abs(p.input->axis(MOVEMENT_AXIS_X));
             p.cVel.x -= tempAcc;
         } else if (p.timer >= breakPoint && p.getXInput() < 0.3) {
-            double dAccA = p.getAttribute("stopturn_initial_velocity");
-            double tempAcc =
-                p.face * dAccA * std::abs(p.input->axis(MOVEMENT_AXIS_X));
+            wideReal dAccA = p.getAttribute("stopturn_initial_velocity");
+            wideReal tempAcc =
+                p.face * dAccA * abs(p.input->axis(MOVEMENT_AXIS_X));
             p.cVel.x += tempAcc;
         } else {
             applyTraction(p, 2.0);
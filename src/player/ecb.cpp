@@ -10,7 +10,7 @@ Ecb::Ecb() : Ecb(Pair(0, 0)) {}
 
 Ecb::Ecb(Pair origin) : Ecb(origin, ECB_DEFAULT_WIDTH, ECB_DEFAULT_HEIGHT) {}
 
-Ecb::Ecb(Pair origin, double width, double height)
+Ecb::Ecb(Pair origin, wideReal width, wideReal height)
     : Ecb(origin,
           ECB_DEFAULT_WIDTH,
           ECB_DEFAULT_HEIGHT,
@@ -18,10 +18,10 @@ Ecb::Ecb(Pair origin, double width, double height)
           ECB_DEFAULT_HEIGHT) {}
 
 Ecb::Ecb(Pair origin,
-         double widthLeft,
-         double heightTop,
-         double widthRight,
-         double heightBottom)
+         wideReal widthLeft,
+         wideReal heightTop,
+         wideReal widthRight,
+         wideReal heightBottom)
     : origin(origin),
       _left(widthLeft),
       _right(widthRight),
@@ -19,16 +19,16 @@
 class Ecb {
    public:
     Pair origin, left, right, top, bottom;
-    double widthLeft, widthRight, heightTop, heightBottom;
+    wideReal widthLeft, widthRight, heightTop, heightBottom;
 
     Ecb();
     Ecb(Pair origin);
-    Ecb(Pair origin, double width, double height);
+    Ecb(Pair origin, wideReal width, wideReal height);
     Ecb(Pair origin,
-        double widthLeft,
-        double heightTop,
-        double widthRight,
-        double heightBottom);
+        wideReal widthLeft,
+        wideReal heightTop,
+        wideReal widthRight,
+        wideReal heightBottom);
 
     void setOrigin(Pair origin);
     void setRight(Pair right);
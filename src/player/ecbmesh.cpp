@@ -6,11 +6,11 @@
 #include <glm/glm.hpp>
 #include <glm/gtc/matrix_transform.hpp>
 
-#define assignValues(x, y) \
-    {                      \
-        out[i++] = x;      \
-        out[i++] = y;      \
-        out[i++] = 0;      \
+#define assignValues(x, y)       \
+    {                            \
+        out[i++] = (GLfloat)(x); \
+        out[i++] = (GLfloat)(y); \
+        out[i++] = 0;            \
     }
 
 void updateMeshToEcb(Ecb& e, GLfloat* out) {
@@ -12,6 +12,8 @@ InputHandler::InputHandler() {
     virtualJoystick.calibrateAxis(SHIELD_AXIS, -1, 1, 0);
 }
 
+InputHandler::~InputHandler() {}
+
 BUTTON_MAPPING InputMapping::gamecubeButtons[] = {
     {0, ATTACK},        {1, JUMP},          {2, JUMP},    {7, START},
     {4, SHIELD_BUTTON}, {5, SHIELD_BUTTON}, {3, SPECIAL}, {-1, __NUM_BUTTONS}};
@@ -64,6 +66,19 @@ double InputHandler::axis(AXIS axisId, int framesBack) {
     return virtualJoystick.axis(axisId, framesBack);
 }
 
+void InputHandler::saveHistory(InputHistory& out) const {
+    size_t current;
+    virtualJoystick.saveHistory(current, out.held, out.down, out.up,
+                                &out.axies[0][0]);
+    out.current = current;
+}
+
+void InputHandler::restoreHistory(InputHistory const& history) {
+    virtualJoystick.restoreHistory(history.current, history.held,
+                                   history.down, history.up,
+                                   &history.axies[0][0]);
+}
+
 KEYBOARD_MAPPING InputMapping::gamecubeKeys[] = {{SDLK_z, JUMP},
                                                  {SDLK_x, SHIELD_BUTTON},
                                                  {SDLK_RETURN, START},
@@ -117,3 +132,22 @@ void KeyboardInputHandler::step() {
         }
     }
 }
+
+void ScriptedInputHandler::setNext(InputFrame const& frame) {
+    next = frame;
+}
+
+void ScriptedInputHandler::step() {
+    virtualJoystick.clear();
+    for (unsigned int i = 0; i < __NUM_BUTTONS; i++) {
+        if ((next.buttons >> i) & 1) {
+            virtualJoystick.setDown(i);
+        } else {
+            virtualJoystick.setUp(i);
+        }
+    }
+
+    for (unsigned int i = 0; i < __NUM_AXIES; i++) {
+        virtualJoystick.setAxis(i, next.axies[i]);
+    }
+}
@@ -1,5 +1,6 @@
 #ifndef __GAME_INPUT_MANAGER
 #define __GAME_INPUT_MANAGER
+#include <stdint.h>
 #include "engine/input/input.hpp"
 
 namespace InputMapping {
@@ -39,17 +40,36 @@ typedef struct AXIS_MAPPING {
 extern BUTTON_MAPPING gamecubeButtons[];
 extern AXIS_MAPPING gamecubeAxies[];
 
+// frames of input an InputHandler remembers
+#define INPUT_HISTORY_FRAMES 10
+
+/** An InputHandler's history as plain data, for snapshots */
+typedef struct InputHistory {
+    uint64_t current;
+    uint64_t held[INPUT_HISTORY_FRAMES];
+    uint64_t down[INPUT_HISTORY_FRAMES];
+    uint64_t up[INPUT_HISTORY_FRAMES];
+    double axies[INPUT_HISTORY_FRAMES][__NUM_AXIES];
+} InputHistory;
+
 class InputHandler {
    protected:
-    Joystick virtualJoystick = Joystick(__NUM_BUTTONS, __NUM_AXIES, 10);
+    Joystick virtualJoystick =
+        Joystick(__NUM_BUTTONS, __NUM_AXIES, INPUT_HISTORY_FRAMES);
 
    public:
     InputHandler();
+    virtual ~InputHandler();
     virtual void step() = 0;
     virtual bool up(BUTTON buttonId, int framesBack = 0);
     virtual bool down(BUTTON buttonId, int framesBack = 0);
     virtual bool held(BUTTON buttonId, int framesBack = 0);
     virtual double axis(AXIS axisId, int framesBack = 0);
+
+    // the buttons and axes of the last few frames, to save and restore
+    // along with the player
+    void saveHistory(InputHistory& out) const;
+    void restoreHistory(InputHistory const& history);
 };
 
 class JoystickInputHandler : public InputHandler {
@@ -76,6 +96,13 @@ typedef struct KEYBOARD_AXIS_MAPPING {
 extern KEYBOARD_MAPPING gamecubeKeys[];
 extern KEYBOARD_AXIS_MAPPING gamecubeKeyAxies[];
 
+// one frame of input for a ScriptedInputHandler: a bit for each BUTTON
+// pressed, and the position of each axis between -1 and 1
+typedef struct InputFrame {
+    uint32_t buttons = 0;
+    double axies[__NUM_AXIES] = {0};
+} InputFrame;
+
 class KeyboardInputHandler : public InputHandler {
     KEYBOARD_MAPPING* keyMap;
     KEYBOARD_AXIS_MAPPING* keyAxisMap;
@@ -87,6 +114,19 @@ class KeyboardInputHandler : public InputHandler {
                          Keyboard* k);
     void step() override;
 };
+
+/**
+ * Input from a program rather than a device, for running players headless
+ *
+ * Each step applies the frame last given to setNext.
+ */
+class ScriptedInputHandler : public InputHandler {
+    InputFrame next;
+
+   public:
+    void setNext(InputFrame const& frame);
+    void step() override;
+};
 }
 
 #endif
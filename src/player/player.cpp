@@ -11,6 +11,7 @@
 #include "engine/model/modelloader.hpp"
 #include "engine/shader/basicshader.hpp"
 #include "player.hpp"
+#include "terrain/map.hpp"
 
 #define GL_GLEXT_PROTOTYPES 1
 #define GL3_PROTOTYPES 1
@@ -30,6 +31,7 @@ Player::Player(PlayerConfig* config,
       input(input),
       config(config) {
     position = initialPosition;
+    previousPosition = initialPosition;
     previousCollision->reset(position + PLAYER_ECB_OFFSET);
     currentCollision->reset(position + PLAYER_ECB_OFFSET);
     changeAction(FALL);
@@ -53,34 +55,50 @@ void Player::init() {
     }
 }
 
-void Player::updateMesh() {
+void Player::updateMesh(Pair const& drawnPosition) {
     // update ecb
     mesh.update(currentCollision->postCollision);
 
     // update location
     glm::mat4 modelTransform;
     modelTransform = glm::translate(
-        modelTransform, glm::vec3(position.x + PLAYER_ECB_OFFSET.x,
-                                  position.y + PLAYER_ECB_OFFSET.y, 0));
+        modelTransform,
+        glm::vec3((float)(drawnPosition.x + PLAYER_ECB_OFFSET.x),
+                  (float)(drawnPosition.y + PLAYER_ECB_OFFSET.y), 0));
     ecbMeshRenderer.setModelTransform(modelTransform);
 
     // update model base transform
     modelTransform = glm::mat4();
     modelTransform =
-        glm::translate(modelTransform, glm::vec3(position.x, position.y, 0));
+        glm::translate(modelTransform,
+                       glm::vec3((float)drawnPosition.x,
+                                 (float)drawnPosition.y, 0));
     modelMeshRenderer.setModelTransform(modelTransform);
 }
 
 void Player::moveTo(Pair newPos) {
     position = newPos;
+    previousPosition = newPos;
     currentCollision->reset(position + PLAYER_ECB_OFFSET);
-    updateMesh();
+    updateMesh(position);
 }
 
 void Player::moveTo(Ecb& ecb) {
     position = ecb.origin - PLAYER_ECB_OFFSET;
     currentCollision->reset(ecb);
-    updateMesh();
+    updateMesh(position);
+}
+
+void Player::carryTo(Pair newPos) {
+    position = newPos;
+    currentCollision->root.setOrigin(position + PLAYER_ECB_OFFSET);
+    currentCollision->playerModified.setOrigin(position + PLAYER_ECB_OFFSET);
+    currentCollision->postCollision.setOrigin(position + PLAYER_ECB_OFFSET);
+    updateMesh(position);
+}
+
+void Player::interpolate(double alpha) {
+    updateMesh(previousPosition + (position - previousPosition) * real(alpha));
 }
 
 void Player::update() {
@@ -97,6 +115,7 @@ void Player::update() {
     if (input->down(START)) {
         position.x = 1.15;
         position.y = 0.6;
+        previousPosition = position;
         currentPlatform = NULL;
         changeAction(FALL);
         currentCollision->reset(position + PLAYER_ECB_OFFSET);
@@ -119,8 +138,9 @@ void Player::update() {
     if (!action->isGrounded(*this)) {
         if (actionState != ESCAPEAIR) {
             cVel.x =
-                sign(cVel.x) * std::min(std::abs(cVel.x),
-                                        getAttribute("max_aerial_h_velocity"));
+                sign(cVel.x) *
+                std::min<real>(abs(cVel.x),
+                               getAttribute("max_aerial_h_velocity"));
         }
     }
 
@@ -160,7 +180,7 @@ void Player::fall(bool fast) {
     if (fastfalled)
         return;
     cVel.y += getAttribute("gravity");
-    cVel.y = std::min(cVel.y, getAttribute("terminal_velocity"));
+    cVel.y = std::min<real>(cVel.y, getAttribute("terminal_velocity"));
 
     if (fast || (input->axis(MOVEMENT_AXIS_Y) > 0.65 &&
                  input->axis(MOVEMENT_AXIS_Y, 3) < 0.1 && cVel.y > 0)) {
@@ -195,7 +215,7 @@ bool Player::canFallOff() const {
 /** Transition from falling to being on ground
     Determine what state to enter from the state we are in */
 void Player::land(const Platform* p) {
-    double yvel = cVel.y;
+    wideReal yvel = cVel.y;
     cVel.y = 0;
     grounded = true;
     fastfalled = false;
@@ -240,12 +260,15 @@ void Player::aerialDrift() {
     // std::cout << inputDrift << " ";
 
     // if the player is moving more than inputDrift, slow then with air friction
-    if (abs(inputDrift) > abs(cVel.x) && sign(cVel.x) == sign(inputDrift)) {
+    if (abs((int)inputDrift) > abs((int)cVel.x) &&
+        sign(cVel.x) == sign(inputDrift)) {
         // std::cout << "too fast, dragging";
         if (cVel.x > 0) {
-            cVel.x = std::max(cVel.x - getAttribute("air_friction"), 0.0);
+            cVel.x =
+                std::max<wideReal>(cVel.x - getAttribute("air_friction"), 0);
         } else {
-            cVel.x = std::min(cVel.x + getAttribute("air_friction"), 0.0);
+            cVel.x =
+                std::min<wideReal>(cVel.x + getAttribute("air_friction"), 0);
         }
     }
 
@@ -262,9 +285,11 @@ void Player::aerialDrift() {
     if (!joystickMoving) {
         // std::cout << "not moving, slowing with friction";
         if (cVel.x > 0) {
-            cVel.x = std::max(cVel.x - getAttribute("air_friction"), 0.0);
+            cVel.x =
+                std::max<wideReal>(cVel.x - getAttribute("air_friction"), 0);
         } else {
-            cVel.x = std::min(cVel.x + getAttribute("air_friction"), 0.0);
+            cVel.x =
+                std::min<wideReal>(cVel.x + getAttribute("air_friction"), 0);
         }
     }
     // std::cout << std::endl;
@@ -312,12 +337,92 @@ void Player::changeAction(ActionState state) {
               << "(" << actionStateName(state) << ")" << std::endl;
     timer = 0;
     action = ACTIONS[state];
-    bank->playAnimation(state);
-    action->step(*this);
+    // set before stepping, so that an action changing straight into another
+    // leaves the state it changed to
     actionState = state;
+    // players simulated headless have no animations
+    if (bank) {
+        bank->playAnimation(state);
+    }
+    action->step(*this);
+}
+
+// where item is in table, which it must be in if it isn't NULL
+template <typename T, typename Items>
+static uint32_t indexIn(T const* item, Items const& table) {
+    return item ? (uint32_t)(item - table.data()) : PLAYER_STATE_NONE;
+}
+
+template <typename T, typename Items>
+static T const* itemAt(uint32_t index, Items const& table) {
+    return index == PLAYER_STATE_NONE ? NULL : &table[index];
+}
+
+void Player::saveState(PlayerState& out, Terrain::Map const& map) const {
+    std::vector<Platform> const& platforms = map.getPlatforms();
+    out.position = position;
+    out.velocity = velocity;
+    out.previousPosition = previousPosition;
+    out.cVel = cVel;
+    out.kVel = kVel;
+    out.previousCollision = *previousCollision;
+    out.currentCollision = *currentCollision;
+    out.ecbBottomFixedSize = ecbBottomFixedSize;
+    out.face = face;
+    out.anchorOffset = platformAnchor.offset;
+    out.anchorMoves = platformAnchor.moves;
+    out.anchorPlatform = indexIn(platformAnchor.platform, platforms);
+    out.anchorSegment = platformAnchor.segment;
+    out.currentPlatform = indexIn(currentPlatform, platforms);
+    out.currentLedge = indexIn(currentLedge, map.getLedges());
+    out.ecbFixedCounter = ecbFixedCounter;
+    out.ledgeRegrabCounter = ledgeRegrabCounter;
+    out.times_jumped = times_jumped;
+    out.timer = timer;
+    out.hitlagFrames = hitlagFrames;
+    out.actionState = actionState;
+    out.jumpType = jumpType;
+    out.fastfalled = fastfalled;
+    out.grounded = grounded;
+    out.isShortHop = isShortHop;
+    out.actionable = actionable;
+    input->saveHistory(out.input);
+}
+
+void Player::restoreState(PlayerState const& state, Terrain::Map& map) {
+    std::vector<Platform> const& platforms = map.getPlatforms();
+    position = state.position;
+    velocity = state.velocity;
+    previousPosition = state.previousPosition;
+    cVel = state.cVel;
+    kVel = state.kVel;
+    *previousCollision = state.previousCollision;
+    *currentCollision = state.currentCollision;
+    ecbBottomFixedSize = state.ecbBottomFixedSize;
+    face = state.face;
+    platformAnchor.offset = state.anchorOffset;
+    platformAnchor.moves = state.anchorMoves;
+    platformAnchor.platform = itemAt<Platform>(state.anchorPlatform, platforms);
+    platformAnchor.segment = state.anchorSegment;
+    currentPlatform = itemAt<Platform>(state.currentPlatform, platforms);
+    currentLedge = itemAt<Ledge>(state.currentLedge, map.getLedges());
+    ecbFixedCounter = state.ecbFixedCounter;
+    ledgeRegrabCounter = state.ledgeRegrabCounter;
+    times_jumped = state.times_jumped;
+    timer = state.timer;
+    hitlagFrames = state.hitlagFrames;
+    actionState = state.actionState;
+    action = ACTIONS[actionState];
+    jumpType = state.jumpType;
+    fastfalled = state.fastfalled;
+    grounded = state.grounded;
+    isShortHop = state.isShortHop;
+    actionable = state.actionable;
+    input->restoreHistory(state.input);
+    updateMesh(position);
 }
 
-void Player::fixEcbBottom(int frames, double size) {
+void Player::fixEcbBottom(int frames, wideReal size) {
     ecbFixedCounter = frames;
     ecbBottomFixedSize = size;
 }
@@ -334,7 +439,7 @@ bool Player::isGrounded() const {
     return action->isGrounded(*this);
 }
 
-double Player::getXInput(int frames) const {
+wideReal Player::getXInput(int frames) const {
     return input->axis(MOVEMENT_AXIS_X, frames) * face;
 }
 
@@ -349,6 +454,7 @@ const PlatformSegment Player::getCurrentPlatformSegment() const {
 
 void Player::setPosition(Pair newPosition) {
     position = newPosition;
+    previousPosition = newPosition;
     currentCollision->postCollision.setOrigin(position + PLAYER_ECB_OFFSET);
 }
 
@@ -2,6 +2,8 @@
 #define __GAME_MAINPLAYER
 
 #include <SDL.h>
+#include <stdint.h>
+#include <type_traits>
 #include "engine/sprite.hpp"
 #include "engine/renderer/meshrenderer.hpp"
 #include "engine/renderer/multirenderer.hpp"
@@ -17,6 +19,55 @@
 #define FACE_LEFT -1;
 #define FACE_RIGHT 1;
 
+namespace Terrain {
+class Map;
+}
+
+// no platform or ledge, in a PlayerState
+#define PLAYER_STATE_NONE UINT32_MAX
+
+/**
+ * Everything about a player that changes as the game runs, as plain data
+ *
+ * The platforms and ledge are indices into the map the player is on, so a
+ * state can be copied with memcpy, written out, and restored into another
+ * player on a copy of the same map.
+ */
+class PlayerState {
+   public:
+    Pair position;
+    Pair velocity;
+    Pair previousPosition;
+    Pair cVel;
+    Pair kVel;
+    PlayerCollision previousCollision;
+    PlayerCollision currentCollision;
+    wideReal ecbBottomFixedSize;
+    wideReal face;
+    // platformAnchor, with its platform as an index
+    Pair anchorOffset;
+    uint64_t anchorMoves;
+    uint32_t anchorPlatform;
+    uint32_t anchorSegment;
+    uint32_t currentPlatform;
+    uint32_t currentLedge;
+    int32_t ecbFixedCounter;
+    int32_t ledgeRegrabCounter;
+    int32_t times_jumped;
+    int32_t timer;
+    int32_t hitlagFrames;
+    ActionState actionState;
+    JumpType jumpType;
+    bool fastfalled;
+    bool grounded;
+    bool isShortHop;
+    bool actionable;
+    InputMapping::InputHistory input;
+};
+
+static_assert(std::is_trivially_copyable<PlayerState>::value,
+              "PlayerState must be plain data");
+
 class Player : public Sprite {
     AnimationBank* bank;
     MeshRenderer ecbMeshRenderer, modelMeshRenderer;
@@ -24,11 +75,13 @@ class Player : public Sprite {
     EcbMesh mesh;
     StaticMesh modelMesh;
 
-    void updateMesh();
+    void updateMesh(Pair const& drawnPosition);
 
    public:
     const Platform* currentPlatform = NULL;
     const Ledge* currentLedge = NULL;
+    // where the player stands on a kinematic current platform
+    PlatformAnchor platformAnchor;
 
     PlayerCollision* previousCollision = new PlayerCollision();
     PlayerCollision* currentCollision = new PlayerCollision();
@@ -38,7 +91,7 @@ class Player : public Sprite {
 
     int ecbFixedCounter = 0;
     int ledgeRegrabCounter = 0;
-    double ecbBottomFixedSize = 0;
+    wideReal ecbBottomFixedSize = 0;
 
     Pair cVel = Pair(0, 0);
     Pair kVel = Pair(0, 0);
@@ -53,19 +106,25 @@ class Player : public Sprite {
     JumpType jumpType;
     bool isShortHop;
     bool actionable = true;
-    double face = FACE_LEFT;
+    wideReal face = FACE_LEFT;
     int hitlagFrames = 0;
 
     void init() override;
     void render(SDL_Renderer* ren) override;
     void update() override;
+    void interpolate(double alpha) override;
 
     void fall(bool fast = false);
     void aerialDrift();
     void grabLedge(Ledge const* l);
-    void fixEcbBottom(int frames, double size);
+    void fixEcbBottom(int frames, wideReal size);
+    // put the player at newPos, drawn there without interpolating from
+    // where it was
     void moveTo(Pair newPos);
     void moveTo(Ecb& ecb);
+    // move along with the platform under the player, keeping the shape of
+    // the ECBs
+    void carryTo(Pair newPos);
 
     Player(PlayerConfig* config,
            InputMapping::InputHandler* input,
@@ -87,8 +146,14 @@ class Player : public Sprite {
     Ecb getLandedEcb(const Platform*) const;
 
     void changeAction(ActionState state);
-    double getXInput(int frames = 0) const;
+    wideReal getXInput(int frames = 0) const;
+    // snap the player to newPosition, like moveTo without resetting the ECBs
     void setPosition(Pair newPosition);
+
+    // the player and its input history, on map
+    void saveState(PlayerState& out, Terrain::Map const& map) const;
+    // without going through changeAction, so the action isn't stepped
+    void restoreState(PlayerState const& state, Terrain::Map& map);
     double getAttribute(char const* name) const;
 
     AbstractRenderer* getRenderer() override;
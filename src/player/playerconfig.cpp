@@ -1,9 +1,17 @@
 #include "playerconfig.hpp"
 #include <yaml-cpp/yaml.h>
 
-PlayerConfig::PlayerConfig(const std::string& configPath)
-    : yamlNode(YAML::LoadFile(configPath)) {}
+PlayerConfig::PlayerConfig(const std::string& configPath) {
+    YAML::Node yamlNode = YAML::LoadFile(configPath);
+    for (auto const& attribute : yamlNode["attributes"]) {
+        // non numeric attributes fail when they are looked up, as before
+        double value;
+        if (YAML::convert<double>::decode(attribute.second, value)) {
+            attributes[attribute.first.as<std::string>()] = value;
+        }
+    }
+}
 
-double PlayerConfig::getAttribute(const std::string& name) {
-    return this->yamlNode["attributes"][name].as<double>();
+double PlayerConfig::getAttribute(const std::string& name) const {
+    return attributes.at(name);
 }
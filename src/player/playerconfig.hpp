@@ -1,14 +1,22 @@
 #ifndef __PLAYER_CONFIG
 #define __PLAYER_CONFIG
 
+#include <map>
+#include <string>
 #include <yaml-cpp/yaml.h>
 
+/**
+ * Character attributes loaded from a yaml file
+ *
+ * Attributes are read once on construction, so that players sharing a
+ * config can look them up from several threads at once.
+ */
 class PlayerConfig {
-    YAML::Node yamlNode;
+    std::map<std::string, double> attributes;
 
    public:
     PlayerConfig(const std::string& configPath);
-    double getAttribute(const std::string& name);
+    double getAttribute(const std::string& name) const;
 };
 
 #endif
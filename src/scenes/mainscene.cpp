@@ -20,64 +20,19 @@
 
 using namespace Terrain;
 
-Map mainSceneMap = Map(
-    {
-        // left passable platform
-        Platform(
-            {
-                Pair(0.4, 0.5), Pair(0.8, 0.5),
-            },
-            true),
-
-        // center passable platform
-        Platform(
-            {
-                Pair(1.5, 1), Pair(1.9, 1),
-            },
-            true),
-
-        // right passable platform
-        Platform(
-            {
-                Pair(0.95, 0.7), Pair(1.35, 0.7),
-            },
-            true),
-
-        // far right passable platform
-        Platform(
-            {
-                Pair(2.95, 1.1), Pair(3.1, 1.1),
-            },
-            true),
-
-        // floating box
-        Platform({
-            Pair(2.1, 0.5), Pair(2.55, 0.5), Pair(2.5, 1), Pair(2.1, 1),
-            Pair(2.1, 0.5),
-        }),
-
-        // convoluted floor surface
-        Platform({
-            Pair(0.1, 2.0), Pair(0.1, 1.35), Pair(0.7, 1.35), Pair(0.7, 1.2),
-            Pair(0.9, 1.2), Pair(0.9, 1.6), Pair(2.2, 1.6), Pair(2.0, 2.0),
-            Pair(2.2, 2.0), Pair(2.4, 2.0), Pair(3, 1.5), Pair(3.4, 1.5),
-            Pair(3.4, 1.1), Pair(3.5, 1.1),
-
-        }),
-    },
-    {
-        Ledge(Pair(2.1, 0.5), FACING_LEFT),
-        Ledge(Pair(2.55, 0.5), FACING_RIGHT),
-
-    });
-
-MainScene::MainScene() : Scene() {
-    map = &mainSceneMap;
-}
+// compiled from stages/main.yaml by stagec
+#define MAIN_STAGE_PATH "assets/main.stage"
+
+MainScene::MainScene() : Scene(), map(NULL) {}
 
 MainScene::~MainScene() {}
 
 void MainScene::init() {
+    map = Map::load(MAIN_STAGE_PATH);
+    if (!map) {
+        exit(1);
+    }
+
     joystick = EnG->input.getJoystick(0);
     if (joystick) {
         joystick->calibrateAxis(0, -30000, 32800, 450);
@@ -118,8 +73,10 @@ void MainScene::init() {
                        },
                        ".");
 
-    cameraPosition = glm::vec3(player->position.x, player->position.y, -2);
-    cameraTarget = glm::vec3(player->position.x, player->position.y, 0);
+    cameraPosition = glm::vec3((float)player->position.x,
+                               (float)player->position.y, -2);
+    cameraTarget =
+        glm::vec3((float)player->position.x, (float)player->position.y, 0);
 
     entities.push_back(player);
     entities.push_back(stateText);
@@ -137,6 +94,8 @@ void MainScene::init() {
 }
 
 void MainScene::update() {
+    map->startFrame();
+
     // update player positions
 
     if (joystick) {
@@ -149,8 +108,8 @@ void MainScene::update() {
             player->update();
             Pair playerMotion = player->velocity * EnG->elapsed;
             map->movePlayer(*player, playerMotion);
-            if (std::isnan(player->position.x) ||
-                std::isnan(player->position.y)) {
+            if (std::isnan((double)player->position.x) ||
+                std::isnan((double)player->position.y)) {
                 exit(1);
             }
         }
@@ -170,26 +129,29 @@ void MainScene::update() {
 
     // update position text to the player's position
     char tmp[128];
-    sprintf(tmp, "(%.2f, %.2f)", player->position.x, player->position.y);
+    sprintf(tmp, "(%.2f, %.2f)", (double)player->position.x,
+            (double)player->position.y);
     posText->updateText(tmp);
 }
 
 void MainScene::render() {
+    // follow the player where it's drawn, between its last two positions
+    Pair drawn = player->previousPosition +
+                 (player->position - player->previousPosition) *
+                     real(EnG->interpolation);
     glm::vec3 projectedPos =
-        glm::vec3(player->position.x, player->position.y - 0.25, -2.0f);
+        glm::vec3((float)drawn.x, (float)(drawn.y - 0.25), -2.0f);
 
-    glm::vec3 projectedTarget =
-        glm::vec3(player->position.x, player->position.y, 0);
+    glm::vec3 projectedTarget = glm::vec3((float)drawn.x, (float)drawn.y, 0);
 
+    // eased once per rendered frame, so by the time the frame took rather
+    // than the simulation's tick
     float easingSpeed = 5;
+    float easing = std::min(1.0f, (float)EnG->frameSeconds * easingSpeed);
 
-    cameraPosition = cameraPosition +
-                     (projectedPos - cameraPosition) *
-                         std::min(1.0f, (float)EnG->elapsed * easingSpeed);
+    cameraPosition = cameraPosition + (projectedPos - cameraPosition) * easing;
 
-    cameraTarget = cameraTarget +
-                   (projectedTarget - cameraTarget) *
-                       std::min(1.0f, (float)EnG->elapsed * easingSpeed);
+    cameraTarget = cameraTarget + (projectedTarget - cameraTarget) * easing;
 
     glm::vec3 up = glm::vec3(0.0f, -1.0f, 0.0f);
     cameraMatrix = glm::lookAt(cameraPosition, cameraTarget, up);
@@ -0,0 +1,102 @@
+#include <cmath>
+
+#include "engine/game.hpp"
+#include "./simscene.hpp"
+
+using namespace Terrain;
+using namespace InputMapping;
+
+// how far past the map players may wander before they're respawned
+#define SIM_SCENE_MARGIN 2
+
+// the bounds of every segment of map, with room to wander past them
+static Bounds wanderingBounds(Map const& map) {
+    Bounds bounds;
+    for (MapSegment const& segment : map.getSegments()) {
+        bounds.include(segment.first);
+        bounds.include(segment.second);
+    }
+    return bounds.expanded(SIM_SCENE_MARGIN);
+}
+
+SimScene::SimScene(Map& map,
+                   PlayerConfig& config,
+                   size_t numPlayers,
+                   unsigned int seed,
+                   size_t workers)
+    : Scene(),
+      map(&map),
+      inside(wanderingBounds(map)),
+      rng(seed),
+      simulation(map, config, spawnPoints(numPlayers), workers),
+      frames(numPlayers) {}
+
+// there's nothing to load, and the players and map are never rendered
+void SimScene::init() {}
+
+void SimScene::render() {}
+
+// somewhere on the map that isn't inside a block
+Pair SimScene::spawnPoint() {
+    Bounds stage = inside.expanded(-SIM_SCENE_MARGIN);
+    std::uniform_real_distribution<double> x((double)stage.min.x,
+                                             (double)stage.max.x);
+    std::uniform_real_distribution<double> y((double)stage.min.y,
+                                             (double)stage.max.y);
+    Pair p;
+    do {
+        p = Pair(x(rng), y(rng));
+    } while (map->isPointInSolid(p));
+    return p;
+}
+
+std::vector<Pair> SimScene::spawnPoints(size_t count) {
+    std::vector<Pair> points;
+    for (size_t i = 0; i < count; i++) {
+        points.push_back(spawnPoint());
+    }
+    return points;
+}
+
+// keep walking one way for a while, with the odd jump, crouch and dodge
+void SimScene::randomizeInput(InputFrame& frame) {
+    frame.buttons = 0;
+    if (rng() % 30 == 0) {
+        std::uniform_real_distribution<double> walk(-1, 1);
+        frame.axies[MOVEMENT_AXIS_X] = walk(rng);
+        frame.axies[MOVEMENT_AXIS_Y] = rng() % 5 == 0 ? 1 : 0;
+    }
+    if (rng() % 40 == 0) {
+        frame.buttons |= 1 << JUMP;
+    }
+    if (rng() % 200 == 0) {
+        frame.buttons |= 1 << SHIELD_BUTTON;
+    }
+}
+
+void SimScene::update() {
+    for (InputFrame& frame : frames) {
+        randomizeInput(frame);
+    }
+    simulation.step(frames.data(), EnG->elapsed);
+
+    for (Player* player : simulation.getPlayers()) {
+        bool nan = std::isnan((double)player->position.x) ||
+                   std::isnan((double)player->position.y);
+        if (nan || !inside.contains(player->position)) {
+            if (player->isGrounded()) {
+                player->fallOffPlatform();
+            }
+            player->moveTo(spawnPoint());
+            respawns++;
+        }
+    }
+}
+
+std::vector<Player*> const& SimScene::getPlayers() const {
+    return simulation.getPlayers();
+}
+
+size_t SimScene::getRespawns() const {
+    return respawns;
+}
@@ -0,0 +1,54 @@
+#ifndef __GAME_SIM_SCENE
+#define __GAME_SIM_SCENE
+
+#include <random>
+#include <vector>
+
+#include "engine/scene.hpp"
+#include "player/player.hpp"
+#include "player/inputhandler.hpp"
+#include "sim/simulation.hpp"
+#include "terrain/bounds.hpp"
+#include "terrain/map.hpp"
+
+using namespace Terrain;
+
+/**
+ * Players driven around a map by seeded random inputs, with nothing to
+ * render
+ *
+ * Each frame steps every player's input, action state and movement the way
+ * MainScene steps its player, so a headless Game can run it as fast as the
+ * simulation goes. Players that leave the map, or end up at NaN, respawn
+ * somewhere on it. The same map, seed and player count always give the same
+ * frames, whatever the number of workers.
+ */
+class SimScene : public Scene {
+    Map* map;
+    // where the players may wander before they're respawned
+    Bounds inside;
+    std::mt19937 rng;
+    Simulation simulation;
+    // the input each player is holding
+    std::vector<InputMapping::InputFrame> frames;
+    size_t respawns = 0;
+
+    Pair spawnPoint();
+    std::vector<Pair> spawnPoints(size_t count);
+    void randomizeInput(InputMapping::InputFrame& frame);
+
+   public:
+    SimScene(Map& map,
+             PlayerConfig& config,
+             size_t numPlayers,
+             unsigned int seed = 1,
+             size_t workers = 1);
+    void init() override;
+    void update() override;
+    void render() override;
+
+    std::vector<Player*> const& getPlayers() const;
+    size_t getRespawns() const;
+};
+
+#endif
@@ -0,0 +1,113 @@
+#include <iostream>
+#include "./simulation.hpp"
+
+using namespace Terrain;
+using namespace InputMapping;
+
+// offset moved up to the next multiple of T's alignment
+template <typename T>
+static size_t alignFor(size_t offset) {
+    return (offset + alignof(T) - 1) / alignof(T) * alignof(T);
+}
+
+Simulation::Simulation(Map& map,
+                       PlayerConfig& config,
+                       std::vector<Pair> const& spawnPoints,
+                       size_t workers)
+    : map(&map), distances(spawnPoints.size()), pool(workers) {
+    for (Pair const& spawn : spawnPoints) {
+        ScriptedInputHandler* input = new ScriptedInputHandler();
+        inputs.push_back(input);
+        players.push_back(new Player(&config, input, NULL, spawn));
+    }
+
+    playersOffset = alignFor<PlayerState>(sizeof(SnapshotHeader));
+    platformsOffset = alignFor<KinematicPlatformState>(
+        playersOffset + players.size() * sizeof(PlayerState));
+    pointsOffset = alignFor<Pair>(
+        platformsOffset + map.getKinematicPlatforms().size() *
+                              sizeof(KinematicPlatformState));
+    snapshotSize =
+        pointsOffset + map.getKinematicPointCount() * sizeof(Pair);
+}
+
+Simulation::~Simulation() {
+    for (Player* p : players) {
+        delete p;
+    }
+    for (ScriptedInputHandler* input : inputs) {
+        delete input;
+    }
+}
+
+void Simulation::step(InputFrame const* frameInputs, double elapsed) {
+    map->startFrame();
+    map->update();
+
+    for (size_t i = 0; i < players.size(); i++) {
+        inputs[i]->setNext(frameInputs[i]);
+        inputs[i]->step();
+
+        players[i]->update();
+        distances[i] = players[i]->velocity * elapsed;
+    }
+    map->movePlayers(players.data(), distances.data(), players.size(), pool);
+    frame++;
+}
+
+void Simulation::save(void* snapshot) const {
+    char* out = (char*)snapshot;
+    SnapshotHeader* header = (SnapshotHeader*)out;
+    header->frame = frame;
+    header->players = players.size();
+    header->kinematicPlatforms = map->getKinematicPlatforms().size();
+    header->kinematicPoints = map->getKinematicPointCount();
+
+    PlayerState* states = (PlayerState*)(out + playersOffset);
+    for (size_t i = 0; i < players.size(); i++) {
+        players[i]->saveState(states[i], *map);
+    }
+    map->saveState((KinematicPlatformState*)(out + platformsOffset),
+                   (Pair*)(out + pointsOffset));
+}
+
+void Simulation::restore(void const* snapshot) {
+    char const* in = (char const*)snapshot;
+    SnapshotHeader const* header = (SnapshotHeader const*)in;
+    if (header->players != players.size() ||
+        header->kinematicPlatforms != map->getKinematicPlatforms().size() ||
+        header->kinematicPoints != map->getKinematicPointCount()) {
+        std::cerr << "snapshot of " << header->players << " players and "
+                  << header->kinematicPlatforms
+                  << " kinematic platforms doesn't fit a simulation of "
+                  << players.size() << " players and "
+                  << map->getKinematicPlatforms().size()
+                  << " kinematic platforms" << std::endl;
+        return;
+    }
+
+    frame = header->frame;
+    PlayerState const* states = (PlayerState const*)(in + playersOffset);
+    for (size_t i = 0; i < players.size(); i++) {
+        players[i]->restoreState(states[i], *map);
+    }
+    map->restoreState(
+        (KinematicPlatformState const*)(in + platformsOffset),
+        (Pair const*)(in + pointsOffset));
+}
+
+size_t Simulation::getSnapshotSize() const {
+    return snapshotSize;
+}
+
+size_t Simulation::getFrame() const {
+    return frame;
+}
+
+std::vector<Player*> const& Simulation::getPlayers() const {
+    return players;
+}
+
+Map& Simulation::getMap() const {
+    return *map;
+}
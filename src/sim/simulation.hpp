@@ -0,0 +1,69 @@
+#ifndef __SIM_SIMULATION
+#define __SIM_SIMULATION
+
+#include <vector>
+#include "engine/workerpool.hpp"
+#include "player/inputhandler.hpp"
+#include "player/player.hpp"
+#include "player/playerconfig.hpp"
+#include "terrain/map.hpp"
+#include "./snapshot.hpp"
+
+/**
+ * Players on a map, stepped one frame at a time by the inputs they're given
+ *
+ * A frame runs the map's kinematic platforms, then each player's input,
+ * action state and movement, the way MainScene runs its player. Stepping
+ * is deterministic: the same state and inputs always give the same next
+ * state, whatever the number of workers, so a simulation can be saved,
+ * rolled back to an earlier frame and stepped forward again.
+ *
+ * A snapshot of the simulation is plain data of the same size every frame,
+ * so saving one is about a memcpy. It names platforms and ledges by index,
+ * so it can be restored into any simulation of as many players on a copy
+ * of the same map.
+ */
+class Simulation {
+    Terrain::Map* map;
+    std::vector<Player*> players;
+    std::vector<InputMapping::ScriptedInputHandler*> inputs;
+    std::vector<Pair> distances;
+    WorkerPool pool;
+    size_t frame = 0;
+
+    // where each part of a snapshot starts, in bytes
+    size_t playersOffset;
+    size_t platformsOffset;
+    size_t pointsOffset;
+    size_t snapshotSize;
+
+   public:
+    // players are made at spawnPoints and have no animations. The map's
+    // kinematic platforms mustn't change while the simulation has it
+    Simulation(Terrain::Map& map,
+               PlayerConfig& config,
+               std::vector<Pair> const& spawnPoints,
+               size_t workers = 1);
+    ~Simulation();
+
+    Simulation(Simulation const&) = delete;
+    Simulation& operator=(Simulation const&) = delete;
+
+    /** Run one frame, each player moving elapsed times its velocity
+     * @param frameInputs one input for each player
+     */
+    void step(InputMapping::InputFrame const* frameInputs, double elapsed);
+
+    // save the state at the start of the next frame into snapshotSize
+    // bytes, aligned for a uint64_t
+    void save(void* snapshot) const;
+    void restore(void const* snapshot);
+    size_t getSnapshotSize() const;
+
+    // frames stepped since the start
+    size_t getFrame() const;
+    std::vector<Player*> const& getPlayers() const;
+    Terrain::Map& getMap() const;
+};
+
+#endif
@@ -0,0 +1,23 @@
+#include "./snapshot.hpp"
+
+SnapshotArena::SnapshotArena(size_t snapshotSize, size_t slots)
+    : slotSize((snapshotSize + sizeof(uint64_t) - 1) / sizeof(uint64_t) *
+               sizeof(uint64_t)),
+      slots(slots),
+      memory(slotSize / sizeof(uint64_t) * slots) {}
+
+void* SnapshotArena::getSlot(size_t index) {
+    return (char*)memory.data() + index * slotSize;
+}
+
+void const* SnapshotArena::getSlot(size_t index) const {
+    return (char const*)memory.data() + index * slotSize;
+}
+
+size_t SnapshotArena::getSlotSize() const {
+    return slotSize;
+}
+
+size_t SnapshotArena::getSlots() const {
+    return slots;
+}
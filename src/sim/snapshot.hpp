@@ -0,0 +1,43 @@
+#ifndef __SIM_SNAPSHOT
+#define __SIM_SNAPSHOT
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+
+/**
+ * The start of a snapshot of a Simulation. The players' states follow it,
+ * then the map's kinematic platform states and their points, each part
+ * aligned for its type
+ */
+typedef struct SnapshotHeader {
+    uint64_t frame;
+    uint32_t players;
+    uint32_t kinematicPlatforms;
+    uint64_t kinematicPoints;
+} SnapshotHeader;
+
+/**
+ * Memory for a number of snapshots of the same size, allocated once
+ *
+ * Snapshots are plain data, so saving a frame into a slot copies it in
+ * without allocating, and a slot can be copied out with memcpy, for
+ * replays or crash dumps.
+ */
+class SnapshotArena {
+    size_t slotSize;
+    size_t slots;
+    // in words, so every slot is aligned for any part of a snapshot
+    std::vector<uint64_t> memory;
+
+   public:
+    SnapshotArena(size_t snapshotSize, size_t slots);
+
+    void* getSlot(size_t index);
+    void const* getSlot(size_t index) const;
+    // bytes from one slot to the next, at least the snapshot size
+    size_t getSlotSize() const;
+    size_t getSlots() const;
+};
+
+#endif
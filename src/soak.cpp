@@ -0,0 +1,209 @@
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <iostream>
+#include <random>
+#include <unistd.h>
+#include "stage/stagegenerator.hpp"
+#include "terrain/map.hpp"
+#include "player/playerconfig.hpp"
+#include "player/inputhandler.hpp"
+
+using namespace Terrain;
+
+// how far past the stage players may wander before they're respawned
+#define SOAK_STAGE_MARGIN 5
+
+static void usage(char const* name) {
+    std::cerr << "usage: " << name
+              << " [-s seed] [-w width] [-h height] [-d density]"
+                 " [-p players] [-f frames] [-j workers]"
+              << std::endl;
+}
+
+static bool isNaN(Pair const& p) {
+    return std::isnan((double)p.x) || std::isnan((double)p.y);
+}
+
+// the smallest bucket at least fraction of the counts fall in
+static size_t percentile(std::vector<size_t> const& histogram,
+                         double fraction) {
+    size_t total = 0;
+    for (size_t count : histogram) {
+        total += count;
+    }
+    size_t seen = 0;
+    for (size_t i = 0; i < histogram.size(); i++) {
+        seen += histogram[i];
+        if (seen >= total * fraction) {
+            return i;
+        }
+    }
+    return histogram.size() - 1;
+}
+
+// somewhere on the stage that isn't inside a block
+static Pair spawnPoint(std::mt19937& rng, Map const& m, Pair const& size) {
+    std::uniform_real_distribution<double> x((double)-size.x / 2,
+                                             (double)size.x / 2);
+    std::uniform_real_distribution<double> y((double)-size.y / 2,
+                                             (double)size.y / 2);
+    Pair p;
+    do {
+        p = Pair(x(rng), y(rng));
+    } while (m.isPointInSolid(p));
+    return p;
+}
+
+// the motion a player asks for this frame: mostly walking and falling, with
+// the odd jump and the odd far too long step
+static Pair randomMotion(std::mt19937& rng, Player& player) {
+    std::uniform_real_distribution<double> walk(-0.1, 0.1);
+    std::uniform_real_distribution<double> fall(-0.1, 0.15);
+    Pair motion = Pair(walk(rng), fall(rng));
+    if (player.isGrounded()) {
+        motion.y = 0;
+        if (rng() % 20 == 0) {
+            player.fallOffPlatform();
+            motion.y = -0.1;
+        }
+    }
+    if (rng() % 50 == 0) {
+        motion = motion * 10;
+    }
+    return motion;
+}
+
+/** Push randomly moving players through a generated stage, and report how
+ * fast they moved, how many iterations their movement took and whether any
+ * of them ended up at NaN
+ *
+ * Players and the movement code log to stdout, so the report goes to
+ * stderr.
+ */
+int main(int argc, char** argv) {
+    StageGeneratorConfig stage;
+    size_t numPlayers = 64, frames = 600, workers = 1;
+    int opt;
+    while ((opt = getopt(argc, argv, "s:w:h:d:p:f:j:")) != -1) {
+        switch (opt) {
+            case 's':
+                stage.seed = std::strtoul(optarg, NULL, 10);
+                break;
+            case 'w':
+                stage.size.x = std::atof(optarg);
+                break;
+            case 'h':
+                stage.size.y = std::atof(optarg);
+                break;
+            case 'd':
+                stage.density = std::atof(optarg);
+                break;
+            case 'p':
+                numPlayers = std::strtoul(optarg, NULL, 10);
+                break;
+            case 'f':
+                frames = std::strtoul(optarg, NULL, 10);
+                break;
+            case 'j':
+                workers = std::max(1ul, std::strtoul(optarg, NULL, 10));
+                break;
+            default:
+                usage(argv[0]);
+                return 2;
+        }
+    }
+    if (optind != argc) {
+        usage(argv[0]);
+        return 2;
+    }
+
+    std::vector<Platform> platforms;
+    std::vector<Ledge> ledges;
+    generateStage(stage, platforms, ledges);
+    Map m = Map(platforms, ledges);
+    std::cerr << "stage: " << m.getPlatforms().size() << " platforms, "
+              << m.getSegments().size() << " segments, "
+              << m.getLedges().size() << " ledges" << std::endl;
+
+    PlayerConfig config("assets/attributes.yaml");
+    InputMapping::JoystickInputHandler input(InputMapping::gamecubeButtons,
+                                             InputMapping::gamecubeAxies,
+                                             NULL);
+    std::mt19937 rng(stage.seed);
+    std::vector<Player> players;
+    players.reserve(numPlayers);
+    for (size_t i = 0; i < numPlayers; i++) {
+        players.push_back(
+            Player(&config, &input, NULL, spawnPoint(rng, m, stage.size)));
+    }
+    std::vector<Player*> playerPtrs;
+    for (Player& p : players) {
+        playerPtrs.push_back(&p);
+    }
+
+    WorkerPool pool(workers);
+    std::vector<Pair> distances(players.size());
+    std::vector<MovementStats> stats(players.size());
+    // iterations per movement, the last bucket counting everything over
+    // the budget
+    std::vector<size_t> histogram(MOVEMENT_ITERATION_BUDGET + 2);
+    size_t nans = 0, panics = 0, exhausted = 0, respawns = 0;
+    double seconds = 0;
+
+    Bounds inside = Bounds(stage.size / -2, stage.size / 2)
+                        .expanded(SOAK_STAGE_MARGIN);
+    for (size_t frame = 0; frame < frames; frame++) {
+        for (size_t i = 0; i < players.size(); i++) {
+            distances[i] = randomMotion(rng, players[i]);
+        }
+
+        auto start = std::chrono::steady_clock::now();
+        m.movePlayers(playerPtrs.data(), distances.data(), players.size(),
+                      pool, stats.data());
+        seconds += std::chrono::duration<double>(
+                       std::chrono::steady_clock::now() - start)
+                       .count();
+
+        for (size_t i = 0; i < players.size(); i++) {
+            Player& player = players[i];
+            histogram[std::min(stats[i].iterations, histogram.size() - 1)]++;
+            panics += stats[i].panicked;
+            exhausted += stats[i].budgetExhausted;
+
+            bool nan = isNaN(player.position);
+            if (nan) {
+                nans++;
+                std::cerr << "frame " << frame << ": player " << i
+                          << " moved by " << distances[i] << " to NaN"
+                          << std::endl;
+            }
+            if (nan || !inside.contains(player.position)) {
+                if (player.isGrounded()) {
+                    player.fallOffPlatform();
+                }
+                player.moveTo(spawnPoint(rng, m, stage.size));
+                respawns++;
+            }
+        }
+    }
+
+    size_t moves = frames * players.size();
+    std::cerr << "moves: " << moves << " in " << seconds << "s ("
+              << moves / seconds << " moves/s on " << workers
+              << " workers)" << std::endl;
+    std::cerr << "moveRecursive iterations:" << std::endl;
+    for (size_t i = 0; i < histogram.size(); i++) {
+        if (histogram[i] > 0) {
+            std::cerr << "    " << i << (i + 1 == histogram.size() ? "+" : "")
+                      << ": " << histogram[i] << std::endl;
+        }
+    }
+    std::cerr << "    p50 = " << percentile(histogram, 0.5)
+              << ", p99 = " << percentile(histogram, 0.99)
+              << ", p99.9 = " << percentile(histogram, 0.999) << std::endl;
+    std::cerr << "panicked: " << panics << ", out of budget: " << exhausted
+              << ", respawned: " << respawns << std::endl;
+    std::cerr << "NaN positions: " << nans << std::endl;
+    return nans == 0 ? 0 : 1;
+}
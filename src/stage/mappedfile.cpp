@@ -0,0 +1,67 @@
+#include <iostream>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "./mappedfile.hpp"
+
+MappedFile::MappedFile() {}
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+bool MappedFile::open(std::string const& path) {
+    close();
+
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        std::cerr << "could not open " << path << ": " << std::strerror(errno)
+                  << std::endl;
+        return false;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0) {
+        std::cerr << "could not stat " << path << ": "
+                  << std::strerror(errno) << std::endl;
+        ::close(fd);
+        return false;
+    }
+
+    // mapping nothing is an error, so empty files just have no data
+    if (info.st_size > 0) {
+        void* mapped =
+            mmap(NULL, info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped == MAP_FAILED) {
+            std::cerr << "could not map " << path << ": "
+                      << std::strerror(errno) << std::endl;
+            ::close(fd);
+            return false;
+        }
+        address = mapped;
+        length = info.st_size;
+    }
+
+    // the mapping stays valid after the descriptor is closed
+    ::close(fd);
+    return true;
+}
+
+void MappedFile::close() {
+    if (address) {
+        munmap(address, length);
+    }
+    address = NULL;
+    length = 0;
+}
+
+void const* MappedFile::data() const {
+    return address;
+}
+
+size_t MappedFile::size() const {
+    return length;
+}
@@ -0,0 +1,30 @@
+#ifndef __STAGE_MAPPED_FILE
+#define __STAGE_MAPPED_FILE
+
+#include <string>
+#include <stddef.h>
+
+/** A whole file mapped read-only into memory, unmapped on destruction */
+class MappedFile {
+    void* address = NULL;
+    size_t length = 0;
+
+   public:
+    MappedFile();
+    ~MappedFile();
+
+    MappedFile(MappedFile const&) = delete;
+    MappedFile& operator=(MappedFile const&) = delete;
+
+    /** Map the file at path, replacing any file mapped before
+     *
+     * @return if the file could be mapped. Errors are reported on stderr
+     */
+    bool open(std::string const& path);
+    void close();
+
+    void const* data() const;
+    size_t size() const;
+};
+
+#endif
@@ -0,0 +1,182 @@
+#include <cmath>
+#include <iostream>
+#include <map>
+#include <yaml-cpp/yaml.h>
+#include "./stagecompiler.hpp"
+#include "./stagefile.hpp"
+#include "terrain/map.hpp"
+#include "terrain/chunkedmap.hpp"
+
+static Pair readPair(YAML::Node const& node) {
+    if (!node.IsSequence() || node.size() != 2) {
+        throw YAML::Exception(node.Mark(), "expected a pair of [x, y]");
+    }
+    return Pair(node[0].as<double>(), node[1].as<double>());
+}
+
+static Facing readFacing(YAML::Node const& node) {
+    std::string facing = node.as<std::string>();
+    if (facing == "left") {
+        return FACING_LEFT;
+    } else if (facing == "right") {
+        return FACING_RIGHT;
+    }
+    throw YAML::Exception(node.Mark(), "facing must be left or right");
+}
+
+bool loadStageDescription(std::string const& path,
+                          std::vector<Platform>& platforms,
+                          std::vector<Ledge>& ledges) {
+    try {
+        YAML::Node stage = YAML::LoadFile(path);
+        for (YAML::Node const& platform : stage["platforms"]) {
+            std::vector<Pair> points;
+            for (YAML::Node const& point : platform["points"]) {
+                points.push_back(readPair(point));
+            }
+            if (points.size() < 2) {
+                throw YAML::Exception(platform.Mark(),
+                                      "platforms need at least 2 points");
+            }
+
+            bool passable = platform["passable"].as<bool>(false);
+            platforms.push_back(Platform(points, passable));
+
+            // moving platforms turn around the middle of their bounds
+            // unless given a pivot
+            YAML::Node motion = platform["motion"];
+            if (motion) {
+                Bounds bounds;
+                for (Pair const& p : points) {
+                    bounds.include(p);
+                }
+                PlatformMotion m;
+                m.pivot = (bounds.min + bounds.max) / 2;
+                if (motion["velocity"]) {
+                    m.velocity = readPair(motion["velocity"]);
+                }
+                m.angularVelocity =
+                    motion["angularVelocity"].as<double>(0);
+                if (motion["pivot"]) {
+                    m.pivot = readPair(motion["pivot"]);
+                }
+                platforms.back().setMotion(m);
+            }
+        }
+
+        for (YAML::Node const& ledge : stage["ledges"]) {
+            ledges.push_back(Ledge(readPair(ledge["position"]),
+                                   readFacing(ledge["facing"])));
+        }
+    } catch (YAML::Exception const& e) {
+        std::cerr << path << ": " << e.what() << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool compileStage(std::string const& sourcePath,
+                  std::string const& outputPath) {
+    std::vector<Platform> platforms;
+    std::vector<Ledge> ledges;
+    if (!loadStageDescription(sourcePath, platforms, ledges)) {
+        return false;
+    }
+
+    StageWriter out;
+    Terrain::Map(platforms, ledges).save(out);
+    if (!out.save(outputPath)) {
+        std::cerr << "could not write " << outputPath << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// tile coordinates of a position
+static std::pair<int, int> tileOf(Pair const& position, double chunkSize) {
+    return std::make_pair((int)floor(position.y / chunkSize),
+                          (int)floor(position.x / chunkSize));
+}
+
+bool compileChunkedStage(std::vector<Platform> const& platforms,
+                         std::vector<Ledge> const& ledges,
+                         double chunkSize,
+                         std::string const& outputDirectory) {
+    if (!(chunkSize > 0)) {
+        std::cerr << "chunk size must be positive" << std::endl;
+        return false;
+    }
+
+    // platforms go to the tile of their center, ledges to the tile they're
+    // in. Tiles are ordered by row, then column
+    class Tile {
+       public:
+        std::vector<Platform> platforms;
+        std::vector<Ledge> ledges;
+        Bounds bounds;
+    };
+    std::map<std::pair<int, int>, Tile> tiles;
+    for (Platform const& platform : platforms) {
+        Bounds bounds;
+        for (PlatformPoint p : platform.points_iter()) {
+            bounds.include(p.point());
+        }
+        Tile& tile =
+            tiles[tileOf((bounds.min + bounds.max) / 2, chunkSize)];
+        tile.platforms.push_back(platform);
+        tile.bounds.include(bounds);
+    }
+    for (Ledge const& ledge : ledges) {
+        Tile& tile = tiles[tileOf(ledge.position, chunkSize)];
+        tile.ledges.push_back(ledge);
+        tile.bounds.include(ledge.position);
+    }
+
+    std::vector<ChunkInfo> chunks;
+    size_t firstPlatform = 0, firstLedge = 0;
+    for (auto const& it : tiles) {
+        Tile const& tile = it.second;
+        ChunkInfo chunk;
+        chunk.x = it.first.second;
+        chunk.y = it.first.first;
+        chunk.bounds = tile.bounds;
+        chunk.firstPlatform = firstPlatform;
+        chunk.numPlatforms = tile.platforms.size();
+        chunk.firstLedge = firstLedge;
+        chunk.numLedges = tile.ledges.size();
+        firstPlatform += chunk.numPlatforms;
+        firstLedge += chunk.numLedges;
+
+        std::string path =
+            ChunkedMap::chunkPath(outputDirectory, chunks.size());
+        StageWriter out;
+        Terrain::Map(tile.platforms, tile.ledges).save(out);
+        if (!out.save(path)) {
+            std::cerr << "could not write " << path << std::endl;
+            return false;
+        }
+        chunks.push_back(chunk);
+    }
+
+    std::string path = outputDirectory + "/" + CHUNK_INDEX_FILE;
+    StageWriter out;
+    out.writeValue(chunkSize);
+    out.write(chunks);
+    if (!out.save(path)) {
+        std::cerr << "could not write " << path << std::endl;
+        return false;
+    }
+    return true;
+}
+
+bool compileChunkedStage(std::string const& sourcePath,
+                         double chunkSize,
+                         std::string const& outputDirectory) {
+    std::vector<Platform> platforms;
+    std::vector<Ledge> ledges;
+    if (!loadStageDescription(sourcePath, platforms, ledges)) {
+        return false;
+    }
+    return compileChunkedStage(platforms, ledges, chunkSize,
+                               outputDirectory);
+}
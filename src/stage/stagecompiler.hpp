@@ -0,0 +1,45 @@
+#ifndef __STAGE_STAGE_COMPILER
+#define __STAGE_STAGE_COMPILER
+
+#include <string>
+#include <vector>
+#include "terrain/platform.hpp"
+#include "terrain/ledge.hpp"
+
+/** Read the platforms and ledges of a YAML stage description
+ *
+ * A description lists platforms, each with its points and whether it's
+ * passable, and ledges with the way they face:
+ *
+ *     platforms:
+ *       - points: [[0.4, 0.5], [0.8, 0.5]]
+ *         passable: true
+ *     ledges:
+ *       - position: [2.1, 0.5]
+ *         facing: left
+ *
+ * @return if the description could be read. Errors are reported on stderr
+ */
+bool loadStageDescription(std::string const& path,
+                          std::vector<Platform>& platforms,
+                          std::vector<Ledge>& ledges);
+
+/** Build the map described at sourcePath and save it as a compiled stage
+ * to outputPath, for Map::load
+ */
+bool compileStage(std::string const& sourcePath,
+                  std::string const& outputPath);
+
+/** Split a stage into square chunks of chunkSize, and save each one as a
+ * compiled stage in outputDirectory along with their index, for
+ * ChunkedMap. The directory must exist
+ */
+bool compileChunkedStage(std::vector<Platform> const& platforms,
+                         std::vector<Ledge> const& ledges,
+                         double chunkSize,
+                         std::string const& outputDirectory);
+bool compileChunkedStage(std::string const& sourcePath,
+                         double chunkSize,
+                         std::string const& outputDirectory);
+
+#endif
@@ -0,0 +1,139 @@
+#include <cstdio>
+#include <sstream>
+#include "./stagefile.hpp"
+
+static size_t alignUp(size_t offset) {
+    return (offset + STAGE_ALIGNMENT - 1) / STAGE_ALIGNMENT * STAGE_ALIGNMENT;
+}
+
+static size_t directoryEnd(size_t numSections) {
+    return alignUp(sizeof(StageHeader) + numSections * sizeof(StageSection));
+}
+
+void StageWriter::writeSection(void const* elements,
+                               size_t count,
+                               size_t elementSize) {
+    // offsets are relative to the payload until the file is finished
+    payload.resize(alignUp(payload.size()), 0);
+
+    StageSection section;
+    section.offset = payload.size();
+    section.count = count;
+    section.elementSize = elementSize;
+    sections.push_back(section);
+
+    char const* bytes = static_cast<char const*>(elements);
+    payload.insert(payload.end(), bytes, bytes + count * elementSize);
+}
+
+std::vector<char> StageWriter::finish() const {
+    size_t payloadStart = directoryEnd(sections.size());
+    std::vector<char> file(payloadStart + payload.size(), 0);
+
+    StageHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, STAGE_MAGIC, sizeof(header.magic));
+    header.version = STAGE_VERSION;
+    header.byteOrder = STAGE_BYTE_ORDER;
+    header.wordSize = sizeof(size_t);
+    header.realFormat = STAGE_REAL_FORMAT;
+    header.numSections = sections.size();
+    header.size = file.size();
+    std::memcpy(file.data(), &header, sizeof(header));
+
+    for (size_t i = 0; i < sections.size(); i++) {
+        StageSection section = sections[i];
+        section.offset += payloadStart;
+        std::memcpy(file.data() + sizeof(header) + i * sizeof(section),
+                    &section, sizeof(section));
+    }
+
+    if (!payload.empty()) {
+        std::memcpy(file.data() + payloadStart, payload.data(),
+                    payload.size());
+    }
+    return file;
+}
+
+bool StageWriter::save(std::string const& path) const {
+    std::vector<char> file = finish();
+    FILE* out = fopen(path.c_str(), "wb");
+    if (!out) {
+        return false;
+    }
+    bool written = fwrite(file.data(), 1, file.size(), out) == file.size();
+    return (fclose(out) == 0) && written;
+}
+
+StageReader::StageReader(void const* file, size_t size)
+    : file(static_cast<char const*>(file)), fileSize(size) {
+    StageHeader header;
+    if (!file || size < sizeof(header)) {
+        fail("too short to be a stage");
+        return;
+    }
+
+    std::memcpy(&header, file, sizeof(header));
+    if (std::memcmp(header.magic, STAGE_MAGIC, sizeof(header.magic)) != 0) {
+        fail("not a stage");
+    } else if (header.version != STAGE_VERSION) {
+        std::ostringstream message;
+        message << "stage version " << header.version << ", expected "
+                << STAGE_VERSION;
+        fail(message.str());
+    } else if (header.byteOrder != STAGE_BYTE_ORDER ||
+               header.wordSize != sizeof(size_t)) {
+        fail("stage was compiled for another platform");
+    } else if (header.realFormat != STAGE_REAL_FORMAT) {
+        fail("stage was compiled for another precision");
+    } else if (header.size != size ||
+               directoryEnd(header.numSections) > size) {
+        fail("stage is truncated");
+    } else {
+        sections = reinterpret_cast<StageSection const*>(this->file +
+                                                         sizeof(header));
+        numSections = header.numSections;
+    }
+}
+
+StageSection const* StageReader::readSection(size_t elementSize,
+                                             size_t alignment) {
+    if (!isValid()) {
+        return NULL;
+    }
+    if (nextSection >= numSections) {
+        fail("stage has fewer sections than expected");
+        return NULL;
+    }
+
+    StageSection const* section = &sections[nextSection++];
+    if (section->elementSize != elementSize) {
+        fail("stage section holds a different type than expected");
+        return NULL;
+    }
+    if (section->offset > fileSize ||
+        section->count > (fileSize - section->offset) / elementSize ||
+        (size_t)(file + section->offset) % alignment != 0) {
+        fail("stage section is out of bounds");
+        return NULL;
+    }
+    return section;
+}
+
+void StageReader::fail(std::string const& message) {
+    if (error.empty()) {
+        error = message;
+    }
+}
+
+bool StageReader::isValid() const {
+    return error.empty();
+}
+
+std::string const& StageReader::getError() const {
+    return error;
+}
+
+bool StageReader::isFinished() const {
+    return nextSection == numSections;
+}
@@ -0,0 +1,147 @@
+#ifndef __STAGE_STAGE_FILE
+#define __STAGE_STAGE_FILE
+
+#include <string>
+#include <vector>
+#include <cstring>
+#include <stddef.h>
+#include <stdint.h>
+#include "engine/pair.hpp"
+#include "engine/table.hpp"
+
+/**
+ * Compiled stage files
+ *
+ * A stage file is a header, a directory of sections and the sections
+ * themselves. Every section is a flat array of one type, stored exactly as
+ * it is laid out in memory so that it can be used in place. Sections are
+ * read back in the order they were written, so the objects saving them and
+ * loading them must agree on that order.
+ *
+ * Files are only valid for the build that wrote them: bump STAGE_VERSION
+ * whenever a stored type or the save order changes.
+ */
+
+#define STAGE_MAGIC "SDLSTAGE"
+#define STAGE_VERSION 4
+// written by the compiler in its native byte order
+#define STAGE_BYTE_ORDER 0x01020304
+// sections start on multiples of this, relative to the start of the file
+#define STAGE_ALIGNMENT 16
+
+// the number formats real can be built as
+enum StageRealFormat {
+    STAGE_REAL_DOUBLE,
+    STAGE_REAL_FLOAT,
+    STAGE_REAL_FIXED,
+};
+
+#if defined(SIM_FIXED)
+#define STAGE_REAL_FORMAT STAGE_REAL_FIXED
+#elif defined(SIM_FLOAT)
+#define STAGE_REAL_FORMAT STAGE_REAL_FLOAT
+#else
+#define STAGE_REAL_FORMAT STAGE_REAL_DOUBLE
+#endif
+
+class StageHeader {
+   public:
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;
+    // sizeof(size_t) of the compiler, which ids are stored as
+    uint32_t wordSize;
+    // STAGE_REAL_FORMAT of the build, which coordinates are stored as
+    uint32_t realFormat;
+    uint32_t numSections;
+    uint64_t size;
+};
+
+class StageSection {
+   public:
+    // offset from the start of the file
+    uint64_t offset;
+    uint64_t count;
+    uint64_t elementSize;
+};
+
+/** Builds the contents of a stage file in memory */
+class StageWriter {
+    std::vector<StageSection> sections;
+    std::vector<char> payload;
+
+    void writeSection(void const* elements, size_t count, size_t elementSize);
+
+   public:
+    template <typename T>
+    void write(T const* elements, size_t count) {
+        writeSection(elements, count, sizeof(T));
+    }
+    template <typename T>
+    void write(std::vector<T> const& elements) {
+        write(elements.data(), elements.size());
+    }
+    template <typename T>
+    void write(Table<T> const& elements) {
+        write(elements.data(), elements.size());
+    }
+    template <typename T>
+    void writeValue(T const& value) {
+        write(&value, 1);
+    }
+
+    // the whole file: header, section directory and sections
+    std::vector<char> finish() const;
+    bool save(std::string const& path) const;
+};
+
+/**
+ * Reads the sections of a stage file in place
+ *
+ * Tables read from the file borrow its memory, so it must outlive them.
+ * Reading a section that doesn't match what's asked for marks the reader
+ * invalid and leaves the output empty.
+ */
+class StageReader {
+    char const* file;
+    size_t fileSize;
+    StageSection const* sections = NULL;
+    size_t numSections = 0;
+    size_t nextSection = 0;
+    std::string error;
+
+    StageSection const* readSection(size_t elementSize, size_t alignment);
+    void fail(std::string const& message);
+
+   public:
+    StageReader(void const* file, size_t size);
+
+    template <typename T>
+    void read(Table<T>& out) {
+        StageSection const* section = readSection(sizeof(T), alignof(T));
+        if (section) {
+            out.borrow(reinterpret_cast<T const*>(file + section->offset),
+                       section->count);
+        } else {
+            out.clear();
+        }
+    }
+
+    template <typename T>
+    void readValue(T& out) {
+        StageSection const* section = readSection(sizeof(T), 1);
+        if (section && section->count != 1) {
+            fail("expected a single value");
+        } else if (section) {
+            std::memcpy(&out, file + section->offset, sizeof(T));
+        }
+    }
+
+    bool isValid() const;
+    // reason the reader became invalid
+    std::string const& getError() const;
+    // whether every section has been read
+    bool isFinished() const;
+};
+
+#endif
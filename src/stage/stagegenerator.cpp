@@ -0,0 +1,123 @@
+#include <cmath>
+#include <random>
+#include "./stagegenerator.hpp"
+
+// std's distributions differ between standard libraries, so stages are
+// drawn straight from the engine to come out the same everywhere
+static double uniform(std::mt19937& rng, double min, double max) {
+    return min + (max - min) * (rng() / 4294967296.0);
+}
+
+static StageFeature pickFeature(std::mt19937& rng,
+                                StageGeneratorConfig const& config) {
+    double total = 0;
+    for (size_t i = 0; i < NUM_STAGE_FEATURES; i++) {
+        total += config.weights[i];
+    }
+    double pick = uniform(rng, 0, total);
+    for (size_t i = 0; i + 1 < NUM_STAGE_FEATURES; i++) {
+        if (pick < config.weights[i]) {
+            return (StageFeature)i;
+        }
+        pick -= config.weights[i];
+    }
+    return (StageFeature)(NUM_STAGE_FEATURES - 1);
+}
+
+// segments of length between min and max, each turned by up to maxAngle
+// radians from flat in the direction of slope
+static std::vector<Pair> makeRun(std::mt19937& rng,
+                                 Pair start,
+                                 size_t segments,
+                                 double min,
+                                 double max,
+                                 double minAngle,
+                                 double maxAngle,
+                                 double slope) {
+    std::vector<Pair> points = {start};
+    for (size_t i = 0; i < segments; i++) {
+        wideReal length = uniform(rng, min, max);
+        wideReal angle = slope * uniform(rng, minAngle, maxAngle);
+        start = start + Pair(cos(angle), sin(angle)) * length;
+        points.push_back(start);
+    }
+    return points;
+}
+
+static void addFeature(std::mt19937& rng,
+                       StageFeature feature,
+                       Pair origin,
+                       double scale,
+                       std::vector<Platform>& platforms,
+                       std::vector<Ledge>& ledges) {
+    switch (feature) {
+        case FEATURE_FLOOR: {
+            std::vector<Pair> points =
+                makeRun(rng, origin, 3 + rng() % 6, 0.2 * scale, 0.5 * scale,
+                        -0.15, 0.15, 1);
+            platforms.push_back(Platform(points));
+            ledges.push_back(Ledge(points.front(), FACING_LEFT));
+            ledges.push_back(Ledge(points.back(), FACING_RIGHT));
+            break;
+        }
+        case FEATURE_WALL: {
+            double height = uniform(rng, 0.3, 1) * scale;
+            platforms.push_back(
+                Platform({origin, origin + Pair(0, -height)}));
+            break;
+        }
+        case FEATURE_CEILING: {
+            double width = uniform(rng, 0.3, 1) * scale;
+            platforms.push_back(Platform({origin + Pair(width, 0), origin}));
+            break;
+        }
+        case FEATURE_PASSABLE: {
+            double width = uniform(rng, 0.2, 0.6) * scale;
+            platforms.push_back(
+                Platform({origin, origin + Pair(width, 0)}, true));
+            break;
+        }
+        case FEATURE_SLOPE: {
+            // steeper than the bumps of floors, short of a wall
+            double slope = rng() % 2 ? 1 : -1;
+            platforms.push_back(Platform(makeRun(rng, origin, 2 + rng() % 4,
+                                                 0.2 * scale, 0.5 * scale,
+                                                 0.3, 1.1, slope)));
+            break;
+        }
+        case FEATURE_PIT: {
+            double width = uniform(rng, 0.3, 1) * scale;
+            double depth = uniform(rng, 0.2, 0.6) * scale;
+            platforms.push_back(Platform({origin + Pair(0, -depth), origin,
+                                          origin + Pair(width, 0),
+                                          origin + Pair(width, -depth)}));
+            break;
+        }
+        case FEATURE_BLOCK: {
+            double width = uniform(rng, 0.3, 1) * scale;
+            double height = uniform(rng, 0.2, 0.6) * scale;
+            platforms.push_back(Platform(
+                {origin, origin + Pair(width, 0), origin + Pair(width, height),
+                 origin + Pair(0, height), origin}));
+            ledges.push_back(Ledge(origin, FACING_LEFT));
+            ledges.push_back(Ledge(origin + Pair(width, 0), FACING_RIGHT));
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+void generateStage(StageGeneratorConfig const& config,
+                   std::vector<Platform>& platforms,
+                   std::vector<Ledge>& ledges) {
+    std::mt19937 rng(config.seed);
+    size_t count = (size_t)(config.size.x * config.size.y * config.density);
+    Pair half = config.size / 2;
+    for (size_t i = 0; i < count; i++) {
+        StageFeature feature = pickFeature(rng, config);
+        Pair origin = Pair(uniform(rng, (double)-half.x, (double)half.x),
+                           uniform(rng, (double)-half.y, (double)half.y));
+        addFeature(rng, feature, origin, config.scale, platforms, ledges);
+    }
+}
@@ -0,0 +1,53 @@
+#ifndef __STAGE_STAGE_GENERATOR
+#define __STAGE_STAGE_GENERATOR
+
+#include <vector>
+#include "terrain/platform.hpp"
+#include "terrain/ledge.hpp"
+
+/** The kinds of terrain generateStage scatters over a stage */
+typedef enum StageFeature {
+    // a bumpy floor with ledges at its ends
+    FEATURE_FLOOR,
+    // a lone wall
+    FEATURE_WALL,
+    // a lone ceiling
+    FEATURE_CEILING,
+    // a short floor that can be dropped through
+    FEATURE_PASSABLE,
+    // a run of floor segments too steep to be flat, but not walls
+    FEATURE_SLOPE,
+    // a pit whose walls meet its floor in two concave corners
+    FEATURE_PIT,
+    // a closed box, floored on top and ceilinged underneath, with ledges at
+    // its top corners
+    FEATURE_BLOCK,
+    NUM_STAGE_FEATURES,
+} StageFeature;
+
+/** How generateStage lays out a stage */
+class StageGeneratorConfig {
+   public:
+    unsigned int seed = 1;
+    // the stage covers size, centred on the origin
+    Pair size = Pair(40, 20);
+    // features per square unit of stage
+    double density = 1;
+    // scales every feature, 1 making them about as big as the ones of the
+    // main stage
+    double scale = 1;
+    // how often each feature is picked, relative to the others
+    double weights[NUM_STAGE_FEATURES] = {3, 1, 1, 2, 2, 1, 2};
+};
+
+/** Scatter seeded random features over a stage, appending their platforms
+ * and ledges to platforms and ledges
+ *
+ * Features may overlap, to make the stage as irregular as real ones end up.
+ * The same config always generates the same stage.
+ */
+void generateStage(StageGeneratorConfig const& config,
+                   std::vector<Platform>& platforms,
+                   std::vector<Ledge>& ledges);
+
+#endif
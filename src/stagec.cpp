@@ -0,0 +1,25 @@
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <sys/stat.h>
+#include "stage/stagecompiler.hpp"
+
+// compiles a YAML stage description into a stage file for Map::load, or
+// with -c into a directory of chunks for ChunkedMap
+int main(int argc, char** argv) {
+    if (argc == 5 && std::strcmp(argv[1], "-c") == 0) {
+        mkdir(argv[4], 0755);
+        return compileChunkedStage(argv[3], std::atof(argv[2]), argv[4]) ? 0
+                                                                       : 1;
+    }
+    if (argc == 3) {
+        return compileStage(argv[1], argv[2]) ? 0 : 1;
+    }
+
+    std::cerr << "usage: " << argv[0] << " <stage.yaml> <output.stage>"
+              << std::endl
+              << "       " << argv[0]
+              << " -c <chunk size> <stage.yaml> <output directory>"
+              << std::endl;
+    return 2;
+}
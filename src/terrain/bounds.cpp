@@ -0,0 +1,55 @@
+#include <algorithm>
+#include "engine/util.hpp"
+#include "./bounds.hpp"
+
+Bounds::Bounds()
+    : min(DOUBLE_INFINITY, DOUBLE_INFINITY),
+      max(-DOUBLE_INFINITY, -DOUBLE_INFINITY) {}
+
+Bounds::Bounds(Pair const& a, Pair const& b)
+    : min(std::min(a.x, b.x), std::min(a.y, b.y)),
+      max(std::max(a.x, b.x), std::max(a.y, b.y)) {}
+
+void Bounds::include(Pair const& p) {
+    min.x = std::min(min.x, p.x);
+    min.y = std::min(min.y, p.y);
+    max.x = std::max(max.x, p.x);
+    max.y = std::max(max.y, p.y);
+}
+
+void Bounds::include(Bounds const& b) {
+    if (b.isEmpty())
+        return;
+    include(b.min);
+    include(b.max);
+}
+
+Bounds Bounds::expanded(double margin) const {
+    Bounds b = *this;
+    b.min.x -= margin;
+    b.min.y -= margin;
+    b.max.x += margin;
+    b.max.y += margin;
+    return b;
+}
+
+bool Bounds::overlaps(Bounds const& b) const {
+    return min.x <= b.max.x && b.min.x <= max.x && min.y <= b.max.y &&
+           b.min.y <= max.y;
+}
+
+bool Bounds::contains(Pair const& p) const {
+    return min.x <= p.x && p.x <= max.x && min.y <= p.y && p.y <= max.y;
+}
+
+bool Bounds::contains(Bounds const& b) const {
+    return contains(b.min) && contains(b.max);
+}
+
+bool Bounds::isEmpty() const {
+    return min.x > max.x || min.y > max.y;
+}
+
+std::ostream& operator<<(std::ostream& strm, const Bounds& b) {
+    return strm << "Bounds(" << b.min << ".." << b.max << ")";
+}
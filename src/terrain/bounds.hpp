@@ -0,0 +1,29 @@
+#ifndef __TERRAIN_BOUNDS
+#define __TERRAIN_BOUNDS
+
+#include "engine/pair.hpp"
+
+/**
+ * Axis aligned bounding box used by the terrain broadphase structures
+ */
+class Bounds {
+   public:
+    Pair min;
+    Pair max;
+
+    Bounds();
+    Bounds(Pair const& a, Pair const& b);
+
+    void include(Pair const& p);
+    void include(Bounds const& b);
+    Bounds expanded(double margin) const;
+
+    bool overlaps(Bounds const& b) const;
+    bool contains(Pair const& p) const;
+    bool contains(Bounds const& b) const;
+    bool isEmpty() const;
+};
+
+std::ostream& operator<<(std::ostream& strm, const Bounds& b);
+
+#endif
@@ -0,0 +1,412 @@
+#include <algorithm>
+#include <cmath>
+#include "./chunkedmap.hpp"
+#include "engine/util.hpp"
+#include "stage/stagefile.hpp"
+
+using namespace Terrain;
+
+std::ostream& operator<<(std::ostream& strm, const ChunkStats& s) {
+    strm << "{ resident = " << s.resident << ", loads = " << s.loads
+         << ", evictions = " << s.evictions
+         << ", overBudget = " << s.overBudget << ", latency = "
+         << s.lastLatency * 1000 << "ms (max " << s.maxLatency * 1000
+         << "ms) }";
+    return strm;
+}
+
+// distance from p to the closest point of b, 0 inside of it
+static double distanceTo(Bounds const& b, Pair const& p) {
+    double dx =
+        std::max<double>(0.0, (double)std::max(b.min.x - p.x, p.x - b.max.x));
+    double dy =
+        std::max<double>(0.0, (double)std::max(b.min.y - p.y, p.y - b.max.y));
+    return std::sqrt(dx * dx + dy * dy);
+}
+
+ChunkedMap::ChunkedMap() {}
+
+ChunkedMap::~ChunkedMap() {
+    if (loader.joinable()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        loader.join();
+    }
+}
+
+std::string ChunkedMap::chunkPath(std::string const& directory,
+                                  size_t chunk) {
+    return directory + "/chunk" + std::to_string(chunk) + ".stage";
+}
+
+bool ChunkedMap::open(std::string const& directory) {
+    if (loader.joinable()) {
+        std::cerr << "chunked map is already open" << std::endl;
+        return false;
+    }
+
+    std::string path = directory + "/" + CHUNK_INDEX_FILE;
+    if (!indexFile.open(path)) {
+        return false;
+    }
+    StageReader in(indexFile.data(), indexFile.size());
+    in.readValue(chunkSize);
+    in.read(chunks);
+    if (!in.isValid() || !in.isFinished()) {
+        std::cerr << path << ": "
+                  << (in.isValid() ? "unexpected sections" : in.getError())
+                  << std::endl;
+        chunks.clear();
+        return false;
+    }
+
+    tiles.clear();
+    tileReach = 0;
+    for (size_t i = 0; i < chunks.size(); i++) {
+        ChunkInfo const& chunk = chunks[i];
+        tiles[std::make_pair(chunk.y, chunk.x)] = i;
+        if (chunk.bounds.isEmpty()) {
+            continue;
+        }
+        double left = chunk.x * chunkSize, top = chunk.y * chunkSize;
+        tileReach = std::max(
+            {tileReach, left - (double)chunk.bounds.min.x,
+             (double)chunk.bounds.max.x - (left + chunkSize),
+             top - (double)chunk.bounds.min.y,
+             (double)chunk.bounds.max.y - (top + chunkSize)});
+    }
+
+    // start with an empty map, until players ask for chunks
+    this->directory = directory;
+    requestGeneration++;
+    requestTime = std::chrono::steady_clock::now();
+    loader = std::thread(&ChunkedMap::load, this);
+    return true;
+}
+
+void ChunkedMap::findNearby(Pair const& position) {
+    // only the tiles whose chunks can reach within the radius are looked
+    // at, unless there are more of them than chunks
+    double reach = residencyRadius + tileReach;
+    double x0 = ceil(((double)position.x - reach) / chunkSize) - 1;
+    double x1 = floor(((double)position.x + reach) / chunkSize);
+    double y0 = ceil(((double)position.y - reach) / chunkSize) - 1;
+    double y1 = floor(((double)position.y + reach) / chunkSize);
+    if (!((x1 - x0 + 1) * (y1 - y0 + 1) <= chunks.size())) {
+        for (size_t i = 0; i < chunks.size(); i++) {
+            double distance = distanceTo(chunks[i].bounds, position);
+            if (distance <= residencyRadius) {
+                nearby.push_back(std::make_pair(distance, i));
+            }
+        }
+        return;
+    }
+
+    for (int y = (int)y0; y <= (int)y1; y++) {
+        for (int x = (int)x0; x <= (int)x1; x++) {
+            auto tile = tiles.find(std::make_pair(y, x));
+            if (tile == tiles.end()) {
+                continue;
+            }
+            double distance =
+                distanceTo(chunks[tile->second].bounds, position);
+            if (distance <= residencyRadius) {
+                nearby.push_back(std::make_pair(distance, tile->second));
+            }
+        }
+    }
+}
+
+void ChunkedMap::update(Player* const* players, size_t count, bool wait) {
+    // rank the chunks near players by distance, nearest first. A chunk
+    // near several players counts at its smallest distance
+    nearby.clear();
+    for (size_t p = 0; p < count; p++) {
+        findNearby(players[p]->position);
+    }
+    std::sort(nearby.begin(), nearby.end(),
+              [](std::pair<double, size_t> const& a,
+                 std::pair<double, size_t> const& b) {
+                  return a.second < b.second ||
+                         (a.second == b.second && a.first < b.first);
+              });
+    nearby.erase(std::unique(nearby.begin(), nearby.end(),
+                             [](std::pair<double, size_t> const& a,
+                                std::pair<double, size_t> const& b) {
+                                 return a.second == b.second;
+                             }),
+                 nearby.end());
+    std::sort(nearby.begin(), nearby.end());
+
+    size_t kept = std::min(nearby.size(), residencyBudget);
+    std::vector<size_t> wanted;
+    for (size_t i = 0; i < kept; i++) {
+        wanted.push_back(nearby[i].second);
+    }
+    std::sort(wanted.begin(), wanted.end());
+
+    std::shared_ptr<View> next;
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        stats.overBudget += nearby.size() - kept;
+        if (wanted != requested) {
+            requested = wanted;
+            request = wanted;
+            requestGeneration++;
+            requestTime = std::chrono::steady_clock::now();
+            wake.notify_all();
+        }
+        if (wait) {
+            published.wait(lock, [&] {
+                return pendingGeneration == requestGeneration;
+            });
+        }
+        next.swap(pending);
+    }
+
+    if (next) {
+        if (view) {
+            carryKinematics(*view, *next);
+            for (size_t p = 0; p < count; p++) {
+                rebind(*players[p], *view, *next);
+            }
+        }
+        view = next;
+    }
+    if (view) {
+        view->map->update();
+    }
+}
+
+void ChunkedMap::load() {
+    // chunks kept loaded by the thread, by index
+    std::map<size_t, std::shared_ptr<Map>> loaded;
+    size_t generation = 0;
+
+    while (true) {
+        std::vector<size_t> resident;
+        std::chrono::steady_clock::time_point asked;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            wake.wait(lock, [&] {
+                return stopping || requestGeneration != generation;
+            });
+            if (stopping) {
+                return;
+            }
+            resident = request;
+            generation = requestGeneration;
+            asked = requestTime;
+        }
+
+        size_t evictions = 0, loads = 0;
+        for (auto it = loaded.begin(); it != loaded.end();) {
+            if (std::binary_search(resident.begin(), resident.end(),
+                                   it->first)) {
+                it++;
+            } else {
+                it = loaded.erase(it);
+                evictions++;
+            }
+        }
+        for (size_t chunk : resident) {
+            if (loaded.count(chunk)) {
+                continue;
+            }
+            // chunks that fail to load stay out of the map, and are tried
+            // again with the next request
+            Map* map = Map::load(chunkPath(directory, chunk));
+            if (map) {
+                loaded[chunk] = std::shared_ptr<Map>(map);
+                loads++;
+            }
+        }
+
+        std::shared_ptr<View> next = makeView(resident, loaded);
+        double latency = std::chrono::duration<double>(
+                             std::chrono::steady_clock::now() - asked)
+                             .count();
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            pending = next;
+            pendingGeneration = generation;
+            stats.loads += loads;
+            stats.evictions += evictions;
+            stats.resident = loaded.size();
+            stats.publishes++;
+            stats.lastLatency = latency;
+            stats.maxLatency = std::max(stats.maxLatency, latency);
+            stats.totalLatency += latency;
+        }
+        published.notify_all();
+    }
+}
+
+std::shared_ptr<ChunkedMap::View> ChunkedMap::makeView(
+    std::vector<size_t> const& resident,
+    std::map<size_t, std::shared_ptr<Map>> const& loaded) const {
+    std::shared_ptr<View> v(new View());
+    std::vector<Map const*> parts;
+    size_t platforms = 0, ledges = 0;
+    for (size_t chunk : resident) {
+        auto it = loaded.find(chunk);
+        if (it == loaded.end()) {
+            continue;
+        }
+
+        Map const& source = *it->second;
+        v->chunks.push_back(chunk);
+        v->platformStart.push_back(platforms);
+        v->ledgeStart.push_back(ledges);
+        v->sources.push_back(it->second);
+        parts.push_back(&source);
+        platforms += source.getPlatforms().size();
+        ledges += source.getLedges().size();
+    }
+    v->platformStart.push_back(platforms);
+    v->ledgeStart.push_back(ledges);
+    v->map.reset(new Map(parts));
+    return v;
+}
+
+size_t ChunkedMap::globalPlatform(View const& v, size_t local) const {
+    size_t i = std::upper_bound(v.platformStart.begin(),
+                                v.platformStart.end(), local) -
+               v.platformStart.begin() - 1;
+    return chunks[v.chunks[i]].firstPlatform + local - v.platformStart[i];
+}
+
+size_t ChunkedMap::globalLedge(View const& v, size_t local) const {
+    size_t i = std::upper_bound(v.ledgeStart.begin(), v.ledgeStart.end(),
+                                local) -
+               v.ledgeStart.begin() - 1;
+    return chunks[v.chunks[i]].firstLedge + local - v.ledgeStart[i];
+}
+
+long ChunkedMap::localPlatform(View const& v, size_t global) const {
+    for (size_t i = 0; i < v.chunks.size(); i++) {
+        ChunkInfo const& chunk = chunks[v.chunks[i]];
+        if (global >= chunk.firstPlatform &&
+            global < chunk.firstPlatform + chunk.numPlatforms) {
+            return v.platformStart[i] + global - chunk.firstPlatform;
+        }
+    }
+    return -1;
+}
+
+long ChunkedMap::localLedge(View const& v, size_t global) const {
+    for (size_t i = 0; i < v.chunks.size(); i++) {
+        ChunkInfo const& chunk = chunks[v.chunks[i]];
+        if (global >= chunk.firstLedge &&
+            global < chunk.firstLedge + chunk.numLedges) {
+            return v.ledgeStart[i] + global - chunk.firstLedge;
+        }
+    }
+    return -1;
+}
+
+void ChunkedMap::rebind(Player& player,
+                        View const& from,
+                        View const& to) const {
+    std::vector<Platform> const& oldPlatforms = from.map->getPlatforms();
+    if (player.currentPlatform >= oldPlatforms.data() &&
+        player.currentPlatform < oldPlatforms.data() + oldPlatforms.size()) {
+        long local = localPlatform(
+            to, globalPlatform(from, player.currentPlatform -
+                                         oldPlatforms.data()));
+        if (local >= 0) {
+            Platform const* platform = &to.map->getPlatforms()[local];
+            if (player.platformAnchor.platform == player.currentPlatform) {
+                player.platformAnchor.platform = platform;
+            }
+            player.currentPlatform = platform;
+        } else if (player.isGrounded()) {
+            player.fallOffPlatform();
+        } else {
+            player.currentPlatform = NULL;
+        }
+    }
+
+    Table<Ledge> const& oldLedges = from.map->getLedges();
+    if (player.currentLedge >= oldLedges.begin() &&
+        player.currentLedge < oldLedges.end()) {
+        long local = localLedge(
+            to, globalLedge(from, player.currentLedge - oldLedges.begin()));
+        if (local >= 0) {
+            player.currentLedge = &to.map->getLedges()[local];
+        } else {
+            player.currentLedge = NULL;
+            ActionState state = player.getActionState();
+            if (state == CLIFFCATCH || state == CLIFFWAIT) {
+                player.fallOffPlatform();
+            }
+        }
+    }
+}
+
+void ChunkedMap::carryKinematics(View const& from, View const& to) const {
+    Table<KinematicPlatform> const& oldKinematic =
+        from.map->getKinematicPlatforms();
+    Table<KinematicPlatform> const& newKinematic =
+        to.map->getKinematicPlatforms();
+    if (oldKinematic.empty() || newKinematic.empty()) {
+        return;
+    }
+
+    std::vector<KinematicPlatformState> oldStates(oldKinematic.size());
+    std::vector<Pair> oldPoints(from.map->getKinematicPointCount());
+    from.map->saveState(oldStates.data(), oldPoints.data());
+    std::vector<KinematicPlatformState> states(newKinematic.size());
+    std::vector<Pair> points(to.map->getKinematicPointCount());
+    to.map->saveState(states.data(), points.data());
+
+    // kinematic platforms are in platform order in both maps, as are the
+    // chunks, so the old ones are found in one pass
+    size_t oldIndex = 0, oldPoint = 0, point = 0;
+    for (size_t i = 0; i < newKinematic.size(); i++) {
+        long local = localPlatform(
+            from, globalPlatform(to, newKinematic[i].platform));
+        while (local >= 0 && oldIndex < oldKinematic.size() &&
+               oldKinematic[oldIndex].platform < (size_t)local) {
+            oldPoint += oldKinematic[oldIndex].numPoints;
+            oldIndex++;
+        }
+        if (local >= 0 && oldIndex < oldKinematic.size() &&
+            oldKinematic[oldIndex].platform == (size_t)local) {
+            states[i] = oldStates[oldIndex];
+            std::copy(oldPoints.begin() + oldPoint,
+                      oldPoints.begin() + oldPoint +
+                          newKinematic[i].numPoints,
+                      points.begin() + point);
+        }
+        point += newKinematic[i].numPoints;
+    }
+    to.map->restoreState(states.data(), points.data());
+}
+
+std::shared_ptr<Map> ChunkedMap::getMap() const {
+    // shares ownership of the view, which keeps the chunks alive
+    return view ? std::shared_ptr<Map>(view, view->map.get())
+                : std::shared_ptr<Map>();
+}
+
+bool ChunkedMap::isResident(size_t chunk) const {
+    return view && std::binary_search(view->chunks.begin(),
+                                      view->chunks.end(), chunk);
+}
+
+Table<ChunkInfo> const& ChunkedMap::getChunks() const {
+    return chunks;
+}
+
+double ChunkedMap::getChunkSize() const {
+    return chunkSize;
+}
+
+ChunkStats ChunkedMap::getStats() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return stats;
+}
@@ -0,0 +1,177 @@
+#ifndef __TERRAIN_CHUNKED_MAP
+#define __TERRAIN_CHUNKED_MAP
+
+#include <chrono>
+#include <condition_variable>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <stddef.h>
+#include "engine/table.hpp"
+#include "player/player.hpp"
+#include "stage/mappedfile.hpp"
+#include "./bounds.hpp"
+#include "./map.hpp"
+
+// name of the chunk list in a chunked stage directory
+#define CHUNK_INDEX_FILE "chunks.stage"
+
+/** One tile of a chunked stage, as listed in its index */
+class ChunkInfo {
+   public:
+    // tile coordinates, in multiples of the chunk size
+    int x;
+    int y;
+    // bounds of the chunk's platforms and ledges. Platforms belong to the
+    // tile their center is in, so they may reach out of it
+    Bounds bounds;
+    // ids of the chunk's platforms and ledges in the whole stage
+    size_t firstPlatform;
+    size_t numPlatforms;
+    size_t firstLedge;
+    size_t numLedges;
+};
+
+/** Residency counters of a ChunkedMap */
+class ChunkStats {
+   public:
+    size_t loads = 0;
+    size_t evictions = 0;
+    size_t resident = 0;
+    // chunks near players that were left out to stay within the budget,
+    // over all updates
+    size_t overBudget = 0;
+    // sets of chunks made resident, and the seconds between asking for a
+    // set and it being ready for collision queries
+    size_t publishes = 0;
+    double lastLatency = 0;
+    double maxLatency = 0;
+    double totalLatency = 0;
+};
+
+std::ostream& operator<<(std::ostream& strm, const ChunkStats& s);
+
+/**
+ * A stage split into square chunks, of which only the ones around players
+ * are kept in memory
+ *
+ * Chunks are compiled stages (see compileChunkedStage) loaded and evicted
+ * by a background thread. Once a set of chunks is loaded, the thread
+ * merges them into a single Map that collision queries run against, using
+ * the collision structures compiled into each chunk as they are, and
+ * update() swaps it in at the start of the next frame. Chunks that aren't
+ * resident can't be collided with.
+ *
+ * Kinematic platforms keep moving for as long as their chunk stays
+ * resident. A chunk loaded again starts them over from where the stage
+ * put them.
+ */
+class ChunkedMap {
+    // resident chunks merged into one map
+    class View {
+       public:
+        // resident chunk indices in ascending order, and where each one's
+        // platforms and ledges start in the merged map
+        std::vector<size_t> chunks;
+        std::vector<size_t> platformStart;
+        std::vector<size_t> ledgeStart;
+        // the chunk maps, whose files and collision structures the merged
+        // map uses in place. Declared first, so they outlive it
+        std::vector<std::shared_ptr<Terrain::Map>> sources;
+        std::unique_ptr<Terrain::Map> map;
+    };
+
+    std::string directory;
+    MappedFile indexFile;
+    double chunkSize = 0;
+    Table<ChunkInfo> chunks;
+    // chunk indices by row and column, and how far past its tile the
+    // terrain of any chunk reaches
+    std::map<std::pair<int, int>, size_t> tiles;
+    double tileReach = 0;
+
+    std::shared_ptr<View> view;
+    // last set of chunks asked for, and scratch for computing the next
+    std::vector<size_t> requested;
+    std::vector<std::pair<double, size_t>> nearby;
+
+    // shared with the loader thread
+    std::thread loader;
+    std::mutex mutex;
+    std::condition_variable wake;
+    std::condition_variable published;
+    std::vector<size_t> request;
+    size_t requestGeneration = 0;
+    std::chrono::steady_clock::time_point requestTime;
+    std::shared_ptr<View> pending;
+    size_t pendingGeneration = 0;
+    bool stopping = false;
+    ChunkStats stats;
+
+    void load();
+    // add the chunks close enough to position to nearby
+    void findNearby(Pair const& position);
+    std::shared_ptr<View> makeView(
+        std::vector<size_t> const& resident,
+        std::map<size_t, std::shared_ptr<Terrain::Map>> const& loaded) const;
+    void rebind(Player& player, View const& from, View const& to) const;
+    // move the kinematic platforms of the chunks resident in both views to
+    // where they are in from
+    void carryKinematics(View const& from, View const& to) const;
+    size_t globalPlatform(View const& v, size_t local) const;
+    size_t globalLedge(View const& v, size_t local) const;
+    // index in the merged map of a platform or ledge, or -1 if its chunk
+    // isn't resident
+    long localPlatform(View const& v, size_t global) const;
+    long localLedge(View const& v, size_t global) const;
+
+   public:
+    // most chunks kept in memory at once
+    size_t residencyBudget = 16;
+    // chunks whose bounds come this close to a player are made resident
+    double residencyRadius = 2;
+
+    ChunkedMap();
+    ~ChunkedMap();
+
+    ChunkedMap(ChunkedMap const&) = delete;
+    ChunkedMap& operator=(ChunkedMap const&) = delete;
+
+    /** Open the chunked stage compiled into directory, and start the
+     * loader thread
+     *
+     * @return if the stage could be opened. Errors are reported on stderr
+     */
+    bool open(std::string const& directory);
+
+    /** Ask for the chunks around players, swap in the chunks loaded since
+     * the last update, and move the kinematic platforms of the resident
+     * chunks by their motion
+     *
+     * Players standing on or holding on to terrain of the old chunks are
+     * moved over to the same terrain in the new ones, and fall if it's no
+     * longer resident. With wait set, blocks until the chunks around the
+     * players are resident.
+     */
+    void update(Player* const* players, size_t count, bool wait = false);
+
+    /** Map of the resident chunks, empty until the first chunks are loaded
+     *
+     * The map stays valid for as long as the pointer is held, but once
+     * update swaps in another, it no longer moves its platforms and
+     * players moved on it aren't rebound.
+     */
+    std::shared_ptr<Terrain::Map> getMap() const;
+    bool isResident(size_t chunk) const;
+    Table<ChunkInfo> const& getChunks() const;
+    double getChunkSize() const;
+    ChunkStats getStats();
+
+    static std::string chunkPath(std::string const& directory, size_t chunk);
+};
+
+#endif
@@ -0,0 +1,9 @@
+#include "./collisioncandidates.hpp"
+
+void CollisionCandidates::clear() {
+    bounds = Bounds();
+    for (size_t i = 0; i < NUM_COLLISION_TYPES; i++) {
+        segments[i].clear();
+    }
+    corners.clear();
+}
@@ -0,0 +1,30 @@
+#ifndef __TERRAIN_COLLISION_CANDIDATES
+#define __TERRAIN_COLLISION_CANDIDATES
+
+#include <vector>
+#include <stddef.h>
+#include "./bounds.hpp"
+#include "./collisionstats.hpp"
+
+/**
+ * Segments and corners near a swept ECB
+ *
+ * Gathered with a single broadphase pass per movement iteration and shared
+ * by every collision probe of that iteration. Every list is in ascending id
+ * order.
+ */
+class CollisionCandidates {
+   public:
+    // area the candidates were gathered for. Sweeps outside of it can not
+    // use these candidates
+    Bounds bounds;
+
+    // segment table ids by collision type, NO_COLLISION holds all of them
+    std::vector<size_t> segments[NUM_COLLISION_TYPES];
+    // point table ids of corners that can be collided with
+    std::vector<size_t> corners;
+
+    void clear();
+};
+
+#endif
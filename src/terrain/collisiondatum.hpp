@@ -7,6 +7,8 @@ class CollisionDatum {
 public:
     TerrainCollisionType type;
     PlatformSegment segment;
+    // id of the segment in the map's segment table
+    size_t segmentId;
     Pair position;
 };
 
@@ -14,6 +16,8 @@ class EdgeCollision {
     public:
     PlatformSegment s1;
     PlatformSegment s2;
+    size_t s1Id;
+    size_t s2Id;
     Pair cornerPosition;
     Pair collisionLine1;
     Pair collisionLine2;
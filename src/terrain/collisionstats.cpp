@@ -0,0 +1,51 @@
+#include "./collisionstats.hpp"
+
+void CollisionStats::reset() {
+    for (size_t i = 0; i < NUM_COLLISION_TYPES; i++) {
+        queries[i] = 0;
+        segmentTests[i] = 0;
+    }
+    edgeQueries = 0;
+    cornerTests = 0;
+    candidatePasses = 0;
+    broadphaseMismatches = 0;
+    cacheHits = 0;
+    cacheMisses = 0;
+}
+
+void CollisionStats::add(CollisionStats const& other) {
+    for (size_t i = 0; i < NUM_COLLISION_TYPES; i++) {
+        queries[i] += other.queries[i];
+        segmentTests[i] += other.segmentTests[i];
+    }
+    edgeQueries += other.edgeQueries;
+    cornerTests += other.cornerTests;
+    candidatePasses += other.candidatePasses;
+    broadphaseMismatches += other.broadphaseMismatches;
+    cacheHits += other.cacheHits;
+    cacheMisses += other.cacheMisses;
+}
+
+size_t CollisionStats::totalSegmentTests() const {
+    size_t total = 0;
+    for (size_t i = 0; i < NUM_COLLISION_TYPES; i++) {
+        total += segmentTests[i];
+    }
+    return total;
+}
+
+std::ostream& operator<<(std::ostream& strm, const CollisionStats& s) {
+    return strm << "CollisionStats { "
+                << "any = " << s.segmentTests[NO_COLLISION] << "/"
+                << s.queries[NO_COLLISION] << ", "
+                << "floor = " << s.segmentTests[FLOOR_COLLISION] << "/"
+                << s.queries[FLOOR_COLLISION] << ", "
+                << "ceil = " << s.segmentTests[CEIL_COLLISION] << "/"
+                << s.queries[CEIL_COLLISION] << ", "
+                << "wall = " << s.segmentTests[WALL_COLLISION] << "/"
+                << s.queries[WALL_COLLISION] << ", "
+                << "corners = " << s.cornerTests << "/" << s.edgeQueries << ", "
+                << "passes = " << s.candidatePasses << ", "
+                << "cache = " << s.cacheHits << "/"
+                << s.cacheHits + s.cacheMisses << " }";
+}
@@ -0,0 +1,36 @@
+#ifndef __TERRAIN_COLLISION_STATS
+#define __TERRAIN_COLLISION_STATS
+
+#include <iostream>
+#include <stddef.h>
+#include "./collisiontype.hpp"
+
+#define NUM_COLLISION_TYPES 4
+
+/**
+ * Counters for the work performed by map collision queries, indexed by the
+ * TerrainCollisionType each query was made for
+ */
+class CollisionStats {
+   public:
+    size_t queries[NUM_COLLISION_TYPES] = {0};
+    size_t segmentTests[NUM_COLLISION_TYPES] = {0};
+    // corner sweeps, and the corners they tested
+    size_t edgeQueries = 0;
+    size_t cornerTests = 0;
+    // broadphase passes gathering candidates for movement iterations
+    size_t candidatePasses = 0;
+    // queries whose result disagreed with a linear scan, when validating
+    size_t broadphaseMismatches = 0;
+    // segment sweeps answered by, and added to, a movement query cache
+    size_t cacheHits = 0;
+    size_t cacheMisses = 0;
+
+    void reset();
+    void add(CollisionStats const& other);
+    size_t totalSegmentTests() const;
+};
+
+std::ostream& operator<<(std::ostream& strm, const CollisionStats& s);
+
+#endif
@@ -0,0 +1,78 @@
+#include "./cornerindex.hpp"
+#include "stage/stagefile.hpp"
+
+void CornerIndex::build(Table<MapPoint> const& points,
+                        std::vector<size_t> const& pointIds) {
+    std::vector<size_t> cornerIds;
+    std::vector<Bounds> bounds;
+    for (size_t id : pointIds) {
+        if (points[id].passable)
+            continue;
+
+        cornerIds.push_back(id);
+        bounds.push_back(Bounds(points[id].position, points[id].position));
+    }
+    ids.assign(std::move(cornerIds));
+    grid.build(bounds);
+    parts.clear();
+}
+
+void CornerIndex::merge(
+    std::vector<std::pair<CornerIndex const*, size_t>> const& indices) {
+    std::vector<size_t> merged;
+    parts.clear();
+    for (auto const& index : indices) {
+        CornerIndex const& c = *index.first;
+        if (c.parts.empty()) {
+            parts.push_back(std::make_pair(&c.grid, merged.size()));
+        }
+        for (auto const& part : c.parts) {
+            parts.push_back(
+                std::make_pair(part.first, merged.size() + part.second));
+        }
+        for (size_t id : c.ids) {
+            merged.push_back(index.second + id);
+        }
+    }
+    ids.assign(std::move(merged));
+    grid = SpatialGrid();
+}
+
+void CornerIndex::query(Bounds const& bounds,
+                        std::vector<size_t>& out) const {
+    if (parts.empty()) {
+        grid.query(bounds, out);
+        for (size_t& i : out) {
+            i = ids[i];
+        }
+        return;
+    }
+
+    out.clear();
+    for (auto const& part : parts) {
+        size_t first = out.size();
+        part.first->queryAppend(bounds, out);
+        for (size_t i = first; i < out.size(); i++) {
+            out[i] = ids[part.second + out[i]];
+        }
+    }
+}
+
+void CornerIndex::save(StageWriter& out) const {
+    out.write(ids);
+    grid.save(out);
+}
+
+void CornerIndex::load(StageReader& in) {
+    in.read(ids);
+    grid.load(in);
+    parts.clear();
+}
+
+Table<size_t> const& CornerIndex::getIds() const {
+    return ids;
+}
+
+size_t CornerIndex::size() const {
+    return ids.size();
+}
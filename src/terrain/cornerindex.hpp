@@ -0,0 +1,46 @@
+#ifndef __TERRAIN_CORNER_INDEX
+#define __TERRAIN_CORNER_INDEX
+
+#include <utility>
+#include <vector>
+#include <stddef.h>
+#include "engine/table.hpp"
+#include "./bounds.hpp"
+#include "./spatialgrid.hpp"
+#include "./mappoint.hpp"
+
+/**
+ * Broadphase over the corners of the map that can be collided with
+ *
+ * Corners of passable platforms are left out. Ids are kept in ascending
+ * order, so queries return candidates in the same order as a scan over the
+ * whole point table would visit them.
+ */
+class CornerIndex {
+    Table<size_t> ids;
+    SpatialGrid grid;
+    // for an index merged from others, their grids and where each one's ids
+    // start in ids
+    std::vector<std::pair<SpatialGrid const*, size_t>> parts;
+
+   public:
+    // index the given point ids, which must be ascending
+    void build(Table<MapPoint> const& points, std::vector<size_t> const& ids);
+
+    /** Merge the corner indices of several maps, each paired with where its
+     * map's points start in this map's point table, in ascending order.
+     * Same as SegmentBucket::merge
+     */
+    void merge(
+        std::vector<std::pair<CornerIndex const*, size_t>> const& indices);
+    void save(StageWriter& out) const;
+    void load(StageReader& in);
+
+    /** Collect the point table ids of corners inside the bounds' cells */
+    void query(Bounds const& bounds, std::vector<size_t>& out) const;
+
+    Table<size_t> const& getIds() const;
+    size_t size() const;
+};
+
+#endif
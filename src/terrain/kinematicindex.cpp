@@ -0,0 +1,38 @@
+#include "./kinematicindex.hpp"
+
+void KinematicIndex::clear() {
+    ids.clear();
+    bounds.clear();
+    extent = Bounds();
+}
+
+void KinematicIndex::add(size_t id, Bounds const& b) {
+    ids.push_back(id);
+    bounds.push_back(b);
+    extent.include(b);
+}
+
+void KinematicIndex::refit(size_t slot, Bounds const& b) {
+    bounds[slot] = b;
+    extent.include(b);
+}
+
+void KinematicIndex::query(Bounds const& b, std::vector<size_t>& out) const {
+    for (size_t i = 0; i < ids.size(); i++) {
+        if (bounds[i].overlaps(b)) {
+            out.push_back(ids[i]);
+        }
+    }
+}
+
+Bounds const& KinematicIndex::getExtent() const {
+    return extent;
+}
+
+std::vector<size_t> const& KinematicIndex::getIds() const {
+    return ids;
+}
+
+size_t KinematicIndex::size() const {
+    return ids.size();
+}
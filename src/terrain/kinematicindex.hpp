@@ -0,0 +1,39 @@
+#ifndef __TERRAIN_KINEMATIC_INDEX
+#define __TERRAIN_KINEMATIC_INDEX
+
+#include <vector>
+#include <stddef.h>
+#include "./bounds.hpp"
+
+/**
+ * Broadphase over the items of the map that move, such as the segments of
+ * kinematic platforms
+ *
+ * Items are kept in a flat list in ascending id order and tested one by
+ * one, so moving an item only rewrites its own bounds, and refitting costs
+ * the number of items that moved rather than the size of the map.
+ */
+class KinematicIndex {
+    std::vector<size_t> ids;
+    std::vector<Bounds> bounds;
+    // everywhere an item has been since the index was built
+    Bounds extent;
+
+   public:
+    void clear();
+    // ids must be added in ascending order
+    void add(size_t id, Bounds const& b);
+    // replace the bounds of the item added slot-th
+    void refit(size_t slot, Bounds const& b);
+
+    /** Append the ids of the items whose bounds overlap the query bounds,
+     * in ascending order
+     */
+    void query(Bounds const& b, std::vector<size_t>& out) const;
+
+    Bounds const& getExtent() const;
+    std::vector<size_t> const& getIds() const;
+    size_t size() const;
+};
+
+#endif
@@ -0,0 +1,118 @@
+#include <cmath>
+#include "./ledgeindex.hpp"
+#include "stage/stagefile.hpp"
+#include "constants.hpp"
+#include "util.hpp"
+#include "engine/util.hpp"
+
+size_t LedgeIndex::side(wideReal facing) {
+    return facing > 0;
+}
+
+void LedgeIndex::build(Table<Ledge> const& ledges) {
+    std::vector<size_t> sideIds[2];
+    std::vector<Bounds> bounds[2];
+    for (size_t id = 0; id < ledges.size(); id++) {
+        size_t s = side(ledges[id].facing);
+        sideIds[s].push_back(id);
+        bounds[s].push_back(Bounds(ledges[id].position, ledges[id].position));
+    }
+
+    for (size_t i = 0; i < 2; i++) {
+        ids[i].assign(std::move(sideIds[i]));
+        grids[i].build(bounds[i]);
+    }
+    parts.clear();
+}
+
+void LedgeIndex::merge(
+    std::vector<std::pair<LedgeIndex const*, size_t>> const& indices) {
+    parts.clear();
+    for (auto const& index : indices) {
+        if (index.first->parts.empty()) {
+            parts.push_back(index);
+        }
+        for (auto const& part : index.first->parts) {
+            parts.push_back(
+                std::make_pair(part.first, index.second + part.second));
+        }
+    }
+    for (size_t i = 0; i < 2; i++) {
+        ids[i].clear();
+        grids[i] = SpatialGrid();
+    }
+}
+
+void LedgeIndex::save(StageWriter& out) const {
+    for (size_t i = 0; i < 2; i++) {
+        out.write(ids[i]);
+        grids[i].save(out);
+    }
+}
+
+void LedgeIndex::load(StageReader& in) {
+    for (size_t i = 0; i < 2; i++) {
+        in.read(ids[i]);
+        grids[i].load(in);
+    }
+    parts.clear();
+}
+
+int LedgeIndex::findNearest(Table<Ledge> const& ledges,
+                            Pair const& ledgeboxPosition,
+                            wideReal face,
+                            std::vector<size_t>& out) const {
+    wideReal distance;
+    if (parts.empty()) {
+        return findNearestIn(ledges.data(), ledgeboxPosition, face, out,
+                             distance);
+    }
+
+    // parts are in ledge order, so keeping only strictly closer ledges
+    // still sends ties to the lowest index
+    int nearest = -1;
+    wideReal nearestDistance = DOUBLE_INFINITY;
+    for (auto const& part : parts) {
+        int found = part.first->findNearestIn(ledges.data() + part.second,
+                                              ledgeboxPosition, face, out,
+                                              distance);
+        if (found >= 0 && distance < nearestDistance) {
+            nearestDistance = distance;
+            nearest = found + part.second;
+        }
+    }
+    return nearest;
+}
+
+int LedgeIndex::findNearestIn(Ledge const* ledges,
+                              Pair const& ledgeboxPosition,
+                              wideReal face,
+                              std::vector<size_t>& out,
+                              wideReal& closest) const {
+    // ledges facing the player can't be grabbed
+    size_t s = side(-face);
+    grids[s].query(Bounds(ledgeboxPosition + Pair(-LEDGEBOX_WIDTH,
+                                                  -LEDGEBOX_HEIGHT),
+                          ledgeboxPosition + Pair(LEDGEBOX_WIDTH, 0)),
+                   out);
+
+    int nearest = -1;
+    wideReal nearestDistance = DOUBLE_INFINITY;
+    for (size_t i : out) {
+        Ledge const& l = ledges[ids[s][i]];
+        Pair diff = l.position - ledgeboxPosition;
+        if (sign(diff.x) != sign(face) || face == l.facing ||
+            abs(diff.x) >= LEDGEBOX_WIDTH ||
+            diff.y <= -LEDGEBOX_HEIGHT || diff.y >= 0)
+            continue;
+
+        wideReal distance = diff.euclidSquared();
+        if (distance < nearestDistance) {
+            nearestDistance = distance;
+            nearest = ids[s][i];
+        }
+    }
+
+    closest = nearestDistance;
+    return nearest;
+}
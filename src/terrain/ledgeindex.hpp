@@ -0,0 +1,58 @@
+#ifndef __TERRAIN_LEDGE_INDEX
+#define __TERRAIN_LEDGE_INDEX
+
+#include <utility>
+#include <vector>
+#include <stddef.h>
+#include "engine/pair.hpp"
+#include "engine/table.hpp"
+#include "./ledge.hpp"
+#include "./spatialgrid.hpp"
+
+/**
+ * Broadphase over the ledges of a map, split by the way they face
+ *
+ * A player can only grab ledges facing the other way, so each facing gets
+ * its own grid and a lookup only visits ledges that could be grabbed.
+ */
+class LedgeIndex {
+    // ledge ids and their grid, for left and right facing ledges
+    Table<size_t> ids[2];
+    SpatialGrid grids[2];
+    // for an index merged from others, the indices and where each one's
+    // ledges start in the merged ledge list
+    std::vector<std::pair<LedgeIndex const*, size_t>> parts;
+
+    static size_t side(wideReal facing);
+    int findNearestIn(Ledge const* ledges,
+                      Pair const& ledgeboxPosition,
+                      wideReal face,
+                      std::vector<size_t>& out,
+                      wideReal& closest) const;
+
+   public:
+    void build(Table<Ledge> const& ledges);
+
+    /** Merge the ledge indices of several maps, each paired with where its
+     * map's ledges start in this map's ledge list, in ascending order.
+     * Same as SegmentBucket::merge
+     */
+    void merge(
+        std::vector<std::pair<LedgeIndex const*, size_t>> const& indices);
+    void save(StageWriter& out) const;
+    void load(StageReader& in);
+
+    /** Find the ledge closest to ledgeboxPosition that a player facing face
+     * can grab from there
+     *
+     * ledges must be the list the index was built from, and out is used as
+     * scratch memory. Returns the ledge's index, or -1 if there is none.
+     * Ties go to the lowest index.
+     */
+    int findNearest(Table<Ledge> const& ledges,
+                    Pair const& ledgeboxPosition,
+                    wideReal face,
+                    std::vector<size_t>& out) const;
+};
+
+#endif
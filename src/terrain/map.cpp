@@ -2,6 +2,8 @@
 #include "util.hpp"
 #include "engine/util.hpp"
 #include "constants.hpp"
+#include <algorithm>
+#include <atomic>
 #include <iostream>
 #include "engine/game.hpp"
 #include "widthbuf.hpp"
@@ -10,6 +12,7 @@
 #include "terrain/platform_segment_iterator.hpp"
 #include "engine/model/cube.hpp"
 #include "engine/shader/basicshader.hpp"
+#include "stage/stagefile.hpp"
 
 #define GLM_FORCE_RADIANS
 #include <glm/glm.hpp>
@@ -27,48 +30,56 @@ using namespace Terrain;
 
 widthstream Terrain::out(255, std::cout);
 
+// query epochs are unique across maps, so a cache can't mistake a map for
+// one that lived at the same address before it
+static std::atomic<size_t> lastQueryEpoch(0);
+
+static size_t newQueryEpoch() {
+    return ++lastQueryEpoch;
+}
+
 void Map::makeMapMesh() {
     std::vector<float>* meshPoints = new std::vector<float>();
     std::vector<float>* meshColors = new std::vector<float>();
-    for (PlatformSegment p : getSegments()) {
-        Pair a = *p.firstPoint();
-        Pair b = *p.secondPoint();
-        std::cout << p.getPlatform() << "  " << a << ".." << b << std::endl;
+    for (MapSegment const& p : getSegments()) {
+        Pair a = p.first;
+        Pair b = p.second;
+        std::cout << p.platform << "  " << a << ".." << b << std::endl;
 
-        meshPoints->push_back(a.x);
-        meshPoints->push_back(a.y);
+        meshPoints->push_back((float)a.x);
+        meshPoints->push_back((float)a.y);
         meshPoints->push_back(0.5);
 
-        meshPoints->push_back(a.x);
-        meshPoints->push_back(a.y);
+        meshPoints->push_back((float)a.x);
+        meshPoints->push_back((float)a.y);
         meshPoints->push_back(-0.5);
 
-        meshPoints->push_back(b.x);
-        meshPoints->push_back(b.y);
+        meshPoints->push_back((float)b.x);
+        meshPoints->push_back((float)b.y);
         meshPoints->push_back(0.5);
 
-        meshPoints->push_back(b.x);
-        meshPoints->push_back(b.y);
+        meshPoints->push_back((float)b.x);
+        meshPoints->push_back((float)b.y);
         meshPoints->push_back(0.5);
 
-        meshPoints->push_back(b.x);
-        meshPoints->push_back(b.y);
+        meshPoints->push_back((float)b.x);
+        meshPoints->push_back((float)b.y);
         meshPoints->push_back(-0.5);
 
-        meshPoints->push_back(a.x);
-        meshPoints->push_back(a.y);
+        meshPoints->push_back((float)a.x);
+        meshPoints->push_back((float)a.y);
         meshPoints->push_back(-0.5);
 
         for (size_t i = 0; i < 6; i++) {
-            if (p.getPlatform()->isPassable()) {
+            if (p.passable) {
                 meshColors->push_back(0.39f);
                 meshColors->push_back(0.30f);
                 meshColors->push_back(1.0f);
-            } else if (Platform::isCeil(p.angle())) {
+            } else if (p.type == CEIL_COLLISION) {
                 meshColors->push_back(0.78f);
                 meshColors->push_back(0.117f);
                 meshColors->push_back(0.117f);
-            } else if (Platform::isWall(p.angle())) {
+            } else if (p.type == WALL_COLLISION) {
                 meshColors->push_back(0.0f);
                 meshColors->push_back(0.78f);
                 meshColors->push_back(1.0f);
@@ -89,105 +100,731 @@ void Map::makeMapMesh() {
 }
 
 Map::Map(std::vector<Platform> platforms, std::vector<Ledge> ledges)
-    : platforms(platforms), ledges(ledges) {}
+    : platforms(platforms), ledges(ledges) {
+    buildSegmentTables();
+    ledgeIndex.build(this->ledges);
+}
+
+Map::Map(StageReader& in, std::shared_ptr<MappedFile> const& stageFile)
+    : stageFile(stageFile) {
+    size_t numPlatforms = 0;
+    in.readValue(numPlatforms);
+    if (in.isValid()) {
+        platforms.reserve(numPlatforms);
+    }
+    for (size_t i = 0; i < numPlatforms && in.isValid(); i++) {
+        platforms.emplace_back(in);
+    }
+
+    in.read(ledges);
+    in.read(segments);
+    in.read(points);
+    in.read(segmentArrays.x1);
+    in.read(segmentArrays.y1);
+    in.read(segmentArrays.x2);
+    in.read(segmentArrays.y2);
+    for (size_t i = 0; i < NUM_COLLISION_TYPES; i++) {
+        buckets[i].load(in);
+    }
+    passableSegments.load(in);
+    corners.load(in);
+    ledgeIndex.load(in);
+    in.read(kinematicPlatforms);
+    if (in.isValid()) {
+        buildKinematicIndex();
+    }
+    queryEpoch = newQueryEpoch();
+}
+
+Map::Map(std::vector<Map const*> const& parts) {
+    std::vector<std::pair<SegmentBucket const*, size_t>>
+        partBuckets[NUM_COLLISION_TYPES], partPassable;
+    std::vector<std::pair<CornerIndex const*, size_t>> partCorners;
+    std::vector<std::pair<LedgeIndex const*, size_t>> partLedges;
+    std::vector<Ledge> mergedLedges;
+    std::vector<MapSegment> mergedSegments;
+    std::vector<MapPoint> mergedPoints;
+    std::vector<KinematicPlatform> kinematic;
+    size_t movingSegmentCount = 0, movingCornerCount = 0;
+
+    for (Map const* part : parts) {
+        size_t firstPlatform = platforms.size();
+        size_t firstSegment = mergedSegments.size();
+        size_t firstPoint = mergedPoints.size();
+        for (size_t type = 0; type < NUM_COLLISION_TYPES; type++) {
+            partBuckets[type].push_back(
+                std::make_pair(&part->buckets[type], firstSegment));
+        }
+        partPassable.push_back(
+            std::make_pair(&part->passableSegments, firstSegment));
+        partCorners.push_back(std::make_pair(&part->corners, firstPoint));
+        partLedges.push_back(
+            std::make_pair(&part->ledgeIndex, mergedLedges.size()));
+
+        platforms.insert(platforms.end(), part->platforms.begin(),
+                         part->platforms.end());
+        mergedLedges.insert(mergedLedges.end(), part->ledges.begin(),
+                            part->ledges.end());
+        for (MapSegment segment : part->segments) {
+            segment.platform += firstPlatform;
+            mergedSegments.push_back(segment);
+            segmentArrays.push(segment.first, segment.second);
+        }
+        for (MapPoint point : part->points) {
+            point.platform += firstPlatform;
+            point.firstSegment += firstSegment;
+            point.secondSegment += firstSegment;
+            mergedPoints.push_back(point);
+        }
+        for (KinematicPlatform k : part->kinematicPlatforms) {
+            k.platform += firstPlatform;
+            k.firstSegment += firstSegment;
+            k.firstPoint += firstPoint;
+            k.firstMovingSegment = movingSegmentCount;
+            k.firstMovingCorner = movingCornerCount;
+            movingSegmentCount += k.numSegments;
+            if (!platforms[k.platform].isPassable()) {
+                movingCornerCount += k.numPoints;
+            }
+            kinematic.push_back(k);
+        }
+    }
+
+    ledges.assign(std::move(mergedLedges));
+    segments.assign(std::move(mergedSegments));
+    points.assign(std::move(mergedPoints));
+    for (size_t type = 0; type < NUM_COLLISION_TYPES; type++) {
+        buckets[type].merge(partBuckets[type]);
+    }
+    passableSegments.merge(partPassable);
+    corners.merge(partCorners);
+    ledgeIndex.merge(partLedges);
+    kinematicPlatforms.assign(std::move(kinematic));
+    buildKinematicIndex();
+    queryEpoch = newQueryEpoch();
+}
+
+Map* Map::load(std::string const& stagePath) {
+    std::shared_ptr<MappedFile> file(new MappedFile());
+    if (!file->open(stagePath)) {
+        return NULL;
+    }
+
+    StageReader in(file->data(), file->size());
+    Map* map = new Map(in, file);
+    if (in.isValid() && !in.isFinished()) {
+        std::cerr << stagePath << ": stage has more sections than expected"
+                  << std::endl;
+    } else if (!in.isValid()) {
+        std::cerr << stagePath << ": " << in.getError() << std::endl;
+    } else {
+        return map;
+    }
+
+    delete map;
+    return NULL;
+}
+
+void Map::save(StageWriter& out) const {
+    out.writeValue(platforms.size());
+    for (Platform const& platform : platforms) {
+        platform.save(out);
+    }
+
+    out.write(ledges);
+    out.write(segments);
+    out.write(points);
+    out.write(segmentArrays.x1);
+    out.write(segmentArrays.y1);
+    out.write(segmentArrays.x2);
+    out.write(segmentArrays.y2);
+    for (size_t i = 0; i < NUM_COLLISION_TYPES; i++) {
+        buckets[i].save(out);
+    }
+    passableSegments.save(out);
+    corners.save(out);
+    ledgeIndex.save(out);
+    out.write(kinematicPlatforms);
+}
+
+// copy the geometry of a platform segment into its map segment
+static void fillSegment(MapSegment& segment, PlatformSegment const& s) {
+    segment.first = *s.firstPoint();
+    segment.second = *s.secondPoint();
+    segment.angle = s.angle();
+    segment.direction = s.direction();
+    segment.normal = s.normal();
+    segment.type = Platform::getCollisionType(segment.angle);
+}
+
+void Map::buildSegmentTables() {
+    queryEpoch = newQueryEpoch();
+    segments.clear();
+    points.clear();
+    segmentArrays.clear();
+
+    // classify segments once so typed queries only visit their own kind.
+    // Kinematic platforms go to the moving indices instead
+    std::vector<size_t> ids[NUM_COLLISION_TYPES], passable, pointIds;
+    std::vector<KinematicPlatform> kinematic;
+    size_t movingSegmentCount = 0, movingCornerCount = 0;
+
+    for (size_t i = 0; i < platforms.size(); i++) {
+        Platform const& platform = platforms[i];
+        size_t firstSegment = segments.size();
+        size_t firstPoint = points.size();
+
+        for (PlatformSegment s : platform.segments_iter()) {
+            MapSegment segment;
+            fillSegment(segment, s);
+            segment.passable = platform.isPassable();
+            segment.platform = i;
+            segment.index = s.getIndex();
+            segments.push_back(segment);
+            segmentArrays.push(segment.first, segment.second);
+        }
+
+        for (PlatformPoint p : platform.points_iter()) {
+            MapPoint point;
+            point.position = p.point();
+            point.passable = platform.isPassable();
+            point.platform = i;
+            point.index = points.size() - firstPoint;
+            point.firstSegment = firstSegment + p.firstSegment().getIndex();
+            point.secondSegment = firstSegment + p.secondSegment().getIndex();
+            points.push_back(point);
+        }
+
+        if (platform.isKinematic()) {
+            KinematicPlatform k;
+            k.platform = i;
+            k.firstSegment = firstSegment;
+            k.numSegments = segments.size() - firstSegment;
+            k.firstPoint = firstPoint;
+            k.numPoints = points.size() - firstPoint;
+            k.firstMovingSegment = movingSegmentCount;
+            k.firstMovingCorner = movingCornerCount;
+            movingSegmentCount += k.numSegments;
+            if (!platform.isPassable()) {
+                movingCornerCount += k.numPoints;
+            }
+            kinematic.push_back(k);
+            continue;
+        }
+
+        for (size_t id = firstSegment; id < segments.size(); id++) {
+            ids[NO_COLLISION].push_back(id);
+            ids[segments[id].type].push_back(id);
+            if (segments[id].passable) {
+                passable.push_back(id);
+            }
+        }
+        for (size_t id = firstPoint; id < points.size(); id++) {
+            pointIds.push_back(id);
+        }
+    }
+
+    for (size_t type = 0; type < NUM_COLLISION_TYPES; type++) {
+        buckets[type].build(segments, ids[type]);
+    }
+    passableSegments.build(segments, passable);
+    corners.build(points, pointIds);
+    kinematicPlatforms.assign(std::move(kinematic));
+    buildKinematicIndex();
+}
+
+void Map::buildKinematicIndex() {
+    movingSegments.clear();
+    movingCorners.clear();
+    for (KinematicPlatform const& k : kinematicPlatforms) {
+        for (size_t i = 0; i < k.numSegments; i++) {
+            MapSegment const& segment = segments[k.firstSegment + i];
+            movingSegments.add(k.firstSegment + i,
+                               Bounds(segment.first, segment.second));
+        }
+        if (platforms[k.platform].isPassable()) {
+            continue;
+        }
+        for (size_t i = 0; i < k.numPoints; i++) {
+            Pair const& position = points[k.firstPoint + i].position;
+            movingCorners.add(k.firstPoint + i, Bounds(position, position));
+        }
+    }
+}
+
+void Map::refitPlatform(KinematicPlatform const& k) {
+    Platform const& platform = platforms[k.platform];
+    MapSegment* segmentData = segments.mutableData();
+    for (size_t i = 0; i < k.numSegments; i++) {
+        MapSegment& segment = segmentData[k.firstSegment + i];
+        fillSegment(segment, platform.getSegment(i));
+        segmentArrays.set(k.firstSegment + i, segment.first, segment.second);
+        movingSegments.refit(k.firstMovingSegment + i,
+                             Bounds(segment.first, segment.second));
+    }
+
+    MapPoint* pointData = points.mutableData();
+    size_t i = 0;
+    for (PlatformPoint p : platform.points_iter()) {
+        MapPoint& point = pointData[k.firstPoint + i];
+        point.position = p.point();
+        if (!platform.isPassable()) {
+            movingCorners.refit(k.firstMovingCorner + i,
+                                Bounds(point.position, point.position));
+        }
+        i++;
+    }
+
+    // cached sweeps may have hit where the platform used to be
+    queryEpoch = newQueryEpoch();
+}
+
+void Map::setPlatformMotion(size_t platform, PlatformMotion const& motion) {
+    bool wasKinematic = platforms[platform].isKinematic();
+    platforms[platform].setMotion(motion);
+    if (!wasKinematic) {
+        buildSegmentTables();
+    }
+}
+
+void Map::movePlatform(size_t platform,
+                       Pair const& translation,
+                       wideReal rotation,
+                       Pair const& pivot) {
+    KinematicPlatform const* k = std::lower_bound(
+        kinematicPlatforms.begin(), kinematicPlatforms.end(), platform,
+        [](KinematicPlatform const& k, size_t platform) {
+            return k.platform < platform;
+        });
+    if (k == kinematicPlatforms.end() || k->platform != platform) {
+        std::cerr << "platform " << platform << " isn't kinematic"
+                  << std::endl;
+        return;
+    }
+
+    platforms[platform].transform(translation, rotation, pivot);
+    refitPlatform(*k);
+}
+
+void Map::saveState(KinematicPlatformState* states,
+                    Pair* statePoints) const {
+    for (KinematicPlatform const& k : kinematicPlatforms) {
+        Platform const& platform = platforms[k.platform];
+        states->motion = platform.getMotion();
+        states->moves = platform.getMoves();
+        states++;
+        for (PlatformPoint p : platform.points_iter()) {
+            *statePoints++ = p.point();
+        }
+    }
+}
+
+void Map::restoreState(KinematicPlatformState const* states,
+                       Pair const* statePoints) {
+    for (KinematicPlatform const& k : kinematicPlatforms) {
+        if (platforms[k.platform].restore(statePoints, states->moves,
+                                          states->motion)) {
+            refitPlatform(k);
+        }
+        states++;
+        statePoints += k.numPoints;
+    }
+}
+
+size_t Map::getKinematicPointCount() const {
+    size_t count = 0;
+    for (KinematicPlatform const& k : kinematicPlatforms) {
+        count += k.numPoints;
+    }
+    return count;
+}
+
+void Map::querySegments(TerrainCollisionType type,
+                        Bounds const& bounds,
+                        std::vector<size_t>& out) const {
+    buckets[type].query(bounds, out);
+    if (movingSegments.size() == 0) {
+        return;
+    }
+
+    // moving segments change type as they turn, so they're filtered here
+    size_t numStatic = out.size();
+    movingSegments.query(bounds, out);
+    if (type != NO_COLLISION) {
+        out.erase(std::remove_if(out.begin() + numStatic, out.end(),
+                                 [&](size_t id) {
+                                     return segments[id].type != type;
+                                 }),
+                  out.end());
+    }
+    std::inplace_merge(out.begin(), out.begin() + numStatic, out.end());
+}
+
+void Map::queryCorners(Bounds const& bounds, std::vector<size_t>& out) const {
+    corners.query(bounds, out);
+    if (movingCorners.size() == 0) {
+        return;
+    }
+
+    size_t numStatic = out.size();
+    movingCorners.query(bounds, out);
+    std::inplace_merge(out.begin(), out.begin() + numStatic, out.end());
+}
+
+PlatformSegment Map::toPlatformSegment(size_t id) const {
+    return platforms[segments[id].platform].getSegment(segments[id].index);
+}
 
 #define PLATFORM_LAND_EPSILON 0.000001
+
+// padding applied to the bounds of a sweep before querying the broadphase,
+// so that segments just touching the sweep are still tested
+#define BROADPHASE_MARGIN 0.001
+
+/** Test the sweep against a single segment, updating the closest collision
+ * if the segment is hit closer than the current closest collision
+ */
+bool closestSegmentCollision(MapSegment const& segment,
+                             Pair const& start,
+                             Pair const& end,
+                             wideReal& closestDist,
+                             Pair& closestPosition) {
+    Pair intersectionPoint;
+    int direction =
+        checkLineIntersection(start, end, segment.first, segment.second,
+                              intersectionPoint, PLATFORM_LAND_EPSILON);
+
+    if (direction >= 0)
+        return false;
+
+    wideReal distance = (intersectionPoint - start).euclid();
+    if (distance < closestDist) {
+        closestDist = distance;
+        closestPosition = intersectionPoint;
+        return true;
+    }
+
+    return false;
+}
+
+void Map::fillCollision(size_t id,
+                        Pair const& position,
+                        TerrainCollisionType type,
+                        CollisionDatum& out) const {
+    out.type = type;
+    out.segment = toPlatformSegment(id);
+    out.segmentId = id;
+    out.position = position;
+}
+
+void Map::gatherCandidates(Ecb const& currentEcb,
+                           Ecb const& projectedEcb,
+                           MovementScratch& scratch) const {
+    CollisionCandidates& nearby = scratch.nearby;
+    nearby.clear();
+
+    Ecb const* ecbs[] = {&currentEcb, &projectedEcb};
+    for (Ecb const* ecb : ecbs) {
+        nearby.bounds.include(ecb->left);
+        nearby.bounds.include(ecb->right);
+        nearby.bounds.include(ecb->top);
+        nearby.bounds.include(ecb->bottom);
+    }
+    nearby.bounds = nearby.bounds.expanded(BROADPHASE_MARGIN);
+
+    // the NO_COLLISION bucket holds every segment, so one query finds the
+    // candidates of every type
+    querySegments(NO_COLLISION, nearby.bounds, nearby.segments[NO_COLLISION]);
+    for (size_t id : nearby.segments[NO_COLLISION]) {
+        nearby.segments[segments[id].type].push_back(id);
+    }
+    queryCorners(nearby.bounds, nearby.corners);
+
+    scratch.collisionStats.candidatePasses++;
+}
+
 bool Map::getClosestCollision(
     Pair const& start,
     Pair const& end,
     CollisionDatum& outputCollision,
     PlatformSegment& ignoredCollision,
     TerrainCollisionType expectedCollisionType) const {
-    double closestDist = DOUBLE_INFINITY;
-    PlatformSegment segment;
-    bool anyCollision = false;
+    // only test the segments of the expected type whose bounds overlap the
+    // sweep
+    querySegments(expectedCollisionType,
+                  Bounds(start, end).expanded(BROADPHASE_MARGIN), candidates);
+
+    return closestCollisionAmong(start, end, candidates, outputCollision,
+                                 ignoredCollision, expectedCollisionType,
+                                 frameStats);
+}
 
-    for (PlatformSegment segment : getSegments()) {
-        if (segment == ignoredCollision && false) {
-            _debug(out << "ignoring collision with platform because it was "
-                          "previously "
-                          "collided with"
-                       << std::endl;
-                   out << ignoredCollision << std::endl;
-                   out << segment << std::endl;);
-            continue;
+bool Map::getClosestCollision(Pair const& start,
+                              Pair const& end,
+                              CollisionDatum& outputCollision,
+                              PlatformSegment& ignoredCollision,
+                              TerrainCollisionType expectedCollisionType,
+                              MovementScratch& scratch) const {
+    QueryCache& cache = scratch.queryCache;
+    if (cacheQueries) {
+        cache.validate(this, queryEpoch);
+        QueryCache::Entry const* cached =
+            cache.find(start, end, expectedCollisionType);
+        if (cached != NULL) {
+            scratch.collisionStats.cacheHits++;
+            if (cached->hit) {
+                fillCollision(cached->segmentId, cached->position,
+                              expectedCollisionType, outputCollision);
+            }
+            return cached->hit;
         }
+        scratch.collisionStats.cacheMisses++;
+    }
 
-        Pair p1 = *segment.firstPoint(), p2 = *segment.secondPoint(),
-             intersectionPoint;
-        int direction = checkLineIntersection(
-            start, end, p1, p2, intersectionPoint, PLATFORM_LAND_EPSILON);
+    CollisionCandidates const& nearby = scratch.nearby;
+    Bounds sweep = Bounds(start, end).expanded(BROADPHASE_MARGIN);
+    std::vector<size_t> const* ids = &nearby.segments[expectedCollisionType];
+    if (!nearby.bounds.contains(sweep)) {
+        querySegments(expectedCollisionType, sweep, scratch.queryIds);
+        ids = &scratch.queryIds;
+    }
 
-        if (direction >= 0)
-            continue;
+    bool anyCollision = closestCollisionAmong(
+        start, end, *ids, outputCollision, ignoredCollision,
+        expectedCollisionType, scratch.collisionStats);
+    if (cacheQueries) {
+        cache.store(start, end, expectedCollisionType, anyCollision,
+                    anyCollision ? outputCollision.segmentId : 0,
+                    anyCollision ? outputCollision.position : Pair(0, 0));
+    }
+    return anyCollision;
+}
 
-        double angle = segment.angle();
-        switch (expectedCollisionType) {
-            case CEIL_COLLISION:
-                std::cout << "ceil coll! " << angle << "  "
-                          << Platform::isCeil(angle) << std::endl;
-                if (!Platform::isCeil(angle))
-                    continue;
-                break;
-            case WALL_COLLISION:
-                if (Platform::isCeil(angle) || !Platform::isWall(angle))
-                    continue;
-                break;
-            case FLOOR_COLLISION:
-                if (Platform::isCeil(angle) || Platform::isWall(angle))
-                    continue;
-                break;
-            case NO_COLLISION:
-                break;
+bool Map::closestCollisionAmong(
+    Pair const& start,
+    Pair const& end,
+    std::vector<size_t> const& ids,
+    CollisionDatum& outputCollision,
+    PlatformSegment& ignoredCollision,
+    TerrainCollisionType expectedCollisionType,
+    CollisionStats& stats) const {
+    stats.queries[expectedCollisionType]++;
+    stats.segmentTests[expectedCollisionType] += ids.size();
+
+    LineHit hit;
+    bool anyCollision =
+        checkLineIntersectionBatch(start, end, segmentArrays, ids.data(),
+                                   ids.size(), -1, hit, PLATFORM_LAND_EPSILON);
+
+    if (anyCollision) {
+        fillCollision(hit.index, hit.point, expectedCollisionType,
+                      outputCollision);
+    }
+
+    if (validateBroadphase) {
+        CollisionDatum expected;
+        bool expectedAny = getClosestCollisionBruteForce(
+            start, end, expected, ignoredCollision, expectedCollisionType);
+        if (expectedAny != anyCollision ||
+            (anyCollision && (expected.segmentId != outputCollision.segmentId ||
+                              expected.position != outputCollision.position))) {
+            stats.broadphaseMismatches++;
+            std::cerr << "broadphase mismatch sweeping " << start << ".."
+                      << end << ": expected " << expectedAny << " "
+                      << expected.segment << " got " << anyCollision << " "
+                      << outputCollision.segment << std::endl;
         }
+    }
+
+    return anyCollision;
+}
+
+bool Map::getClosestCollisionBruteForce(
+    Pair const& start,
+    Pair const& end,
+    CollisionDatum& outputCollision,
+    PlatformSegment& ignoredCollision,
+    TerrainCollisionType expectedCollisionType) const {
+    wideReal closestDist = DOUBLE_INFINITY;
+    Pair closestPosition;
+    size_t closestId = 0;
+    bool anyCollision = false;
 
-        double distance = (intersectionPoint - start).euclid();
-        if (distance < closestDist) {
-            closestDist = distance;
-            outputCollision.type = expectedCollisionType;
-            outputCollision.segment = segment;
-            outputCollision.position = intersectionPoint;
+    for (size_t id = 0; id < segments.size(); id++) {
+        if (expectedCollisionType != NO_COLLISION &&
+            segments[id].type != expectedCollisionType)
+            continue;
+
+        if (closestSegmentCollision(segments[id], start, end, closestDist,
+                                    closestPosition)) {
+            closestId = id;
             anyCollision = true;
         }
     }
 
+    if (anyCollision) {
+        fillCollision(closestId, closestPosition, expectedCollisionType,
+                      outputCollision);
+    }
+
     return anyCollision;
 }
 
+/** Sweep the line a1..a2 to b1..b2 against a single corner, updating the
+ * closest collision if the corner is hit before the current closest one
+ */
+static bool closestCornerCollision(MapPoint const& p,
+                                   Pair const& a1,
+                                   Pair const& a2,
+                                   Pair const& b1,
+                                   Pair const& b2,
+                                   PlatformSegment* ignoredCollision,
+                                   wideReal& closestDist,
+                                   EdgeCollision& collision) {
+    Pair point = p.position;
+    Pair line1, line2;
+    int direction = checkLineSweep(a1, a2, b1, b2, point, line1, line2);
+
+    if (direction != -1)
+        return false;
+
+    // don't collide with the platform we're standing on
+    if (ignoredCollision != NULL &&
+        (point == *ignoredCollision->firstPoint() ||
+         point == *ignoredCollision->secondPoint())) {
+        return false;
+    }
+
+    wideReal distance = (line1 - a1).euclid();
+    if (distance < closestDist) {
+        closestDist = distance;
+        collision.cornerPosition = point;
+        collision.collisionLine1 = line1;
+        collision.collisionLine2 = line2;
+        collision.s1Id = p.firstSegment;
+        collision.s2Id = p.secondSegment;
+        return true;
+    }
+
+    return false;
+}
+
+static Bounds edgeSweepBounds(Pair const& a1,
+                              Pair const& a2,
+                              Pair const& b1,
+                              Pair const& b2) {
+    Bounds sweep(a1, a2);
+    sweep.include(b1);
+    sweep.include(b2);
+    return sweep.expanded(BROADPHASE_MARGIN);
+}
+
 bool Map::getClosestEdgeCollision(Pair const& a1,
                                   Pair const& a2,
                                   Pair const& b1,
                                   Pair const& b2,
                                   EdgeCollision& collision,
                                   PlatformSegment* ignoredCollision) const {
-    for (PlatformPoint const& p : getPoints()) {
-        // TODO compare if multiple colls happen same frame?
-        Pair point = p.point();
-        if (p.getPlatform()->isPassable())
-            continue;
+    queryCorners(edgeSweepBounds(a1, a2, b1, b2), candidates);
+    return closestEdgeCollisionAmong(a1, a2, b1, b2, candidates, collision,
+                                     ignoredCollision, frameStats);
+}
 
-        int direction =
-            checkLineSweep(a1, a2, b1, b2, point, collision.collisionLine1,
-                           collision.collisionLine2);
+bool Map::getClosestEdgeCollision(Pair const& a1,
+                                  Pair const& a2,
+                                  Pair const& b1,
+                                  Pair const& b2,
+                                  EdgeCollision& collision,
+                                  PlatformSegment* ignoredCollision,
+                                  MovementScratch& scratch) const {
+    Bounds sweep = edgeSweepBounds(a1, a2, b1, b2);
+    std::vector<size_t> const* ids = &scratch.nearby.corners;
+    if (!scratch.nearby.bounds.contains(sweep)) {
+        queryCorners(sweep, scratch.queryIds);
+        ids = &scratch.queryIds;
+    }
+
+    return closestEdgeCollisionAmong(a1, a2, b1, b2, *ids, collision,
+                                     ignoredCollision, scratch.collisionStats);
+}
+
+bool Map::closestEdgeCollisionAmong(Pair const& a1,
+                                    Pair const& a2,
+                                    Pair const& b1,
+                                    Pair const& b2,
+                                    std::vector<size_t> const& ids,
+                                    EdgeCollision& collision,
+                                    PlatformSegment* ignoredCollision,
+                                    CollisionStats& stats) const {
+    wideReal closestDist = DOUBLE_INFINITY;
+    bool anyCollision = false;
+
+    stats.edgeQueries++;
 
-        if (direction != -1)
+    // corners are visited in ascending id order and only a strictly closer
+    // hit replaces the current one, so ties go to the lowest id
+    for (size_t id : ids) {
+        MapPoint const& p = points[id];
+        if (!inSweptQuad(a1, a2, b1, b2, p.position, BROADPHASE_MARGIN))
             continue;
 
-        if (ignoredCollision != NULL &&
-            (point == *ignoredCollision->firstPoint() ||
-             point == *ignoredCollision->secondPoint())) {
+        stats.cornerTests++;
+        if (closestCornerCollision(p, a1, a2, b1, b2, ignoredCollision,
+                                   closestDist, collision)) {
+            anyCollision = true;
+        }
+    }
+
+    if (anyCollision) {
+        collision.s1 = toPlatformSegment(collision.s1Id);
+        collision.s2 = toPlatformSegment(collision.s2Id);
+    }
+
+    if (validateBroadphase) {
+        EdgeCollision expected;
+        bool expectedAny = getClosestEdgeCollisionBruteForce(
+            a1, a2, b1, b2, expected, ignoredCollision);
+        if (expectedAny != anyCollision ||
+            (anyCollision &&
+             expected.cornerPosition != collision.cornerPosition)) {
+            stats.broadphaseMismatches++;
+            std::cerr << "corner broadphase mismatch sweeping " << a1 << ".."
+                      << a2 << " to " << b1 << ".." << b2 << ": expected "
+                      << expectedAny << " " << expected.cornerPosition
+                      << " got " << anyCollision << " "
+                      << collision.cornerPosition << std::endl;
+        }
+    }
+
+    return anyCollision;
+}
+
+bool Map::getClosestEdgeCollisionBruteForce(
+    Pair const& a1,
+    Pair const& a2,
+    Pair const& b1,
+    Pair const& b2,
+    EdgeCollision& collision,
+    PlatformSegment* ignoredCollision) const {
+    wideReal closestDist = DOUBLE_INFINITY;
+    bool anyCollision = false;
+
+    for (MapPoint const& p : points) {
+        if (p.passable)
             continue;
-            std::cout << "ignoring this platform, i'm standing on it!"
-                      << std::endl;
+
+        if (closestCornerCollision(p, a1, a2, b1, b2, ignoredCollision,
+                                   closestDist, collision)) {
+            anyCollision = true;
         }
+    }
 
-        collision.cornerPosition = point;
-        collision.s1 = p.firstSegment();
-        collision.s2 = p.secondSegment();
-        return true;
+    if (anyCollision) {
+        collision.s1 = toPlatformSegment(collision.s1Id);
+        collision.s2 = toPlatformSegment(collision.s2Id);
     }
 
-    return false;
+    return anyCollision;
 }
 
 void basicProjection(Player& player,
@@ -226,17 +863,28 @@ void basicProjection(Player& player,
     }
 }
 
-void Map::moveRecursive(Player& player,
-                        Ecb& currentEcb,
-                        Ecb& projectedEcb) const {
-    // ecb after resolving the next step of motion
-    Ecb nextStepEcb = projectedEcb;
-
-    _debug(out.indent(4); out << std::endl;
-           out << "===========================" << std::endl;
-           out << "moveRecursive" << std::endl;
-           out << "    " << currentEcb << std::endl;
-           out << "    " << projectedEcb << std::endl;);
+/** Run one iteration of the walk on top of the scratch frame stack
+ *
+ * Moves currentEcb towards the frame's projected ecb, stopping at the
+ * closest collision. A walk interrupted by a collision pushes a nested walk
+ * starting from the collision point.
+ */
+Map::MovementStep Map::stepMovement(Player& player,
+                                    Ecb& currentEcb,
+                                    MovementScratch& scratch) const {
+    MovementFrame& frame = scratch.frames[scratch.depth - 1];
+    Ecb& nextStepEcb = frame.nextStepEcb;
+    Ecb& projectedEcb = frame.projectedEcb;
+    PlatformSegment& lastWallCollision = frame.lastWallCollision;
+    Ecb& closestNextStepEcb = frame.closestNextStepEcb;
+    Ecb& closestProjectedEcb = frame.closestProjectedEcb;
+    PlatformSegment& closestLastWallCollision = frame.closestLastWallCollision;
+
+    Ecb& closestCollisionPointEcb = scratch.closestCollisionPointEcb;
+    Ecb& tmpCollisionPointEcb = scratch.tmpCollisionPointEcb;
+    Ecb& tmpNextStepEcb = scratch.tmpNextStepEcb;
+    Ecb& tmpProjectedEcb = scratch.tmpProjectedEcb;
+    PlatformSegment& tmpLastWallCollision = scratch.tmpLastWallCollision;
 
 #define debugEcb()                                             \
     {                                                          \
@@ -269,7 +917,7 @@ void Map::moveRecursive(Player& player,
             currentClosestDistance = thisProjectedDistance;           \
             currentPriority = thisPriority;                           \
             e = type;                                                 \
-            debugTmpEcb();                                            \
+            _debug(debugTmpEcb());                                    \
         } else {                                                      \
             _debug(out << "ignoring, current is closer" << std::endl; \
                    out << thisProjectedDistance << " > "              \
@@ -278,187 +926,323 @@ void Map::moveRecursive(Player& player,
         _debug(out << "----" << std::endl;);                          \
     }
 
-    PlatformSegment lastWallCollision = PlatformSegment(NULL, -1);
+    // panic state
+    frame.iterationCount++;
+    scratch.stats.iterations++;
+    if (frame.iterationCount > MOVEMENT_FRAME_ITERATIONS) {
+        _debug(out << "panicing and exiting on iteration "
+                   << frame.iterationCount << std::endl;
+               out.indent(-4););
+        scratch.stats.panicked = true;
+        return MOVEMENT_STEP_RESOLVED;
+    }
 
-    int iterationCount = 0;
-    do {
-        // panic state
-        iterationCount++;
-        if (iterationCount > 10) {
-            _debug(out << "panicing and exiting on iteration " << iterationCount
-                       << std::endl;
-                   // exit(1);
-                   out.indent(-4););
-            return;
-        }
+    _debug(out << std::endl;
+           out << "---------------------------" << std::endl; debugEcb();
+           out << "---------------------------" << std::endl;);
+
+    wideReal currentClosestDistance = DOUBLE_INFINITY;
+    wideReal thisProjectedDistance = DOUBLE_INFINITY;
+    int currentPriority = 0, thisPriority;
+    closestCollisionPointEcb = nextStepEcb;
+    closestNextStepEcb = nextStepEcb;
+    closestProjectedEcb = projectedEcb;
+
+    tmpCollisionPointEcb = currentEcb;
+    tmpNextStepEcb = nextStepEcb;
+    tmpProjectedEcb = projectedEcb;
+    closestLastWallCollision = lastWallCollision;
+    tmpLastWallCollision = lastWallCollision;
+
+    ENVIRONMENT_COLLISION_TYPE e = NO_ENVIRONMENT_COLLISION;
+
+    // we make movements in short segments.
+    // each of these collisions will optionally update nextStepEcb if they
+    // are closer than the original ecb
+
+    const Platform* currentPlatform = NULL;
+    Player const& player_const = player;
+
+    gatherCandidates(currentEcb, projectedEcb, scratch);
+    scratch.stats.probes += player.isGrounded() ? 8 : 9;
+
+    // perform right wall collision
+    if ((thisPriority = rightWallCollision(
+             *this, player_const, Pair(1, 0), tmpCollisionPointEcb,
+             tmpNextStepEcb, tmpProjectedEcb, thisProjectedDistance,
+             tmpLastWallCollision, scratch))) {
+        overrideEcbs("Right Wall collision", ENVIRONMENT_WALL_COLLISION,
+                     origin);
+    }
 
-        _debug(out << std::endl;
-               out << "---------------------------" << std::endl; debugEcb();
-               out << "---------------------------" << std::endl;);
-
-        double currentClosestDistance = DOUBLE_INFINITY;
-        double thisProjectedDistance = DOUBLE_INFINITY;
-        int currentPriority = 0, thisPriority;
-        Ecb closestCollisionPointEcb = nextStepEcb;
-        Ecb closestNextStepEcb = nextStepEcb;
-        Ecb closestProjectedEcb = projectedEcb;
-
-        Ecb tmpCollisionPointEcb = currentEcb;
-        Ecb tmpNextStepEcb = nextStepEcb;
-        Ecb tmpProjectedEcb = projectedEcb;
-        PlatformSegment closestLastWallCollision = lastWallCollision;
-        PlatformSegment tmpLastWallCollision = lastWallCollision;
-
-        ENVIRONMENT_COLLISION_TYPE e = NO_ENVIRONMENT_COLLISION;
-
-        // we make movements in short segments.
-        // each of these collisions will optionally update nextStepEcb if they
-        // are closer than the original ecb
-
-        const Platform* currentPlatform = NULL;
-        Player const& player_const = player;
-
-        // perform right wall collision
-        if ((thisPriority = rightWallCollision(
-                 *this, player_const, Pair(1, 0), tmpCollisionPointEcb,
-                 tmpNextStepEcb, tmpProjectedEcb, thisProjectedDistance,
-                 tmpLastWallCollision))) {
-            overrideEcbs("Right Wall collision", ENVIRONMENT_WALL_COLLISION,
-                         origin);
-        }
+    // perform left wall collision
+    tmpCollisionPointEcb = currentEcb;
+    tmpNextStepEcb = nextStepEcb;
+    tmpProjectedEcb = projectedEcb;
+    tmpLastWallCollision = lastWallCollision;
+    if ((thisPriority = leftWallCollision(
+             *this, player_const, Pair(-1, 0), tmpCollisionPointEcb,
+             tmpNextStepEcb, tmpProjectedEcb, thisProjectedDistance,
+             tmpLastWallCollision, scratch))) {
+        overrideEcbs("Left Wall collision", ENVIRONMENT_WALL_COLLISION,
+                     origin);
+    }
 
-        // perform left wall collision
-        tmpCollisionPointEcb = currentEcb;
-        tmpNextStepEcb = nextStepEcb;
-        tmpProjectedEcb = projectedEcb;
-        tmpLastWallCollision = lastWallCollision;
-        if ((thisPriority = leftWallCollision(
-                 *this, player_const, Pair(-1, 0), tmpCollisionPointEcb,
-                 tmpNextStepEcb, tmpProjectedEcb, thisProjectedDistance,
-                 tmpLastWallCollision))) {
-            overrideEcbs("Left Wall collision", ENVIRONMENT_WALL_COLLISION,
-                         origin);
-        }
+    // // perform ceiling collision
+    tmpCollisionPointEcb = currentEcb;
+    tmpNextStepEcb = nextStepEcb;
+    tmpProjectedEcb = projectedEcb;
+    tmpLastWallCollision = lastWallCollision;
+    if ((thisPriority = ceilingCollision(
+             *this, player_const, Pair(0, -1), tmpCollisionPointEcb,
+             tmpNextStepEcb, tmpProjectedEcb, thisProjectedDistance,
+             tmpLastWallCollision, scratch))) {
+        overrideEcbs("Ceiling collision", ENVIRONMENT_CEIL_COLLISION,
+                     origin);
+    }
 
-        // // perform ceiling collision
-        tmpCollisionPointEcb = currentEcb;
-        tmpNextStepEcb = nextStepEcb;
-        tmpProjectedEcb = projectedEcb;
-        tmpLastWallCollision = lastWallCollision;
-        if ((thisPriority = ceilingCollision(
-                 *this, player_const, Pair(0, -1), tmpCollisionPointEcb,
-                 tmpNextStepEcb, tmpProjectedEcb, thisProjectedDistance,
-                 tmpLastWallCollision))) {
-            overrideEcbs("Ceiling collision", ENVIRONMENT_CEIL_COLLISION,
-                         origin);
-        }
+    tmpCollisionPointEcb = currentEcb;
+    tmpNextStepEcb = nextStepEcb;
+    tmpProjectedEcb = projectedEcb;
+    if ((thisPriority = topRightEdgeCollision(
+             *this, player_const, tmpCollisionPointEcb, tmpNextStepEcb,
+             tmpProjectedEcb, thisProjectedDistance, scratch))) {
+        overrideEcbs("Top Right Edge collision", ENVIRONMENT_EDGE_COLLISION,
+                     origin);
+    }
 
-        tmpCollisionPointEcb = currentEcb;
-        tmpNextStepEcb = nextStepEcb;
-        tmpProjectedEcb = projectedEcb;
-        if ((thisPriority = topRightEdgeCollision(
-                 *this, player_const, tmpCollisionPointEcb, tmpNextStepEcb,
-                 tmpProjectedEcb, thisProjectedDistance))) {
-            overrideEcbs("Top Right Edge collision", ENVIRONMENT_EDGE_COLLISION,
-                         origin);
-        }
+    tmpCollisionPointEcb = currentEcb;
+    tmpNextStepEcb = nextStepEcb;
+    tmpProjectedEcb = projectedEcb;
+    if ((thisPriority = bottomRightEdgeCollision(
+             *this, player_const, tmpCollisionPointEcb, tmpNextStepEcb,
+             tmpProjectedEcb, thisProjectedDistance, scratch))) {
+        overrideEcbs("Bottom Right Edge collision",
+                     ENVIRONMENT_EDGE_COLLISION, origin);
+    }
 
-        tmpCollisionPointEcb = currentEcb;
-        tmpNextStepEcb = nextStepEcb;
-        tmpProjectedEcb = projectedEcb;
-        if ((thisPriority = bottomRightEdgeCollision(
-                 *this, player_const, tmpCollisionPointEcb, tmpNextStepEcb,
-                 tmpProjectedEcb, thisProjectedDistance))) {
-            overrideEcbs("Bottom Right Edge collision",
-                         ENVIRONMENT_EDGE_COLLISION, origin);
-        }
+    tmpCollisionPointEcb = currentEcb;
+    tmpNextStepEcb = nextStepEcb;
+    tmpProjectedEcb = projectedEcb;
+    if ((thisPriority = bottomLeftEdgeCollision(
+             *this, player_const, tmpCollisionPointEcb, tmpNextStepEcb,
+             tmpProjectedEcb, thisProjectedDistance, scratch))) {
+        overrideEcbs("Bottom Left Edge collision",
+                     ENVIRONMENT_EDGE_COLLISION, origin);
+    }
 
-        tmpCollisionPointEcb = currentEcb;
-        tmpNextStepEcb = nextStepEcb;
-        tmpProjectedEcb = projectedEcb;
-        if ((thisPriority = bottomLeftEdgeCollision(
-                 *this, player_const, tmpCollisionPointEcb, tmpNextStepEcb,
-                 tmpProjectedEcb, thisProjectedDistance))) {
-            overrideEcbs("Bottom Left Edge collision",
-                         ENVIRONMENT_EDGE_COLLISION, origin);
-        }
+    tmpCollisionPointEcb = currentEcb;
+    tmpNextStepEcb = nextStepEcb;
+    tmpProjectedEcb = projectedEcb;
+    if ((thisPriority = topRightEdgeCollision(
+             *this, player_const, tmpCollisionPointEcb, tmpNextStepEcb,
+             tmpProjectedEcb, thisProjectedDistance, scratch))) {
+        overrideEcbs("Bottom Left Edge collision",
+                     ENVIRONMENT_EDGE_COLLISION, origin);
+    }
 
-        tmpCollisionPointEcb = currentEcb;
-        tmpNextStepEcb = nextStepEcb;
-        tmpProjectedEcb = projectedEcb;
-        if ((thisPriority = topRightEdgeCollision(
-                 *this, player_const, tmpCollisionPointEcb, tmpNextStepEcb,
-                 tmpProjectedEcb, thisProjectedDistance))) {
-            overrideEcbs("Bottom Left Edge collision",
-                         ENVIRONMENT_EDGE_COLLISION, origin);
-        }
+    tmpCollisionPointEcb = currentEcb;
+    tmpNextStepEcb = nextStepEcb;
+    tmpProjectedEcb = projectedEcb;
+    if ((thisPriority = topLeftEdgeCollision(
+             *this, player_const, tmpCollisionPointEcb, tmpNextStepEcb,
+             tmpProjectedEcb, thisProjectedDistance, scratch))) {
+        overrideEcbs("Top Left Edge collision", ENVIRONMENT_EDGE_COLLISION,
+                     origin);
+    }
 
+    if (!player.isGrounded()) {
+        // perform this collision last so that we can call player::land()
+        // without it being overridden
         tmpCollisionPointEcb = currentEcb;
         tmpNextStepEcb = nextStepEcb;
         tmpProjectedEcb = projectedEcb;
-        if ((thisPriority = topLeftEdgeCollision(
-                 *this, player_const, tmpCollisionPointEcb, tmpNextStepEcb,
-                 tmpProjectedEcb, thisProjectedDistance))) {
-            overrideEcbs("Top Left Edge collision", ENVIRONMENT_EDGE_COLLISION,
-                         origin);
+        if (performFloorCollision(*this, player, tmpCollisionPointEcb,
+                                  tmpNextStepEcb, tmpProjectedEcb,
+                                  currentPlatform, thisProjectedDistance,
+                                  scratch)) {
+            overrideEcbs("Floor Collision", ENVIRONMENT_FLOOR_COLLISION,
+                         bottom);
         }
+    }
 
-        if (!player.isGrounded()) {
-            // perform this collision last so that we can call player::land()
-            // without it being overridden
-            tmpCollisionPointEcb = currentEcb;
-            tmpNextStepEcb = nextStepEcb;
-            tmpProjectedEcb = projectedEcb;
-            if (performFloorCollision(*this, player, tmpCollisionPointEcb,
-                                      tmpNextStepEcb, tmpProjectedEcb,
-                                      currentPlatform, thisProjectedDistance)) {
-                overrideEcbs("Floor Collision", ENVIRONMENT_FLOOR_COLLISION,
-                             bottom);
-            }
+    // this only works because landing terminates collision
+    if (e == ENVIRONMENT_FLOOR_COLLISION) {
+        player.land(currentPlatform);
+    }
+
+    // interrupt the walk if we hit something, and walk the rest of this
+    // step from the position of the collision
+    if (currentClosestDistance != DOUBLE_INFINITY &&
+        closestNextStepEcb.origin != projectedEcb.origin) {
+        _debug(out << "######## movement was interrupted, nesting!"
+                   << std::endl;);
+        currentEcb = closestCollisionPointEcb;
+        frame.predictedNextStep = closestNextStepEcb.origin;
+
+        if (scratch.depth == MOVEMENT_MAX_DEPTH) {
+            scratch.stats.panicked = true;
+            return MOVEMENT_STEP_RESOLVED;
         }
 
-        // this only works because landing terminates collision
-        if (e == ENVIRONMENT_FLOOR_COLLISION) {
-            player.land(currentPlatform);
+        pushMovementFrame(scratch, closestNextStepEcb);
+        return MOVEMENT_STEP_INTERRUPTED;
+    }
+
+    // otherwise, just jump the player to the next step of their motion
+    // this will be the projected ecb
+    currentEcb = closestNextStepEcb;
+    return finishMovementStep(currentEcb, frame);
+}
+
+void Map::pushMovementFrame(MovementScratch& scratch,
+                            Ecb const& projectedEcb) const {
+    MovementFrame& frame = scratch.frames[scratch.depth++];
+    frame.nextStepEcb = projectedEcb;
+    frame.projectedEcb = projectedEcb;
+    frame.lastWallCollision = PlatformSegment(NULL, -1);
+    frame.iterationCount = 0;
+    scratch.stats.maxDepth = std::max(scratch.stats.maxDepth, scratch.depth);
+
+    _debug(out.indent(4); out << std::endl;
+           out << "===========================" << std::endl;
+           out << "walk" << std::endl;
+           out << "    " << projectedEcb << std::endl;);
+}
+
+Map::MovementStep Map::finishMovementStep(Ecb const& currentEcb,
+                                          MovementFrame& frame) const {
+    frame.lastWallCollision = frame.closestLastWallCollision;
+    frame.nextStepEcb = frame.closestProjectedEcb;
+    frame.projectedEcb = frame.closestProjectedEcb;
+
+    if (currentEcb.origin != frame.projectedEcb.origin)
+        return MOVEMENT_STEP_CONTINUE;
+
+    _debug(out << "resolving: " << currentEcb << std::endl;
+           out << "===========================" << std::endl; out.indent(-4););
+    return MOVEMENT_STEP_RESOLVED;
+}
+
+void Map::solveMovement(Player& player,
+                        Ecb& currentEcb,
+                        Ecb& projectedEcb,
+                        MovementScratch& scratch) const {
+    scratch.depth = 0;
+    pushMovementFrame(scratch, projectedEcb);
+
+    while (scratch.depth > 0) {
+        if (scratch.stats.iterations >= MOVEMENT_ITERATION_BUDGET) {
+            // out of time, leave the player where they got to
+            scratch.stats.budgetExhausted = true;
+            scratch.stats.panicked = true;
+            projectedEcb = scratch.frames[0].projectedEcb;
+            scratch.depth = 0;
+            return;
         }
 
-        // recursively update this step of motion if we were interrupted
-        if (currentClosestDistance != DOUBLE_INFINITY &&
-            closestNextStepEcb.origin != projectedEcb.origin) {
-            _debug(out << "######## movement was interrupted, recursing!"
-                       << std::endl;);
-            // start the recursive walk at the position of the collision
-            currentEcb = closestCollisionPointEcb;
-            Ecb predictedNextStepEcb = closestNextStepEcb;
-            moveRecursive(player, currentEcb, closestNextStepEcb);
-            if (predictedNextStepEcb.origin != closestNextStepEcb.origin) {
-                // the other motion interrupted this motion, so
-                // our projected ECB is no longer valid. The recursive call
-                // will have resolved motion ,so we break;
-                _debug(out << "recursive walk changed projected ECB"
-                           << std::endl;
-                       out << "breaking loop" << std::endl;);
-                // currentEcb = closestNextStepEcb;
+        if (stepMovement(player, currentEcb, scratch) !=
+            MOVEMENT_STEP_RESOLVED)
+            continue;
+
+        // the walk resolved, hand its projected ecb to the walk it
+        // interrupted, which then finishes its own iteration
+        while (scratch.depth > 0) {
+            scratch.depth--;
+            Ecb const& resolvedEcb = scratch.frames[scratch.depth].projectedEcb;
+            if (scratch.depth == 0) {
+                projectedEcb = resolvedEcb;
                 break;
             }
-        } else {
-            // otherwise, just jump the player to the next step of their motion
-            // this will be the projected ecb
-            currentEcb = closestNextStepEcb;
-        }
-        lastWallCollision = closestLastWallCollision;
-        nextStepEcb = closestProjectedEcb;
-        projectedEcb = closestProjectedEcb;
 
-    } while (currentEcb.origin != projectedEcb.origin);
+            MovementFrame& frame = scratch.frames[scratch.depth - 1];
+            frame.closestNextStepEcb = resolvedEcb;
+            if (frame.predictedNextStep != frame.closestNextStepEcb.origin) {
+                // the nested walk changed where this walk ends up, so this
+                // walk's projection is no longer valid. The nested walk
+                // resolved the motion, so this walk is done as well
+                _debug(out << "nested walk changed projected ECB"
+                           << std::endl;);
+                continue;
+            }
 
-    _debug(out << "resolving: " << currentEcb << std::endl;
-           out << "===========================" << std::endl; out.indent(-4););
+            if (finishMovementStep(currentEcb, frame) ==
+                MOVEMENT_STEP_CONTINUE)
+                break;
+        }
+    }
 }
 
 void Map::movePlayer(Player& player, Pair& requestedDistance) const {
+    movePlayer(player, requestedDistance, scratch);
+}
+
+void Map::movePlayer(Player& player,
+                     Pair& requestedDistance,
+                     MovementScratch& scratch) const {
+    scratch.collisionStats.reset();
+    resolveMovement(player, requestedDistance, scratch);
+    frameStats.add(scratch.collisionStats);
+}
+
+void Map::movePlayers(Player* const* players,
+                      Pair* requestedDistances,
+                      size_t count,
+                      WorkerPool& pool,
+                      MovementStats* stats) const {
+    if (workerScratch.size() < pool.size()) {
+        workerScratch.resize(pool.size());
+    }
+    for (MovementScratch& s : workerScratch) {
+        s.collisionStats.reset();
+    }
+
+    // players only read the map and write to their own worker's scratch
+    pool.run(count, [&](size_t i, size_t worker) {
+        MovementScratch& s = workerScratch[worker];
+        resolveMovement(*players[i], requestedDistances[i], s);
+        if (stats != NULL) {
+            stats[i] = s.stats;
+        }
+    });
+
+    for (MovementScratch const& s : workerScratch) {
+        frameStats.add(s.collisionStats);
+    }
+}
+
+// players standing on a kinematic platform are carried along with it
+// before they move, and remember where on it they ended up after
+static void carryPlayer(Player& player) {
+    Platform const* platform = player.currentPlatform;
+    Pair position;
+    if (player.isGrounded() && platform != NULL &&
+        platform->carry(player.platformAnchor, position)) {
+        player.carryTo(position);
+    }
+}
+
+static void anchorPlayer(Player& player) {
+    Platform const* platform = player.currentPlatform;
+    if (player.isGrounded() && platform != NULL && platform->isKinematic()) {
+        platform->anchor(player.position, player.platformAnchor);
+    }
+}
+
+/** Move the player without touching any state outside of the player and
+ * scratch. Collision work is counted in scratch.collisionStats
+ */
+void Map::resolveMovement(Player& player,
+                          Pair& requestedDistance,
+                          MovementScratch& scratch) const {
+    scratch.stats.reset();
+    size_t segmentTests = scratch.collisionStats.totalSegmentTests();
+    size_t cornerTests = scratch.collisionStats.cornerTests;
+
+    carryPlayer(player);
+
     // TODO think about ledge grabbing
-    grabLedges(player);
+    grabLedges(player, scratch);
 
     _debug(out << "===========================" << std::endl;
            out << "===========================" << std::endl;
@@ -466,8 +1250,10 @@ void Map::movePlayer(Player& player, Pair& requestedDistance) const {
            out << "requested distance: " << requestedDistance << std::endl;
            out << "grounded? " << player.isGrounded() << std::endl;);
 
-    if (requestedDistance.x == 0 && requestedDistance.y == 0)
+    if (requestedDistance.x == 0 && requestedDistance.y == 0) {
+        anchorPlayer(player);
         return;
+    }
 
     // if the player is grounded, move them along the platform
     Pair projectedPosition = player.position;
@@ -492,26 +1278,32 @@ void Map::movePlayer(Player& player, Pair& requestedDistance) const {
                out << "projected pos:      " << projectedPosition
                    << std::endl;);
 
-        moveRecursive(player, currentEcb, projectedEcb);
+        solveMovement(player, currentEcb, projectedEcb, scratch);
 
         // reset player position to the projected Ecb
         player.moveTo(currentEcb);
     }
+    anchorPlayer(player);
+
+    scratch.stats.segmentTests =
+        scratch.collisionStats.totalSegmentTests() - segmentTests;
+    scratch.stats.cornerTests =
+        scratch.collisionStats.cornerTests - cornerTests;
+}
+
+MovementStats const& Map::getLastMovementStats() const {
+    return scratch.stats;
 }
 
-void Map::grabLedges(Player& player) const {
+void Map::grabLedges(Player& player, MovementScratch& scratch) const {
     if (!player.canGrabLedge())
         return;
 
-    for (Ledge const& l : ledges) {
-        Pair ledgebox_position = player.position + Pair(0, -LEDGEBOX_BASE);
-        Pair diff = l.position - ledgebox_position;
-        if (sign(diff.x) == sign(player.face) && player.face != l.facing &&
-            std::abs(diff.x) < LEDGEBOX_WIDTH && diff.y > -LEDGEBOX_HEIGHT &&
-            diff.y < 0) {
-            player.grabLedge(&l);
-            return;
-        }
+    Pair ledgebox_position = player.position + Pair(0, -LEDGEBOX_BASE);
+    int nearest = ledgeIndex.findNearest(ledges, ledgebox_position,
+                                         player.face, scratch.queryIds);
+    if (nearest >= 0) {
+        player.grabLedge(&ledges[nearest]);
     }
 }
 
@@ -519,27 +1311,76 @@ Platform* Map::getPlatform(size_t index) {
     return &(platforms[index]);
 }
 
-IteratorChain<PlatformPointArray> Map::getPoints() const {
-    std::vector<PlatformPointArray> arrays;
-    for (Platform const& p : platforms) {
-        arrays.push_back(p.points_iter());
-    }
-    return IteratorChain<PlatformPointArray>(arrays);
+std::vector<Platform> const& Map::getPlatforms() const {
+    return platforms;
 }
 
-IteratorChain<PlatformSegmentArray> Map::getSegments() const {
-    std::vector<PlatformSegmentArray> arrays;
-    for (Platform const& p : platforms) {
-        arrays.push_back(p.segments_iter());
-    }
-    return IteratorChain<PlatformSegmentArray>(arrays);
+Table<Ledge> const& Map::getLedges() const {
+    return ledges;
+}
+
+Table<MapPoint> const& Map::getPoints() const {
+    return points;
+}
+
+Table<MapSegment> const& Map::getSegments() const {
+    return segments;
+}
+
+SegmentBucket const& Map::getSegmentBucket(TerrainCollisionType type) const {
+    return buckets[type];
+}
+
+SegmentBucket const& Map::getPassableSegments() const {
+    return passableSegments;
+}
+
+CornerIndex const& Map::getCornerIndex() const {
+    return corners;
+}
+
+Table<KinematicPlatform> const& Map::getKinematicPlatforms() const {
+    return kinematicPlatforms;
+}
+
+void Map::startFrame() {
+    queryEpoch = newQueryEpoch();
+    broadphaseMismatches += frameStats.broadphaseMismatches;
+    lastFrameStats = frameStats;
+    frameStats.reset();
+}
+
+CollisionStats const& Map::getCollisionStats() const {
+    return frameStats;
+}
+
+CollisionStats const& Map::getLastFrameCollisionStats() const {
+    return lastFrameStats;
+}
+
+size_t Map::getBroadphaseMismatches() const {
+    return broadphaseMismatches + frameStats.broadphaseMismatches;
 }
 
 void Map::init() {
     makeMapMesh();
 }
 void Map::preUpdate() {}
-void Map::update() {}
+void Map::update() {
+    for (KinematicPlatform const& k : kinematicPlatforms) {
+        Platform& platform = platforms[k.platform];
+        PlatformMotion motion = platform.getMotion();
+        if (motion.velocity == Pair(0, 0) && motion.angularVelocity == 0) {
+            continue;
+        }
+
+        platform.transform(motion.velocity, motion.angularVelocity,
+                           motion.pivot);
+        motion.pivot += motion.velocity;
+        platform.setMotion(motion);
+        refitPlatform(k);
+    }
+}
 void Map::postUpdate() {}
 
 AbstractRenderer* Map::getRenderer() {
@@ -1,15 +1,31 @@
 #ifndef __GAME_MAP
 #define __GAME_MAP
 
+#include <stdint.h>
+#include <memory>
+#include <string>
 #include <vector>
 #include "engine/entity.hpp"
+#include "engine/table.hpp"
+#include "engine/workerpool.hpp"
 #include "player/player.hpp"
 #include "./platform.hpp"
 #include "./ledge.hpp"
 #include "./collisiondatum.hpp"
+#include "./segmentbucket.hpp"
+#include "./cornerindex.hpp"
+#include "./ledgeindex.hpp"
+#include "./kinematicindex.hpp"
+#include "./terrainquery.hpp"
+#include "./collisioncandidates.hpp"
+#include "./movementsolver.hpp"
+#include "./collisionstats.hpp"
+#include "./mapsegment.hpp"
+#include "./mappoint.hpp"
+#include "linebatch.hpp"
 #include "widthbuf.hpp"
-#include "iterator_wrapper.hpp"
 #include "engine/renderer/meshrenderer.hpp"
+#include "stage/mappedfile.hpp"
 
 namespace Terrain {
 
@@ -21,20 +37,192 @@ typedef enum ENVIRONMENT_COLLISION_TYPE {
     ENVIRONMENT_FLOOR_COLLISION,
 } ENVIRONMENT_COLLISION_TYPE;
 
+/** Where the segments and points of a kinematic platform are in the map's
+ * tables, and in its indices of moving segments and corners
+ */
+class KinematicPlatform {
+   public:
+    size_t platform;
+    size_t firstSegment;
+    size_t numSegments;
+    size_t firstPoint;
+    size_t numPoints;
+    size_t firstMovingSegment;
+    // corners of passable platforms aren't indexed
+    size_t firstMovingCorner;
+};
+
+/** What changes about a kinematic platform as the game runs, besides its
+ * points, as plain data
+ */
+typedef struct KinematicPlatformState {
+    PlatformMotion motion;
+    uint64_t moves;
+} KinematicPlatformState;
+
 class Map : public Entity {
     std::vector<Platform> platforms;
-    std::vector<Ledge> ledges;
+    Table<Ledge> ledges;
     MeshRenderer* renderer;
+    // compiled stage the tables point into, for maps loaded from one
+    std::shared_ptr<MappedFile> stageFile;
+
+    // every segment and point of every platform, flattened in platform
+    // order. Ids used by the collision structures index into these tables
+    Table<MapSegment> segments;
+    Table<MapPoint> points;
+    // segment endpoints in the same order as the table, laid out for the
+    // batched intersection kernel
+    SegmentArrays segmentArrays;
+    // scratch buffer for broadphase results, reused between queries
+    mutable std::vector<size_t> candidates;
+
+    // segments classified by the collision type they take part in. The
+    // NO_COLLISION bucket holds every segment
+    SegmentBucket buckets[NUM_COLLISION_TYPES];
+    SegmentBucket passableSegments;
+    CornerIndex corners;
+    LedgeIndex ledgeIndex;
+    // segments and corners of kinematic platforms are kept out of the
+    // buckets and the corner index, and are found through these instead,
+    // so moving a platform only refits its own bounds
+    Table<KinematicPlatform> kinematicPlatforms;
+    KinematicIndex movingSegments;
+    KinematicIndex movingCorners;
+    // mismatches of the frames before the one in progress
+    size_t broadphaseMismatches = 0;
+
+    mutable CollisionStats frameStats;
+    CollisionStats lastFrameStats;
+    // renewed every frame and whenever the geometry changes, so query
+    // caches know when to forget their results
+    size_t queryEpoch = 0;
+
+    // scratch used by movePlayer calls that don't bring their own
+    mutable MovementScratch scratch;
+    // one scratch per worker of the pool movePlayers last ran on
+    mutable std::vector<MovementScratch> workerScratch;
+
+    typedef enum MovementStep {
+        MOVEMENT_STEP_CONTINUE,
+        MOVEMENT_STEP_INTERRUPTED,
+        MOVEMENT_STEP_RESOLVED,
+    } MovementStep;
+
+    void resolveMovement(Player& player,
+                         Pair& requestedDistance,
+                         MovementScratch& scratch) const;
+    void solveMovement(Player& player,
+                       Ecb& currentEcb,
+                       Ecb& projectedEcb,
+                       MovementScratch& scratch) const;
+    MovementStep stepMovement(Player& player,
+                              Ecb& currentEcb,
+                              MovementScratch& scratch) const;
+    void pushMovementFrame(MovementScratch& scratch,
+                           Ecb const& projectedEcb) const;
+    MovementStep finishMovementStep(Ecb const& currentEcb,
+                                    MovementFrame& frame) const;
+
+    Map(StageReader& in, std::shared_ptr<MappedFile> const& stageFile);
 
-    void grabLedges(Player& player) const;
+    void grabLedges(Player& player, MovementScratch& scratch) const;
     void makeMapMesh();
+    void buildSegmentTables();
+    void buildKinematicIndex();
+    void refitPlatform(KinematicPlatform const& k);
+    // candidates from the static structures and the moving indices, in
+    // ascending id order
+    void querySegments(TerrainCollisionType type,
+                       Bounds const& bounds,
+                       std::vector<size_t>& out) const;
+    void queryCorners(Bounds const& bounds, std::vector<size_t>& out) const;
+    // candidate segments of the kinds picked by a TerrainQueryFilter mask
+    void queryFiltered(unsigned filter,
+                       Bounds const& bounds,
+                       std::vector<size_t>& out) const;
+    bool castRay(Pair const& start,
+                 Pair const& end,
+                 unsigned filter,
+                 QueryHit& out,
+                 std::vector<size_t>& ids) const;
+    void fillCollision(size_t id,
+                       Pair const& position,
+                       TerrainCollisionType type,
+                       CollisionDatum& out) const;
+    bool closestCollisionAmong(Pair const& start,
+                               Pair const& end,
+                               std::vector<size_t> const& ids,
+                               CollisionDatum& out,
+                               PlatformSegment& ignoredSegment,
+                               TerrainCollisionType type,
+                               CollisionStats& stats) const;
+    bool closestEdgeCollisionAmong(Pair const& a1,
+                                   Pair const& a2,
+                                   Pair const& b1,
+                                   Pair const& b2,
+                                   std::vector<size_t> const& ids,
+                                   EdgeCollision& out,
+                                   PlatformSegment* ignored,
+                                   CollisionStats& stats) const;
 
    public:
+    // when set, every broadphase query is checked against a linear scan of
+    // all segments and mismatches are reported on stderr
+    bool validateBroadphase = false;
+    // when set, sweeps made while moving players are remembered for the
+    // rest of the frame in the movement scratch
+    bool cacheQueries = true;
+
     Map(std::vector<Platform> platforms, std::vector<Ledge> ledges);
+
+    /** Merge maps into one holding their platforms and ledges one after
+     * the other
+     *
+     * The collision structures of the parts are used in place rather than
+     * rebuilt, so merging only costs copying their tables. The parts must
+     * outlive the map and not change, and a merged map can't be saved.
+     */
+    explicit Map(std::vector<Map const*> const& parts);
+
+    /** Load a map from a stage compiled by stagec
+     *
+     * The file is memory mapped and its tables are used in place, so
+     * loading takes the same time whatever the size of the stage. Returns
+     * NULL and reports why on stderr if the file can't be used.
+     */
+    static Map* load(std::string const& stagePath);
+    // write everything load needs, including the collision structures
+    void save(StageWriter& out) const;
+
     void movePlayer(Player& player, Pair& requestedDistance) const;
-    void moveRecursive(Player& player,
-                       Ecb& currentEcb,
-                       Ecb& projectedEcb) const;
+    void movePlayer(Player& player,
+                    Pair& requestedDistance,
+                    MovementScratch& scratch) const;
+    // work done by the last movePlayer call using the map's own scratch
+    MovementStats const& getLastMovementStats() const;
+
+    /** Move every player by its requested distance, spreading the players
+     * over the workers of pool
+     *
+     * Each player is resolved exactly as movePlayer would, so the results
+     * don't depend on the size of the pool. Players must be distinct. If
+     * stats isn't NULL, it receives the stats of each player's movement.
+     * Not safe to call concurrently on the same map.
+     */
+    void movePlayers(Player* const* players,
+                     Pair* requestedDistances,
+                     size_t count,
+                     WorkerPool& pool,
+                     MovementStats* stats = NULL) const;
+
+    /** Gather the segments and corners near the ECB swept from currentEcb
+     * to projectedEcb into scratch.nearby, for the collision queries of one
+     * movement iteration
+     */
+    void gatherCandidates(Ecb const& currentEcb,
+                          Ecb const& projectedEcb,
+                          MovementScratch& scratch) const;
 
     bool getClosestCollision(
         Pair const& start,
@@ -43,6 +231,26 @@ class Map : public Entity {
         PlatformSegment& ignoredSegment,
         TerrainCollisionType expectedEnvironmentCollision) const;
 
+    // same as above, but only tests the candidates gathered into scratch.
+    // Falls back to querying the map if the sweep leaves the area they were
+    // gathered for, and reuses results from the scratch's query cache. Only
+    // writes to scratch, so it's safe to call from several threads using
+    // different scratches
+    bool getClosestCollision(
+        Pair const& start,
+        Pair const& end,
+        CollisionDatum& out,
+        PlatformSegment& ignoredSegment,
+        TerrainCollisionType expectedEnvironmentCollision,
+        MovementScratch& scratch) const;
+
+    bool getClosestCollisionBruteForce(
+        Pair const& start,
+        Pair const& end,
+        CollisionDatum& out,
+        PlatformSegment& ignoredSegment,
+        TerrainCollisionType expectedEnvironmentCollision) const;
+
     bool getClosestEdgeCollision(Pair const& a1,
                                  Pair const& a2,
                                  Pair const& b1,
@@ -50,13 +258,126 @@ class Map : public Entity {
                                  EdgeCollision& out,
                                  PlatformSegment* ignored) const;
 
+    bool getClosestEdgeCollision(Pair const& a1,
+                                 Pair const& a2,
+                                 Pair const& b1,
+                                 Pair const& b2,
+                                 EdgeCollision& out,
+                                 PlatformSegment* ignored,
+                                 MovementScratch& scratch) const;
+
+    bool getClosestEdgeCollisionBruteForce(Pair const& a1,
+                                           Pair const& a2,
+                                           Pair const& b1,
+                                           Pair const& b2,
+                                           EdgeCollision& out,
+                                           PlatformSegment* ignored) const;
+
+    /** Find the first segment picked by filter, a TerrainQueryFilter mask,
+     * that the line from start to end crosses from either side
+     *
+     * Goes through the broadphase and the batched intersection kernel, so
+     * it costs the segments near the line rather than the whole map. Uses
+     * the map's own scratch, so it isn't safe to call from several threads
+     * at once; rayCasts with a pool is.
+     */
+    bool rayCast(Pair const& start,
+                 Pair const& end,
+                 unsigned filter,
+                 QueryHit& out) const;
+
+    /** Cast count rays, out[i] receiving the hit of rays[i]. With a pool,
+     * the rays are spread over its workers. Not safe to call concurrently
+     * with movePlayers
+     */
+    void rayCasts(Ray const* rays,
+                  size_t count,
+                  unsigned filter,
+                  QueryHit* out) const;
+    void rayCasts(Ray const* rays,
+                  size_t count,
+                  unsigned filter,
+                  QueryHit* out,
+                  WorkerPool& pool) const;
+
+    // if the segment from a to b crosses or touches any segment picked by
+    // filter
+    bool overlapsSegment(Pair const& a, Pair const& b, unsigned filter) const;
+
+    /** If point is inside a closed platform, one whose last point is its
+     * first. Only the QUERY_PASSABLE bit of filter is used, to also look
+     * inside passable platforms
+     */
+    bool isPointInSolid(Pair const& point,
+                        unsigned filter = QUERY_SOLID) const;
+
+    /** Sweep ecb by motion, and find the first segment picked by filter
+     * that it touches
+     *
+     * out.fraction is how far along motion the ECB gets before touching
+     * the segment, which is 0 if it starts out overlapping terrain.
+     */
+    bool ecbCast(Ecb const& ecb,
+                 Pair const& motion,
+                 unsigned filter,
+                 QueryHit& out) const;
+
+    /** Make a platform kinematic, moving by motion on every update()
+     *
+     * Making a static platform kinematic rebuilds the collision structures,
+     * so it is best done before the game starts. Kinematic platforms can be
+     * given a new motion at any time.
+     */
+    void setPlatformMotion(size_t platform, PlatformMotion const& motion);
+
+    /** Turn a kinematic platform by rotation radians around pivot, then
+     * move it by translation
+     *
+     * Only the platform's own segments and corners are refit, so this
+     * costs the size of the platform rather than of the map. Players
+     * standing on it are carried along the next time they move. Not safe
+     * to call while players are being moved.
+     */
+    void movePlatform(size_t platform,
+                      Pair const& translation,
+                      wideReal rotation,
+                      Pair const& pivot);
+
+    /** Save where the kinematic platforms are, or put them back where they
+     * were when they were saved, for rolling the map back to an earlier
+     * frame. There's a state for each kinematic platform in the order of
+     * the kinematic platform table, and getKinematicPointCount points.
+     * Restoring refits the platforms that moved since. Not safe to call
+     * while players are being moved.
+     */
+    void saveState(KinematicPlatformState* states, Pair* statePoints) const;
+    void restoreState(KinematicPlatformState const* states,
+                      Pair const* statePoints);
+    // how many points the kinematic platforms have between them
+    size_t getKinematicPointCount() const;
+
     Platform* getPlatform(size_t index);
+    std::vector<Platform> const& getPlatforms() const;
+    Table<Ledge> const& getLedges() const;
+    size_t getBroadphaseMismatches() const;
+
+    Table<MapPoint> const& getPoints() const;
+    Table<MapSegment> const& getSegments() const;
+    PlatformSegment toPlatformSegment(size_t id) const;
+    SegmentBucket const& getSegmentBucket(TerrainCollisionType type) const;
+    SegmentBucket const& getPassableSegments() const;
+    CornerIndex const& getCornerIndex() const;
+    Table<KinematicPlatform> const& getKinematicPlatforms() const;
 
-    IteratorChain<PlatformPointArray> getPoints() const;
-    IteratorChain<PlatformSegmentArray> getSegments() const;
+    // move the collision counters of the frame in progress into the
+    // counters of the last frame
+    void startFrame();
+    CollisionStats const& getCollisionStats() const;
+    CollisionStats const& getLastFrameCollisionStats() const;
 
     void init();
     void preUpdate();
+    // move every kinematic platform by its motion
     void update();
     void postUpdate();
     AbstractRenderer* getRenderer();
@@ -10,10 +10,10 @@
 
 using namespace Terrain;
 
-// #define _debug(...)
+#define _debug(...)
 
-#define _debug(...) \
-    { __VA_ARGS__ }
+// #define _debug(...) \
+//     { __VA_ARGS__ }
 
 inline Pair const& getEcbSideRight(Ecb const& e) {
     return e.right;
@@ -43,19 +43,19 @@ inline void setEcbTop(Ecb& e, Pair const pos) {
     return e.setTop(pos);
 }
 
-inline double getX(Pair const& pos) {
+inline wideReal getX(Pair const& pos) {
     return pos.x;
 }
 
-inline double getY(Pair const& pos) {
+inline wideReal getY(Pair const& pos) {
     return pos.y;
 }
 
-inline void setX(Pair& pos, const double val) {
+inline void setX(Pair& pos, const wideReal val) {
     pos.x = val;
 }
 
-inline void setY(Pair& pos, const double val) {
+inline void setY(Pair& pos, const wideReal val) {
     pos.y = val;
 }
 
@@ -66,9 +66,9 @@ inline void setY(Pair& pos, const double val) {
  * difference to projectedEcb.
  *
  */
-template <double (*x)(Pair const& pos),
-          double (*y)(Pair const& pos),
-          void (*xSet)(Pair& pos, const double val)>
+template <wideReal (*x)(Pair const& pos),
+          wideReal (*y)(Pair const& pos),
+          void (*xSet)(Pair& pos, const wideReal val)>
 
 void rollback(Player const& player,
               Ecb const& currentEcb,
@@ -91,7 +91,7 @@ void rollback(Player const& player,
 
         _debug(out << relPosNoColl << " " << relPosColl << std::endl;);
 
-        double noCollisionDistance = x(relPosColl) - x(relPosNoColl);
+        wideReal noCollisionDistance = x(relPosColl) - x(relPosNoColl);
         if (currentEcb.origin == nextStepEcb.origin) {
             // we collide with the wall at the next step. only slide.
             noCollisionDistance = x(currentEcb.origin) - x(projectedEcb.origin);
@@ -116,10 +116,10 @@ void rollback(Player const& player,
  */
 template <Pair const& (*getEcbSide)(Ecb const&),
           void (*setEcbSide)(Ecb&, Pair const pos),
-          double (*x)(Pair const& pos),
-          double (*y)(Pair const& pos),
-          void (*setBlockingAxis)(Pair& pos, double val),
-          void (*setNonblockingAxis)(Pair& pos, double value),
+          wideReal (*x)(Pair const& pos),
+          wideReal (*y)(Pair const& pos),
+          void (*setBlockingAxis)(Pair& pos, wideReal val),
+          void (*setNonblockingAxis)(Pair& pos, wideReal value),
           TerrainCollisionType expectedCollisionType>
 int performWallCollision(Map const& m,
                          Player const& player,
@@ -127,8 +127,9 @@ int performWallCollision(Map const& m,
                          Ecb& currentEcb,
                          Ecb& nextStepEcb,
                          Ecb& projectedEcb,
-                         double& distance,
-                         PlatformSegment& lastWallCollision) {
+                         wideReal& distance,
+                         PlatformSegment& lastWallCollision,
+                         MovementScratch& scratch) {
     CollisionDatum collision;
     int priority = 10;
 
@@ -140,16 +141,17 @@ int performWallCollision(Map const& m,
     Ecb _currentEcb = currentEcb;
     if (!m.getClosestCollision(getEcbSide(_currentEcb),
                                getEcbSide(projectedEcb), collision,
-                               lastWallCollision, expectedCollisionType)) {
+                               lastWallCollision, expectedCollisionType,
+                               scratch)) {
         return 0;
     }
 
-    double directionY = y(projectedEcb.origin) - y(_currentEcb.origin);
-    double lineDirectionY = sign(
-        (*collision.segment.firstPoint() - *collision.segment.secondPoint()).y);
+    MapSegment const& segment = m.getSegments()[collision.segmentId];
+    wideReal directionY = y(projectedEcb.origin) - y(_currentEcb.origin);
+    wideReal lineDirectionY = -sign(segment.direction.y);
 
     // ignore collisions if we would instead collide on an edge
-    if (*collision.segment.firstPoint() == collision.position &&
+    if (segment.first == collision.position &&
         lineDirectionY == sign(directionY)) {
         _debug(
             out << "reducing collision with wall because the edge might collide"
@@ -158,7 +160,7 @@ int performWallCollision(Map const& m,
     }
 
     // ignore collisions if we would instead collide on an edge
-    if (*collision.segment.secondPoint() == collision.position &&
+    if (segment.second == collision.position &&
         lineDirectionY != sign(directionY)) {
         _debug(
             out << "reducing collision with wall because the edge might collide"
@@ -170,30 +172,24 @@ int performWallCollision(Map const& m,
 
     distance = (getEcbSide(currentEcb) - collision.position).euclid();
 
-    _debug(out << "colliding with wall " << collision.segment.getPlatform()
-               << " at " << collision.position << std::endl;);
+    _debug(out << "colliding with wall " << segment.platform << " at "
+               << collision.position << std::endl;);
 
     Pair wallSlidePosition = collision.position;
 
     // perform sliding if the player is not grounded
     if (!player.isGrounded()) {
-        double slidePosition =
+        wideReal slidePosition =
             (directionY > 0)
-                ? std::min(std::max(y(*collision.segment.secondPoint()),
-                                    y(*collision.segment.firstPoint())),
+                ? std::min(std::max(y(segment.second), y(segment.first)),
                            y(getEcbSide(projectedEcb)))
-                : std::max(std::min(y(*collision.segment.secondPoint()),
-                                    y(*collision.segment.firstPoint())),
+                : std::max(std::min(y(segment.second), y(segment.first)),
                            y(getEcbSide(projectedEcb)));
 
-        double wallSlidePercent =
-            (slidePosition - y(*collision.segment.firstPoint())) /
-            (y(*collision.segment.secondPoint()) -
-             y(*collision.segment.firstPoint()));
-        wallSlidePosition = *collision.segment.firstPoint() +
-                            ((*collision.segment.secondPoint() -
-                              *collision.segment.firstPoint()) *
-                             wallSlidePercent);
+        wideReal wallSlidePercent = (slidePosition - y(segment.first)) /
+                                  (y(segment.second) - y(segment.first));
+        wallSlidePosition = segment.first + ((segment.second - segment.first) *
+                                             wallSlidePercent);
     }
 
     _debug(out << "position after sliding " << wallSlidePosition << std::endl;);
@@ -229,7 +225,8 @@ int performWallEdgeCollision(Map const& m,
                              Ecb& currentEcb,
                              Ecb& nextStepEcb,
                              Ecb& projectedEcb,
-                             double& distance) {
+                             wideReal& distance,
+                             MovementScratch& scratch) {
     int priority = 10;
     Pair currentForward = getForwardEdge(currentEcb);
     Pair projectedForward = getForwardEdge(projectedEcb);
@@ -264,7 +261,7 @@ int performWallEdgeCollision(Map const& m,
 
     if (!m.getClosestEdgeCollision(currentEdge.start, currentEdge.end,
                                    projectedEdge.start, projectedEdge.end,
-                                   collision, point)) {
+                                   collision, point, scratch)) {
         return 0;
     }
 
@@ -299,16 +296,16 @@ int performWallEdgeCollision(Map const& m,
         // if the angle between the direction of the side and the
         // angle of motion is > 90 degrees, we slide backwards. Otherwise.
         // we slide forwards
-        double dot = Dot(move, currentEdge.end - currentEdge.start);
+        wideReal dot = Dot(move, currentEdge.end - currentEdge.start);
 
         Pair slide = (dot < 0) ? collisionPoint - collisionLine2
                                : collisionPoint - collisionLine1;
 
         // if the direction of sliding is into the platform, don't slide
-        double averagePlatformY =
-            (collision.s1.firstPoint()->y + collision.s1.secondPoint()->y +
-             collision.s2.firstPoint()->y + collision.s2.secondPoint()->y) /
-                4 -
+        MapSegment const& s1 = m.getSegments()[collision.s1Id];
+        MapSegment const& s2 = m.getSegments()[collision.s2Id];
+        wideReal averagePlatformY =
+            (s1.first.y + s1.second.y + s2.first.y + s2.second.y) / 4 -
             collision.cornerPosition.y;
 
         _debug(out << "platform y is on average" << averagePlatformY
@@ -323,7 +320,7 @@ int performWallEdgeCollision(Map const& m,
             return 0;
         }
 
-        if (std::abs(slide.y - 0) < COLLISION_EPSILON) {
+        if (abs(slide.y - 0) < COLLISION_EPSILON) {
             return 0;
         }
 
@@ -332,9 +329,10 @@ int performWallEdgeCollision(Map const& m,
 
         _debug(out << "unscaled slide: " << slide << std::endl;);
 
-        double ySlide = projectedEcb.origin.y - currentEcb.origin.y;
+        wideReal ySlide = projectedEcb.origin.y - currentEcb.origin.y;
         _debug(out << "initial vertical slide: " << ySlide << std::endl;);
-        ySlide = sign(ySlide) * std::min(std::abs(ySlide), std::abs(slide.y));
+        ySlide = sign(ySlide) *
+                 std::min<wideReal>(abs(ySlide), abs(slide.y));
         _debug(out << "minimal vertical slide: " << ySlide << std::endl;);
 
         slide *= ySlide / slide.y;
@@ -345,7 +343,7 @@ int performWallEdgeCollision(Map const& m,
 
         nextStepEcb.setOrigin(nextStepEcb.origin + slide);
         // deal with clipping due to floating point errors
-        if (std::abs(getForwardEdge(nextStepEcb).x - collisionPoint.x) <
+        if (abs(getForwardEdge(nextStepEcb).x - collisionPoint.x) <
             COLLISION_EPSILON) {
             Pair newOrigin = getForwardEdge(nextStepEcb);
             newOrigin.x = collisionPoint.x;
@@ -371,13 +369,14 @@ bool performFloorCollision(Map const& m,
                            Ecb& nextStepEcb,
                            Ecb& projectedEcb,
                            const Platform*& currentPlatform,
-                           double& distance) {
+                           wideReal& distance,
+                           MovementScratch& scratch) {
     CollisionDatum collision;
     PlatformSegment currentPlatformAsSegment = PlatformSegment();
 
     if (!m.getClosestCollision(currentEcb.bottom, projectedEcb.bottom,
                                collision, currentPlatformAsSegment,
-                               FLOOR_COLLISION)) {
+                               FLOOR_COLLISION, scratch)) {
         return false;
     }
     if (collision.type != FLOOR_COLLISION)
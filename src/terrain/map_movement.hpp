@@ -7,7 +7,8 @@ namespace Terrain {
 #define WALL_COLL_ARGS                                                \
     Map const &m, Player const &player, const Pair expectedDirection, \
         Ecb &currentEcb, Ecb &nextStepEcb, Ecb &projectedEcb,         \
-        double &distance, PlatformSegment &lastWallCollision
+        wideReal &distance, PlatformSegment &lastWallCollision,       \
+        MovementScratch &scratch
 
 extern int (*rightWallCollision)(WALL_COLL_ARGS);
 extern int (*leftWallCollision)(WALL_COLL_ARGS);
@@ -15,7 +16,8 @@ extern int (*ceilingCollision)(WALL_COLL_ARGS);
 
 #define EDGE_COLL_ARGS                                                     \
     Map const &m, Player const &player, Ecb &currentEcb, Ecb &nextStepEcb, \
-        Ecb &projectedEcb, double &distance
+        Ecb &projectedEcb, wideReal &distance,                             \
+        MovementScratch &scratch
 
 extern int (*topRightEdgeCollision)(EDGE_COLL_ARGS);
 extern int (*bottomRightEdgeCollision)(EDGE_COLL_ARGS);
@@ -28,7 +30,8 @@ bool performFloorCollision(Map const& m,
                            Ecb& nextStepEcb,
                            Ecb& projectedEcb,
                            const Platform*& currentPlatform,
-                           double& distance);
+                           wideReal& distance,
+                           MovementScratch& scratch);
 }
 
 #endif
@@ -0,0 +1,263 @@
+#include <algorithm>
+#include "./map.hpp"
+#include "util.hpp"
+#include "linebatch.hpp"
+
+// public geometric queries of the map, for callers other than player
+// movement such as AI and cameras
+
+using namespace Terrain;
+
+// padding applied to the bounds of a cast before querying the broadphase,
+// so that segments just touching the cast are still tested
+#define QUERY_MARGIN 0.001
+#define QUERY_EPSILON 0.000001
+
+static unsigned filterOf(MapSegment const& segment) {
+    switch (segment.type) {
+        case FLOOR_COLLISION:
+            return QUERY_FLOORS;
+        case WALL_COLLISION:
+            return QUERY_WALLS;
+        case CEIL_COLLISION:
+            return QUERY_CEILINGS;
+        default:
+            return 0;
+    }
+}
+
+void Map::queryFiltered(unsigned filter,
+                        Bounds const& bounds,
+                        std::vector<size_t>& out) const {
+    // a single kind of segment has a bucket of its own
+    TerrainCollisionType type = NO_COLLISION;
+    switch (filter & QUERY_SOLID) {
+        case 0:
+            out.clear();
+            return;
+        case QUERY_FLOORS:
+            type = FLOOR_COLLISION;
+            break;
+        case QUERY_WALLS:
+            type = WALL_COLLISION;
+            break;
+        case QUERY_CEILINGS:
+            type = CEIL_COLLISION;
+            break;
+    }
+
+    querySegments(type, bounds, out);
+    // only filter when the bucket holds segments the caller didn't ask for
+    bool typesMatch =
+        type != NO_COLLISION || (filter & QUERY_SOLID) == QUERY_SOLID;
+    if (typesMatch && (filter & QUERY_PASSABLE)) {
+        return;
+    }
+    out.erase(std::remove_if(out.begin(), out.end(),
+                             [&](size_t id) {
+                                 MapSegment const& s = segments[id];
+                                 return !(filterOf(s) & filter) ||
+                                        (s.passable &&
+                                         !(filter & QUERY_PASSABLE));
+                             }),
+              out.end());
+}
+
+// fill in a hit on segment at position, with its normal facing towards
+// from
+static void fillHit(MapSegment const& segment,
+                    size_t id,
+                    Pair const& position,
+                    wideReal fraction,
+                    Pair const& from,
+                    QueryHit& out) {
+    out.hit = true;
+    out.segmentId = id;
+    out.position = position;
+    out.fraction = fraction;
+    out.normal = segment.normal;
+    if (Dot(out.normal, from) < 0) {
+        out.normal = out.normal * -1;
+    }
+}
+
+bool Map::castRay(Pair const& start,
+                  Pair const& end,
+                  unsigned filter,
+                  QueryHit& out,
+                  std::vector<size_t>& ids) const {
+    out = QueryHit();
+    queryFiltered(filter, Bounds(start, end).expanded(QUERY_MARGIN), ids);
+
+    LineHit hit;
+    if (!checkLineIntersectionBatch(start, end, segmentArrays, ids.data(),
+                                    ids.size(), 0, hit, QUERY_EPSILON)) {
+        return false;
+    }
+
+    wideReal length = (end - start).euclid();
+    fillHit(segments[hit.index], hit.index, hit.point,
+            length > 0 ? hit.distance / length : 0, start - hit.point, out);
+    return true;
+}
+
+bool Map::rayCast(Pair const& start,
+                  Pair const& end,
+                  unsigned filter,
+                  QueryHit& out) const {
+    return castRay(start, end, filter, out, candidates);
+}
+
+void Map::rayCasts(Ray const* rays,
+                   size_t count,
+                   unsigned filter,
+                   QueryHit* out) const {
+    for (size_t i = 0; i < count; i++) {
+        castRay(rays[i].start, rays[i].end, filter, out[i], candidates);
+    }
+}
+
+void Map::rayCasts(Ray const* rays,
+                   size_t count,
+                   unsigned filter,
+                   QueryHit* out,
+                   WorkerPool& pool) const {
+    if (workerScratch.size() < pool.size()) {
+        workerScratch.resize(pool.size());
+    }
+
+    pool.run(count, [&](size_t i, size_t worker) {
+        castRay(rays[i].start, rays[i].end, filter, out[i],
+                workerScratch[worker].queryIds);
+    });
+}
+
+bool Map::overlapsSegment(Pair const& a, Pair const& b, unsigned filter) const {
+    QueryHit hit;
+    return castRay(a, b, filter, hit, candidates);
+}
+
+bool Map::isPointInSolid(Pair const& point, unsigned filter) const {
+    Bounds world = buckets[NO_COLLISION].getBounds();
+    world.include(movingSegments.getExtent());
+    if (!world.contains(point)) {
+        return false;
+    }
+
+    // count the crossings of a ray from the point to the right of the map.
+    // Candidates are in platform order, so each platform's crossings are
+    // counted in one run
+    Pair end = Pair(world.max.x + 1, point.y);
+    querySegments(NO_COLLISION, Bounds(point, end), candidates);
+    size_t platform = 0;
+    bool inside = false;
+    for (size_t id : candidates) {
+        MapSegment const& s = segments[id];
+        if (s.platform != platform) {
+            if (inside) {
+                return true;
+            }
+            platform = s.platform;
+        }
+        if ((s.passable && !(filter & QUERY_PASSABLE)) ||
+            !platforms[s.platform].isClosed()) {
+            continue;
+        }
+
+        if ((s.first.y > point.y) != (s.second.y > point.y)) {
+            wideReal x = s.first.x + (point.y - s.first.y) *
+                                       (s.second.x - s.first.x) /
+                                       (s.second.y - s.first.y);
+            if (x > point.x) {
+                inside = !inside;
+            }
+        }
+    }
+    return inside;
+}
+
+// if p is inside the convex quad, or on its edges
+static bool insideQuad(Pair const* quad, Pair const& p) {
+    int side = 0;
+    for (size_t k = 0; k < 4; k++) {
+        wideReal c = PerpDot(quad[(k + 1) % 4] - quad[k], p - quad[k]);
+        if (c == 0) {
+            continue;
+        }
+        int s = c > 0 ? 1 : -1;
+        if (side != 0 && s != side) {
+            return false;
+        }
+        side = s;
+    }
+    return true;
+}
+
+bool Map::ecbCast(Ecb const& ecb,
+                  Pair const& motion,
+                  unsigned filter,
+                  QueryHit& out) const {
+    out = QueryHit();
+    Pair quad[] = {ecb.left, ecb.top, ecb.right, ecb.bottom};
+    Bounds swept;
+    for (Pair const& v : quad) {
+        swept.include(v);
+        swept.include(v + motion);
+    }
+    queryFiltered(filter, swept.expanded(QUERY_MARGIN), candidates);
+
+    // terrain the ECB already touches stops it where it starts
+    for (size_t id : candidates) {
+        MapSegment const& s = segments[id];
+        if (insideQuad(quad, s.first)) {
+            fillHit(s, id, s.first, 0, ecb.origin - s.first, out);
+            return true;
+        }
+        for (size_t k = 0; k < 4; k++) {
+            Pair point;
+            if (checkLineIntersection(s.first, s.second, quad[k],
+                                      quad[(k + 1) % 4], point,
+                                      QUERY_EPSILON) != 0) {
+                fillHit(s, id, point, 0, ecb.origin - point, out);
+                return true;
+            }
+        }
+    }
+
+    wideReal length = motion.euclid();
+    if (length == 0) {
+        return false;
+    }
+
+    // a convex shape first touches a segment either with one of its
+    // corners, or with an edge running into one of the segment's ends
+    for (Pair const& v : quad) {
+        LineHit hit;
+        if (checkLineIntersectionBatch(v, v + motion, segmentArrays,
+                                       candidates.data(), candidates.size(),
+                                       0, hit, QUERY_EPSILON) &&
+            (!out.hit || hit.distance / length < out.fraction)) {
+            fillHit(segments[hit.index], hit.index, hit.point,
+                    hit.distance / length, motion * -1, out);
+        }
+    }
+    for (size_t id : candidates) {
+        MapSegment const& s = segments[id];
+        Pair ends[] = {s.first, s.second};
+        for (Pair const& q : ends) {
+            for (size_t k = 0; k < 4; k++) {
+                Pair point;
+                if (checkLineIntersection(q, q - motion, quad[k],
+                                          quad[(k + 1) % 4], point,
+                                          QUERY_EPSILON) == 0) {
+                    continue;
+                }
+                wideReal fraction = (point - q).euclid() / length;
+                if (!out.hit || fraction < out.fraction) {
+                    fillHit(s, id, q, fraction, motion * -1, out);
+                }
+            }
+        }
+    }
+    return out.hit;
+}
@@ -0,0 +1,26 @@
+#ifndef __TERRAIN_MAP_POINT
+#define __TERRAIN_MAP_POINT
+
+#include <stddef.h>
+#include "engine/pair.hpp"
+
+/**
+ * Flattened copy of a platform point, owned by the Map
+ */
+class MapPoint {
+   public:
+    Pair position;
+    bool passable;
+
+    // index of the owning platform in the map, and of this point within
+    // that platform
+    size_t platform;
+    size_t index;
+
+    // ids in the map's segment table of the segments on either side of
+    // this point
+    size_t firstSegment;
+    size_t secondSegment;
+};
+
+#endif
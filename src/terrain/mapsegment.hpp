@@ -0,0 +1,35 @@
+#ifndef __TERRAIN_MAP_SEGMENT
+#define __TERRAIN_MAP_SEGMENT
+
+#include <stddef.h>
+#include "engine/pair.hpp"
+#include "./collisiontype.hpp"
+
+/**
+ * Flattened copy of a platform segment, owned by the Map
+ *
+ * The map keeps every segment of every platform in one contiguous table so
+ * collision queries can read the endpoints without going through the
+ * owning Platform.
+ */
+class MapSegment {
+   public:
+    Pair first;
+    Pair second;
+    wideReal angle;
+    // unit direction from first to second, and its left hand normal
+    Pair direction;
+    Pair normal;
+    bool passable;
+
+    // which kind of collision this segment takes part in, derived from the
+    // angle when the map is built
+    TerrainCollisionType type;
+
+    // index of the owning platform in the map, and of this segment within
+    // that platform
+    size_t platform;
+    int index;
+};
+
+#endif
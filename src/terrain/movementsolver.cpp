@@ -0,0 +1,18 @@
+#include "./movementsolver.hpp"
+
+void MovementStats::reset() {
+    *this = MovementStats();
+}
+
+std::ostream& operator<<(std::ostream& strm, const MovementStats& s) {
+    return strm << "MovementStats { "
+                << "iterations = " << s.iterations << ", "
+                << "probes = " << s.probes << ", "
+                << "segmentTests = " << s.segmentTests << ", "
+                << "cornerTests = " << s.cornerTests << ", "
+                << "maxDepth = " << s.maxDepth << ", "
+                << "panicked = " << s.panicked << ", "
+                << "budgetExhausted = " << s.budgetExhausted << " }";
+}
+
+MovementScratch::MovementScratch() : frames(MOVEMENT_MAX_DEPTH) {}
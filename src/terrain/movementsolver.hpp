@@ -0,0 +1,92 @@
+#ifndef __TERRAIN_MOVEMENT_SOLVER
+#define __TERRAIN_MOVEMENT_SOLVER
+
+#include <iostream>
+#include <vector>
+#include <stddef.h>
+#include "player/ecb.hpp"
+#include "./platformsegment.hpp"
+#include "./collisioncandidates.hpp"
+#include "./collisionstats.hpp"
+#include "./querycache.hpp"
+
+// iterations a single walk may take before giving up (the old "panic")
+#define MOVEMENT_FRAME_ITERATIONS 10
+// walks interrupted by a collision start a nested walk from the collision
+// point. This bounds how deep those may nest
+#define MOVEMENT_MAX_DEPTH 16
+// iterations a whole movement may take, across all nested walks
+#define MOVEMENT_ITERATION_BUDGET 64
+
+/** Work performed while resolving a single Map::movePlayer call */
+class MovementStats {
+   public:
+    size_t iterations = 0;
+    size_t probes = 0;
+    size_t segmentTests = 0;
+    size_t cornerTests = 0;
+    size_t maxDepth = 0;
+    // a walk ran out of iterations or nested too deep
+    bool panicked = false;
+    // the movement ran out of its iteration budget and stopped early
+    bool budgetExhausted = false;
+
+    void reset();
+};
+
+std::ostream& operator<<(std::ostream& strm, const MovementStats& s);
+
+/**
+ * State of one walk towards a projected ECB
+ *
+ * Walks that get interrupted wait on a nested walk from the collision
+ * point, and finish their iteration once it resolves.
+ */
+class MovementFrame {
+   public:
+    Ecb nextStepEcb;
+    Ecb projectedEcb;
+    PlatformSegment lastWallCollision;
+    int iterationCount = 0;
+
+    // closest collision of the current iteration. closestNextStepEcb is
+    // the projected ecb of the nested walk while one is running
+    Ecb closestNextStepEcb;
+    Ecb closestProjectedEcb;
+    PlatformSegment closestLastWallCollision;
+    Pair predictedNextStep;
+};
+
+/**
+ * Preallocated working memory for resolving movement
+ *
+ * Reusing one scratch between calls keeps the solver from allocating, and
+ * holds the stats of the last call. Everything the solver writes while
+ * resolving a movement lives here, so movements using different scratches
+ * can be resolved on different threads.
+ */
+class MovementScratch {
+   public:
+    std::vector<MovementFrame> frames;
+    size_t depth = 0;
+    CollisionCandidates nearby;
+    // broadphase results of queries that leave the gathered area
+    std::vector<size_t> queryIds;
+    // segment sweeps made during the current frame of the map
+    QueryCache queryCache;
+
+    Ecb closestCollisionPointEcb;
+    Ecb tmpCollisionPointEcb;
+    Ecb tmpNextStepEcb;
+    Ecb tmpProjectedEcb;
+    PlatformSegment tmpLastWallCollision;
+
+    MovementStats stats;
+    // collision queries made through this scratch that haven't been merged
+    // into the map's frame stats yet
+    CollisionStats collisionStats;
+
+    MovementScratch();
+};
+
+#endif
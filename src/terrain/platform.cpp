@@ -1,5 +1,7 @@
+#include <algorithm>
 #include <vector>
 #include <cmath>
+#include <cstring>
 #include <iostream>
 #include <stdio.h>
 #include <SDL.h>
@@ -13,50 +15,216 @@
 #include "./collisiontype.hpp"
 #include "platform_segment_iterator.hpp"
 #include "platform_point_iterator.hpp"
+#include "stage/stagefile.hpp"
 
 #define _debug(...)
 // #define _debug(...) \
 //     { __VA_ARGS__ }
 
 Platform::Platform(std::vector<Pair> points, bool passable)
-    : points(points), passable(passable) {
+    : passable(passable) {
     if (points.size() < 2) {
         // this is an error situation
         std::cerr << "platform construciton with less than 2 points"
                   << std::endl;
     }
 
-    angles = std::vector<double>(points.size());
-    lengths = std::vector<double>(points.size());
-    for (size_t i = 0; i < points.size() - 1; i++) {
+    setPoints(points);
+}
+
+void Platform::setPoints(std::vector<Pair> const& points) {
+    this->points.assign(points);
+    angles.assign(std::vector<wideReal>(points.size()));
+    lengths.assign(std::vector<wideReal>(points.size()));
+    directions.assign(std::vector<Pair>(points.size(), Pair(0, 0)));
+    normals.assign(std::vector<Pair>(points.size(), Pair(0, 0)));
+    inverseLengths.assign(std::vector<wideReal>(points.size()));
+    deriveSegments();
+    buildLocator();
+}
+
+bool Platform::deriveSegments() {
+    Pair const* points = this->points.data();
+    wideReal* angles = this->angles.mutableData();
+    wideReal* lengths = this->lengths.mutableData();
+    Pair* directions = this->directions.mutableData();
+    Pair* normals = this->normals.mutableData();
+    wideReal* inverseLengths = this->inverseLengths.mutableData();
+    bool turned = false;
+    for (size_t i = 0; i + 1 < this->points.size(); i++) {
+        bool wasWall = isWall(angles[i]);
         Pair p1 = points[i];
         Pair p2 = points[i + 1];
-        angles[i] = std::atan2(p2.y - p1.y, p2.x - p1.x);
+        angles[i] = atan2(p2.y - p1.y, p2.x - p1.x);
         lengths[i] = (p2 - p1).euclid();
+
+        // zero length segments point along their angle of 0
+        if (lengths[i] > 0) {
+            inverseLengths[i] = 1 / lengths[i];
+            directions[i] = (p2 - p1) * inverseLengths[i];
+        } else {
+            inverseLengths[i] = 0;
+            directions[i] = Pair(1, 0);
+        }
+        normals[i] = Pair(-directions[i].y, directions[i].x);
+        turned = turned || isWall(angles[i]) != wasWall;
     }
+    return turned;
+}
+
+void Platform::buildLocator() {
+    std::vector<size_t> floors;
+    for (size_t i = 0; i + 1 < points.size(); i++) {
+        if (!isWall(angles[i])) {
+            floors.push_back(i);
+        }
+    }
+    locator.build(points, floors);
+}
+
+Platform::Platform(StageReader& in) {
+    in.read(points);
+    in.read(angles);
+    in.read(lengths);
+    in.read(directions);
+    in.read(normals);
+    in.read(inverseLengths);
+    in.readValue(passable);
+    locator.load(in);
+    in.readValue(kinematic);
+    in.readValue(motion);
 }
 
 Platform::~Platform() {}
 
+void Platform::save(StageWriter& out) const {
+    out.write(points);
+    out.write(angles);
+    out.write(lengths);
+    out.write(directions);
+    out.write(normals);
+    out.write(inverseLengths);
+    out.writeValue(passable);
+    locator.save(out);
+    out.writeValue(kinematic);
+    out.writeValue(motion);
+}
+
+void Platform::setMotion(PlatformMotion const& motion) {
+    this->motion = motion;
+    kinematic = true;
+}
+
+PlatformMotion const& Platform::getMotion() const {
+    return motion;
+}
+
+bool Platform::isKinematic() const {
+    return kinematic;
+}
+
+size_t Platform::getMoves() const {
+    return moves;
+}
+
+void Platform::transform(Pair const& translation,
+                         wideReal rotation,
+                         Pair const& pivot) {
+    Pair* moved = points.mutableData();
+    if (rotation != 0) {
+        wideReal c = cos(rotation), s = sin(rotation);
+        for (size_t i = 0; i < points.size(); i++) {
+            Pair r = moved[i] - pivot;
+            moved[i] = pivot + Pair(r.x * c - r.y * s, r.x * s + r.y * c);
+        }
+    }
+    for (size_t i = 0; i < points.size(); i++) {
+        moved[i] = moved[i] + translation;
+    }
+
+    // the locator only needs building again if its segments changed, or
+    // their order along x did
+    if (deriveSegments() || !locator.refit(points)) {
+        buildLocator();
+    }
+    moves++;
+}
+
+bool Platform::restore(Pair const* points,
+                       size_t moves,
+                       PlatformMotion const& motion) {
+    this->motion = motion;
+    // bit for bit, as Pair's == allows for rounding that a replay mustn't
+    size_t size = this->points.size() * sizeof(Pair);
+    if (moves == this->moves &&
+        std::memcmp(this->points.data(), points, size) == 0) {
+        return false;
+    }
+    std::memcpy(this->points.mutableData(), points, size);
+    if (deriveSegments() || !locator.refit(this->points)) {
+        buildLocator();
+    }
+    this->moves = moves;
+    return true;
+}
+
+void Platform::anchor(Pair const& position, PlatformAnchor& out) const {
+    out.platform = this;
+    out.moves = moves;
+    out.segment = getSegmentIndexByLocation(position);
+    // directions are only unit length to rounding, which a fixed point
+    // build would otherwise pile up every frame. Dividing by the squared
+    // length undoes the round trip while the direction stays the same
+    out.offset = toSegmentSpace(out.segment, position) /
+                 directions[out.segment].euclidSquared();
+}
+
+bool Platform::carry(PlatformAnchor const& anchor, Pair& position) const {
+    if (anchor.platform != this || anchor.moves == moves) {
+        return false;
+    }
+    position = fromSegmentSpace(anchor.segment, anchor.offset);
+    return true;
+}
+
 Pair Platform::movePointToSegmentSpace(Pair& platformPoint,
-                                       double platformAngle,
+                                       wideReal platformAngle,
                                        Pair& otherPoint) {
     // move other point into relative world space
     Pair wsRelPair = otherPoint - platformPoint;
-    double length = wsRelPair.euclid();
+    wideReal length = wsRelPair.euclid();
 
     // rotate it into platform space
-    double wsAngle = std::atan2(wsRelPair.y, wsRelPair.x);
-    double psAngle = wsAngle - platformAngle;
-    return Pair(std::cos(psAngle) * length, std::sin(psAngle) * length);
+    wideReal wsAngle = atan2(wsRelPair.y, wsRelPair.x);
+    wideReal psAngle = wsAngle - platformAngle;
+    return Pair(cos(psAngle) * length, sin(psAngle) * length);
+}
+
+Pair Platform::toSegmentSpace(size_t segment, Pair const& point) const {
+    Pair relative = point - points[segment];
+    return Pair(Dot(relative, directions[segment]),
+                Dot(relative, normals[segment]));
+}
+
+Pair Platform::fromSegmentSpace(size_t segment, Pair const& point) const {
+    return points[segment] + directions[segment] * point.x +
+           normals[segment] * point.y;
 }
 
-bool Platform::isWall(double angle) {
-    return (std::abs(angle) > M_PI * 3.0 / 8.0);
+bool Platform::isWall(wideReal angle) {
+    return (abs(angle) > M_PI * 3.0 / 8.0);
 }
 
-bool Platform::isCeil(double angle) {
-    return (std::abs(angle - M_PI) < M_PI * 1.0 / 8.0);
+bool Platform::isCeil(wideReal angle) {
+    return (abs(angle - M_PI) < M_PI * 1.0 / 8.0);
+}
+
+TerrainCollisionType Platform::getCollisionType(wideReal angle) {
+    if (isCeil(angle))
+        return CEIL_COLLISION;
+    if (isWall(angle))
+        return WALL_COLLISION;
+    return FLOOR_COLLISION;
 }
 bool Platform::checkEdgeCollision(Pair const& a1,
                                   Pair const& a2,
@@ -99,8 +267,7 @@ void Platform::render(SDL_Renderer* r) {
                            (int)(points[i + 1].x * PLAYER_SCALE),
                            (int)(points[i + 1].y * PLAYER_SCALE));
 
-        Pair offset = Pair(-std::sin(angles[i]) * PLATFORM_DIR_OFFSET,
-                           std::cos(angles[i]) * PLATFORM_DIR_OFFSET);
+        Pair offset = normals[i] * PLATFORM_DIR_OFFSET;
         Pair q1 = points[i] + offset;
         Pair q2 = points[i + 1] + offset;
 
@@ -134,8 +301,9 @@ bool Platform::initGroundedMovement(Pair& position,
 
     out.platform = this;
     out.currentSegment = i;
-    out.currentPlatformPercent = (position - points[i]).euclid() / lengths[i];
-    out.remainingDistance = std::abs(velocity.x);
+    out.currentPlatformPercent =
+        toSegmentSpace(i, position).x * inverseLengths[i];
+    out.remainingDistance = abs(velocity.x);
 
     return true;
 }
@@ -177,7 +345,7 @@ bool Platform::stepGroundedMovement(Pair& position,
     if (ms.remainingDistance <= 0) {
         _debug(std::cout << "ending motion, went so far" << std::endl;);
         ms.currentPlatformPercent =
-            -ms.remainingDistance / lengths[ms.currentSegment];
+            -ms.remainingDistance * inverseLengths[ms.currentSegment];
         if (ms.direction < 0) {
             ms.currentPlatformPercent = 1 - ms.currentPlatformPercent;
         }
@@ -223,40 +391,40 @@ bool Platform::isPassable() const {
     return passable;
 }
 
+bool Platform::isClosed() const {
+    return points.size() > 3 && points[0] == points.back();
+}
+
 PlatformSegment Platform::getSegment(int index) const {
     return PlatformSegment(this, index);
 }
 
 size_t Platform::getSegmentIndexByLocation(Pair position, int direction) const {
-    // find the segment of the platform we're on
-    size_t i;
-    size_t closestPoint = 0;
-    double closestDist = DOUBLE_INFINITY;
-    for (i = 0; i < points.size() - 1; i++) {
-        int ind = i + (direction >= 0);
-        double distance = (position - points[ind]).euclid();
-        if (distance <= closestDist) {
-            closestDist = distance;
-            closestPoint = ind;
-        }
-        if (!isWall(angles[i]) && points[i].x <= position.x &&
+    if (points.size() < 2)
+        return 0;
+
+    // find the first segment of the platform we're on
+    size_t const *it, *end;
+    locator.query(position.x, it, end);
+    for (; it != end; it++) {
+        size_t i = *it;
+        if (points[i].x <= position.x &&
             (onLine(points[i], points[i + 1], position) ||
              position == points[i])) {
-            break;
+            return i;
         }
     }
 
-    _debug(std::cout << "i: " << i << std::endl;
-           std::cout << "points: " << points.size() << std::endl;);
+    _debug(std::cerr << "grounded movement starts off of platform"
+                     << std::endl;);
 
-    // can't find a point, select the closest point instead
-    if (i >= points.size() - 1) {
-        _debug(std::cerr << "grounded movement starts off of platform (" << i
-                         << ")" << std::endl;);
-        i = closestPoint;
+    // can't find a segment, select the closest point instead. Moving right
+    // looks at the end points of segments, moving left at their start
+    // points
+    if (direction >= 0) {
+        return locator.closestPoint(points, position, 1, points.size() - 1);
     }
-
-    return i;
+    return locator.closestPoint(points, position, 0, points.size() - 2);
 }
 
 PlatformSegmentArray Platform::segments_iter() const {
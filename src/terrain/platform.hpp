@@ -5,6 +5,7 @@
 #include <vector>
 #include "engine/pair.hpp"
 #include "engine/entity.hpp"
+#include "engine/table.hpp"
 #include "./platformsegment.hpp"
 #include "./platformpoint.hpp"
 #include "./platform_point_iterator.hpp"
@@ -12,25 +13,90 @@
 #include "./platform_movement.hpp"
 #include "./collisiontype.hpp"
 #include "./collisiondatum.hpp"
+#include "./segmentlocator.hpp"
 
 class Platform : public Entity {
     friend class PlatformSegment;
     friend class PlatformPoint;
     friend class PlatformPointArray;
     friend class PlatformSegmentArray;
-    std::vector<Pair> points;
-    std::vector<double> angles;
-    std::vector<double> lengths;
+    Table<Pair> points;
+    Table<wideReal> angles;
+    Table<wideReal> lengths;
+    // unit direction and left hand normal of each segment, and the inverse
+    // of its length (0 for zero length segments)
+    Table<Pair> directions;
+    Table<Pair> normals;
+    Table<wideReal> inverseLengths;
     bool passable;
+    // non-wall segments by x, for finding where grounded movement starts
+    SegmentLocator locator;
+
+    // kinematic platforms can be moved after the map is built, and count
+    // how many times they have been
+    bool kinematic = false;
+    PlatformMotion motion;
+    size_t moves = 0;
+
+    // set the points and derive everything else from them
+    void setPoints(std::vector<Pair> const& points);
+    // derive the angle, length, direction and normal of every segment from
+    // the points in place. Returns true if a segment turned into a wall or
+    // out of being one
+    bool deriveSegments();
+    // index the segments that aren't walls by x
+    void buildLocator();
 
    public:
     Platform(std::vector<Pair> points, bool passable = false);
+    // use a platform saved to a compiled stage in place
+    explicit Platform(StageReader& in);
     ~Platform();
 
+    void save(StageWriter& out) const;
+
+    /** Make the platform kinematic, moving by motion every frame the map
+     * it's in is updated. A zero motion keeps it still, but lets it be
+     * moved with Map::movePlatform
+     */
+    void setMotion(PlatformMotion const& motion);
+    PlatformMotion const& getMotion() const;
+    bool isKinematic() const;
+    size_t getMoves() const;
+
+    /** Turn the platform by rotation radians around pivot, then move it by
+     * translation. It ends up exactly as if it was built with the moved
+     * points
+     */
+    void transform(Pair const& translation,
+                   wideReal rotation,
+                   Pair const& pivot);
+
+    /** Put the platform back where it was after moves moves, given the
+     * points and motion it had then. Returns false if it already had
+     * exactly those points, so nothing derived from them changed
+     */
+    bool restore(Pair const* points,
+                 size_t moves,
+                 PlatformMotion const& motion);
+
+    // remember where position is on the platform, and find it again after
+    // the platform moved. carry returns false if the anchor is for another
+    // platform or the platform hasn't moved since
+    void anchor(Pair const& position, PlatformAnchor& out) const;
+    bool carry(PlatformAnchor const& anchor, Pair& position) const;
+
     static Pair movePointToSegmentSpace(Pair& platformPair,
-                                        double platformAngle,
+                                        wideReal platformAngle,
                                         Pair& otherPair);
 
+    /** Move a point into the space of a segment, where the x axis runs
+     * along the segment from its first point and y along its normal. Same
+     * as movePointToSegmentSpace, without the trigonometry
+     */
+    Pair toSegmentSpace(size_t segment, Pair const& point) const;
+    Pair fromSegmentSpace(size_t segment, Pair const& point) const;
+
     bool checkEdgeCollision(Pair const& a1,
                             Pair const& a2,
                             Pair const& b1,
@@ -52,11 +118,14 @@ class Platform : public Entity {
     void postUpdate();
     void render(SDL_Renderer* r);
     bool isPassable() const;
+    // if the last point is the first, making the platform a solid polygon
+    bool isClosed() const;
     PlatformSegment getSegment(int index) const;
     size_t getSegmentIndexByLocation(Pair position, int direction = 0) const;
 
-    static bool isWall(double angle);
-    static bool isCeil(double angle);
+    static bool isWall(wideReal angle);
+    static bool isCeil(wideReal angle);
+    static TerrainCollisionType getCollisionType(wideReal angle);
 
     PlatformSegmentArray segments_iter() const;
     PlatformPointArray points_iter() const;
@@ -1,14 +1,39 @@
 #ifndef __GAME_PLATFORM_MOVEMENT
 #define __GAME_PLATFORM_MOVEMENT
 
+#include <stddef.h>
+#include "engine/pair.hpp"
+
+class Platform;
+
 typedef struct PlatformMovementState {
     bool initialized = false;
     const Platform *platform;
     int currentSegment;
     int direction;
-    double currentPlatformPercent;
-    double remainingDistance;
+    wideReal currentPlatformPercent;
+    wideReal remainingDistance;
 } PlatformMovementState;
 
-#endif
+/** How a kinematic platform moves every frame */
+typedef struct PlatformMotion {
+    // distance moved per frame
+    Pair velocity = Pair(0, 0);
+    // radians turned per frame around the pivot, which travels with the
+    // platform
+    wideReal angularVelocity = 0;
+    Pair pivot = Pair(0, 0);
+} PlatformMotion;
 
+/** Where a grounded player stands on a kinematic platform, kept in the
+ * space of the segment under them so they can be carried when it moves
+ */
+typedef struct PlatformAnchor {
+    const Platform *platform = NULL;
+    // moves the platform had made when the anchor was taken
+    size_t moves = 0;
+    size_t segment = 0;
+    Pair offset = Pair(0, 0);
+} PlatformAnchor;
+
+#endif
@@ -19,14 +19,26 @@ const Pair PlatformSegment::slope() const {
     return diff / diff.euclid();
 }
 
-double PlatformSegment::angle() const {
+wideReal PlatformSegment::angle() const {
     return platform->angles[index];
 }
 
+Pair const& PlatformSegment::direction() const {
+    return platform->directions[index];
+}
+
+Pair const& PlatformSegment::normal() const {
+    return platform->normals[index];
+}
+
 const Platform* PlatformSegment::getPlatform() const {
     return platform;
 }
 
+int PlatformSegment::getIndex() const {
+    return index;
+}
+
 bool PlatformSegment::operator==(const PlatformSegment& p) const {
     return p.platform == platform &&
            (p.index == index || p.index == -1 || index == -1);
@@ -16,8 +16,11 @@ class PlatformSegment {
     const Pair* firstPoint() const;
     const Pair* secondPoint() const;
     const Pair slope() const;
-    double angle() const;
+    wideReal angle() const;
+    Pair const& direction() const;
+    Pair const& normal() const;
     const Platform* getPlatform() const;
+    int getIndex() const;
 
     bool operator==(const PlatformSegment& p) const;
     bool operator<(const PlatformSegment& p) const;
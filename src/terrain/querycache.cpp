@@ -0,0 +1,73 @@
+#include <string.h>
+#include <stdint.h>
+#include "./querycache.hpp"
+
+#ifdef SIM_FIXED
+static uint64_t bits(Fixed f) {
+    return f.getRaw();
+}
+#else
+static uint64_t bits(double d) {
+    uint64_t b;
+    memcpy(&b, &d, sizeof(b));
+    return b;
+}
+#endif
+
+static bool sameBits(Pair const& a, Pair const& b) {
+    return bits(a.x) == bits(b.x) && bits(a.y) == bits(b.y);
+}
+
+size_t QueryCache::slot(Pair const& start,
+                        Pair const& end,
+                        TerrainCollisionType type) {
+    uint64_t h = type;
+    uint64_t keys[] = {bits(start.x), bits(start.y), bits(end.x), bits(end.y)};
+    for (uint64_t k : keys) {
+        h = (h ^ k) * 0x100000001b3ULL;
+        h ^= h >> 29;
+    }
+    return h & (QUERY_CACHE_SIZE - 1);
+}
+
+void QueryCache::validate(void const* newOwner, size_t newEpoch) {
+    if (owner == newOwner && epoch == newEpoch)
+        return;
+
+    clear();
+    owner = newOwner;
+    epoch = newEpoch;
+}
+
+void QueryCache::clear() {
+    for (Entry& e : entries) {
+        e.valid = false;
+    }
+}
+
+QueryCache::Entry const* QueryCache::find(Pair const& start,
+                                          Pair const& end,
+                                          TerrainCollisionType type) const {
+    Entry const& e = entries[slot(start, end, type)];
+    if (e.valid && e.type == type && sameBits(e.start, start) &&
+        sameBits(e.end, end)) {
+        return &e;
+    }
+    return NULL;
+}
+
+void QueryCache::store(Pair const& start,
+                       Pair const& end,
+                       TerrainCollisionType type,
+                       bool hit,
+                       size_t segmentId,
+                       Pair const& position) {
+    Entry& e = entries[slot(start, end, type)];
+    e.start = start;
+    e.end = end;
+    e.type = type;
+    e.valid = true;
+    e.hit = hit;
+    e.segmentId = segmentId;
+    e.position = position;
+}
@@ -0,0 +1,61 @@
+#ifndef __TERRAIN_QUERY_CACHE
+#define __TERRAIN_QUERY_CACHE
+
+#include <stddef.h>
+#include "engine/pair.hpp"
+#include "./collisiontype.hpp"
+
+// number of remembered sweeps. Must be a power of two
+#define QUERY_CACHE_SIZE 64
+
+/**
+ * Small direct mapped cache of segment sweep results
+ *
+ * Entries are keyed on the exact bits of the sweep endpoints and the
+ * collision type, so a hit returns exactly what the query would have. The
+ * owner stamps the cache with a map and an epoch, and it forgets everything
+ * when either changes.
+ */
+class QueryCache {
+   public:
+    class Entry {
+       public:
+        Pair start;
+        Pair end;
+        TerrainCollisionType type;
+        bool valid = false;
+
+        bool hit;
+        size_t segmentId;
+        Pair position;
+    };
+
+   private:
+    Entry entries[QUERY_CACHE_SIZE];
+    void const* owner = NULL;
+    size_t epoch = 0;
+
+    static size_t slot(Pair const& start,
+                       Pair const& end,
+                       TerrainCollisionType type);
+
+   public:
+    /** Forget every entry if the cache was filled for another owner or
+     * epoch
+     */
+    void validate(void const* owner, size_t epoch);
+    void clear();
+
+    /** The entry for the sweep, or NULL if it isn't cached */
+    Entry const* find(Pair const& start,
+                      Pair const& end,
+                      TerrainCollisionType type) const;
+    void store(Pair const& start,
+               Pair const& end,
+               TerrainCollisionType type,
+               bool hit,
+               size_t segmentId,
+               Pair const& position);
+};
+
+#endif
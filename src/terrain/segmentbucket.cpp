@@ -0,0 +1,82 @@
+#include "./segmentbucket.hpp"
+#include "stage/stagefile.hpp"
+
+void SegmentBucket::build(Table<MapSegment> const& segments,
+                          std::vector<size_t> const& bucketIds) {
+    ids.assign(bucketIds);
+    parts.clear();
+
+    std::vector<Bounds> bounds;
+    for (size_t id : ids) {
+        bounds.push_back(Bounds(segments[id].first, segments[id].second));
+    }
+    grid.build(bounds);
+}
+
+void SegmentBucket::merge(
+    std::vector<std::pair<SegmentBucket const*, size_t>> const& buckets) {
+    std::vector<size_t> merged;
+    parts.clear();
+    partBounds = Bounds();
+    for (auto const& bucket : buckets) {
+        SegmentBucket const& b = *bucket.first;
+        if (b.parts.empty()) {
+            parts.push_back(std::make_pair(&b.grid, merged.size()));
+        }
+        for (auto const& part : b.parts) {
+            parts.push_back(
+                std::make_pair(part.first, merged.size() + part.second));
+        }
+        for (size_t id : b.ids) {
+            merged.push_back(bucket.second + id);
+        }
+        partBounds.include(b.getBounds());
+    }
+    ids.assign(std::move(merged));
+    grid = SpatialGrid();
+}
+
+void SegmentBucket::query(Bounds const& bounds,
+                          std::vector<size_t>& out) const {
+    if (parts.empty()) {
+        grid.query(bounds, out);
+        for (size_t& i : out) {
+            i = ids[i];
+        }
+        return;
+    }
+
+    // each part's ids follow the previous part's, so the candidates come
+    // out in ascending order without sorting
+    out.clear();
+    for (auto const& part : parts) {
+        size_t first = out.size();
+        part.first->queryAppend(bounds, out);
+        for (size_t i = first; i < out.size(); i++) {
+            out[i] = ids[part.second + out[i]];
+        }
+    }
+}
+
+void SegmentBucket::save(StageWriter& out) const {
+    out.write(ids);
+    grid.save(out);
+}
+
+void SegmentBucket::load(StageReader& in) {
+    in.read(ids);
+    grid.load(in);
+    parts.clear();
+}
+
+Bounds SegmentBucket::getBounds() const {
+    return parts.empty() ? grid.getBounds() : partBounds;
+}
+
+Table<size_t> const& SegmentBucket::getIds() const {
+    return ids;
+}
+
+size_t SegmentBucket::size() const {
+    return ids.size();
+}
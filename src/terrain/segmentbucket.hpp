@@ -0,0 +1,50 @@
+#ifndef __TERRAIN_SEGMENT_BUCKET
+#define __TERRAIN_SEGMENT_BUCKET
+
+#include <utility>
+#include <vector>
+#include <stddef.h>
+#include "engine/table.hpp"
+#include "./bounds.hpp"
+#include "./spatialgrid.hpp"
+#include "./mapsegment.hpp"
+
+/**
+ * A subset of the map's segment table with its own broadphase
+ *
+ * Ids are kept in ascending order, so queries return candidates in the
+ * same order as a scan over the whole segment table would visit them.
+ */
+class SegmentBucket {
+    Table<size_t> ids;
+    SpatialGrid grid;
+    // for a bucket merged from others, their grids and where each one's ids
+    // start in ids
+    std::vector<std::pair<SpatialGrid const*, size_t>> parts;
+    Bounds partBounds;
+
+   public:
+    void build(Table<MapSegment> const& segments,
+               std::vector<size_t> const& ids);
+
+    /** Merge the buckets of several maps, each paired with where its map's
+     * segments start in this map's segment table, in ascending order
+     *
+     * Their grids are used in place rather than rebuilt, so the buckets
+     * must outlive this one and not change. A merged bucket can't be saved.
+     */
+    void merge(
+        std::vector<std::pair<SegmentBucket const*, size_t>> const& buckets);
+    void save(StageWriter& out) const;
+    void load(StageReader& in);
+
+    /** Collect the segment table ids of candidates overlapping the bounds */
+    void query(Bounds const& bounds, std::vector<size_t>& out) const;
+
+    // area covered by the bucket's broadphase
+    Bounds getBounds() const;
+    Table<size_t> const& getIds() const;
+    size_t size() const;
+};
+
+#endif
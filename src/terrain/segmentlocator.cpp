@@ -0,0 +1,217 @@
+#include <algorithm>
+#include "./segmentlocator.hpp"
+#include "engine/util.hpp"
+#include "stage/stagefile.hpp"
+
+// relative slack on squared distances. Distances whose square roots round
+// to the same value are within a couple of ulps of each other
+#define CLOSEST_POINT_SLACK 1e-12
+
+void SegmentLocator::build(Table<Pair> const& points,
+                           std::vector<size_t> const& segments) {
+    std::vector<wideReal> cuts, lo, hi;
+    for (size_t id : segments) {
+        lo.push_back(std::min(points[id].x, points[id + 1].x) -
+                     SEGMENT_LOCATOR_MARGIN);
+        hi.push_back(std::max(points[id].x, points[id + 1].x) +
+                     SEGMENT_LOCATOR_MARGIN);
+        cuts.push_back(lo.back());
+        cuts.push_back(hi.back());
+    }
+    std::sort(cuts.begin(), cuts.end());
+    cuts.erase(std::unique(cuts.begin(), cuts.end()), cuts.end());
+
+    // count the segments of every slab, then fill them in. Segments are
+    // visited in ascending order, which keeps every slab sorted
+    size_t numSlabs = cuts.empty() ? 0 : cuts.size() - 1;
+    std::vector<size_t> starts(numSlabs + 1, 0), ids;
+    for (int pass = 0; pass < 2; pass++) {
+        std::vector<size_t> fill(starts.begin(), starts.end() - 1);
+        for (size_t i = 0; i < segments.size(); i++) {
+            size_t first =
+                std::lower_bound(cuts.begin(), cuts.end(), lo[i]) -
+                cuts.begin();
+            size_t last =
+                std::lower_bound(cuts.begin(), cuts.end(), hi[i]) -
+                cuts.begin();
+            for (size_t s = first; s < last; s++) {
+                if (pass == 0) {
+                    starts[s + 1]++;
+                } else {
+                    ids[fill[s]++] = segments[i];
+                }
+            }
+        }
+
+        if (pass == 0) {
+            for (size_t s = 0; s < numSlabs; s++) {
+                starts[s + 1] += starts[s];
+            }
+            ids.resize(starts[numSlabs]);
+        }
+    }
+
+    std::vector<size_t> order(points.size());
+    for (size_t i = 0; i < points.size(); i++) {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(),
+                     [&](size_t a, size_t b) {
+                         return points[a].x < points[b].x;
+                     });
+    std::vector<wideReal> orderX(points.size());
+    for (size_t i = 0; i < points.size(); i++) {
+        orderX[i] = points[order[i]].x;
+    }
+
+    slabX.assign(std::move(cuts));
+    slabStart.assign(std::move(starts));
+    slabIds.assign(std::move(ids));
+    sortedPoints.assign(std::move(order));
+    sortedX.assign(std::move(orderX));
+}
+
+bool SegmentLocator::refit(Table<Pair> const& points) {
+    // every cut is the start of the segments first found in the slab after
+    // it, or the end of those last found in the slab before it. All of them
+    // have to give it the same value, and the cuts have to stay ascending
+    size_t numSlabs = slabX.empty() ? 0 : slabX.size() - 1;
+    wideReal* cuts = slabX.mutableData();
+    size_t const* ids = slabIds.data();
+    auto inSlab = [&](size_t slab, size_t id) {
+        return std::binary_search(ids + slabStart[slab],
+                                  ids + slabStart[slab + 1], id);
+    };
+    bool cutSet = false;
+    for (size_t s = 0; s < numSlabs; s++) {
+        bool nextSet = false;
+        for (size_t i = slabStart[s]; i < slabStart[s + 1]; i++) {
+            size_t id = ids[i];
+            if (s == 0 || !inSlab(s - 1, id)) {
+                wideReal lo = std::min(points[id].x, points[id + 1].x) -
+                              SEGMENT_LOCATOR_MARGIN;
+                if (cutSet && cuts[s] != lo)
+                    return false;
+                cuts[s] = lo;
+                cutSet = true;
+            }
+            if (s + 1 == numSlabs || !inSlab(s + 1, id)) {
+                wideReal hi = std::max(points[id].x, points[id + 1].x) +
+                              SEGMENT_LOCATOR_MARGIN;
+                if (nextSet && cuts[s + 1] != hi)
+                    return false;
+                cuts[s + 1] = hi;
+                nextSet = true;
+            }
+        }
+        if (!cutSet || (s > 0 && !(cuts[s - 1] < cuts[s])))
+            return false;
+        cutSet = nextSet;
+    }
+    if (numSlabs > 0 && !(cutSet && cuts[numSlabs - 1] < cuts[numSlabs]))
+        return false;
+
+    // points of equal x stay in index order, like the stable sort leaves them
+    wideReal* x = sortedX.mutableData();
+    size_t const* order = sortedPoints.data();
+    for (size_t i = 0; i < sortedX.size(); i++) {
+        x[i] = points[order[i]].x;
+        if (i > 0 && (x[i] < x[i - 1] ||
+                      (x[i] == x[i - 1] && order[i] < order[i - 1])))
+            return false;
+    }
+    return true;
+}
+
+void SegmentLocator::save(StageWriter& out) const {
+    out.write(slabX);
+    out.write(slabStart);
+    out.write(slabIds);
+    out.write(sortedPoints);
+    out.write(sortedX);
+}
+
+void SegmentLocator::load(StageReader& in) {
+    in.read(slabX);
+    in.read(slabStart);
+    in.read(slabIds);
+    in.read(sortedPoints);
+    in.read(sortedX);
+}
+
+void SegmentLocator::query(wideReal x,
+                           size_t const*& begin,
+                           size_t const*& end) const {
+    begin = end = slabIds.data();
+    size_t slab = std::upper_bound(slabX.begin(), slabX.end(), x) -
+                  slabX.begin();
+    if (slab == 0 || slab >= slabX.size())
+        return;
+
+    begin = slabIds.data() + slabStart[slab - 1];
+    end = slabIds.data() + slabStart[slab];
+}
+
+/** Visit sorted points outwards from x, on each side stopping at the
+ * first point further than limit along x. The visitor may lower limit
+ */
+template <typename Visit>
+static void walkOutwards(Table<wideReal> const& sortedX,
+                         Table<size_t> const& sortedPoints,
+                         size_t start,
+                         wideReal x,
+                         wideReal const& limit,
+                         Visit visit) {
+    for (size_t i = start; i < sortedX.size(); i++) {
+        wideReal dx = sortedX[i] - x;
+        if (dx * dx > limit)
+            break;
+        visit(sortedPoints[i]);
+    }
+    for (size_t i = start; i-- > 0;) {
+        wideReal dx = x - sortedX[i];
+        if (dx * dx > limit)
+            break;
+        visit(sortedPoints[i]);
+    }
+}
+
+size_t SegmentLocator::closestPoint(Table<Pair> const& points,
+                                    Pair const& position,
+                                    size_t first,
+                                    size_t last) const {
+    size_t start = std::lower_bound(sortedX.begin(), sortedX.end(),
+                                    position.x) -
+                   sortedX.begin();
+
+    // find the smallest squared distance first, then settle ties between
+    // every point that may share its square root like the linear scan would
+    wideReal best = DOUBLE_INFINITY;
+    walkOutwards(sortedX, sortedPoints, start, position.x, best,
+                 [&](size_t id) {
+                     if (id < first || id > last)
+                         return;
+                     wideReal distance =
+                         (position - points[id]).euclidSquared();
+                     if (distance < best)
+                         best = distance;
+                 });
+
+    wideReal limit = best * (1 + CLOSEST_POINT_SLACK);
+    wideReal closestDist = DOUBLE_INFINITY;
+    size_t closest = first;
+    walkOutwards(sortedX, sortedPoints, start, position.x, limit,
+                 [&](size_t id) {
+                     if (id < first || id > last ||
+                         (position - points[id]).euclidSquared() > limit)
+                         return;
+                     wideReal distance = (position - points[id]).euclid();
+                     if (distance < closestDist ||
+                         (distance == closestDist && id > closest)) {
+                         closestDist = distance;
+                         closest = id;
+                     }
+                 });
+
+    return closest;
+}
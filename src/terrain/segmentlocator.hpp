@@ -0,0 +1,67 @@
+#ifndef __TERRAIN_SEGMENT_LOCATOR
+#define __TERRAIN_SEGMENT_LOCATOR
+
+#include <vector>
+#include <stddef.h>
+#include "engine/pair.hpp"
+#include "engine/table.hpp"
+
+class StageWriter;
+class StageReader;
+
+// how far past its endpoints a segment's interval reaches. Covers the
+// tolerances of onLine and Pair comparisons
+#define SEGMENT_LOCATOR_MARGIN 0.001
+
+/**
+ * Lookup of the segments of a single platform by x position
+ *
+ * The x axis is cut into slabs at every segment interval's endpoint, and
+ * each slab lists the segments covering it in ascending index order, so a
+ * lookup is a binary search followed by a short scan. Points are also kept
+ * sorted by x for finding the closest one when a position is off the
+ * platform.
+ */
+class SegmentLocator {
+    // slab i covers [slabX[i], slabX[i + 1]) and holds the segments
+    // slabIds[slabStart[i]..slabStart[i + 1]]
+    Table<wideReal> slabX;
+    Table<size_t> slabStart;
+    Table<size_t> slabIds;
+
+    // point indices and their x, sorted by x
+    Table<size_t> sortedPoints;
+    Table<wideReal> sortedX;
+
+   public:
+    /** Index the given segments of points. Segment i joins points[i] and
+     * points[i + 1], and ids must be ascending
+     */
+    void build(Table<Pair> const& points, std::vector<size_t> const& segments);
+
+    /** Follow the indexed points to where they moved, keeping which
+     * segments every slab holds. Gives the same result as build, unless the
+     * x order of the segment intervals or points changed. Then it returns
+     * false and the locator has to be built again
+     */
+    bool refit(Table<Pair> const& points);
+    void save(StageWriter& out) const;
+    void load(StageReader& in);
+
+    /** Point begin..end at the ids of the segments whose interval holds x,
+     * in ascending order
+     */
+    void query(wideReal x, size_t const*& begin, size_t const*& end) const;
+
+    /** Index of the point in points[first..last] closest to position
+     *
+     * Gives the same result as scanning the range in order and keeping the
+     * last point whose euclid() distance is no more than the closest so far.
+     */
+    size_t closestPoint(Table<Pair> const& points,
+                        Pair const& position,
+                        size_t first,
+                        size_t last) const;
+};
+
+#endif
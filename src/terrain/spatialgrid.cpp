@@ -0,0 +1,162 @@
+#include <algorithm>
+#include <cmath>
+#include "./spatialgrid.hpp"
+#include "stage/stagefile.hpp"
+
+// upper bound on the number of cells relative to the number of items
+#define GRID_CELLS_PER_ITEM 4
+
+SpatialGrid::SpatialGrid() : origin(0, 0) {}
+
+void SpatialGrid::build(std::vector<Bounds> const& bounds) {
+    cellStart.clear();
+    items.clear();
+    columns = rows = 0;
+
+    Bounds world;
+    wideReal totalExtent = 0;
+    for (Bounds const& b : bounds) {
+        world.include(b);
+        totalExtent += std::max(b.max.x - b.min.x, b.max.y - b.min.y);
+    }
+
+    if (bounds.size() == 0 || world.isEmpty()) {
+        return;
+    }
+
+    // pick a cell size close to the average item size, but large enough
+    // that the grid does not have many more cells than items
+    wideReal width = world.max.x - world.min.x;
+    wideReal height = world.max.y - world.min.y;
+    wideReal area =
+        std::max<wideReal>(width, 1e-9) * std::max<wideReal>(height, 1e-9);
+    cellSize =
+        std::max(totalExtent / bounds.size(),
+                 sqrt(area / (GRID_CELLS_PER_ITEM * bounds.size())));
+    if (!(cellSize > 0)) {
+        cellSize = 1;
+    }
+
+    // sparse worlds (e.g. a few small items far apart) would still produce
+    // huge grids, so grow the cells until the cell count is bounded
+    while ((width / cellSize + 1) * (height / cellSize + 1) >
+           GRID_CELLS_PER_ITEM * bounds.size() + 1) {
+        cellSize *= 2;
+    }
+
+    origin = world.min;
+    columns = (size_t)(width / cellSize) + 1;
+    rows = (size_t)(height / cellSize) + 1;
+
+    // count the items in each cell, then lay the cells out back to back
+    std::vector<size_t> counts(columns * rows + 1, 0);
+    for (Bounds const& b : bounds) {
+        for (size_t y = row(b.min.y); y <= row(b.max.y); y++) {
+            for (size_t x = column(b.min.x); x <= column(b.max.x); x++) {
+                counts[y * columns + x]++;
+            }
+        }
+    }
+
+    std::vector<size_t> start(columns * rows + 1, 0);
+    for (size_t i = 0; i < columns * rows; i++) {
+        start[i + 1] = start[i] + counts[i];
+    }
+
+    std::vector<size_t> cellItems(start[columns * rows]);
+    std::vector<size_t> fill(start.begin(), start.end() - 1);
+    for (size_t id = 0; id < bounds.size(); id++) {
+        Bounds const& b = bounds[id];
+        for (size_t y = row(b.min.y); y <= row(b.max.y); y++) {
+            for (size_t x = column(b.min.x); x <= column(b.max.x); x++) {
+                cellItems[fill[y * columns + x]++] = id;
+            }
+        }
+    }
+
+    cellStart.assign(std::move(start));
+    items.assign(std::move(cellItems));
+}
+
+size_t SpatialGrid::column(wideReal x) const {
+    wideReal c = floor((x - origin.x) / cellSize);
+    if (!(c > 0))
+        return 0;
+    return std::min((size_t)c, columns - 1);
+}
+
+size_t SpatialGrid::row(wideReal y) const {
+    wideReal r = floor((y - origin.y) / cellSize);
+    if (!(r > 0))
+        return 0;
+    return std::min((size_t)r, rows - 1);
+}
+
+void SpatialGrid::query(Bounds const& bounds, std::vector<size_t>& out) const {
+    out.clear();
+    queryAppend(bounds, out);
+}
+
+void SpatialGrid::queryAppend(Bounds const& bounds,
+                              std::vector<size_t>& out) const {
+    if (columns == 0 || bounds.isEmpty())
+        return;
+
+    // reject queries entirely outside of the grid
+    wideReal maxX = origin.x + columns * cellSize;
+    wideReal maxY = origin.y + rows * cellSize;
+    if (bounds.max.x < origin.x || bounds.max.y < origin.y ||
+        bounds.min.x > maxX || bounds.min.y > maxY)
+        return;
+
+    size_t x0 = column(bounds.min.x), x1 = column(bounds.max.x);
+    size_t y0 = row(bounds.min.y), y1 = row(bounds.max.y);
+    size_t first = out.size();
+    for (size_t y = y0; y <= y1; y++) {
+        for (size_t x = x0; x <= x1; x++) {
+            size_t cell = y * columns + x;
+            out.insert(out.end(), items.begin() + cellStart[cell],
+                       items.begin() + cellStart[cell + 1]);
+        }
+    }
+
+    // items spanning several cells show up once per cell
+    if (x0 != x1 || y0 != y1) {
+        std::sort(out.begin() + first, out.end());
+        out.erase(std::unique(out.begin() + first, out.end()), out.end());
+    }
+}
+
+Bounds SpatialGrid::getBounds() const {
+    if (columns == 0) {
+        return Bounds();
+    }
+    return Bounds(origin,
+                  origin + Pair(columns * cellSize, rows * cellSize));
+}
+
+size_t SpatialGrid::numCells() const {
+    return columns * rows;
+}
+
+wideReal SpatialGrid::getCellSize() const {
+    return cellSize;
+}
+
+void SpatialGrid::save(StageWriter& out) const {
+    out.writeValue(origin);
+    out.writeValue(cellSize);
+    out.writeValue(columns);
+    out.writeValue(rows);
+    out.write(cellStart);
+    out.write(items);
+}
+
+void SpatialGrid::load(StageReader& in) {
+    in.readValue(origin);
+    in.readValue(cellSize);
+    in.readValue(columns);
+    in.readValue(rows);
+    in.read(cellStart);
+    in.read(items);
+}
@@ -0,0 +1,57 @@
+#ifndef __TERRAIN_SPATIAL_GRID
+#define __TERRAIN_SPATIAL_GRID
+
+#include <vector>
+#include <stddef.h>
+#include "engine/pair.hpp"
+#include "engine/table.hpp"
+#include "./bounds.hpp"
+
+class StageWriter;
+class StageReader;
+
+/**
+ * Uniform grid broadphase over a static set of bounding boxes
+ *
+ * Items are identified by their index in the bounds list the grid was built
+ * from. Every item is registered in each cell its bounds overlap, and cells
+ * are stored back to back so that a query touches contiguous memory.
+ */
+class SpatialGrid {
+    Pair origin;
+    wideReal cellSize = 1;
+    size_t columns = 0;
+    size_t rows = 0;
+
+    // cell i holds items[cellStart[i]..cellStart[i + 1]]
+    Table<size_t> cellStart;
+    Table<size_t> items;
+
+    size_t column(wideReal x) const;
+    size_t row(wideReal y) const;
+
+   public:
+    SpatialGrid();
+
+    void build(std::vector<Bounds> const& bounds);
+
+    /** Collect the ids of every item whose cell overlaps the query bounds
+     *
+     * The output is sorted and free of duplicates, so callers iterate
+     * candidates in the same order as a linear scan would.
+     */
+    void query(Bounds const& bounds, std::vector<size_t>& out) const;
+    // same as query, but adds the ids after what out already holds
+    void queryAppend(Bounds const& bounds, std::vector<size_t>& out) const;
+
+    // write the grid to a compiled stage, or use one read from it in place
+    void save(StageWriter& out) const;
+    void load(StageReader& in);
+
+    // area covered by the cells, empty for a grid without items
+    Bounds getBounds() const;
+    size_t numCells() const;
+    wideReal getCellSize() const;
+};
+
+#endif
@@ -0,0 +1,5 @@
+#include "./terrainquery.hpp"
+
+Ray::Ray() : start(0, 0), end(0, 0) {}
+
+Ray::Ray(Pair const& start, Pair const& end) : start(start), end(end) {}
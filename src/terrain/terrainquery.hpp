@@ -0,0 +1,43 @@
+#ifndef __TERRAIN_QUERY
+#define __TERRAIN_QUERY
+
+#include <stddef.h>
+#include "engine/pair.hpp"
+
+/** Kinds of segment the public map queries can hit, combined as a mask */
+typedef enum TerrainQueryFilter {
+    QUERY_FLOORS = 1,
+    QUERY_WALLS = 2,
+    QUERY_CEILINGS = 4,
+    // segments of passable platforms are only hit when this is set as well
+    // as their type
+    QUERY_PASSABLE = 8,
+    QUERY_SOLID = QUERY_FLOORS | QUERY_WALLS | QUERY_CEILINGS,
+    QUERY_ALL = QUERY_SOLID | QUERY_PASSABLE,
+} TerrainQueryFilter;
+
+/** A line from start to end, for batched ray casts */
+class Ray {
+   public:
+    Pair start;
+    Pair end;
+
+    Ray();
+    Ray(Pair const& start, Pair const& end);
+};
+
+/** First terrain hit by a ray or shape cast */
+class QueryHit {
+   public:
+    bool hit = false;
+    // id of the segment in the map's segment table
+    size_t segmentId = 0;
+    // where the terrain was touched
+    Pair position = Pair(0, 0);
+    // how far along the cast the hit is, from 0 at its start to 1 at its end
+    wideReal fraction = 1;
+    // unit normal of the segment, facing back towards the cast
+    Pair normal = Pair(0, 0);
+};
+
+#endif
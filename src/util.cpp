@@ -7,30 +7,34 @@
 #define _debug(...)
 // #define _debug(...) { __VA_ARGS__; }
 
-double Dot(const Pair& a, const Pair& b) {
+wideReal Dot(const Pair& a, const Pair& b) {
     return (a.x * b.x) + (a.y * b.y);
 }
 
-double PerpDot(const Pair& a, const Pair& b) {
+wideReal PerpDot(const Pair& a, const Pair& b) {
     return (a.y * b.x) - (a.x * b.y);
 }
 
-int checkLineIntersection(Pair const& p0,
-                          Pair const& p1,
-                          Pair const& p2,
-                          Pair const& p3,
-                          Pair& out,
-                          double epsilon) {
-    Pair a = p1 - p0;
-    Pair b = p3 - p2;
-
-    double f = PerpDot(a, b);
+int checkLineIntersectionPrecise(Pair const& p0,
+                                 Pair const& p1,
+                                 Pair const& p2,
+                                 Pair const& p3,
+                                 WidePair& out,
+                                 wideReal epsilon) {
+    WidePair q0 = WidePair(p0.x, p0.y);
+    WidePair q1 = WidePair(p1.x, p1.y);
+    WidePair q2 = WidePair(p2.x, p2.y);
+    WidePair q3 = WidePair(p3.x, p3.y);
+    WidePair a = q1 - q0;
+    WidePair b = q3 - q2;
+
+    wideReal f = (a.y * b.x) - (a.x * b.y);
     if (!f)  // lines are parallel
         return 0;
 
-    Pair c(p3 - p1);
-    double aa = PerpDot(a, c);
-    double bb = PerpDot(b, c);
+    WidePair c(q3 - q1);
+    wideReal aa = (a.y * c.x) - (a.x * c.y);
+    wideReal bb = (b.y * c.x) - (b.x * c.y);
 
     if (f < 0) {
         if (aa > epsilon)
@@ -54,11 +58,88 @@ int checkLineIntersection(Pair const& p0,
             return 0;
     }
 
-    double r = std::max(0.0, 1.0 - std::min(1.0, aa / f));
-    out = ((p3 - p2) * r) + p2;
+    wideReal r = std::max<wideReal>(0, 1 - std::min<wideReal>(1, aa / f));
+    out = ((q3 - q2) * r) + q2;
     return -sign(f);
 }
 
+int checkLineIntersection(Pair const& p0,
+                          Pair const& p1,
+                          Pair const& p2,
+                          Pair const& p3,
+                          Pair& out,
+                          wideReal epsilon) {
+    WidePair point;
+    int direction = checkLineIntersectionPrecise(p0, p1, p2, p3, point,
+                                                 epsilon);
+    if (direction)
+        out = Pair(point.x, point.y);
+    return direction;
+}
+
+// the helpers below work on raw coordinates, they are called for every
+// corner near a swept edge
+
+static wideReal segmentDistanceSquared(Pair const& a,
+                                     Pair const& b,
+                                     Pair const& c) {
+    wideReal abx = b.x - a.x, aby = b.y - a.y;
+    wideReal acx = c.x - a.x, acy = c.y - a.y;
+    wideReal lengthSquared = abx * abx + aby * aby;
+    wideReal t = 0;
+    if (lengthSquared > 0)
+        t = std::max<wideReal>(
+            0, std::min<wideReal>(1, (acx * abx + acy * aby) / lengthSquared));
+    wideReal dx = acx - abx * t, dy = acy - aby * t;
+    return dx * dx + dy * dy;
+}
+
+static wideReal edgeSide(Pair const& a, Pair const& b, Pair const& p) {
+    return (b.y - a.y) * (p.x - a.x) - (b.x - a.x) * (p.y - a.y);
+}
+
+static bool inTriangle(Pair const& a,
+                       Pair const& b,
+                       Pair const& c,
+                       Pair const& p) {
+    wideReal d1 = edgeSide(a, b, p);
+    wideReal d2 = edgeSide(b, c, p);
+    wideReal d3 = edgeSide(c, a, p);
+    return (d1 > 0 && d2 > 0 && d3 > 0) || (d1 < 0 && d2 < 0 && d3 < 0);
+}
+
+bool inSweptQuad(Pair const& a1,
+                 Pair const& a2,
+                 Pair const& b1,
+                 Pair const& b2,
+                 Pair const& c,
+                 wideReal margin) {
+    if (c.x < std::min(std::min(a1.x, a2.x), std::min(b1.x, b2.x)) - margin ||
+        c.x > std::max(std::max(a1.x, a2.x), std::max(b1.x, b2.x)) + margin ||
+        c.y < std::min(std::min(a1.y, a2.y), std::min(b1.y, b2.y)) - margin ||
+        c.y > std::max(std::max(a1.y, a2.y), std::max(b1.y, b2.y)) + margin)
+        return false;
+
+    // the swept area is the convex hull of the four corners, which is
+    // covered by the four triangles they form. Points on or near the
+    // boundary are caught by their distance to the lines between corners.
+    if (inTriangle(a1, a2, b1, c) || inTriangle(a1, a2, b2, c) ||
+        inTriangle(a1, b1, b2, c) || inTriangle(a2, b1, b2, c))
+        return true;
+
+    Pair const* corners[] = {&a1, &a2, &b1, &b2};
+    wideReal marginSquared = margin * margin;
+    for (int i = 0; i < 4; i++) {
+        for (int j = i + 1; j < 4; j++) {
+            if (segmentDistanceSquared(*corners[i], *corners[j], c) <=
+                marginSquared)
+                return true;
+        }
+    }
+
+    return false;
+}
+
 #define exchange(i, j) \
     {                  \
         tmp = i;       \
@@ -80,7 +161,7 @@ int checkLineSweep(Pair const& a1,
                    Pair const& c,
                    Pair& out1,
                    Pair& out2,
-                   double epsilon) {
+                   wideReal epsilon) {
     _debug(std::cout << "a1: " << a1 << std::endl;
            std::cout << "a2: " << a2 << std::endl;
            std::cout << "b1: " << b1 << std::endl;
@@ -97,7 +178,7 @@ int checkLineSweep(Pair const& a1,
            std::cout << "diff1 len^2: " << diff1.euclidSquared() << std::endl;
            std::cout << "diff2 len^2: " << diff2.euclidSquared() << std::endl;)
 
-        double biggestLen =
+        wideReal biggestLen =
             std::max(diff1.euclidSquared(), diff2.euclidSquared());
 
     if (biggestLen == 0) {
@@ -107,7 +188,7 @@ int checkLineSweep(Pair const& a1,
         return 1;
     }
 
-    Pair biggestDiff = diff1 * (std::sqrt(biggestLen) / diff1.euclid());
+    Pair biggestDiff = diff1 * (sqrt(biggestLen) / diff1.euclid());
 
     _debug(std::cout << "biggest diff " << biggestDiff << std::endl);
 
@@ -126,9 +207,9 @@ int checkLineSweep(Pair const& a1,
            std::cout << "wasIntersection B: " << wasIntersection2
                      << std::endl;);
 
-    double pointADist = (intersectionA - c).euclid();
-    double pointBDist = (intersectionB - c).euclid();
-    double diffDist = pointADist + pointBDist;
+    wideReal pointADist = (intersectionA - c).euclid();
+    wideReal pointBDist = (intersectionB - c).euclid();
+    wideReal diffDist = pointADist + pointBDist;
 
     if (diffDist == 0) {
         _debug(std::cout << "diffDist = 0" << std::endl);
@@ -138,7 +219,7 @@ int checkLineSweep(Pair const& a1,
         return -wasIntersection1;
     };
 
-    double rC = pointADist / diffDist;
+    wideReal rC = pointADist / diffDist;
 
     _debug(std::cout << "rC" << rC << std::endl;
 
@@ -156,14 +237,14 @@ int checkLineSweep(Pair const& a1,
 
 #define EPSILON 0.0001
 bool onLine(Pair const& l1, Pair const& l2, Pair const& point) {
-    if (std::abs(l1.x - l2.x) < EPSILON) {
-        return std::abs(point.x - l1.x) < EPSILON &&
+    if (abs(l1.x - l2.x) < EPSILON) {
+        return abs(point.x - l1.x) < EPSILON &&
                std::min(l1.y, l2.y) < point.y && std::max(l1.y, l2.y) > point.y;
     }
 
     Pair slope = l2 - l1;
-    double xdiff = point.x - l1.x;
-    double ratio = (xdiff / slope.x);
+    wideReal xdiff = point.x - l1.x;
+    wideReal ratio = (xdiff / slope.x);
     if (ratio < 0 || ratio > 1)
         return false;
     Pair predictedPoint = l1 + slope / slope.x * xdiff;
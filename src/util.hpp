@@ -12,7 +12,18 @@ int checkLineIntersection(Pair const& p0,
                           Pair const& p2,
                           Pair const& p3,
                           Pair& out,
-                          double epsilon = 0.0000001);
+                          wideReal epsilon = 0.0000001);
+
+/**
+ * checkLineIntersection, leaving the hit point in wideReal precision
+ * whatever real is. The intersection is always computed in wideReal
+ */
+int checkLineIntersectionPrecise(Pair const& p0,
+                                 Pair const& p1,
+                                 Pair const& p2,
+                                 Pair const& p3,
+                                 WidePair& out,
+                                 wideReal epsilon = 0.0000001);
 
 int checkLineSweep(Pair const& a1,
                    Pair const& a2,
@@ -21,12 +32,24 @@ int checkLineSweep(Pair const& a1,
                    Pair const& c,
                    Pair& out1,
                    Pair& out2,
-                   double epsilon = 0.001);
+                   wideReal epsilon = 0.001);
+
+/**
+ * Check if c lies in the area swept by moving the line a1..a2 to b1..b2,
+ * or within margin of it. Any point checkLineSweep reports a collision
+ * with lies in this area.
+ */
+bool inSweptQuad(Pair const& a1,
+                 Pair const& a2,
+                 Pair const& b1,
+                 Pair const& b2,
+                 Pair const& c,
+                 wideReal margin);
 
 #define M_PI 3.14159265358979323846 /* pi */
 bool onLine(Pair const& l1, Pair const& l2, Pair const& point);
 
-double Dot(const Pair& a, const Pair& b);
-double PerpDot(const Pair& a, const Pair& b);
+wideReal Dot(const Pair& a, const Pair& b);
+wideReal PerpDot(const Pair& a, const Pair& b);
 
 #endif
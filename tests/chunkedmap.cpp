@@ -0,0 +1,203 @@
+#include <cmath>
+#include <cstdio>
+#include <random>
+#include <stdlib.h>
+#include <unistd.h>
+#include "gtest/gtest.h"
+#include "terrain/chunkedmap.hpp"
+#include "stage/stagecompiler.hpp"
+#include "lib/mock-player.hpp"
+#include "lib/random-platforms.hpp"
+
+using namespace Terrain;
+
+// compiles platforms into a new chunked stage, removed with the fixture
+class ChunkedMapTest : public ::testing::Test {
+   protected:
+    std::string directory;
+
+    void compile(std::vector<Platform> const& platforms,
+                 std::vector<Ledge> const& ledges,
+                 double chunkSize) {
+        char path[] = "/tmp/sdl-game-chunks-XXXXXX";
+        ASSERT_TRUE(mkdtemp(path) != NULL);
+        directory = path;
+        ASSERT_TRUE(
+            compileChunkedStage(platforms, ledges, chunkSize, directory));
+    }
+
+    void TearDown() override {
+        if (directory.empty())
+            return;
+        for (size_t i = 0;; i++) {
+            if (remove(ChunkedMap::chunkPath(directory, i).c_str()) != 0)
+                break;
+        }
+        remove((directory + "/" + CHUNK_INDEX_FILE).c_str());
+        rmdir(directory.c_str());
+    }
+};
+
+static double distanceTo(Bounds const& b, Pair const& p) {
+    double dx =
+        std::max<double>(0.0, (double)std::max(b.min.x - p.x, p.x - b.max.x));
+    double dy =
+        std::max<double>(0.0, (double)std::max(b.min.y - p.y, p.y - b.max.y));
+    return std::sqrt(dx * dx + dy * dy);
+}
+
+TEST_F(ChunkedMapTest, residentChunksFollowPlayers) {
+    compile(makeRandomPlatforms(49, 400), {}, 8);
+    ChunkedMap chunked;
+    chunked.residencyRadius = 1;
+    ASSERT_TRUE(chunked.open(directory));
+    Table<ChunkInfo> const& chunks = chunked.getChunks();
+    ASSERT_GT(chunks.size(), 16);
+
+    Player player = makeMockPlayer(Pair(-15, -15));
+    Player* players[] = {&player};
+    Pair positions[] = {Pair(-15, -15), Pair(15, 15), Pair(0, 0)};
+    for (Pair const& position : positions) {
+        player.position = position;
+        chunked.update(players, 1, true);
+
+        size_t platforms = 0;
+        for (size_t i = 0; i < chunks.size(); i++) {
+            bool near = distanceTo(chunks[i].bounds, position) <= 1;
+            EXPECT_EQ(near, chunked.isResident(i)) << "chunk " << i;
+            if (chunked.isResident(i)) {
+                platforms += chunks[i].numPlatforms;
+            }
+        }
+        ASSERT_TRUE(chunked.getMap() != NULL);
+        EXPECT_EQ(platforms, chunked.getMap()->getPlatforms().size());
+    }
+
+    ChunkStats stats = chunked.getStats();
+    EXPECT_GT(stats.loads, 0);
+    EXPECT_GT(stats.evictions, 0);
+    EXPECT_GE(stats.publishes, 3);
+    EXPECT_GE(stats.maxLatency, stats.lastLatency);
+
+    // the closest chunks win when there are too many to keep
+    chunked.residencyBudget = 2;
+    chunked.residencyRadius = 100;
+    chunked.update(players, 1, true);
+    EXPECT_EQ(2, chunked.getStats().resident);
+    EXPECT_GT(chunked.getStats().overBudget, 0);
+    for (size_t i = 0; i < chunks.size(); i++) {
+        if (distanceTo(chunks[i].bounds, player.position) == 0) {
+            EXPECT_TRUE(chunked.isResident(i));
+        }
+    }
+}
+
+TEST_F(ChunkedMapTest, movementMatchesWholeMap) {
+    std::vector<Platform> platforms = makeRandomPlatforms(50, 200);
+    compile(platforms, {}, 6);
+    Map whole = Map(platforms, {});
+
+    ChunkedMap chunked;
+    chunked.residencyRadius = 100;
+    ASSERT_TRUE(chunked.open(directory));
+    chunked.residencyBudget = chunked.getChunks().size();
+
+    std::mt19937 rng(14);
+    std::uniform_real_distribution<double> position(-20, 20);
+    std::uniform_real_distribution<double> velocity(-0.8, 0.8);
+    for (size_t i = 0; i < 16; i++) {
+        Pair start = Pair(position(rng), position(rng));
+        Player a = makeMockPlayer(start);
+        Player b = makeMockPlayer(start);
+        Player* players[] = {&b};
+        for (size_t frame = 0; frame < 30; frame++) {
+            chunked.update(players, 1, true);
+            Pair motion = Pair(velocity(rng), velocity(rng) + 0.2);
+            a.update();
+            b.update();
+            Pair motionA = motion, motionB = motion;
+            if (a.isGrounded())
+                motionA.y = 0;
+            if (b.isGrounded())
+                motionB.y = 0;
+            whole.movePlayer(a, motionA);
+            chunked.getMap()->movePlayer(b, motionB);
+            ASSERT_EQ(a.position, b.position);
+            ASSERT_EQ(a.getActionState(), b.getActionState());
+        }
+    }
+}
+
+TEST_F(ChunkedMapTest, keepsPlayersOnTheirPlatform) {
+    std::vector<Platform> platforms = {
+        Platform({Pair(0, 2), Pair(3, 2)}),
+        Platform({Pair(20, 2), Pair(23, 2)}),
+    };
+    compile(platforms, {}, 8);
+
+    ChunkedMap chunked;
+    chunked.residencyRadius = 1;
+    ASSERT_TRUE(chunked.open(directory));
+    Player player = makeMockPlayer(Pair(1, 1.5));
+    Player* players[] = {&player};
+    chunked.update(players, 1, true);
+
+    for (size_t frame = 0; frame < 30 && !player.isGrounded(); frame++) {
+        Pair motion = Pair(0, 0.1);
+        player.update();
+        chunked.getMap()->movePlayer(player, motion);
+    }
+    ASSERT_TRUE(player.isGrounded());
+    Platform const* before = player.currentPlatform;
+
+    // bringing in the other chunk moves the player to the new map
+    chunked.residencyRadius = 100;
+    chunked.update(players, 1, true);
+    ASSERT_EQ(2, chunked.getMap()->getPlatforms().size());
+    EXPECT_NE(before, player.currentPlatform);
+    EXPECT_EQ(&chunked.getMap()->getPlatforms()[0], player.currentPlatform);
+    EXPECT_TRUE(player.isGrounded());
+
+    // and losing its platform makes it fall
+    chunked.residencyBudget = 0;
+    chunked.update(players, 1, true);
+    EXPECT_EQ(0, chunked.getMap()->getPlatforms().size());
+    EXPECT_EQ(NULL, player.currentPlatform);
+    EXPECT_FALSE(player.isGrounded());
+}
+
+TEST_F(ChunkedMapTest, movesKinematicPlatforms) {
+    std::vector<Platform> platforms = {
+        Platform({Pair(0, 2), Pair(3, 2)}),
+        Platform({Pair(20, 2), Pair(23, 2)}),
+    };
+    PlatformMotion motion;
+    motion.velocity = Pair(0.1, 0);
+    platforms[0].setMotion(motion);
+    compile(platforms, {}, 8);
+
+    ChunkedMap chunked;
+    chunked.residencyRadius = 1;
+    ASSERT_TRUE(chunked.open(directory));
+    Player player = makeMockPlayer(Pair(1, 1.5));
+    Player* players[] = {&player};
+    for (size_t frame = 0; frame < 5; frame++) {
+        chunked.update(players, 1, true);
+    }
+    std::shared_ptr<Map> before = chunked.getMap();
+    ASSERT_EQ(1, before->getPlatforms().size());
+    EXPECT_EQ(5, before->getPlatforms()[0].getMoves());
+    EXPECT_EQ(Pair(0.5, 2),
+              *before->getPlatforms()[0].getSegment(0).firstPoint());
+
+    // the platform keeps going from where it was in the new map, while the
+    // old one stays usable for as long as it's held
+    chunked.residencyRadius = 100;
+    chunked.update(players, 1, true);
+    ASSERT_EQ(2, chunked.getMap()->getPlatforms().size());
+    EXPECT_EQ(6, chunked.getMap()->getPlatforms()[0].getMoves());
+    EXPECT_EQ(0, chunked.getMap()->getPlatforms()[1].getMoves());
+    EXPECT_EQ(Pair(0.6, 2),
+              *chunked.getMap()->getPlatforms()[0].getSegment(0).firstPoint());
+    EXPECT_EQ(5, before->getPlatforms()[0].getMoves());
+}
@@ -0,0 +1,82 @@
+#include <cmath>
+#include <random>
+#include "gtest/gtest.h"
+#include "engine/fixed.hpp"
+
+// one unit in the last place
+#define FIXED_ULP (1.0 / 4294967296.0)
+
+TEST(Fixed, arithmetic) {
+    EXPECT_EQ(Fixed(0.125), Fixed(0.5) * Fixed(0.25));
+    EXPECT_EQ(Fixed(-3), Fixed(1.5) * -2);
+    EXPECT_EQ(Fixed(0.75), Fixed(3) / 4);
+    EXPECT_EQ(Fixed(-1.25), Fixed(1) - 2.25);
+    EXPECT_EQ(int64_t(1) << 32, Fixed(1).getRaw());
+    EXPECT_EQ(1, Fixed::fromRaw(1).getRaw());
+    EXPECT_DOUBLE_EQ(-2.5, (double)Fixed(-2.5));
+    EXPECT_EQ(-2, (int)Fixed(-2.5));
+
+    // conversions from double round to the nearest value
+    EXPECT_EQ(1, Fixed(0.6 * FIXED_ULP).getRaw());
+    EXPECT_EQ(0, Fixed(0.4 * FIXED_ULP).getRaw());
+    EXPECT_EQ(-1, Fixed(-0.6 * FIXED_ULP).getRaw());
+}
+
+TEST(Fixed, saturates) {
+    Fixed max = Fixed::fromRaw(INT64_MAX), min = Fixed::fromRaw(INT64_MIN);
+    EXPECT_EQ(max, Fixed(1e6) * Fixed(1e6));
+    EXPECT_EQ(min, Fixed(-1e6) * Fixed(1e6));
+    EXPECT_EQ(max, max + 1);
+    EXPECT_EQ(max, Fixed(1) / 0);
+    EXPECT_EQ(min, Fixed(-1) / 0);
+    EXPECT_EQ(Fixed(0), Fixed(0) / 0);
+    EXPECT_EQ(max, Fixed(std::numeric_limits<double>::infinity()));
+    EXPECT_EQ(max, -min);
+}
+
+TEST(Fixed, rounding) {
+    EXPECT_EQ(Fixed(-2), floor(Fixed(-1.5)));
+    EXPECT_EQ(Fixed(1), floor(Fixed(1.5)));
+    EXPECT_EQ(Fixed(-1), ceil(Fixed(-1.5)));
+    EXPECT_EQ(Fixed(2), ceil(Fixed(1.5)));
+    EXPECT_EQ(Fixed(3), ceil(Fixed(3)));
+    EXPECT_EQ(Fixed(1.5), abs(Fixed(-1.5)));
+}
+
+TEST(Fixed, sqrt) {
+    EXPECT_EQ(Fixed(3), sqrt(Fixed(9)));
+    EXPECT_EQ(Fixed(0.5), sqrt(Fixed(0.25)));
+    EXPECT_EQ(Fixed(0), sqrt(Fixed(-1)));
+
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<double> value(0, 1000);
+    for (int i = 0; i < 1000; i++) {
+        Fixed v = value(rng);
+        EXPECT_NEAR(std::sqrt((double)v), (double)sqrt(v), FIXED_ULP);
+    }
+}
+
+TEST(Fixed, trigonometry) {
+    EXPECT_EQ(Fixed(0), atan2(Fixed(0), Fixed(0)));
+    EXPECT_NEAR(M_PI, (double)atan2(Fixed(0), Fixed(-1)), 1e-8);
+    EXPECT_NEAR(-M_PI / 2, (double)atan2(Fixed(-1), Fixed(0)), 1e-8);
+
+    std::mt19937 rng(4);
+    std::uniform_real_distribution<double> coordinate(-100, 100);
+    std::uniform_real_distribution<double> angle(-20, 20);
+    for (int i = 0; i < 1000; i++) {
+        Fixed y = coordinate(rng), x = coordinate(rng);
+        EXPECT_NEAR(std::atan2((double)y, (double)x), (double)atan2(y, x),
+                    1e-8)
+            << y << ", " << x;
+
+        Fixed a = angle(rng);
+        EXPECT_NEAR(std::sin((double)a), (double)sin(a), 1e-8) << a;
+        EXPECT_NEAR(std::cos((double)a), (double)cos(a), 1e-8) << a;
+    }
+
+    // tiny vectors keep their angle
+    Fixed tiny = Fixed::fromRaw(3);
+    EXPECT_NEAR(std::atan2(1, 3), (double)atan2(Fixed::fromRaw(1), tiny),
+                1e-8);
+}
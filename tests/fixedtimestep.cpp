@@ -0,0 +1,33 @@
+#include "gtest/gtest.h"
+#include "engine/fixedtimestep.hpp"
+
+TEST(FixedTimestep, carriesLeftoverTime) {
+    FixedTimestep timestep(0.01);
+    EXPECT_EQ(0, timestep.advance(0.004));
+    EXPECT_NEAR(0.4, timestep.interpolation(), 1e-9);
+    EXPECT_EQ(1, timestep.advance(0.008));
+    EXPECT_NEAR(0.2, timestep.interpolation(), 1e-9);
+    EXPECT_EQ(2, timestep.advance(0.02));
+    EXPECT_NEAR(0.2, timestep.interpolation(), 1e-9);
+}
+
+TEST(FixedTimestep, keepsExactRateOverManyFrames) {
+    // a 144Hz display running a 60Hz simulation
+    FixedTimestep timestep(1.0 / 60.0);
+    size_t steps = 0;
+    for (int frame = 0; frame < 144 * 600; frame++) {
+        steps += timestep.advance(1.0 / 144.0);
+    }
+    EXPECT_NEAR(60 * 600, steps, 1);
+    EXPECT_EQ(0, timestep.getDroppedSteps());
+}
+
+TEST(FixedTimestep, capsStepsPerFrame) {
+    FixedTimestep timestep(0.01, 4);
+    EXPECT_EQ(4, timestep.advance(1.006));
+    EXPECT_EQ(96, timestep.getDroppedSteps());
+    // only the leftover part of a step carries over
+    EXPECT_NEAR(0.6, timestep.interpolation(), 1e-6);
+    EXPECT_EQ(1, timestep.advance(0.005));
+    EXPECT_EQ(0, timestep.advance(-1));
+}
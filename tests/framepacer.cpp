@@ -0,0 +1,51 @@
+#include <chrono>
+#include "gtest/gtest.h"
+#include "engine/framepacer.hpp"
+
+TEST(FrameTimeHistogram, percentiles) {
+    FrameTimeHistogram h;
+    EXPECT_EQ(0, h.getPercentile(0.5));
+    for (int i = 1; i <= 100; i++) {
+        h.record(i * 100000);
+    }
+    h.record(1000000000);
+
+    EXPECT_EQ(101, h.getCount());
+    EXPECT_NEAR(5.1e6, h.getPercentile(0.5), 10000);
+    EXPECT_NEAR(10e6, h.getPercentile(0.99), 10000);
+    // past the last bucket, only the max is known
+    EXPECT_EQ(1000000000, h.getPercentile(1));
+    EXPECT_EQ(1000000000, h.getMax());
+
+    h.reset();
+    EXPECT_EQ(0, h.getCount());
+    EXPECT_EQ(0, h.getMax());
+}
+
+TEST(FramePacer, holdsTargetRate) {
+    typedef FramePacer::Clock Clock;
+    FramePacer pacer(500);
+    Clock::time_point start = Clock::now();
+    pacer.waitForNextFrame();
+    for (int i = 0; i < 50; i++) {
+        pacer.waitForNextFrame();
+    }
+    double seconds =
+        std::chrono::duration<double>(Clock::now() - start).count();
+
+    // frames never come early, so 50 frames take at least 100ms
+    EXPECT_GE(seconds, 0.1);
+    EXPECT_EQ(50, pacer.getFrameTimes().getCount());
+    // a frame that started late is followed by a shorter one, keeping the
+    // average on target
+    EXPECT_GE(pacer.getFrameTimes().getMean(), 1900000);
+}
+
+TEST(FramePacer, uncappedDoesntWait) {
+    FramePacer pacer(0);
+    for (int i = 0; i < 1000; i++) {
+        pacer.waitForNextFrame();
+    }
+    EXPECT_EQ(999, pacer.getFrameTimes().getCount());
+    EXPECT_LT(pacer.getFrameTimes().getPercentile(0.5), 1000000);
+}
@@ -0,0 +1,63 @@
+#include <cmath>
+#include "gtest/gtest.h"
+#include "engine/game.hpp"
+#include "player/inputhandler.hpp"
+#include "player/playerconfig.hpp"
+#include "scenes/simscene.hpp"
+#include "stage/stagegenerator.hpp"
+#include "terrain/map.hpp"
+
+using namespace Terrain;
+using namespace InputMapping;
+
+TEST(ScriptedInputHandler, appliesNextFrame) {
+    ScriptedInputHandler input;
+    InputFrame frame;
+    frame.buttons = 1 << JUMP;
+    frame.axies[MOVEMENT_AXIS_X] = -0.5;
+    input.setNext(frame);
+    input.step();
+    EXPECT_TRUE(input.down(JUMP));
+    EXPECT_FALSE(input.down(SHIELD_BUTTON));
+    EXPECT_DOUBLE_EQ(-0.5, input.axis(MOVEMENT_AXIS_X));
+    EXPECT_DOUBLE_EQ(0, input.axis(MOVEMENT_AXIS_Y));
+
+    input.setNext(InputFrame());
+    input.step();
+    EXPECT_FALSE(input.down(JUMP));
+    EXPECT_TRUE(input.down(JUMP, 1));
+    EXPECT_DOUBLE_EQ(0, input.axis(MOVEMENT_AXIS_X));
+}
+
+// positions of the players after running a generated stage headless
+static std::vector<Pair> runHeadless(size_t workers) {
+    StageGeneratorConfig stage;
+    stage.size = Pair(10, 5);
+    std::vector<Platform> platforms;
+    std::vector<Ledge> ledges;
+    generateStage(stage, platforms, ledges);
+    Map m = Map(platforms, ledges);
+    PlayerConfig config("assets/attributes.yaml");
+
+    SimScene scene(m, config, 8, 3, workers);
+    Game game(scene);
+    game.fixedTickrate = 1.0 / 60.0;
+    EXPECT_GT(game.runHeadless(120), 0);
+
+    std::vector<Pair> positions;
+    for (Player const* p : scene.getPlayers()) {
+        EXPECT_FALSE(std::isnan((double)p->position.x));
+        EXPECT_FALSE(std::isnan((double)p->position.y));
+        positions.push_back(p->position);
+    }
+    return positions;
+}
+
+TEST(SimScene, runsHeadlessTheSameOnAnyWorkers) {
+    std::vector<Pair> serial = runHeadless(1);
+    std::vector<Pair> parallel = runHeadless(4);
+    ASSERT_EQ(8, serial.size());
+    for (size_t i = 0; i < serial.size(); i++) {
+        EXPECT_EQ(serial[i], parallel[i]);
+    }
+}
@@ -0,0 +1,20 @@
+#include <random>
+#include "./random-platforms.hpp"
+
+std::vector<Platform> makeRandomPlatforms(unsigned int seed, size_t count) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> position(-20, 20);
+    std::uniform_real_distribution<double> step(-1.5, 1.5);
+
+    std::vector<Platform> platforms;
+    for (size_t i = 0; i < count; i++) {
+        Pair p = Pair(position(rng), position(rng));
+        std::vector<Pair> points = {p};
+        for (size_t j = 0; j < 1 + rng() % 6; j++) {
+            p = p + Pair(step(rng), step(rng));
+            points.push_back(p);
+        }
+        platforms.push_back(Platform(points, rng() % 4 == 0));
+    }
+    return platforms;
+}
@@ -0,0 +1,11 @@
+#ifndef __TEST_RANDOM_PLATFORMS
+#define __TEST_RANDOM_PLATFORMS
+
+#include <vector>
+#include "terrain/platform.hpp"
+
+// count short platforms scattered around the origin, a quarter of them
+// passable
+std::vector<Platform> makeRandomPlatforms(unsigned int seed, size_t count);
+
+#endif
@@ -0,0 +1,18 @@
+#ifndef __TEST_TOLERANCE
+#define __TEST_TOLERANCE
+
+#include <limits>
+#include "engine/pair.hpp"
+
+// how far a real worked out from coordinates around magnitude in size may
+// stray from the same value worked out in double precision
+inline double tolerance(double magnitude) {
+#ifdef SIM_FIXED
+    double epsilon = 1.0 / 4294967296.0;
+#else
+    double epsilon = std::numeric_limits<real>::epsilon();
+#endif
+    return 16 * epsilon * magnitude;
+}
+
+#endif
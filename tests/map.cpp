@@ -1,10 +1,15 @@
 #include <math.h>
+#include <random>
 #include "gtest/gtest.h"
 #include "engine/pair.hpp"
 #include "terrain/platform.hpp"
 #include "terrain/map.hpp"
 #include "lib/mock-player.hpp"
+#include "lib/random-platforms.hpp"
+#include "lib/tolerance.hpp"
 #include "util.hpp"
+#include "engine/util.hpp"
+#include "constants.hpp"
 
 // void Map::getClosestCollision(
 //             Pair const& start,
@@ -122,8 +127,10 @@ TEST(Map, movePlayer_Grounded_Flat_Into_Wall) {
     Pair requestedMotion = Pair(10, 0);
     m.movePlayer(p, requestedMotion);
 
-    EXPECT_NEAR(p.currentCollision->postCollision.right.x, 15, 0.000001);
-    EXPECT_NEAR(p.currentCollision->postCollision.bottom.y, 10, 0.000001);
+    EXPECT_NEAR((double)p.currentCollision->postCollision.right.x, 15,
+                0.000001);
+    EXPECT_NEAR((double)p.currentCollision->postCollision.bottom.y, 10,
+                0.000001);
 }
 
 TEST(Map, movePlayer_Grounded_Slant_Down_Left_Into_Wall) {
@@ -144,7 +151,8 @@ TEST(Map, movePlayer_Grounded_Slant_Down_Left_Into_Wall) {
 
     PlatformSegment segment = m.getPlatform(0)->getSegment(0);
 
-    EXPECT_NEAR(15, p.currentCollision->postCollision.right.x, 0.000001);
+    EXPECT_NEAR(15, (double)p.currentCollision->postCollision.right.x,
+                0.000001);
     EXPECT_TRUE(onLine(*segment.firstPoint(), *segment.secondPoint(),
                        p.currentCollision->postCollision.bottom));
 }
@@ -167,7 +175,8 @@ TEST(Map, movePlayer_Grounded_Slant_Down_Right_Into_Wall) {
 
     PlatformSegment segment = m.getPlatform(0)->getSegment(0);
 
-    EXPECT_NEAR(15, p.currentCollision->postCollision.right.x, 0.000001);
+    EXPECT_NEAR(15, (double)p.currentCollision->postCollision.right.x,
+                0.000001);
     EXPECT_TRUE(onLine(*segment.firstPoint(), *segment.secondPoint(),
                        p.currentCollision->postCollision.bottom));
 }
@@ -185,9 +194,39 @@ TEST(Map, movePlayer_Airborne_Flat_Into_Wall) {
     Pair requestedMotion = Pair(10, 0);
     m.movePlayer(p, requestedMotion);
 
-    EXPECT_NEAR(15, p.currentCollision->postCollision.right.x, 0.000001);
-    EXPECT_NEAR(p.currentCollision->playerModified.origin.y,
-                p.currentCollision->postCollision.origin.y, 0.000001);
+    EXPECT_NEAR(15, (double)p.currentCollision->postCollision.right.x,
+                0.000001);
+    EXPECT_NEAR((double)p.currentCollision->playerModified.origin.y,
+                (double)p.currentCollision->postCollision.origin.y, 0.000001);
+}
+
+TEST(Map, movePlayer_Stats) {
+    Player p = makeMockPlayer(Pair(10, 10));
+    p.init();
+    Map m = Map(
+        {
+            Platform({Pair(15, 20), Pair(15, -20)}),
+        },
+        {});
+
+    MovementScratch scratch;
+    Pair requestedMotion = Pair(10, 0);
+    m.movePlayer(p, requestedMotion, scratch);
+
+    EXPECT_NEAR(15, (double)p.currentCollision->postCollision.right.x,
+                0.000001);
+
+    // the wall interrupts the first walk, which nests a second one
+    MovementStats const& stats = scratch.stats;
+    EXPECT_GE(stats.iterations, 2);
+    EXPECT_EQ(stats.maxDepth, 2);
+    EXPECT_GE(stats.probes, 8 * stats.iterations);
+    EXPECT_GT(stats.segmentTests, 0);
+    EXPECT_FALSE(stats.panicked);
+    EXPECT_FALSE(stats.budgetExhausted);
+
+    // the map's own scratch was not used
+    EXPECT_EQ(m.getLastMovementStats().iterations, 0);
 }
 
 TEST(Map, movePlayer_Airborne_Slanted_Up_Into_Wall) {
@@ -203,9 +242,10 @@ TEST(Map, movePlayer_Airborne_Slanted_Up_Into_Wall) {
     Pair requestedMotion = Pair(10, -5);
     m.movePlayer(p, requestedMotion);
 
-    EXPECT_NEAR(p.currentCollision->postCollision.right.x, 11, 0.000001);
+    EXPECT_NEAR((double)p.currentCollision->postCollision.right.x, 11,
+                0.000001);
 
-    EXPECT_NEAR(p.position.y, 5, 0.000001);
+    EXPECT_NEAR((double)p.position.y, 5, 0.000001);
 }
 
 TEST(Map, movePlayer_Airborne_Slanted_Down_Into_Wall) {
@@ -221,9 +261,10 @@ TEST(Map, movePlayer_Airborne_Slanted_Down_Into_Wall) {
     Pair requestedMotion = Pair(10, 5);
     m.movePlayer(p, requestedMotion);
 
-    EXPECT_NEAR(p.currentCollision->postCollision.right.x, 11, 0.000001);
+    EXPECT_NEAR((double)p.currentCollision->postCollision.right.x, 11,
+                0.000001);
 
-    EXPECT_NEAR(p.position.y, 15, 0.000001);
+    EXPECT_NEAR((double)p.position.y, 15, 0.000001);
 }
 
 TEST(Map, DISABLED_movePlayer_Airborne_Slanted_Up_Into_Wall_Slip_Off) {
@@ -325,6 +366,8 @@ TEST(Map, movePlayer_Airborne_Flat_Into_Corner_BottomLeft) {
     EXPECT_EQ(p.currentCollision->postCollision.top, Pair(10.9, -1));
 }
 
+// checks exact positions worked out in double precision
+#ifndef SIM_FLOAT
 TEST(Map, movePlayer_Airborne_Diagonal_Down_Corner_TopRight) {
     /*
         ╱╲ ─────
@@ -378,7 +421,10 @@ TEST(Map, movePlayer_Airborne_Diagonal_Down_Corner_TopRight) {
     EXPECT_EQ(p.currentCollision->postCollision.right, Pair(10.1, 0.1));
     EXPECT_EQ(p.currentCollision->postCollision.top, Pair(9.1, -0.9));
 }
+#endif
 
+// checks exact positions worked out in double precision
+#ifndef SIM_FLOAT
 TEST(Map, movePlayer_Airborne_Diagonal_Up_Corner_BottomRight) {
     // setup scene
     Player p = makeMockPlayer(Pair(10, 0));
@@ -424,6 +470,7 @@ TEST(Map, movePlayer_Airborne_Diagonal_Up_Corner_BottomRight) {
     EXPECT_EQ(p.currentCollision->postCollision.right, Pair(10.1, -0.1));
     EXPECT_EQ(p.currentCollision->postCollision.top, Pair(9.1, -1.1));
 }
+#endif
 
 TEST(Map, movePlayer_Airborne_DownY_BottomRight) {
     // setup scene
@@ -595,11 +642,13 @@ TEST(Map, movePlayer_Interrupt_Collision_Motion) {
     Pair requestedMotion = Pair(4, 6);
     m.movePlayer(p, requestedMotion);
 
-    EXPECT_NEAR(p.currentCollision->postCollision.origin.x, 4, 0.0001);
-    EXPECT_NEAR(p.currentCollision->postCollision.right.x, 5, 0.0001);
-    EXPECT_NEAR(p.currentCollision->postCollision.bottom.y, 5, 0.0001);
+    EXPECT_NEAR((double)p.currentCollision->postCollision.origin.x, 4, 0.0001);
+    EXPECT_NEAR((double)p.currentCollision->postCollision.right.x, 5, 0.0001);
+    EXPECT_NEAR((double)p.currentCollision->postCollision.bottom.y, 5, 0.0001);
 }
 
+// checks exact positions worked out in double precision
+#ifndef SIM_FLOAT
 TEST(Map, movePlayer_Playtest_3) {
     /*
         Sliding an ecb from a falling position against the corner into
@@ -630,8 +679,10 @@ TEST(Map, movePlayer_Playtest_3) {
     m.movePlayer(p, requestedMotion);
 
     EXPECT_EQ(p.currentCollision->postCollision.origin.x, 2.04);
-    EXPECT_NEAR(p.currentCollision->postCollision.origin.y, 0.510417, 0.00001);
+    EXPECT_NEAR((double)p.currentCollision->postCollision.origin.y, 0.510417,
+                0.00001);
 }
+#endif
 
 TEST(Map, movePlayer_Teleport_Playtest_4) {
     /*
@@ -666,8 +717,9 @@ TEST(Map, movePlayer_Teleport_Playtest_4) {
     Pair requestedMotion = Pair(0.0101667, 0);
     m.movePlayer(p, requestedMotion);
 
-    EXPECT_NEAR(p.currentCollision->postCollision.origin.x, 0.8110937, 0.00001);
-    EXPECT_NEAR(p.currentCollision->postCollision.origin.y, 1, 0.00001);
+    EXPECT_NEAR((double)p.currentCollision->postCollision.origin.x, 0.8110937,
+                0.00001);
+    EXPECT_NEAR((double)p.currentCollision->postCollision.origin.y, 1, 0.00001);
 }
 
 TEST(Map, pointsIterator) {
@@ -692,11 +744,11 @@ TEST(Map, pointsIterator) {
         {});
 
     // remove all points
-    for (PlatformPoint p : m.getPoints()) {
-        auto position = pts_set.find(p.point());
+    for (MapPoint const& p : m.getPoints()) {
+        auto position = pts_set.find(p.position);
         if (position == pts_set.end()) {
             ASSERT_NE(position, pts_set.end())
-                << "pair " << p.point() << " not found in set!" << std::endl;
+                << "pair " << p.position << " not found in set!" << std::endl;
             continue;
         }
         pts_set.erase(position);
@@ -710,3 +762,638 @@ TEST(Map, pointsIterator) {
         }
     }
 }
+
+TEST(Map, getClosestCollision_BroadphaseMatchesBruteForce) {
+    Map m = Map(makeRandomPlatforms(42, 200), {});
+    m.validateBroadphase = true;
+
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<double> position(-22, 22);
+    std::uniform_real_distribution<double> step(-4, 4);
+    TerrainCollisionType types[] = {NO_COLLISION, FLOOR_COLLISION,
+                                    WALL_COLLISION, CEIL_COLLISION};
+
+    size_t hits = 0;
+    for (size_t i = 0; i < 2000; i++) {
+        Pair start = Pair(position(rng), position(rng));
+        Pair end = start + Pair(step(rng), step(rng));
+        TerrainCollisionType type = types[i % 4];
+
+        PlatformSegment ignored;
+        CollisionDatum fast, slow;
+        bool fastHit = m.getClosestCollision(start, end, fast, ignored, type);
+        bool slowHit =
+            m.getClosestCollisionBruteForce(start, end, slow, ignored, type);
+
+        ASSERT_EQ(slowHit, fastHit) << start << ".." << end;
+        if (slowHit) {
+            hits++;
+            EXPECT_EQ(slow.segmentId, fast.segmentId);
+            EXPECT_EQ(slow.segment, fast.segment);
+            EXPECT_EQ(slow.position, fast.position);
+        }
+    }
+
+    EXPECT_GT(hits, 0);
+    EXPECT_EQ(m.getBroadphaseMismatches(), 0);
+}
+
+TEST(Map, getClosestEdgeCollision_IndexMatchesBruteForce) {
+    Map m = Map(makeRandomPlatforms(43, 200), {});
+    m.validateBroadphase = true;
+
+    std::mt19937 rng(8);
+    std::uniform_real_distribution<double> position(-22, 22);
+    std::uniform_real_distribution<double> size(0.1, 1.5);
+    std::uniform_real_distribution<double> step(-4, 4);
+
+    size_t hits = 0;
+    for (size_t i = 0; i < 2000; i++) {
+        // a diagonal ecb edge, swept by a random motion
+        Pair a1 = Pair(position(rng), position(rng));
+        Pair a2 = a1 + Pair(size(rng), -size(rng));
+        if (i % 2)
+            std::swap(a1, a2);
+        Pair motion = Pair(step(rng), step(rng));
+        Pair b1 = a1 + motion, b2 = a2 + motion;
+
+        EdgeCollision fast, slow;
+        bool fastHit = m.getClosestEdgeCollision(a1, a2, b1, b2, fast, NULL);
+        bool slowHit =
+            m.getClosestEdgeCollisionBruteForce(a1, a2, b1, b2, slow, NULL);
+
+        ASSERT_EQ(slowHit, fastHit) << a1 << ".." << a2 << " + " << motion;
+        if (slowHit) {
+            hits++;
+            EXPECT_EQ(slow.cornerPosition, fast.cornerPosition);
+            EXPECT_EQ(slow.s1Id, fast.s1Id);
+            EXPECT_EQ(slow.s2Id, fast.s2Id);
+            EXPECT_EQ(slow.collisionLine1, fast.collisionLine1);
+        }
+    }
+
+    EXPECT_GT(hits, 0);
+    EXPECT_EQ(m.getBroadphaseMismatches(), 0);
+    EXPECT_GT(m.getCollisionStats().edgeQueries, 0);
+    EXPECT_LT(m.getCollisionStats().cornerTests,
+              m.getCollisionStats().edgeQueries * m.getCornerIndex().size());
+}
+
+TEST(Map, getClosestEdgeCollision_Nearest) {
+    // two wedges in the path of the edge, the farther one first in the map
+    Map m = Map(
+        {
+            Platform({Pair(6, 0), Pair(5, 0.5), Pair(6, 1)}, false),
+            Platform({Pair(4, 0), Pair(3, 0.5), Pair(4, 1)}, false),
+        },
+        {});
+
+    Pair a1 = Pair(1, 0), a2 = Pair(0, 1);
+    Pair b1 = Pair(11, 0), b2 = Pair(10, 1);
+
+    EdgeCollision collision;
+    ASSERT_TRUE(m.getClosestEdgeCollision(a1, a2, b1, b2, collision, NULL));
+    EXPECT_EQ(collision.cornerPosition, Pair(3, 0.5));
+    EXPECT_EQ(collision.s1.getPlatform(), m.getPlatform(1));
+}
+
+TEST(Map, gatherCandidates_MatchesQueries) {
+    Map m = Map(makeRandomPlatforms(44, 200), {});
+
+    std::mt19937 rng(9);
+    std::uniform_real_distribution<double> position(-22, 22);
+    std::uniform_real_distribution<double> size(0.2, 2);
+    std::uniform_real_distribution<double> step(-4, 4);
+    TerrainCollisionType types[] = {NO_COLLISION, FLOOR_COLLISION,
+                                    WALL_COLLISION, CEIL_COLLISION};
+
+    MovementScratch scratch;
+    for (size_t i = 0; i < 500; i++) {
+        Ecb current = Ecb(Pair(position(rng), position(rng)), size(rng),
+                          size(rng));
+        Ecb projected = current;
+        projected.setOrigin(current.origin + Pair(step(rng), step(rng)));
+        m.gatherCandidates(current, projected, scratch);
+
+        Pair const* sides[][2] = {
+            {&current.left, &projected.left},
+            {&current.right, &projected.right},
+            {&current.top, &projected.top},
+            {&current.bottom, &projected.bottom},
+        };
+        for (auto side : sides) {
+            for (TerrainCollisionType type : types) {
+                PlatformSegment ignored;
+                CollisionDatum shared, queried;
+                bool sharedHit = m.getClosestCollision(
+                    *side[0], *side[1], shared, ignored, type, scratch);
+                bool queriedHit = m.getClosestCollision(
+                    *side[0], *side[1], queried, ignored, type);
+                ASSERT_EQ(queriedHit, sharedHit);
+                if (queriedHit) {
+                    EXPECT_EQ(queried.segmentId, shared.segmentId);
+                    EXPECT_EQ(queried.position, shared.position);
+                }
+            }
+        }
+
+        EdgeCollision shared, queried;
+        bool sharedHit =
+            m.getClosestEdgeCollision(current.top, current.right,
+                                      projected.top, projected.right, shared,
+                                      NULL, scratch);
+        bool queriedHit = m.getClosestEdgeCollision(
+            current.top, current.right, projected.top, projected.right,
+            queried, NULL);
+        ASSERT_EQ(queriedHit, sharedHit);
+        if (queriedHit) {
+            EXPECT_EQ(queried.cornerPosition, shared.cornerPosition);
+        }
+    }
+
+    EXPECT_EQ(scratch.collisionStats.candidatePasses, 500);
+}
+
+TEST(Map, getClosestCollision_QueryCache) {
+    Map m = Map(
+        {
+            Platform({Pair(0, 0), Pair(4, 0), Pair(4, -2), Pair(0, -2),
+                      Pair(0, 0)}),
+        },
+        {});
+
+    MovementScratch scratch;
+    Ecb current = Ecb(Pair(2, -1), 0.5, 0.5);
+    Ecb projected = current;
+    projected.setOrigin(Pair(5, -1));
+    m.gatherCandidates(current, projected, scratch);
+
+    PlatformSegment ignored;
+    CollisionDatum first, second;
+    ASSERT_TRUE(m.getClosestCollision(Pair(2, -1), Pair(5, -1), first, ignored,
+                                      WALL_COLLISION, scratch));
+    ASSERT_TRUE(m.getClosestCollision(Pair(2, -1), Pair(5, -1), second,
+                                      ignored, WALL_COLLISION, scratch));
+    EXPECT_EQ(first.segmentId, second.segmentId);
+    EXPECT_EQ(first.position, second.position);
+    EXPECT_EQ(1, scratch.collisionStats.cacheMisses);
+    EXPECT_EQ(1, scratch.collisionStats.cacheHits);
+    EXPECT_EQ(1, scratch.collisionStats.queries[WALL_COLLISION]);
+
+    // misses are remembered too, and keyed on the collision type
+    CollisionDatum miss;
+    EXPECT_FALSE(m.getClosestCollision(Pair(2, -1), Pair(5, -1), miss,
+                                       ignored, CEIL_COLLISION, scratch));
+    EXPECT_FALSE(m.getClosestCollision(Pair(2, -1), Pair(5, -1), miss,
+                                       ignored, CEIL_COLLISION, scratch));
+    EXPECT_EQ(2, scratch.collisionStats.cacheHits);
+
+    // a new frame forgets everything
+    m.startFrame();
+    ASSERT_TRUE(m.getClosestCollision(Pair(2, -1), Pair(5, -1), second,
+                                      ignored, WALL_COLLISION, scratch));
+    EXPECT_EQ(3, scratch.collisionStats.cacheMisses);
+    EXPECT_EQ(2, scratch.collisionStats.queries[WALL_COLLISION]);
+}
+
+TEST(Map, movePlayer_QueryCacheMatchesUncached) {
+    Map cached = Map(makeRandomPlatforms(46, 200), {});
+    Map uncached = Map(makeRandomPlatforms(46, 200), {});
+    uncached.cacheQueries = false;
+
+    std::mt19937 rng(12);
+    std::uniform_real_distribution<double> position(-20, 20);
+    std::uniform_real_distribution<double> velocity(-0.8, 0.8);
+    for (size_t i = 0; i < 32; i++) {
+        Pair start = Pair(position(rng), position(rng));
+        Player a = makeMockPlayer(start);
+        Player b = makeMockPlayer(start);
+        for (size_t frame = 0; frame < 30; frame++) {
+            Pair motion = Pair(velocity(rng), velocity(rng) + 0.2);
+            a.update();
+            b.update();
+            Pair motionA = motion, motionB = motion;
+            if (a.isGrounded())
+                motionA.y = 0;
+            if (b.isGrounded())
+                motionB.y = 0;
+            cached.movePlayer(a, motionA);
+            uncached.movePlayer(b, motionB);
+            ASSERT_EQ(b.position.x, a.position.x);
+            ASSERT_EQ(b.position.y, a.position.y);
+        }
+    }
+
+    EXPECT_GT(cached.getCollisionStats().cacheMisses, 0);
+    EXPECT_EQ(0, uncached.getCollisionStats().cacheMisses);
+}
+
+TEST(Map, movePlayers_MatchesMovePlayer) {
+    Map m = Map(makeRandomPlatforms(45, 200), {});
+
+    std::mt19937 rng(11);
+    std::uniform_real_distribution<double> position(-20, 20);
+    std::uniform_real_distribution<double> velocity(-0.8, 0.8);
+
+    const size_t numPlayers = 64;
+    const size_t numFrames = 30;
+    std::vector<Pair> starts;
+    std::vector<std::vector<Pair>> motions(numFrames);
+    for (size_t i = 0; i < numPlayers; i++) {
+        starts.push_back(Pair(position(rng), position(rng)));
+    }
+    for (std::vector<Pair>& frame : motions) {
+        for (size_t i = 0; i < numPlayers; i++) {
+            frame.push_back(Pair(velocity(rng), velocity(rng) + 0.2));
+        }
+    }
+
+    // reference run, one player at a time
+    std::vector<Player> expected;
+    for (Pair const& start : starts) {
+        expected.push_back(makeMockPlayer(start));
+    }
+    for (std::vector<Pair> const& frame : motions) {
+        for (size_t i = 0; i < numPlayers; i++) {
+            Pair motion = frame[i];
+            expected[i].update();
+            if (expected[i].isGrounded())
+                motion.y = 0;
+            m.movePlayer(expected[i], motion);
+        }
+    }
+
+    size_t sizes[] = {1, 2, 4, 8};
+    for (size_t size : sizes) {
+        WorkerPool pool(size);
+        std::vector<Player> players;
+        for (Pair const& start : starts) {
+            players.push_back(makeMockPlayer(start));
+        }
+        std::vector<Player*> playerPtrs;
+        for (Player& p : players) {
+            playerPtrs.push_back(&p);
+        }
+
+        for (std::vector<Pair> const& frame : motions) {
+            std::vector<Pair> distances = frame;
+            for (size_t i = 0; i < numPlayers; i++) {
+                players[i].update();
+                if (players[i].isGrounded())
+                    distances[i].y = 0;
+            }
+            m.movePlayers(playerPtrs.data(), distances.data(), numPlayers,
+                          pool);
+        }
+
+        for (size_t i = 0; i < numPlayers; i++) {
+            EXPECT_EQ(expected[i].position, players[i].position)
+                << "player " << i << " with " << size << " workers";
+            EXPECT_EQ(expected[i].getActionState(),
+                      players[i].getActionState());
+        }
+    }
+}
+
+TEST(SpatialGrid, query) {
+    std::vector<Bounds> bounds = {
+        Bounds(Pair(0, 0), Pair(1, 1)), Bounds(Pair(5, 5), Pair(6, 6)),
+        Bounds(Pair(0, 9), Pair(9, 9)), Bounds(Pair(2, 2), Pair(2.5, 2.5)),
+    };
+    SpatialGrid grid;
+    grid.build(bounds);
+
+    std::vector<size_t> out;
+    grid.query(Bounds(Pair(0.5, 0.5), Pair(0.6, 0.6)), out);
+    EXPECT_NE(std::find(out.begin(), out.end(), 0), out.end());
+
+    grid.query(Bounds(Pair(-1, -1), Pair(10, 10)), out);
+    EXPECT_EQ(out, std::vector<size_t>({0, 1, 2, 3}));
+
+    grid.query(Bounds(Pair(20, 20), Pair(21, 21)), out);
+    EXPECT_TRUE(out.empty());
+}
+
+TEST(LedgeIndex, findNearest) {
+    std::mt19937 rng(13);
+    std::uniform_real_distribution<double> position(-5, 5);
+    std::vector<Ledge> ledges;
+    for (size_t i = 0; i < 400; i++) {
+        ledges.push_back(Ledge(Pair(position(rng), position(rng)),
+                               rng() % 2 ? FACING_LEFT : FACING_RIGHT));
+    }
+    LedgeIndex index;
+    index.build(ledges);
+
+    std::vector<size_t> scratch;
+    std::uniform_real_distribution<double> near(-0.25, 0.25);
+    size_t found = 0;
+    for (size_t i = 0; i < 2000; i++) {
+        // look around existing ledges so that some are in reach
+        Pair box = ledges[rng() % ledges.size()].position +
+                   Pair(near(rng), near(rng));
+        double face = rng() % 2 ? -1 : 1;
+
+        int expected = -1;
+        wideReal expectedDistance = DOUBLE_INFINITY;
+        for (size_t id = 0; id < ledges.size(); id++) {
+            Pair diff = ledges[id].position - box;
+            if (sign(diff.x) == sign(face) && face != ledges[id].facing &&
+                abs(diff.x) < LEDGEBOX_WIDTH &&
+                diff.y > -LEDGEBOX_HEIGHT && diff.y < 0 &&
+                diff.euclidSquared() < expectedDistance) {
+                expected = id;
+                expectedDistance = diff.euclidSquared();
+            }
+        }
+
+        ASSERT_EQ(expected, index.findNearest(ledges, box, face, scratch));
+        found += expected >= 0;
+    }
+    EXPECT_GT(found, 0);
+}
+
+TEST(LedgeIndex, findNearest_PrefersNearest) {
+    // both ledges are in reach of a right facing player, the second one
+    // is closer
+    std::vector<Ledge> ledges = {
+        Ledge(Pair(0.15, -0.1), FACING_LEFT),
+        Ledge(Pair(0.05, -0.05), FACING_LEFT),
+        Ledge(Pair(0.01, -0.01), FACING_RIGHT),
+    };
+    LedgeIndex index;
+    index.build(ledges);
+
+    std::vector<size_t> scratch;
+    EXPECT_EQ(1, index.findNearest(ledges, Pair(0, 0), 1, scratch));
+    EXPECT_EQ(-1, index.findNearest(ledges, Pair(0, 0), -1, scratch));
+}
+
+TEST(Map, segmentBuckets) {
+    Map m = Map(
+        {
+            // floor, wall, ceiling, wall
+            Platform({Pair(0, 0), Pair(4, 0), Pair(4, -2), Pair(0, -2),
+                      Pair(0, 0)}),
+            Platform({Pair(1, -1), Pair(2, -1)}, true),
+        },
+        {});
+
+    EXPECT_EQ(5, m.getSegmentBucket(NO_COLLISION).size());
+    EXPECT_EQ(std::vector<size_t>({0, 4}),
+              m.getSegmentBucket(FLOOR_COLLISION).getIds());
+    EXPECT_EQ(std::vector<size_t>({1, 3}),
+              m.getSegmentBucket(WALL_COLLISION).getIds());
+    EXPECT_EQ(std::vector<size_t>({2}),
+              m.getSegmentBucket(CEIL_COLLISION).getIds());
+    EXPECT_EQ(std::vector<size_t>({4}), m.getPassableSegments().getIds());
+}
+
+TEST(Map, collisionStats) {
+    Map m = Map(
+        {
+            Platform({Pair(0, 0), Pair(4, 0), Pair(4, -2), Pair(0, -2),
+                      Pair(0, 0)}),
+        },
+        {});
+
+    PlatformSegment ignored;
+    CollisionDatum collision;
+    ASSERT_TRUE(m.getClosestCollision(Pair(2, -1), Pair(2, 1), collision,
+                                      ignored, FLOOR_COLLISION));
+    ASSERT_TRUE(m.getClosestCollision(Pair(2, -1), Pair(5, -1), collision,
+                                      ignored, WALL_COLLISION));
+
+    CollisionStats const& stats = m.getCollisionStats();
+    EXPECT_EQ(1, stats.queries[FLOOR_COLLISION]);
+    EXPECT_EQ(1, stats.queries[WALL_COLLISION]);
+    EXPECT_EQ(0, stats.queries[CEIL_COLLISION]);
+    EXPECT_LE(stats.segmentTests[FLOOR_COLLISION], 1);
+    EXPECT_LE(stats.segmentTests[WALL_COLLISION], 2);
+
+    m.startFrame();
+    EXPECT_EQ(0, m.getCollisionStats().totalSegmentTests());
+    EXPECT_EQ(1, m.getLastFrameCollisionStats().queries[WALL_COLLISION]);
+}
+
+// the same platform, built at its current position and not kinematic
+static Platform staticCopy(Platform const& platform) {
+    std::vector<Pair> points;
+    for (PlatformPoint p : platform.points_iter()) {
+        points.push_back(p.point());
+    }
+    return Platform(points, platform.isPassable());
+}
+
+TEST(Map, movePlatform_MatchesRebuiltMap) {
+    std::vector<Platform> platforms = makeRandomPlatforms(51, 200);
+    std::mt19937 rng(15);
+    std::uniform_real_distribution<double> speed(-0.3, 0.3);
+    std::uniform_real_distribution<double> spin(-0.1, 0.1);
+    for (size_t i = 0; i < platforms.size(); i += 10) {
+        PlatformMotion motion;
+        motion.velocity = Pair(speed(rng), speed(rng));
+        motion.angularVelocity = i % 20 ? spin(rng) : 0;
+        motion.pivot = *platforms[i].getSegment(0).firstPoint();
+        platforms[i].setMotion(motion);
+    }
+    Map m = Map(platforms, {});
+    m.validateBroadphase = true;
+    EXPECT_EQ(20, m.getKinematicPlatforms().size());
+
+    std::uniform_real_distribution<double> position(-22, 22);
+    std::uniform_real_distribution<double> step(-4, 4);
+    TerrainCollisionType types[] = {NO_COLLISION, FLOOR_COLLISION,
+                                    WALL_COLLISION, CEIL_COLLISION};
+    size_t hits = 0;
+    for (size_t frame = 0; frame < 20; frame++) {
+        m.update();
+
+        std::vector<Platform> moved;
+        for (Platform const& platform : m.getPlatforms()) {
+            moved.push_back(staticCopy(platform));
+        }
+        Map rebuilt = Map(moved, {});
+
+        ASSERT_EQ(rebuilt.getSegments().size(), m.getSegments().size());
+        for (size_t id = 0; id < m.getSegments().size(); id++) {
+            ASSERT_EQ(rebuilt.getSegments()[id].first,
+                      m.getSegments()[id].first);
+            ASSERT_EQ(rebuilt.getSegments()[id].type,
+                      m.getSegments()[id].type);
+        }
+
+        for (size_t i = 0; i < 200; i++) {
+            Pair start = Pair(position(rng), position(rng));
+            Pair end = start + Pair(step(rng), step(rng));
+            TerrainCollisionType type = types[i % 4];
+            PlatformSegment ignored;
+            CollisionDatum a, b;
+            bool hitA = rebuilt.getClosestCollision(start, end, a, ignored,
+                                                    type);
+            bool hitB = m.getClosestCollision(start, end, b, ignored, type);
+            ASSERT_EQ(hitA, hitB) << start << ".." << end;
+            if (hitA) {
+                hits++;
+                EXPECT_EQ(a.segmentId, b.segmentId);
+                EXPECT_EQ(a.position, b.position);
+            }
+
+            Pair a1 = start, a2 = start + Pair(0.5, -0.5);
+            Pair motion = end - start;
+            EdgeCollision edgeA, edgeB;
+            bool edgeHitA = rebuilt.getClosestEdgeCollision(
+                a1, a2, a1 + motion, a2 + motion, edgeA, NULL);
+            bool edgeHitB = m.getClosestEdgeCollision(
+                a1, a2, a1 + motion, a2 + motion, edgeB, NULL);
+            ASSERT_EQ(edgeHitA, edgeHitB);
+            if (edgeHitA) {
+                EXPECT_EQ(edgeA.cornerPosition, edgeB.cornerPosition);
+            }
+        }
+    }
+
+    EXPECT_GT(hits, 0);
+    EXPECT_EQ(0, m.getBroadphaseMismatches());
+}
+
+TEST(Map, movePlatform_RefitsInPlace) {
+    Map m = Map(
+        {
+            Platform({Pair(0, 0), Pair(4, 0)}),
+            Platform({Pair(10, 0), Pair(14, 0)}),
+        },
+        {});
+    // static platforms can't be moved
+    m.movePlatform(1, Pair(0, 1), 0, Pair(0, 0));
+    EXPECT_EQ(Pair(10, 0), m.getSegments()[1].first);
+
+    m.setPlatformMotion(1, PlatformMotion());
+    EXPECT_EQ(std::vector<size_t>({0}),
+              m.getSegmentBucket(NO_COLLISION).getIds());
+    size_t const* staticIds =
+        m.getSegmentBucket(NO_COLLISION).getIds().data();
+
+    // a quarter turn around its middle turns the floor into a wall
+    m.movePlatform(1, Pair(0, 1), M_PI / 2, Pair(12, 0));
+    EXPECT_EQ(staticIds, m.getSegmentBucket(NO_COLLISION).getIds().data());
+    EXPECT_EQ(1, m.getPlatform(1)->getMoves());
+    MapSegment const& moved = m.getSegments()[1];
+    EXPECT_NEAR(12, (double)moved.first.x, tolerance(12));
+    EXPECT_NEAR(-1, (double)moved.first.y, tolerance(12));
+    EXPECT_EQ(WALL_COLLISION, moved.type);
+
+    PlatformSegment ignored;
+    CollisionDatum collision;
+    EXPECT_FALSE(m.getClosestCollision(Pair(13, -1), Pair(13, 1), collision,
+                                       ignored, FLOOR_COLLISION));
+    ASSERT_TRUE(m.getClosestCollision(Pair(13, 1), Pair(11, 1), collision,
+                                      ignored, WALL_COLLISION));
+    EXPECT_EQ(1, collision.segmentId);
+    EXPECT_NEAR(12, (double)collision.position.x, tolerance(12));
+}
+
+TEST(Map, update_CarriesGroundedPlayers) {
+    Map m = Map({Platform({Pair(0, 10), Pair(20, 10)})}, {});
+    PlatformMotion motion;
+    motion.velocity = Pair(0.1, -0.05);
+    m.setPlatformMotion(0, motion);
+
+    Player p = makeMockPlayer(Pair(5, 10));
+    p.init();
+    p.land(m.getPlatform(0));
+    Pair still = Pair(0, 0);
+    m.movePlayer(p, still);
+
+    for (size_t frame = 0; frame < 10; frame++) {
+        m.update();
+        Pair requestedMotion = Pair(0, 0);
+        m.movePlayer(p, requestedMotion);
+    }
+    EXPECT_NEAR(6, (double)p.position.x, tolerance(10));
+    EXPECT_NEAR(9.5, (double)p.position.y, tolerance(10));
+
+    // walking moves the player on top of the platform's motion
+    m.update();
+    Pair requestedMotion = Pair(1, 0);
+    m.movePlayer(p, requestedMotion);
+    EXPECT_NEAR(7.1, (double)p.position.x, tolerance(10));
+    EXPECT_NEAR(9.45, (double)p.position.y, tolerance(10));
+    EXPECT_TRUE(p.isGrounded());
+
+    // turning platforms swing the player around their pivot
+    motion.velocity = Pair(0, 0);
+    motion.angularVelocity = M_PI / 40;
+    motion.pivot = Pair(5.1, 9.45);
+    m.setPlatformMotion(0, motion);
+    for (size_t frame = 0; frame < 5; frame++) {
+        m.update();
+        Pair requestedMotion = Pair(0, 0);
+        m.movePlayer(p, requestedMotion);
+    }
+    // every turn carries the player with its own rounding
+    EXPECT_NEAR(5.1 + 2 * cos(M_PI / 8), (double)p.position.x,
+                tolerance(5 * 10));
+    EXPECT_NEAR(9.45 + 2 * sin(M_PI / 8), (double)p.position.y,
+                tolerance(5 * 10));
+}
+
+TEST(Map, merge_MatchesWholeMap) {
+    std::vector<Platform> platforms = makeRandomPlatforms(53, 200);
+    PlatformMotion motion;
+    motion.velocity = Pair(0.1, 0.05);
+    motion.angularVelocity = 0.02;
+    platforms[150].setMotion(motion);
+    Map first = Map(std::vector<Platform>(platforms.begin(),
+                                          platforms.begin() + 120),
+                    {});
+    Map second = Map(
+        std::vector<Platform>(platforms.begin() + 120, platforms.end()), {});
+    Map merged = Map(std::vector<Map const*>({&first, &second}));
+    Map whole = Map(platforms, {});
+    merged.validateBroadphase = true;
+
+    for (size_t type = 0; type < NUM_COLLISION_TYPES; type++) {
+        Table<size_t> const& ids =
+            merged.getSegmentBucket((TerrainCollisionType)type).getIds();
+        EXPECT_EQ(std::vector<size_t>(ids.begin(), ids.end()),
+                  whole.getSegmentBucket((TerrainCollisionType)type).getIds());
+    }
+    Table<size_t> const& corners = merged.getCornerIndex().getIds();
+    EXPECT_EQ(std::vector<size_t>(corners.begin(), corners.end()),
+              whole.getCornerIndex().getIds());
+    ASSERT_EQ(1, merged.getKinematicPlatforms().size());
+    EXPECT_EQ(150, merged.getKinematicPlatforms()[0].platform);
+
+    std::mt19937 rng(19);
+    std::uniform_real_distribution<double> position(-22, 22);
+    std::uniform_real_distribution<double> step(-4, 4);
+    size_t hits = 0;
+    for (size_t frame = 0; frame < 4; frame++) {
+        merged.update();
+        whole.update();
+        for (size_t i = 0; i < 500; i++) {
+            Pair start = Pair(position(rng), position(rng));
+            Pair end = start + Pair(step(rng), step(rng));
+            QueryHit a, b;
+            bool hit = merged.rayCast(start, end, QUERY_ALL, a);
+            ASSERT_EQ(whole.rayCast(start, end, QUERY_ALL, b), hit);
+            if (hit) {
+                hits++;
+                EXPECT_EQ(b.segmentId, a.segmentId);
+                EXPECT_EQ(b.position, a.position);
+            }
+
+            PlatformSegment ignored;
+            CollisionDatum collision;
+            merged.getClosestCollision(start, end, collision, ignored,
+                                       FLOOR_COLLISION);
+            EdgeCollision edge;
+            merged.getClosestEdgeCollision(start, start + Pair(0.5, -0.5),
+                                           end, end + Pair(0.5, -0.5), edge,
+                                           NULL);
+        }
+    }
+    EXPECT_GT(hits, 0);
+    EXPECT_EQ(0, merged.getBroadphaseMismatches());
+}
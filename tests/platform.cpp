@@ -3,6 +3,10 @@
 #include "engine/pair.hpp"
 #include "terrain/platform.hpp"
 #include "terrain/platformsegment.hpp"
+#include "engine/util.hpp"
+#include "util.hpp"
+#include "lib/tolerance.hpp"
+#include <random>
 
 TEST(Platform, GroundedMovement_NoMovement) {
     // flat surface with no movement
@@ -256,6 +260,27 @@ TEST(Platform, movePointToSegmentSpace) {
         Pair(sqrt(2) / 2, -sqrt(2) / 2));
 }
 
+TEST(Platform, toSegmentSpace) {
+    std::vector<Pair> pts = {Pair(1, 0), Pair(2, 1), Pair(2, 3), Pair(0, 3),
+                             Pair(0, 3)};
+    Platform platform = Platform(pts);
+    Pair others[] = {Pair(0, 0), Pair(2, 0), Pair(-1.5, 4), Pair(3, 3)};
+
+    for (size_t i = 0; i < pts.size() - 1; i++) {
+        wideReal angle = platform.getSegment(i).angle();
+        for (Pair other : others) {
+            Pair expected =
+                Platform::movePointToSegmentSpace(pts[i], angle, other);
+            Pair local = platform.toSegmentSpace(i, other);
+            EXPECT_EQ(expected, local) << "segment " << i << " " << other;
+            EXPECT_EQ(other, platform.fromSegmentSpace(i, local));
+        }
+    }
+
+    // the end of a segment is its length along x
+    EXPECT_EQ(Pair(sqrt(2), 0), platform.toSegmentSpace(0, pts[1]));
+}
+
 /*
 
 TEST(Platform, checkCollision_Basic_Floor) {
@@ -454,3 +479,162 @@ TEST(Platform, segmentsIterator) {
         }
     }
 }
+
+// the linear walk getSegmentIndexByLocation used to do
+static size_t segmentIndexByLocationLinear(std::vector<Pair> const& points,
+                                           Pair position,
+                                           int direction) {
+    size_t i;
+    size_t closestPoint = 0;
+    wideReal closestDist = DOUBLE_INFINITY;
+    for (i = 0; i < points.size() - 1; i++) {
+        int ind = i + (direction >= 0);
+        wideReal distance = (position - points[ind]).euclid();
+        if (distance <= closestDist) {
+            closestDist = distance;
+            closestPoint = ind;
+        }
+        wideReal angle = atan2(points[i + 1].y - points[i].y,
+                               points[i + 1].x - points[i].x);
+        if (!Platform::isWall(angle) && points[i].x <= position.x &&
+            (onLine(points[i], points[i + 1], position) ||
+             position == points[i])) {
+            break;
+        }
+    }
+
+    if (i >= points.size() - 1) {
+        i = closestPoint;
+    }
+    return i;
+}
+
+TEST(Platform, getSegmentIndexByLocation_MatchesLinear) {
+    std::mt19937 rng(3);
+    std::uniform_real_distribution<double> step(-1, 1);
+    std::uniform_real_distribution<double> unit(0, 1);
+
+    for (size_t run = 0; run < 200; run++) {
+        // mostly rightward floors with the odd wall or backtrack
+        std::vector<Pair> points = {Pair(step(rng), step(rng))};
+        for (size_t j = 0; j < 2 + rng() % 40; j++) {
+            Pair d = Pair(unit(rng) * 1.5 - 0.3, step(rng) * 0.6);
+            // repeat some points to get zero length segments and ties
+            if (rng() % 10 == 0) {
+                d = Pair(0, 0);
+            }
+            points.push_back(points.back() + d);
+        }
+        Platform platform = Platform(points);
+
+        for (size_t k = 0; k < 100; k++) {
+            size_t s = rng() % (points.size() - 1);
+            Pair position;
+            switch (k % 4) {
+                case 0:
+                    // on a segment
+                    position = points[s] + (points[s + 1] - points[s]) *
+                                               unit(rng);
+                    break;
+                case 1:
+                    position = points[s];
+                    break;
+                case 2:
+                    // near a segment
+                    position = points[s] + Pair(step(rng), step(rng)) * 1e-4;
+                    break;
+                default:
+                    position = points[s] + Pair(step(rng), step(rng)) * 3;
+            }
+
+            for (int direction : {-1, 0, 1}) {
+                ASSERT_EQ(
+                    segmentIndexByLocationLinear(points, position, direction),
+                    platform.getSegmentIndexByLocation(position, direction))
+                    << "run " << run << " position " << position
+                    << " direction " << direction;
+            }
+        }
+    }
+}
+
+TEST(Platform, transform_MatchesBuiltPlatform) {
+    std::vector<Pair> pts = {Pair(1, 0), Pair(2, 1), Pair(2, 3), Pair(0, 3)};
+    Platform platform = Platform(pts);
+    platform.transform(Pair(0.5, -1), M_PI / 3, Pair(1, 1));
+    EXPECT_EQ(1, platform.getMoves());
+
+    double c = cos(M_PI / 3), s = sin(M_PI / 3);
+    std::vector<Pair> moved;
+    for (Pair p : pts) {
+        Pair r = p - Pair(1, 1);
+        moved.push_back(Pair(1, 1) +
+                        Pair(r.x * c - r.y * s, r.x * s + r.y * c) +
+                        Pair(0.5, -1));
+    }
+    Platform built = Platform(moved);
+    for (size_t i = 0; i < pts.size() - 1; i++) {
+        EXPECT_EQ(*built.getSegment(i).firstPoint(),
+                  *platform.getSegment(i).firstPoint());
+        EXPECT_EQ(built.getSegment(i).angle(), platform.getSegment(i).angle());
+        EXPECT_EQ(built.getSegment(i).normal(),
+                  platform.getSegment(i).normal());
+    }
+
+    // anchored positions follow the platform
+    Pair position = (moved[0] + moved[1]) / 2;
+    PlatformAnchor anchor;
+    platform.anchor(position, anchor);
+    EXPECT_FALSE(platform.carry(anchor, position));
+    platform.transform(Pair(0, 2), 0, Pair(0, 0));
+    ASSERT_TRUE(platform.carry(anchor, position));
+    EXPECT_NEAR((double)((moved[0] + moved[1]).x / 2), (double)position.x,
+                tolerance(4));
+    EXPECT_NEAR((double)((moved[0] + moved[1]).y / 2 + 2), (double)position.y,
+                tolerance(4));
+}
+
+TEST(Platform, transform_UpdatesInPlace) {
+    std::mt19937 rng(5);
+    std::uniform_real_distribution<double> step(-1, 1);
+    std::uniform_real_distribution<double> unit(0, 1);
+
+    for (size_t run = 0; run < 50; run++) {
+        std::vector<Pair> points = {Pair(step(rng), step(rng))};
+        for (size_t j = 0; j < 2 + rng() % 20; j++) {
+            points.push_back(points.back() +
+                             Pair(unit(rng) * 1.5 - 0.3, step(rng) * 0.6));
+        }
+        Platform platform = Platform(points);
+        Pair const* storage = platform.getSegment(0).firstPoint();
+
+        for (size_t k = 0; k < 10; k++) {
+            // slides keep the x order, turns mostly don't
+            wideReal rotation = k % 3 == 2 ? step(rng) : 0;
+            platform.transform(Pair(step(rng), step(rng)), rotation,
+                               points[0]);
+            EXPECT_EQ(storage, platform.getSegment(0).firstPoint());
+
+            std::vector<Pair> moved;
+            for (size_t i = 0; i < points.size() - 1; i++) {
+                moved.push_back(*platform.getSegment(i).firstPoint());
+            }
+            moved.push_back(
+                *platform.getSegment(points.size() - 2).secondPoint());
+            Platform built = Platform(moved);
+            for (size_t q = 0; q < 40; q++) {
+                size_t s = rng() % (moved.size() - 1);
+                Pair position = q % 2 ? moved[s]
+                                      : moved[s] + (moved[s + 1] - moved[s]) *
+                                                       unit(rng);
+                for (int direction : {-1, 0, 1}) {
+                    ASSERT_EQ(
+                        built.getSegmentIndexByLocation(position, direction),
+                        platform.getSegmentIndexByLocation(position,
+                                                           direction))
+                        << "run " << run << " move " << k;
+                }
+            }
+        }
+    }
+}
@@ -1,5 +1,6 @@
 #include "gtest/gtest.h"
 #include "player/player.hpp"
+#include "lib/mock-player.hpp"
 
 // TEST(Player, moveTo) {
 //     Player p = Player("./assets/attributes.yaml", 0, 0);
@@ -12,3 +13,14 @@
 //     EXPECT_EQ(p.currentCollision->root.top - oldEcb.top, Pair(10, 10));
 //     EXPECT_EQ(p.currentCollision->root.bottom - oldEcb.bottom, Pair(10, 10));
 // }
+
+TEST(Player, previousPosition_StartsAtSpawn) {
+    Player p = makeMockPlayer(Pair(3, 4));
+    EXPECT_EQ(Pair(3, 4), p.previousPosition);
+
+    // teleports aren't interpolated from where the player was
+    p.moveTo(Pair(10, 10));
+    EXPECT_EQ(Pair(10, 10), p.previousPosition);
+    p.setPosition(Pair(-2, 1));
+    EXPECT_EQ(Pair(-2, 1), p.previousPosition);
+}
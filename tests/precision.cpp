@@ -0,0 +1,157 @@
+#include <cmath>
+#include <random>
+#include <sstream>
+#include <type_traits>
+#include "gtest/gtest.h"
+#include "terrain/map.hpp"
+#include "stage/stagegenerator.hpp"
+#include "lib/mock-player.hpp"
+
+using namespace Terrain;
+
+#define TRAJECTORY_PLAYERS 8
+#define TRAJECTORY_FRAMES 120
+#define TRAJECTORY_SAMPLES 4
+
+// std's distributions differ between standard libraries, and the reference
+// below has to be reproduced by all of them
+static double uniform(std::mt19937& rng, double min, double max) {
+    return min + (max - min) * (rng() / 4294967296.0);
+}
+
+// where each player is every TRAJECTORY_FRAMES / TRAJECTORY_SAMPLES frames,
+// walking and falling around a generated stage
+static std::vector<Pair> simulateTrajectories() {
+    StageGeneratorConfig config;
+    config.seed = 19;
+    config.size = Pair(8, 4);
+    std::vector<Platform> platforms;
+    std::vector<Ledge> ledges;
+    generateStage(config, platforms, ledges);
+    Map m = Map(platforms, ledges);
+
+    std::mt19937 rng(19);
+    std::vector<Pair> samples;
+    for (size_t i = 0; i < TRAJECTORY_PLAYERS; i++) {
+        Player p = makeMockPlayer(
+            Pair(uniform(rng, -4, 4), uniform(rng, -2, 2)));
+        for (size_t frame = 1; frame <= TRAJECTORY_FRAMES; frame++) {
+            Pair motion =
+                Pair(uniform(rng, -0.08, 0.08), uniform(rng, -0.06, 0.1));
+            if (p.isGrounded())
+                motion.y = 0;
+            m.movePlayer(p, motion);
+            if (frame % (TRAJECTORY_FRAMES / TRAJECTORY_SAMPLES) == 0) {
+                samples.push_back(p.position);
+            }
+        }
+    }
+    return samples;
+}
+
+TEST(Precision, trajectoriesMatchDoublePrecision) {
+    // recorded from a double precision build
+    double reference[TRAJECTORY_PLAYERS * TRAJECTORY_SAMPLES][2] = {
+        {-0.40400691740214834, -1.0709581328183408},
+        {-0.72425138204283035, -0.53751824024276229},
+        {-0.77616834433506132, -0.59250525469249116},
+        {-0.67058911587285053, -0.4837311956119052},
+        {-3.3119002485275257, 1.0434599272906775},
+        {-3.5340918774902805, 1.2701585617661471},
+        {-3.7374351852387169, 1.3324193831533186},
+        {-3.7545038424804789, 1.8279263639077536},
+        {2.0963141951337469, 2.692039089463651},
+        {2.0402955792844315, 2.974607846066355},
+        {2.1895820953324461, 3.6931407971680157},
+        {2.0590954505652213, 4.1258427851274613},
+        {4.0079358577355739, 0.47995978269726058},
+        {3.9800065366911181, 0.4008148599330601},
+        {4.4677610279628022, 0.39269033742061465},
+        {4.2390711249309154, 0.39696207725603544},
+        {-3.9285741078853604, 1.6901134210824966},
+        {-4.2515789734572191, 2.2033875486254693},
+        {-3.8930831951275491, 2.5993438531458395},
+        {-4.0593243714049461, 2.9604412416368739},
+        {-3.0535385562106971, 1.038511725626885},
+        {-2.8206392084434633, 2.0194552471861242},
+        {-2.5745155962648005, 2.3273564719036215},
+        {-2.3125871058644871, 3.0135164545848956},
+        {-3.8280830122903002, -0.040870287604631045},
+        {-3.243253720633307, -0.065240041260824666},
+        {-3.2118381000570988, -0.06276292148807916},
+        {-3.3053606177534074, -0.070137166323399003},
+        {-0.44040694557130328, 0.84245859051123184},
+        {-0.026475861822131186, 1.0877589448790306},
+        {-0.26204698595163722, 0.93446442349035452},
+        {-0.1660525939435101, 1.0115602117610927}
+    };
+    // how far the positions of this build may drift from the reference
+    double tolerance = std::is_same<real, double>::value  ? 1e-9
+                       : std::is_same<real, float>::value ? 1e-4
+                                                          : 1e-6;
+
+    std::vector<Pair> samples = simulateTrajectories();
+    ASSERT_EQ(TRAJECTORY_PLAYERS * TRAJECTORY_SAMPLES, samples.size());
+    double worst = 0;
+    for (size_t i = 0; i < samples.size(); i++) {
+        double drift = std::hypot((double)samples[i].x - reference[i][0],
+                                  (double)samples[i].y - reference[i][1]);
+        worst = std::max(worst, drift);
+        EXPECT_LE(drift, tolerance)
+            << "player " << i / TRAJECTORY_SAMPLES << " at frame "
+            << (i % TRAJECTORY_SAMPLES + 1) *
+                   (TRAJECTORY_FRAMES / TRAJECTORY_SAMPLES);
+    }
+    // reported with --gtest_output, to follow the drift across changes
+    std::ostringstream drift;
+    drift << worst;
+    RecordProperty("worstDrift", drift.str());
+}
+
+#ifdef SIM_FIXED
+TEST(Precision, fixedPointReplaysExactly) {
+    // recorded from a fixed point build, as raw Q32.32 values. Any compiler,
+    // optimization level or cpu has to reproduce them bit for bit
+    int64_t reference[TRAJECTORY_PLAYERS * TRAJECTORY_SAMPLES][2] = {
+        {-1735196498, -4599730154},
+        {-3110636001, -2308623257},
+        {-3333617662, -2544790692},
+        {-2880158305, -2077609665},
+        {-14224503256, 4481626263},
+        {-15178809036, 5455289487},
+        {-16052161895, 5722697677},
+        {-16125471219, 7850883953},
+        {9003600908, 11562219847},
+        {8763002785, 12775843416},
+        {9404183488, 15861918944},
+        {8843747616, 17720359833},
+        {17213953433, 2061411570},
+        {17093997868, 1721486713},
+        {19188887420, 1686592154},
+        {18206671729, 1704939139},
+        {-16873097314, 7258981869},
+        {-18260392648, 9463477460},
+        {-16720665006, 11164096836},
+        {-17434665422, 12714998309},
+        {-13114848236, 4460373899},
+        {-12114553151, 8673494244},
+        {-11057460290, 9995919931},
+        {-9932485989, 12942954616},
+        {-16441491345, -175536549},
+        {-13929668662, -280203844},
+        {-13794739635, -269564698},
+        {-14196415810, -301236841},
+        {-1891533427, 3618332096},
+        {-113712963, 4671889098},
+        {-1125483233, 4013494145},
+        {-713190462, 4344618031}
+    };
+
+    std::vector<Pair> samples = simulateTrajectories();
+    ASSERT_EQ(TRAJECTORY_PLAYERS * TRAJECTORY_SAMPLES, samples.size());
+    for (size_t i = 0; i < samples.size(); i++) {
+        EXPECT_EQ(reference[i][0], samples[i].x.getRaw()) << "sample " << i;
+        EXPECT_EQ(reference[i][1], samples[i].y.getRaw()) << "sample " << i;
+    }
+}
+#endif
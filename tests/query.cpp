@@ -0,0 +1,236 @@
+#include <cmath>
+#include <random>
+#include "gtest/gtest.h"
+#include "terrain/map.hpp"
+#include "engine/workerpool.hpp"
+#include "lib/random-platforms.hpp"
+#include "lib/tolerance.hpp"
+#include "util.hpp"
+
+using namespace Terrain;
+
+static unsigned filterOf(MapSegment const& segment) {
+    switch (segment.type) {
+        case FLOOR_COLLISION:
+            return QUERY_FLOORS;
+        case WALL_COLLISION:
+            return QUERY_WALLS;
+        case CEIL_COLLISION:
+            return QUERY_CEILINGS;
+        default:
+            return 0;
+    }
+}
+
+// closest segment crossing the ray by scanning every segment
+static bool rayCastBruteForce(Map const& m,
+                              Pair const& start,
+                              Pair const& end,
+                              unsigned filter,
+                              QueryHit& out) {
+    out = QueryHit();
+    wideReal closest = DOUBLE_INFINITY;
+    Table<MapSegment> const& segments = m.getSegments();
+    for (size_t id = 0; id < segments.size(); id++) {
+        MapSegment const& s = segments[id];
+        if (!(filterOf(s) & filter) ||
+            (s.passable && !(filter & QUERY_PASSABLE))) {
+            continue;
+        }
+        Pair point;
+        if (checkLineIntersection(start, end, s.first, s.second, point,
+                                  0.000001) == 0) {
+            continue;
+        }
+        wideReal distance = (point - start).euclid();
+        if (distance < closest) {
+            closest = distance;
+            out.hit = true;
+            out.segmentId = id;
+            out.position = point;
+        }
+    }
+    return out.hit;
+}
+
+static std::vector<Ray> makeRandomRays(unsigned int seed, size_t count) {
+    std::mt19937 rng(seed);
+    std::uniform_real_distribution<double> position(-22, 22);
+    std::uniform_real_distribution<double> step(-6, 6);
+    std::vector<Ray> rays;
+    for (size_t i = 0; i < count; i++) {
+        Pair start = Pair(position(rng), position(rng));
+        rays.push_back(Ray(start, start + Pair(step(rng), step(rng))));
+    }
+    return rays;
+}
+
+TEST(MapQuery, rayCast_MatchesBruteForce) {
+    std::vector<Platform> platforms = makeRandomPlatforms(52, 200);
+    for (size_t i = 0; i < platforms.size(); i += 20) {
+        PlatformMotion motion;
+        motion.velocity = Pair(0.2, -0.1);
+        motion.angularVelocity = 0.05;
+        platforms[i].setMotion(motion);
+    }
+    Map m = Map(platforms, {});
+    for (size_t frame = 0; frame < 5; frame++) {
+        m.update();
+    }
+
+    unsigned filters[] = {QUERY_ALL, QUERY_SOLID, QUERY_FLOORS,
+                          QUERY_WALLS | QUERY_CEILINGS,
+                          QUERY_FLOORS | QUERY_PASSABLE};
+    std::vector<Ray> rays = makeRandomRays(16, 2000);
+    size_t hits = 0;
+    for (size_t i = 0; i < rays.size(); i++) {
+        unsigned filter = filters[i % 5];
+        QueryHit fast, slow;
+        bool fastHit = m.rayCast(rays[i].start, rays[i].end, filter, fast);
+        bool slowHit =
+            rayCastBruteForce(m, rays[i].start, rays[i].end, filter, slow);
+        ASSERT_EQ(slowHit, fastHit) << rays[i].start << ".." << rays[i].end;
+        EXPECT_EQ(fastHit, m.overlapsSegment(rays[i].start, rays[i].end,
+                                             filter));
+        if (slowHit) {
+            hits++;
+            EXPECT_EQ(slow.segmentId, fast.segmentId);
+            EXPECT_EQ(slow.position, fast.position);
+            wideReal length = (rays[i].end - rays[i].start).euclid();
+            EXPECT_NEAR(
+                (double)((fast.position - rays[i].start).euclid() / length),
+                (double)fast.fraction, tolerance(28) / (double)length);
+            EXPECT_GE(Dot(fast.normal, rays[i].start - fast.position), 0);
+        }
+    }
+    EXPECT_GT(hits, 0);
+}
+
+TEST(MapQuery, rayCasts_MatchesRayCast) {
+    Map m = Map(makeRandomPlatforms(53, 200), {});
+    std::vector<Ray> rays = makeRandomRays(17, 1000);
+    std::vector<QueryHit> expected(rays.size());
+    for (size_t i = 0; i < rays.size(); i++) {
+        m.rayCast(rays[i].start, rays[i].end, QUERY_SOLID, expected[i]);
+    }
+
+    std::vector<QueryHit> batched(rays.size()), pooled(rays.size());
+    m.rayCasts(rays.data(), rays.size(), QUERY_SOLID, batched.data());
+    WorkerPool pool(4);
+    m.rayCasts(rays.data(), rays.size(), QUERY_SOLID, pooled.data(), pool);
+    for (size_t i = 0; i < rays.size(); i++) {
+        ASSERT_EQ(expected[i].hit, batched[i].hit);
+        ASSERT_EQ(expected[i].hit, pooled[i].hit);
+        if (expected[i].hit) {
+            EXPECT_EQ(expected[i].segmentId, batched[i].segmentId);
+            EXPECT_EQ(expected[i].segmentId, pooled[i].segmentId);
+            EXPECT_EQ(expected[i].position, pooled[i].position);
+        }
+    }
+}
+
+TEST(MapQuery, isPointInSolid) {
+    Map m = Map(
+        {
+            // a solid block, a passable one and an open floor
+            Platform({Pair(0, 0), Pair(4, 0), Pair(4, 2), Pair(0, 2),
+                      Pair(0, 0)}),
+            Platform({Pair(6, 0), Pair(8, 0), Pair(8, 2), Pair(6, 2),
+                      Pair(6, 0)},
+                     true),
+            Platform({Pair(10, 1), Pair(14, 1), Pair(14, 0)}),
+        },
+        {});
+
+    EXPECT_TRUE(m.isPointInSolid(Pair(1, 1)));
+    EXPECT_TRUE(m.isPointInSolid(Pair(3.5, 0.5), QUERY_ALL));
+    EXPECT_FALSE(m.isPointInSolid(Pair(5, 1)));
+    EXPECT_FALSE(m.isPointInSolid(Pair(7, 1)));
+    EXPECT_TRUE(m.isPointInSolid(Pair(7, 1), QUERY_ALL));
+    EXPECT_FALSE(m.isPointInSolid(Pair(12, 0.5)));
+    EXPECT_FALSE(m.isPointInSolid(Pair(-3, 1)));
+    EXPECT_FALSE(m.isPointInSolid(Pair(1, 30)));
+}
+
+TEST(MapQuery, ecbCast) {
+    Map m = Map(
+        {
+            Platform({Pair(0, 0), Pair(10, 0)}),
+            Platform({Pair(3, -1.8), Pair(3, 0)}),
+            Platform({Pair(6, -3), Pair(9, -3)}, true),
+        },
+        {});
+
+    // falling onto the floor
+    Ecb ecb = Ecb(Pair(5, -2), 0.5, 1, 0.5, 1);
+    QueryHit hit;
+    ASSERT_TRUE(m.ecbCast(ecb, Pair(0, 3), QUERY_SOLID, hit));
+    EXPECT_EQ(0, hit.segmentId);
+    EXPECT_NEAR(1.0 / 3, (double)hit.fraction, tolerance(5));
+    EXPECT_EQ(Pair(5, 0), hit.position);
+    EXPECT_EQ(Pair(0, -1), hit.normal);
+    EXPECT_FALSE(m.ecbCast(ecb, Pair(0, 3), QUERY_WALLS, hit));
+
+    // the lower right edge running into the top of the wall
+    ecb = Ecb(Pair(1, -2), 0.5, 1, 0.5, 1);
+    ASSERT_TRUE(m.ecbCast(ecb, Pair(4, 0), QUERY_SOLID, hit));
+    EXPECT_EQ(1, hit.segmentId);
+    EXPECT_NEAR(0.4, (double)hit.fraction, tolerance(7));
+    EXPECT_EQ(Pair(3, -1.8), hit.position);
+
+    // passable platforms are only hit when asked for
+    ecb = Ecb(Pair(7, -5), 0.5, 1, 0.5, 1);
+    EXPECT_FALSE(m.ecbCast(ecb, Pair(0, 2.5), QUERY_SOLID, hit));
+    ASSERT_TRUE(m.ecbCast(ecb, Pair(0, 2.5), QUERY_ALL, hit));
+    EXPECT_EQ(2, hit.segmentId);
+    EXPECT_NEAR(0.4, (double)hit.fraction, tolerance(7));
+
+    // starting out across terrain
+    ecb = Ecb(Pair(3, -1), 0.5, 1, 0.5, 1);
+    ASSERT_TRUE(m.ecbCast(ecb, Pair(1, 0), QUERY_SOLID, hit));
+    EXPECT_EQ(0, hit.fraction);
+}
+
+TEST(MapQuery, ecbCast_StopsBeforeTerrain) {
+    Map m = Map(makeRandomPlatforms(54, 200), {});
+    std::mt19937 rng(18);
+    std::uniform_real_distribution<double> position(-22, 22);
+    std::uniform_real_distribution<double> size(0.1, 0.6);
+    std::uniform_real_distribution<double> step(-3, 3);
+
+    size_t hits = 0, misses = 0;
+    for (size_t i = 0; i < 500; i++) {
+        Ecb ecb = Ecb(Pair(position(rng), position(rng)), size(rng),
+                      size(rng), size(rng), size(rng));
+        Pair motion = Pair(step(rng), step(rng));
+        QueryHit hit;
+        bool anyHit = m.ecbCast(ecb, motion, QUERY_SOLID, hit);
+        if (anyHit && hit.fraction == 0) {
+            continue;
+        }
+        anyHit ? hits++ : misses++;
+
+        // nothing is touched on the way to the hit, or the end
+        wideReal reached = anyHit ? hit.fraction : 1;
+        for (size_t k = 0; k < 20; k++) {
+            wideReal t = reached * k / 20;
+            Ecb moved = ecb;
+            moved.setOrigin(ecb.origin + motion * t);
+            QueryHit touched;
+            ASSERT_FALSE(
+                m.ecbCast(moved, Pair(0, 0), QUERY_SOLID, touched))
+                << ecb.origin << " + " << motion << " at " << t;
+        }
+        if (anyHit) {
+            Ecb moved = ecb;
+            moved.setOrigin(ecb.origin + motion * hit.fraction);
+            // rounding the origin may leave it just short of the terrain
+            wideReal nudge = tolerance(22) / (double)motion.euclid();
+            QueryHit touched;
+            EXPECT_TRUE(
+                m.ecbCast(moved, motion * nudge, QUERY_SOLID, touched));
+        }
+    }
+    EXPECT_GT(hits, 0);
+    EXPECT_GT(misses, 0);
+}
@@ -0,0 +1,211 @@
+#include <cstring>
+#include <random>
+#include "gtest/gtest.h"
+#include "netcode/loopback.hpp"
+#include "netcode/rollback.hpp"
+#include "player/inputhandler.hpp"
+#include "player/playerconfig.hpp"
+#include "sim/simulation.hpp"
+#include "sim/snapshot.hpp"
+#include "terrain/map.hpp"
+
+using namespace Terrain;
+using namespace InputMapping;
+
+// a walled floor under a turning passable platform
+static Map makeArena() {
+    Platform spinner({Pair(-4, 2), Pair(4, 2)}, true);
+    PlatformMotion motion;
+    motion.angularVelocity = 0.02;
+    motion.pivot = Pair(0, 2);
+    spinner.setMotion(motion);
+    return Map({Platform({Pair(-20, -10),
+                          Pair(-20, 5),
+                          Pair(20, 5),
+                          Pair(20, -10)}),
+                spinner},
+               {});
+}
+
+static std::vector<Pair> const SPAWNS = {Pair(-10, 4), Pair(10, 4)};
+
+// each player walks one way for a while, jumping now and then
+static InputFrame scriptedInput(size_t player, size_t frame) {
+    std::mt19937 rng(player * 7919 + frame / 15);
+    std::uniform_real_distribution<double> walk(-1, 1);
+    InputFrame input;
+    input.axies[MOVEMENT_AXIS_X] = walk(rng);
+    if ((frame + player * 11) % 40 == 0) {
+        input.buttons |= 1 << JUMP;
+    }
+    return input;
+}
+
+// a snapshot holds everything a simulation goes on from, so two that are
+// the same byte for byte run the same from then on
+static void expectSameSnapshots(Simulation const& a, Simulation const& b) {
+    ASSERT_EQ(a.getSnapshotSize(), b.getSnapshotSize());
+    SnapshotArena snapshots(a.getSnapshotSize(), 2);
+    a.save(snapshots.getSlot(0));
+    b.save(snapshots.getSlot(1));
+    EXPECT_EQ(0, std::memcmp(snapshots.getSlot(0), snapshots.getSlot(1),
+                             a.getSnapshotSize()));
+}
+
+TEST(Simulation, restoreRunsTheSameFramesAgain) {
+    Map m = makeArena();
+    PlayerConfig config("assets/attributes.yaml");
+    Simulation sim(m, config, SPAWNS);
+    std::vector<InputFrame> frame(SPAWNS.size());
+
+    for (size_t f = 0; f < 30; f++) {
+        for (size_t p = 0; p < frame.size(); p++) {
+            frame[p] = scriptedInput(p, f);
+        }
+        sim.step(frame.data(), 1.0 / 60.0);
+    }
+    SnapshotArena saved(sim.getSnapshotSize(), 1);
+    sim.save(saved.getSlot(0));
+
+    SnapshotArena first(sim.getSnapshotSize(), 60);
+    for (size_t f = 30; f < 90; f++) {
+        for (size_t p = 0; p < frame.size(); p++) {
+            frame[p] = scriptedInput(p, f);
+        }
+        sim.step(frame.data(), 1.0 / 60.0);
+        sim.save(first.getSlot(f - 30));
+    }
+
+    sim.restore(saved.getSlot(0));
+    EXPECT_EQ(30, sim.getFrame());
+    SnapshotArena again(sim.getSnapshotSize(), 1);
+    for (size_t f = 30; f < 90; f++) {
+        for (size_t p = 0; p < frame.size(); p++) {
+            frame[p] = scriptedInput(p, f);
+        }
+        sim.step(frame.data(), 1.0 / 60.0);
+        sim.save(again.getSlot(0));
+        EXPECT_EQ(0, std::memcmp(first.getSlot(f - 30), again.getSlot(0),
+                                 sim.getSnapshotSize()))
+            << "frame " << f;
+    }
+    EXPECT_EQ(90, m.getPlatform(1)->getMoves());
+}
+
+static bool allGrounded(Simulation const& sim) {
+    for (Player const* p : sim.getPlayers()) {
+        if (!p->isGrounded()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// platforms are named by index, so the grounded players of a snapshot land
+// on the same platforms of another map
+TEST(Simulation, snapshotRestoresIntoAnotherSimulation) {
+    Map m = makeArena();
+    PlayerConfig config("assets/attributes.yaml");
+    Simulation sim(m, config, SPAWNS);
+    std::vector<InputFrame> frame(SPAWNS.size());
+    while (sim.getFrame() < 40 || !allGrounded(sim)) {
+        ASSERT_LT(sim.getFrame(), 200);
+        for (size_t p = 0; p < frame.size(); p++) {
+            frame[p] = scriptedInput(p, sim.getFrame());
+        }
+        sim.step(frame.data(), 1.0 / 60.0);
+    }
+    size_t saved = sim.getFrame();
+
+    // a snapshot is plain data, so it survives being copied out bytewise
+    SnapshotArena arena(sim.getSnapshotSize(), 2);
+    sim.save(arena.getSlot(0));
+    std::vector<char> copied(sim.getSnapshotSize());
+    std::memcpy(copied.data(), arena.getSlot(0), copied.size());
+    std::memcpy(arena.getSlot(1), copied.data(), copied.size());
+
+    Map other = makeArena();
+    Simulation restored(other, config, {Pair(0, 0), Pair(1, 0)});
+    restored.restore(arena.getSlot(1));
+    EXPECT_EQ(saved, restored.getFrame());
+    EXPECT_EQ(saved, other.getPlatform(1)->getMoves());
+    for (size_t i = 0; i < SPAWNS.size(); i++) {
+        Player const* p = sim.getPlayers()[i];
+        Player const* q = restored.getPlayers()[i];
+        EXPECT_TRUE(q->isGrounded());
+        EXPECT_EQ(p->getCurrentPlatform() - &m.getPlatforms()[0],
+                  q->getCurrentPlatform() - &other.getPlatforms()[0]);
+    }
+
+    for (size_t f = saved; f < saved + 60; f++) {
+        for (size_t p = 0; p < frame.size(); p++) {
+            frame[p] = scriptedInput(p, f);
+        }
+        sim.step(frame.data(), 1.0 / 60.0);
+        restored.step(frame.data(), 1.0 / 60.0);
+        expectSameSnapshots(sim, restored);
+    }
+}
+
+TEST(RollbackSession, peersAgreeOverALossyNetwork) {
+    LoopbackConfig net;
+    net.delay = 3;
+    net.jitter = 4;
+    net.loss = 0.2;
+    net.seed = 5;
+    LoopbackNetwork network(net, 2);
+
+    RollbackConfig rollback;
+    rollback.maxRollbackFrames = 8;
+    rollback.inputDelay = 2;
+    PlayerConfig config("assets/attributes.yaml");
+
+    Map maps[] = {makeArena(), makeArena()};
+    Simulation sim0(maps[0], config, SPAWNS);
+    Simulation sim1(maps[1], config, SPAWNS);
+    Simulation* sims[] = {&sim0, &sim1};
+    RollbackSession session0(rollback, sim0, 0, network.getEndpoint(0));
+    RollbackSession session1(rollback, sim1, 1, network.getEndpoint(1));
+    RollbackSession* sessions[] = {&session0, &session1};
+
+    // each peer gives the input for the next frame it hasn't given yet
+    size_t const frames = 300;
+    size_t given[] = {0, 0};
+    while (given[0] < frames || given[1] < frames ||
+           session0.getConfirmedFrame() < frames + rollback.inputDelay ||
+           session1.getConfirmedFrame() < frames + rollback.inputDelay) {
+        for (size_t p = 0; p < 2; p++) {
+            if (given[p] < frames) {
+                if (sessions[p]->advanceFrame(scriptedInput(p, given[p]))) {
+                    given[p]++;
+                }
+            } else {
+                sessions[p]->poll();
+            }
+        }
+        network.tick();
+    }
+    EXPECT_GT(network.getDropped(), 0);
+    EXPECT_GT(session0.getStats().rollbacks, 0);
+    EXPECT_LE(session0.getStats().deepestRollback,
+              rollback.maxRollbackFrames);
+    EXPECT_LE(session1.getStats().deepestRollback,
+              rollback.maxRollbackFrames);
+
+    // inputs given on a frame are for inputDelay frames later
+    Map m = makeArena();
+    Simulation reference(m, config, SPAWNS);
+    std::vector<InputFrame> frame(SPAWNS.size());
+    for (size_t f = 0; f < frames; f++) {
+        for (size_t p = 0; p < frame.size(); p++) {
+            frame[p] = f < rollback.inputDelay
+                           ? InputFrame()
+                           : scriptedInput(p, f - rollback.inputDelay);
+        }
+        reference.step(frame.data(), rollback.elapsed);
+    }
+    for (Simulation* sim : sims) {
+        EXPECT_EQ(frames, sim->getFrame());
+        expectSameSnapshots(reference, *sim);
+    }
+}
@@ -0,0 +1,294 @@
+#include <cstdio>
+#include <random>
+#include <stdlib.h>
+#include <unistd.h>
+#include "gtest/gtest.h"
+#include "terrain/map.hpp"
+#include "stage/stagefile.hpp"
+#include "stage/stagecompiler.hpp"
+#include "lib/mock-player.hpp"
+#include "lib/random-platforms.hpp"
+
+using namespace Terrain;
+
+// name of a new empty file for the test to write to
+static std::string makeTempPath() {
+    char path[] = "/tmp/sdl-game-stage-XXXXXX";
+    int fd = mkstemp(path);
+    if (fd >= 0) {
+        close(fd);
+    }
+    return path;
+}
+
+static void writeFile(std::string const& path, std::vector<char> const& data) {
+    FILE* f = fopen(path.c_str(), "wb");
+    fwrite(data.data(), 1, data.size(), f);
+    fclose(f);
+}
+
+template <typename T>
+static std::vector<T> toVector(Table<T> const& table) {
+    return std::vector<T>(table.begin(), table.end());
+}
+
+TEST(StageReader, readsSectionsInOrder) {
+    std::vector<double> values = {1.5, 2.5, 3.5};
+    StageWriter out;
+    out.writeValue((size_t)42);
+    out.write(values);
+    out.write(std::vector<Pair>());
+    std::vector<char> file = out.finish();
+
+    StageReader in(file.data(), file.size());
+    size_t value = 0;
+    Table<double> table;
+    Table<Pair> empty;
+    in.readValue(value);
+    in.read(table);
+    in.read(empty);
+
+    ASSERT_TRUE(in.isValid()) << in.getError();
+    EXPECT_TRUE(in.isFinished());
+    EXPECT_EQ(42, value);
+    EXPECT_EQ(values, table);
+    // the table points into the file
+    EXPECT_TRUE(table.isBorrowed());
+    EXPECT_LE(file.data(), (char const*)table.begin());
+    EXPECT_GE(file.data() + file.size(), (char const*)table.end());
+    EXPECT_EQ(0, empty.size());
+
+    // asking for another type than was written fails
+    StageReader mismatched(file.data(), file.size());
+    Table<Bounds> bounds;
+    mismatched.read(bounds);
+    EXPECT_FALSE(mismatched.isValid());
+    EXPECT_EQ(0, bounds.size());
+
+    // and so does reading past the last section
+    StageReader overrun(file.data(), file.size());
+    for (size_t i = 0; i < 4; i++) {
+        overrun.read(table);
+    }
+    EXPECT_FALSE(overrun.isValid());
+}
+
+TEST(StageReader, rejectsBadHeaders) {
+    StageWriter out;
+    out.write(std::vector<double>(16, 1.0));
+    std::vector<char> file = out.finish();
+
+    EXPECT_TRUE(StageReader(file.data(), file.size()).isValid());
+    EXPECT_FALSE(StageReader(file.data(), file.size() - 1).isValid());
+    EXPECT_FALSE(StageReader(file.data(), 4).isValid());
+
+    std::vector<char> badMagic = file;
+    badMagic[0] = 'X';
+    EXPECT_FALSE(StageReader(badMagic.data(), badMagic.size()).isValid());
+
+    std::vector<char> badVersion = file;
+    StageHeader header;
+    std::memcpy(&header, badVersion.data(), sizeof(header));
+    header.version++;
+    std::memcpy(badVersion.data(), &header, sizeof(header));
+    EXPECT_FALSE(StageReader(badVersion.data(), badVersion.size()).isValid());
+
+    // stages of a float or fixed point build don't load into a double one,
+    // and vice versa
+    std::vector<char> badPrecision = file;
+    std::memcpy(&header, badPrecision.data(), sizeof(header));
+    header.realFormat = STAGE_REAL_FORMAT == STAGE_REAL_DOUBLE
+                            ? STAGE_REAL_FIXED
+                            : STAGE_REAL_DOUBLE;
+    std::memcpy(badPrecision.data(), &header, sizeof(header));
+    EXPECT_FALSE(
+        StageReader(badPrecision.data(), badPrecision.size()).isValid());
+}
+
+TEST(Stage, load_MatchesBuiltMap) {
+    std::vector<Ledge> ledges;
+    std::mt19937 rng(13);
+    std::uniform_real_distribution<double> position(-20, 20);
+    for (size_t i = 0; i < 50; i++) {
+        ledges.push_back(Ledge(Pair(position(rng), position(rng)),
+                               i % 2 ? FACING_LEFT : FACING_RIGHT));
+    }
+    Map built = Map(makeRandomPlatforms(47, 200), ledges);
+
+    std::string path = makeTempPath();
+    StageWriter out;
+    built.save(out);
+    ASSERT_TRUE(out.save(path));
+    Map* loaded = Map::load(path);
+    ASSERT_TRUE(loaded != NULL);
+
+    // the tables are used straight from the file
+    EXPECT_TRUE(loaded->getSegments().isBorrowed());
+    EXPECT_TRUE(
+        loaded->getSegmentBucket(FLOOR_COLLISION).getIds().isBorrowed());
+
+    Table<MapSegment> const& segments = built.getSegments();
+    ASSERT_EQ(segments.size(), loaded->getSegments().size());
+    for (size_t i = 0; i < segments.size(); i++) {
+        MapSegment const& s = loaded->getSegments()[i];
+        EXPECT_EQ(segments[i].first, s.first);
+        EXPECT_EQ(segments[i].second, s.second);
+        EXPECT_EQ(segments[i].type, s.type);
+        EXPECT_EQ(segments[i].platform, s.platform);
+        EXPECT_EQ(segments[i].index, s.index);
+        EXPECT_EQ(built.toPlatformSegment(i).angle(),
+                  loaded->toPlatformSegment(i).angle());
+    }
+    ASSERT_EQ(built.getPoints().size(), loaded->getPoints().size());
+    TerrainCollisionType types[] = {NO_COLLISION, FLOOR_COLLISION,
+                                    WALL_COLLISION, CEIL_COLLISION};
+    for (TerrainCollisionType type : types) {
+        EXPECT_EQ(toVector(built.getSegmentBucket(type).getIds()),
+                  loaded->getSegmentBucket(type).getIds());
+    }
+    EXPECT_EQ(toVector(built.getCornerIndex().getIds()),
+              loaded->getCornerIndex().getIds());
+
+    // queries and movement give the same results on both maps
+    std::uniform_real_distribution<double> step(-4, 4);
+    for (size_t i = 0; i < 1000; i++) {
+        Pair start = Pair(position(rng), position(rng));
+        Pair end = start + Pair(step(rng), step(rng));
+        PlatformSegment ignored;
+        CollisionDatum a, b;
+        TerrainCollisionType type = types[i % 4];
+        bool hitA = built.getClosestCollision(start, end, a, ignored, type);
+        bool hitB = loaded->getClosestCollision(start, end, b, ignored, type);
+        ASSERT_EQ(hitA, hitB);
+        if (hitA) {
+            EXPECT_EQ(a.segmentId, b.segmentId);
+            EXPECT_EQ(a.position, b.position);
+        }
+    }
+
+    std::uniform_real_distribution<double> velocity(-0.8, 0.8);
+    for (size_t i = 0; i < 32; i++) {
+        Pair start = Pair(position(rng), position(rng));
+        Player a = makeMockPlayer(start);
+        Player b = makeMockPlayer(start);
+        for (size_t frame = 0; frame < 30; frame++) {
+            Pair motion = Pair(velocity(rng), velocity(rng) + 0.2);
+            a.update();
+            b.update();
+            Pair motionA = motion, motionB = motion;
+            if (a.isGrounded())
+                motionA.y = 0;
+            if (b.isGrounded())
+                motionB.y = 0;
+            built.movePlayer(a, motionA);
+            loaded->movePlayer(b, motionB);
+            ASSERT_EQ(a.position, b.position);
+            ASSERT_EQ(a.getActionState(), b.getActionState());
+        }
+    }
+
+    delete loaded;
+    remove(path.c_str());
+}
+
+TEST(Stage, load_RejectsInvalidFiles) {
+    std::string path = makeTempPath();
+    StageWriter out;
+    Map(makeRandomPlatforms(48, 20), {}).save(out);
+    std::vector<char> file = out.finish();
+
+    // empty
+    EXPECT_EQ(NULL, Map::load(path));
+
+    // truncated
+    writeFile(path, std::vector<char>(file.begin(), file.end() - 8));
+    EXPECT_EQ(NULL, Map::load(path));
+
+    // not a map
+    StageWriter other;
+    other.write(std::vector<double>(16, 1.0));
+    writeFile(path, other.finish());
+    EXPECT_EQ(NULL, Map::load(path));
+
+    writeFile(path, file);
+    Map* map = Map::load(path);
+    EXPECT_TRUE(map != NULL);
+    delete map;
+
+    remove(path.c_str());
+    EXPECT_EQ(NULL, Map::load(path));
+}
+
+TEST(Stage, compileStage) {
+    std::vector<Platform> platforms;
+    std::vector<Ledge> ledges;
+    ASSERT_TRUE(loadStageDescription("stages/main.yaml", platforms, ledges));
+    EXPECT_EQ(6, platforms.size());
+    ASSERT_EQ(2, ledges.size());
+    EXPECT_EQ(Pair(2.55, 0.5), ledges[1].position);
+    EXPECT_EQ(FACING_RIGHT, ledges[1].facing);
+    EXPECT_TRUE(platforms[0].isPassable());
+    EXPECT_FALSE(platforms[4].isPassable());
+
+    std::string path = makeTempPath();
+    ASSERT_TRUE(compileStage("stages/main.yaml", path));
+    Map* map = Map::load(path);
+    ASSERT_TRUE(map != NULL);
+    EXPECT_EQ(Map(platforms, ledges).getSegments().size(),
+              map->getSegments().size());
+    delete map;
+    remove(path.c_str());
+
+    EXPECT_FALSE(compileStage("stages/missing.yaml", path));
+}
+
+TEST(Stage, load_KeepsKinematicPlatforms) {
+    std::string path = makeTempPath();
+    std::string source = "platforms:\n"
+                         "  - points: [[0, 0], [4, 0]]\n"
+                         "    motion:\n"
+                         "      velocity: [0.1, 0]\n"
+                         "      angularVelocity: 0.05\n"
+                         "  - points: [[-3, 1], [-1, 1]]\n";
+    writeFile(path, std::vector<char>(source.begin(), source.end()));
+    std::vector<Platform> platforms;
+    std::vector<Ledge> ledges;
+    ASSERT_TRUE(loadStageDescription(path, platforms, ledges));
+    ASSERT_TRUE(platforms[0].isKinematic());
+    EXPECT_FALSE(platforms[1].isKinematic());
+    EXPECT_EQ(Pair(0.1, 0), platforms[0].getMotion().velocity);
+    EXPECT_EQ(0.05, platforms[0].getMotion().angularVelocity);
+    EXPECT_EQ(Pair(2, 0), platforms[0].getMotion().pivot);
+
+    Map built = Map(platforms, ledges);
+    StageWriter out;
+    built.save(out);
+    ASSERT_TRUE(out.save(path));
+    Map* loaded = Map::load(path);
+    ASSERT_TRUE(loaded != NULL);
+    ASSERT_EQ(1, loaded->getKinematicPlatforms().size());
+
+    // both maps move the platform the same way
+    for (size_t frame = 0; frame < 10; frame++) {
+        built.update();
+        loaded->update();
+    }
+    for (size_t id = 0; id < built.getSegments().size(); id++) {
+        EXPECT_EQ(built.getSegments()[id].first,
+                  loaded->getSegments()[id].first);
+        EXPECT_EQ(built.getSegments()[id].second,
+                  loaded->getSegments()[id].second);
+    }
+    PlatformSegment ignored;
+    CollisionDatum a, b;
+    Pair start = built.getSegments()[0].first + Pair(0.5, -1);
+    Pair end = start + Pair(0, 2);
+    ASSERT_TRUE(
+        built.getClosestCollision(start, end, a, ignored, NO_COLLISION));
+    ASSERT_TRUE(
+        loaded->getClosestCollision(start, end, b, ignored, NO_COLLISION));
+    EXPECT_EQ(a.position, b.position);
+
+    delete loaded;
+    remove(path.c_str());
+}
@@ -0,0 +1,116 @@
+#include <cmath>
+#include <random>
+#include "gtest/gtest.h"
+#include "terrain/map.hpp"
+#include "stage/stagegenerator.hpp"
+#include "lib/mock-player.hpp"
+
+using namespace Terrain;
+
+TEST(StageGenerator, sameSeedSameStage) {
+    StageGeneratorConfig config;
+    config.size = Pair(10, 5);
+    std::vector<Platform> platformsA, platformsB, platformsC;
+    std::vector<Ledge> ledgesA, ledgesB, ledgesC;
+    generateStage(config, platformsA, ledgesA);
+    generateStage(config, platformsB, ledgesB);
+    config.seed++;
+    generateStage(config, platformsC, ledgesC);
+
+    Map a = Map(platformsA, ledgesA);
+    Map b = Map(platformsB, ledgesB);
+    Map c = Map(platformsC, ledgesC);
+    ASSERT_EQ(a.getPoints().size(), b.getPoints().size());
+    for (size_t i = 0; i < a.getPoints().size(); i++) {
+        EXPECT_EQ(a.getPoints()[i].position, b.getPoints()[i].position);
+    }
+    ASSERT_EQ(ledgesA.size(), ledgesB.size());
+    EXPECT_FALSE(a.getPoints().size() == c.getPoints().size() &&
+                 a.getPoints()[0].position == c.getPoints()[0].position);
+}
+
+TEST(StageGenerator, makesEveryKindOfTerrain) {
+    StageGeneratorConfig config;
+    config.size = Pair(10, 5);
+    std::vector<Platform> platforms;
+    std::vector<Ledge> ledges;
+    generateStage(config, platforms, ledges);
+    Map m = Map(platforms, ledges);
+
+    size_t types[NUM_COLLISION_TYPES] = {0};
+    size_t passable = 0, slopes = 0, closed = 0;
+    for (MapSegment const& s : m.getSegments()) {
+        types[s.type]++;
+        passable += s.passable;
+        slopes += s.type == FLOOR_COLLISION && abs(s.angle) > 0.3;
+    }
+    for (Platform const& p : m.getPlatforms()) {
+        closed += p.isClosed();
+    }
+    EXPECT_GT(types[FLOOR_COLLISION], 0);
+    EXPECT_GT(types[WALL_COLLISION], 0);
+    EXPECT_GT(types[CEIL_COLLISION], 0);
+    EXPECT_GT(passable, 0);
+    EXPECT_GT(slopes, 0);
+    EXPECT_GT(closed, 0);
+
+    // ledges hang off the corners of platforms
+    ASSERT_GT(ledges.size(), 0);
+    for (Ledge const& l : ledges) {
+        bool onPoint = false;
+        for (MapPoint const& p : m.getPoints()) {
+            onPoint |= p.position == l.position;
+        }
+        EXPECT_TRUE(onPoint) << l.position;
+    }
+}
+
+TEST(StageGenerator, densityScalesFeatures) {
+    StageGeneratorConfig config;
+    config.size = Pair(10, 5);
+    for (double& weight : config.weights) {
+        weight = 0;
+    }
+    config.weights[FEATURE_WALL] = 1;
+
+    std::vector<Platform> platforms;
+    std::vector<Ledge> ledges;
+    generateStage(config, platforms, ledges);
+    EXPECT_EQ(50, platforms.size());
+    EXPECT_EQ(0, ledges.size());
+
+    platforms.clear();
+    config.density = 2;
+    generateStage(config, platforms, ledges);
+    EXPECT_EQ(100, platforms.size());
+    for (Platform const& p : platforms) {
+        EXPECT_EQ(WALL_COLLISION,
+                  Platform::getCollisionType(p.getSegment(0).angle()));
+    }
+}
+
+TEST(StageGenerator, playersStayFinite) {
+    StageGeneratorConfig config;
+    config.size = Pair(6, 4);
+    config.density = 2;
+    std::vector<Platform> platforms;
+    std::vector<Ledge> ledges;
+    generateStage(config, platforms, ledges);
+    Map m = Map(platforms, ledges);
+
+    std::mt19937 rng(18);
+    std::uniform_real_distribution<double> position(-3, 3);
+    std::uniform_real_distribution<double> velocity(-0.2, 0.2);
+    for (size_t i = 0; i < 8; i++) {
+        Player p = makeMockPlayer(Pair(position(rng), position(rng)));
+        for (size_t frame = 0; frame < 60; frame++) {
+            Pair motion = Pair(velocity(rng), velocity(rng) + 0.1);
+            if (p.isGrounded())
+                motion.y = 0;
+            m.movePlayer(p, motion);
+            ASSERT_FALSE(std::isnan((double)p.position.x) ||
+                         std::isnan((double)p.position.y))
+                << "player " << i << " frame " << frame;
+        }
+    }
+}
@@ -1,6 +1,9 @@
 #include "gtest/gtest.h"
 #include "engine/pair.hpp"
 #include "util.hpp"
+#include "linebatch.hpp"
+#include <limits>
+#include <random>
 
 TEST(Util, checkLineIntersection_Basic) {
     Pair a1 = Pair(-1, 1), a2 = Pair(2, 1);
@@ -302,6 +305,8 @@ TEST(Platform, checkLineSweep_Testing_Playtest_2) {
     ASSERT_EQ(collision_dir, -1);
 }
 
+// checks exact positions worked out in double precision
+#ifndef SIM_FLOAT
 TEST(Platform, checkLineSweep_Testing_Othertest_3) {
     // bottom right collision for these ECBs
     /*
@@ -339,3 +344,139 @@ TEST(Platform, checkLineSweep_Testing_Othertest_3) {
 
     ASSERT_EQ(collision_dir, -1);
 }
+#endif
+
+// reference result for checkLineIntersectionBatch: the closest hit found by
+// checking every segment in order
+static bool closestHitScalar(Pair const& p0,
+                             Pair const& p1,
+                             SegmentArrays const& s,
+                             std::vector<size_t> const& ids,
+                             int requiredDirection,
+                             LineHit& out) {
+    bool any = false;
+    out.distance = std::numeric_limits<double>::infinity();
+    for (size_t id : ids) {
+        WidePair point;
+        int direction = checkLineIntersectionPrecise(
+            p0, p1, Pair(s.x1[id], s.y1[id]), Pair(s.x2[id], s.y2[id]),
+            point);
+        if (!direction ||
+            (requiredDirection && direction != requiredDirection))
+            continue;
+
+        wideReal distance = (point - WidePair(p0.x, p0.y)).euclid();
+        if (distance < out.distance) {
+            out.index = id;
+            out.point = Pair(point.x, point.y);
+            out.direction = direction;
+            out.distance = distance;
+            any = true;
+        }
+    }
+    return any;
+}
+
+TEST(Util, checkLineIntersectionBatch_MatchesScalar) {
+    std::mt19937 rng(1234);
+    std::uniform_real_distribution<double> coord(-10, 10);
+    // snap some coordinates to a coarse grid so that parallel segments,
+    // shared endpoints and equally close hits come up regularly
+    std::uniform_int_distribution<int> snapped(-4, 4);
+    auto randomPair = [&](bool snap) {
+        if (snap)
+            return Pair(snapped(rng), snapped(rng));
+        return Pair(coord(rng), coord(rng));
+    };
+
+    LineBatchImpl impls[] = {LINE_BATCH_SCALAR, LINE_BATCH_SSE2,
+                             LINE_BATCH_AVX2};
+    LineBatchImpl original = getLineBatchImpl();
+
+    for (int round = 0; round < 300; round++) {
+        bool snap = round % 2;
+        SegmentArrays segments;
+        size_t count = round % 37;
+        for (size_t i = 0; i < count; i++) {
+            segments.push(randomPair(snap), randomPair(snap));
+        }
+
+        // every other id, in order, to exercise the indexed loads
+        std::vector<size_t> all, odd;
+        for (size_t i = 0; i < count; i++) {
+            all.push_back(i);
+            if (i % 2)
+                odd.push_back(i);
+        }
+
+        Pair p0 = randomPair(snap), p1 = randomPair(snap);
+        for (int requiredDirection = -1; requiredDirection <= 1;
+             requiredDirection++) {
+            LineHit expectedAll, expectedOdd;
+            bool anyAll = closestHitScalar(p0, p1, segments, all,
+                                           requiredDirection, expectedAll);
+            bool anyOdd = closestHitScalar(p0, p1, segments, odd,
+                                           requiredDirection, expectedOdd);
+
+            for (LineBatchImpl impl : impls) {
+                if (!isLineBatchImplSupported(impl))
+                    continue;
+                setLineBatchImpl(impl);
+
+                LineHit hit;
+                ASSERT_EQ(checkLineIntersectionBatch(p0, p1, segments, NULL,
+                                                     count,
+                                                     requiredDirection, hit),
+                          anyAll);
+                if (anyAll) {
+                    EXPECT_EQ(hit.index, expectedAll.index);
+                    EXPECT_EQ(hit.point, expectedAll.point);
+                    EXPECT_EQ(hit.direction, expectedAll.direction);
+                    EXPECT_EQ(hit.distance, expectedAll.distance);
+                }
+
+                ASSERT_EQ(checkLineIntersectionBatch(
+                              p0, p1, segments, odd.data(), odd.size(),
+                              requiredDirection, hit),
+                          anyOdd);
+                if (anyOdd) {
+                    EXPECT_EQ(hit.index, expectedOdd.index);
+                    EXPECT_EQ(hit.point, expectedOdd.point);
+                    EXPECT_EQ(hit.distance, expectedOdd.distance);
+                }
+            }
+        }
+    }
+
+    setLineBatchImpl(original);
+}
+
+TEST(Util, checkLineIntersectionBatch_TieGoesToFirst) {
+    // two identical segments crossing the sweep at the same point, placed
+    // in different vector lanes, among segments out of reach of the sweep
+    SegmentArrays segments;
+    for (int i = 0; i < 8; i++) {
+        if (i == 5 || i == 6)
+            segments.push(Pair(1, 2), Pair(1, 0));
+        else
+            segments.push(Pair(i + 10, 0), Pair(i + 10, 2));
+    }
+
+    LineBatchImpl impls[] = {LINE_BATCH_SCALAR, LINE_BATCH_SSE2,
+                             LINE_BATCH_AVX2};
+    LineBatchImpl original = getLineBatchImpl();
+    for (LineBatchImpl impl : impls) {
+        if (!isLineBatchImplSupported(impl))
+            continue;
+        setLineBatchImpl(impl);
+
+        LineHit hit;
+        ASSERT_TRUE(checkLineIntersectionBatch(Pair(0, 1), Pair(3, 1),
+                                               segments, NULL,
+                                               segments.size(), 0, hit));
+        EXPECT_EQ(hit.index, 5u);
+        EXPECT_EQ(hit.point, Pair(1, 1));
+        EXPECT_EQ(hit.distance, 1);
+    }
+    setLineBatchImpl(original);
+}
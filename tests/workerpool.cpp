@@ -0,0 +1,31 @@
+#include <atomic>
+#include <vector>
+#include "gtest/gtest.h"
+#include "engine/workerpool.hpp"
+
+TEST(WorkerPool, runsEveryItemOnce) {
+    size_t sizes[] = {1, 2, 4, 8};
+    for (size_t size : sizes) {
+        WorkerPool pool(size);
+        ASSERT_EQ(size, pool.size());
+
+        // run a few jobs on the same pool to exercise waking it up again
+        for (size_t count = 0; count < 100; count += 33) {
+            std::vector<std::atomic<int>> visits(count);
+            for (std::atomic<int>& v : visits) {
+                v = 0;
+            }
+            std::atomic<bool> badWorker(false);
+            pool.run(count, [&](size_t item, size_t worker) {
+                visits[item]++;
+                if (worker >= size)
+                    badWorker = true;
+            });
+
+            for (std::atomic<int>& v : visits) {
+                EXPECT_EQ(1, v);
+            }
+            EXPECT_FALSE(badWorker);
+        }
+    }
+}